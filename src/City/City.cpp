@@ -20,6 +20,15 @@
 //=====================================================================
 
 #include "City/City.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+// Size of the cells of the grid of sleeping cars [meter].
+static constexpr float STATIC_CELL_SIZE = 10.0f;
+// Max number of cells of the grid of sleeping cars along each axis.
+static constexpr uint32_t MAX_STATIC_CELLS = 512u;
 
 //------------------------------------------------------------------------------
 City::City()
@@ -32,36 +41,389 @@ void City::reset()
 {
     LOGI("Reset city");
 
-    m_car_id = m_ego_id = m_ghost_id = 0u;
+    m_car_id = m_agent_id = m_ego_id = m_ghost_id = m_pedestrian_id = 0u;
 
-    m_ghosts.clear();
+    for (auto const& it: m_locations)
+    {
+        if (it.second.lane != nullptr)
+        {
+            it.second.lane->remove(*it.first, it.second.s);
+        }
+    }
+    m_locations.clear();
     m_cars.clear();
+    m_ego = CarHandle();
+    m_tiles.clearParkings();
     m_parkings.clear();
+    m_crowd.clear();
+    m_tiles.activate();
+    m_statics_outdated = true;
 }
 
 //------------------------------------------------------------------------------
 Car* City::get(const char* name)
 {
-    for (auto& it: m_cars)
+    return m_cars.get(m_cars.find(name));
+}
+
+//------------------------------------------------------------------------------
+Car& City::createCar(CarGroup const group, const char* model, const char* name,
+                     sf::Color color, MeterPerSecondSquared const acceleration,
+                     MeterPerSecond const speed, sf::Vector2<Meter> const& position,
+                     Radian const heading, Radian const steering)
+{
+    CarHandle const handle = m_cars.create(name, group, model, color);
+    Car* car_ = m_cars.get(handle);
+    if (car_ == nullptr)
     {
-        if (it->name == name)
-            return &(*it);
+        std::string const e("Car name already used '");
+        throw std::runtime_error(e + name + "'");
     }
 
-    return nullptr;
+    Car& car = *car_;
+    car.name = name;
+    car.init(acceleration, speed, position, heading, steering);
+    return car;
+}
+
+//------------------------------------------------------------------------------
+bool City::removeCar(CarHandle const handle)
+{
+    Car* car = m_cars.get(handle);
+    if (car == nullptr)
+        return false;
+
+    LOGI("Remove car '%s'", car->name.c_str());
+    m_statics_outdated |= sleeping(*car);
+    unlocate(*car);
+    for (auto& it: m_parkings)
+    {
+        it->unbind(*car);
+    }
+    return m_cars.destroy(handle);
 }
 
 //------------------------------------------------------------------------------
 Road& City::addRoad(std::vector<sf::Vector2<Meter>> const& centers,
-                    Meter const width, std::array<size_t, TrafficSide::Max> lanes)
+                    Meter const width, std::array<size_t, TrafficSide::Max> lanes,
+                    Road::Curve const curve)
 {
     LOGI("Add road: start (%g m, %g m), stop (%g m, %g m), width %g m",
-         centers[0].x, centers[0].y, centers[1].x, centers[1].y, width);
+         centers.front().x, centers.front().y, centers.back().x, centers.back().y,
+         width);
+
+    m_roads.push_back(std::make_unique<Road>(centers, width, lanes, curve));
+    m_tiles.insert(*m_roads.back());
+    m_graph_outdated = true;
+    return *m_roads.back();
+}
+
+//------------------------------------------------------------------------------
+Road& City::addRoad(sf::Vector2<Meter> const& start, Radian const heading,
+                    std::vector<math::Clothoid> const& segments,
+                    Meter const width, std::array<size_t, TrafficSide::Max> lanes)
+{
+    LOGI("Add road: start (%g m, %g m), heading %g deg, %zu clothoids, width %g m",
+         start.x, start.y, Degree(heading), segments.size(), width);
+
+    m_roads.push_back(std::make_unique<Road>(start, heading, segments, width, lanes));
+    m_tiles.insert(*m_roads.back());
+    m_graph_outdated = true;
+    return *m_roads.back();
+}
 
-    m_roads.push_back(std::make_unique<Road>(centers, width, lanes));
+//------------------------------------------------------------------------------
+Road& City::addRoad(std::unique_ptr<Road> road)
+{
+    m_roads.push_back(std::move(road));
+    m_tiles.insert(*m_roads.back());
+    m_graph_outdated = true;
     return *m_roads.back();
 }
 
+//------------------------------------------------------------------------------
+RoadGraph const& City::graph(bool const contracted)
+{
+    if (m_graph_outdated)
+    {
+        m_graph.build(m_roads);
+        m_graph_outdated = false;
+        LOGI("Road graph: %zu lanes", m_graph.size());
+    }
+    if (contracted && !m_graph.contracted() && (m_graph.size() != 0u))
+    {
+        m_graph.contract();
+        LOGI("Road graph: %zu shortcuts", m_graph.shortcuts());
+    }
+    return m_graph;
+}
+
+//------------------------------------------------------------------------------
+void City::updateLanes()
+{
+    for (Car& car: m_cars.entities(CarGroup::Traffic | CarGroup::Agent))
+    {
+        if (m_tiles.active(car.position()))
+        {
+            locate(car);
+        }
+    }
+    if (Car* ego = m_cars.get(m_ego))
+    {
+        locate(*ego);
+    }
+}
+
+//------------------------------------------------------------------------------
+void City::updateSlopes()
+{
+    if (m_terrain.flat())
+        return ;
+
+    m_wheels.clear();
+    m_sloped_cars.clear();
+    for (Car& car: m_cars.entities(CarGroup::Traffic | CarGroup::Agent | CarGroup::Ego))
+    {
+        if (m_tiles.active(car.position()))
+        {
+            for (WheelBluePrint const& wheel: car.shape().blueprint().wheels)
+            {
+                m_wheels.push_back(wheel.position);
+            }
+            m_sloped_cars.push_back(&car);
+        }
+    }
+    m_terrain.altitudes(m_wheels, m_wheel_altitudes);
+
+    // Pitch from the mean altitudes of the front and rear axles.
+    Meter const* z = m_wheel_altitudes.data();
+    for (Car* car: m_sloped_cars)
+    {
+        Meter const rise = ((z[CarBluePrint::FL] + z[CarBluePrint::FR]) -
+                            (z[CarBluePrint::RL] + z[CarBluePrint::RR])) / 2.0;
+        car->slope(units::math::atan(rise / car->blueprint.wheelbase));
+        z += CarBluePrint::Where::MAX;
+    }
+}
+
+//------------------------------------------------------------------------------
+bool City::sleep(CarHandle const handle)
+{
+    if ((m_cars.get(handle) == nullptr) || (m_cars.group(handle) != CarGroup::Traffic))
+        return false;
+
+    m_cars.regroup(handle, CarGroup::Static);
+    m_statics_outdated = true;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool City::wake(CarHandle const handle)
+{
+    Car* car = m_cars.get(handle);
+    if ((car == nullptr) || (m_cars.group(handle) != CarGroup::Static))
+        return false;
+
+    LOGI("Wake up car '%s'", car->name.c_str());
+    m_cars.regroup(handle, CarGroup::Traffic);
+    m_statics_outdated = true;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void City::index() const
+{
+    if (!m_statics_outdated)
+        return ;
+    m_statics_outdated = false;
+
+    m_static_cars.clear();
+    float x0 = std::numeric_limits<float>::max(), y0 = x0;
+    float x1 = -x0, y1 = -x0;
+    for (Car const& car: m_cars.entities(CarGroup::Static))
+    {
+        sf::FloatRect const box = car.obb().getGlobalBounds();
+        x0 = std::min(x0, box.left);
+        y0 = std::min(y0, box.top);
+        x1 = std::max(x1, box.left + box.width);
+        y1 = std::max(y1, box.top + box.height);
+        m_static_cars.push_back(&car);
+    }
+    if (m_static_cars.empty())
+    {
+        m_statics.clear();
+        m_static_items.clear();
+        return ;
+    }
+
+    // Sleeping cars do not move: the grid is fitted to them.
+    sf::Vector2u const dimensions(
+        std::min(MAX_STATIC_CELLS, uint32_t(std::ceil((x1 - x0) / STATIC_CELL_SIZE))),
+        std::min(MAX_STATIC_CELLS, uint32_t(std::ceil((y1 - y0) / STATIC_CELL_SIZE))));
+    m_statics.resize(sf::FloatRect(x0, y0, x1 - x0, y1 - y0),
+                     sf::Vector2u(std::max(1u, dimensions.x), std::max(1u, dimensions.y)));
+
+    m_static_items.resize(m_static_cars.size());
+    for (size_t i = 0u; i < m_static_cars.size(); ++i)
+    {
+        sf::FloatRect const box = m_static_cars[i]->obb().getGlobalBounds();
+        SpatialHashGrid::Item& item = m_static_items[i];
+        item.position = sf::Vector2f(box.left + box.width / 2.0f, box.top + box.height / 2.0f);
+        item.dimension = sf::Vector2f(box.width, box.height);
+        item.id = i;
+        m_statics.add(item);
+    }
+}
+
+//------------------------------------------------------------------------------
+void City::statics(sf::FloatRect const& area, std::vector<Car const*>& result) const
+{
+    index();
+    result.clear();
+    if (m_static_cars.empty() || !m_statics.bounds().intersects(area))
+        return ;
+
+    m_statics.findNear(area, m_static_found);
+    for (SpatialHashGrid::Item const* item: m_static_found)
+    {
+        result.push_back(m_static_cars[item->id]);
+    }
+}
+
+//------------------------------------------------------------------------------
+void City::updatePedestrians(Second const dt)
+{
+    if (m_crowd.pedestrians().empty())
+        return ;
+
+    // Moving cars, then sleeping cars near pedestrians. The crowd indexes them
+    // in a grid, so each pedestrian only checks the nearby cars.
+    std::vector<sf::RectangleShape const*> obstacles;
+    uint8_t const moving = (COLLIDABLES & ~CarGroup::Static) | CarGroup::Ego;
+    for (Car const& car: m_cars.entities(moving))
+    {
+        if (m_tiles.active(car.position()))
+        {
+            obstacles.push_back(&car.obb());
+        }
+    }
+    std::vector<Car const*> sleeping;
+    statics(m_crowd.bounds(), sleeping);
+    for (Car const* car: sleeping)
+    {
+        obstacles.push_back(&car->obb());
+    }
+    m_crowd.update(dt, obstacles, &m_tiles);
+}
+
+//------------------------------------------------------------------------------
+Lane* City::lane(Car const& car) const
+{
+    auto it = m_locations.find(&car);
+    return (it == m_locations.end()) ? nullptr : it->second.lane;
+}
+
+//------------------------------------------------------------------------------
+void City::locate(Car& car)
+{
+    // Distance a car outside lanes shall drive before looking again for lanes.
+    static const Meter RELOCATE_DISTANCE = 1.0_m;
+
+    sf::Vector2<Meter> const& position = car.position();
+    auto it = m_locations.find(&car);
+    Lane const* previous = nullptr;
+    if (it != m_locations.end())
+    {
+        Location& location = it->second;
+        if (location.lane == nullptr)
+        {
+            // Parked car or car outside roads.
+            if (math::distance(location.position, position) < RELOCATE_DISTANCE)
+                return ;
+        }
+        else if (location.lane->contains(position, location.segment))
+        {
+            // Still in the same lane: the usual case.
+            Lane::Occupant const occupant = location.lane->occupant(car, location.segment);
+            location.lane->move(location.s, occupant);
+            location.s = occupant.s;
+            return ;
+        }
+        else
+        {
+            // Has left its lane.
+            location.lane->remove(car, location.s);
+            previous = location.lane;
+        }
+    }
+
+    Location& location = m_locations[&car];
+    location.lane = findLane(position, previous);
+    location.position = position;
+    location.segment = math::Frenet::NONE;
+    if (location.lane != nullptr)
+    {
+        Lane::Occupant const occupant = location.lane->occupant(car, location.segment);
+        location.lane->insert(occupant);
+        location.s = occupant.s;
+    }
+
+    // Far cars are dead-reckoned along their lane.
+    car.follow((location.lane != nullptr) ? &location.lane->frenet() : nullptr);
+}
+
+//------------------------------------------------------------------------------
+void City::unlocate(Car const& car)
+{
+    auto it = m_locations.find(&car);
+    if (it == m_locations.end())
+        return ;
+
+    if (it->second.lane != nullptr)
+    {
+        it->second.lane->remove(car, it->second.s);
+    }
+    m_locations.erase(it);
+}
+
+//------------------------------------------------------------------------------
+Lane* City::findLane(sf::Vector2<Meter> const& position, Lane const* previous)
+{
+    if (previous != nullptr)
+    {
+        // Neighbors are edges of the road network: no need to contract.
+        RoadGraph const& g = graph(false);
+        RoadGraph::Id const v = g.vertex(*previous);
+        if (v != RoadGraph::NONE)
+        {
+            for (RoadGraph::Edge const& e: g.edges(v))
+            {
+                if (g.lane(e.to)->contains(position))
+                    return g.lane(e.to);
+            }
+        }
+    }
+
+    // Only roads of the tile holding the position.
+    Tiles::Tile const* tile = m_tiles.tile(position);
+    if (tile == nullptr)
+        return nullptr;
+
+    for (Road const* road: tile->roads)
+    {
+        for (size_t side = 0u; side < TrafficSide::Max; ++side)
+        {
+            for (auto const& lane: road->m_lanes[side])
+            {
+                if (lane->contains(position))
+                    return lane.get();
+            }
+        }
+    }
+
+    return nullptr;
+}
+
 //------------------------------------------------------------------------------
 Parking& City::addParking(const char* type, sf::Vector2<Meter> const& position,
                           Radian const heading)
@@ -72,6 +434,7 @@ Parking& City::addParking(const char* type, sf::Vector2<Meter> const& position,
     m_parkings.push_back(std::make_unique<Parking>(
                              BluePrints::get<ParkingBluePrint>(type),
                              position, heading));
+    m_tiles.insert(*m_parkings.back());
     return *m_parkings.back();
 }
 
@@ -80,7 +443,7 @@ Parking& City::addParking(const char* type, Road const& road, TrafficSide const
                           double const offset_long, double const offset_lat)
 {
     return addParking(type, road.offset(side, 0u, offset_long, offset_lat),
-                      -road.heading(side));
+                      -road.heading(side, 0u, offset_long));
 }
 
 //------------------------------------------------------------------------------
@@ -96,20 +459,23 @@ Parking& City::addParking(Parking const& parking)
 Car& City::addEgo(const char* model, sf::Vector2<Meter> const& position,
                   Radian const heading, MeterPerSecond const speed)
 {
-    char name[8];
-    snprintf(name, 8, "ego%zu", m_ego_id++);
+    char name[16];
+    snprintf(name, 16, "ego%zu", m_ego_id++);
 
     LOGI("Add Ego car '%s': position (%g m, %g m), heading %g deg, speed %g mps",
          name, position.x, position.y, Degree(heading), speed);
 
-    if (m_ego != nullptr)
+    if (m_cars.get(m_ego) != nullptr)
     {
         LOGW("Ego car already created. Old will be replaced!");
+        removeCar(m_ego);
     }
 
-    m_ego = createCar<Car>(model, name, EGO_CAR_COLOR, 0.0_mps_sq, speed,
-                           position, heading, 0.0_rad);
-    return *m_ego;
+    Car& ego = createCar(CarGroup::Ego, model, name, EGO_CAR_COLOR, 0.0_mps_sq,
+                         speed, position, heading, 0.0_rad);
+    m_ego = m_cars.handle(ego);
+    locate(ego);
+    return ego;
 }
 
 //------------------------------------------------------------------------------
@@ -118,7 +484,7 @@ Car& City::addEgo(const char* model, Road const& road, TrafficSide const side,
                   double const offset_lat, MeterPerSecond const speed)
 {
     return addEgo(model, road.offset(side, lane, offset_long, offset_lat),
-                  road.heading(side), speed);
+                  road.heading(side, lane, offset_long), speed);
 }
 
 //------------------------------------------------------------------------------
@@ -126,15 +492,16 @@ Car& City::addCar(const char* model, sf::Vector2<Meter> const& position,
                   Radian const heading, MeterPerSecond const speed,
                   Radian const steering)
 {
-    char name[8];
-    snprintf(name, 8, "car%zu", m_car_id++);
+    char name[16];
+    snprintf(name, 16, "car%zu", m_car_id++);
 
     LOGI("Add car '%s': position (%g m, %g m), heading %g deg, speed %g mps",
          name, position.x, position.y, Degree(heading), speed);
 
-    m_cars.push_back(createCar<Car>(model, name, CAR_COLOR, 0.0_mps_sq, speed,
-                                    position, heading, steering));
-    return *m_cars.back();
+    Car& car = createCar(CarGroup::Traffic, model, name, CAR_COLOR, 0.0_mps_sq,
+                         speed, position, heading, steering);
+    locate(car);
+    return car;
 }
 
 //------------------------------------------------------------------------------
@@ -143,7 +510,22 @@ Car& City::addCar(const char* model, Road const& road, TrafficSide const side,
                   double const offset_lat, MeterPerSecond const speed)
 {
     return addCar(model, road.offset(side, lane, offset_long, offset_lat),
-                  road.heading(side), speed);
+                  road.heading(side, lane, offset_long), speed);
+}
+
+//------------------------------------------------------------------------------
+Car& City::addAgent(const char* model, Road const& road, TrafficSide const side,
+                    size_t const lane, double const offset_long,
+                    MeterPerSecond const speed)
+{
+    char name[16];
+    snprintf(name, 16, "agent%zu", m_agent_id++);
+
+    Car& car = createCar(CarGroup::Agent, model, name, CAR_COLOR, 0.0_mps_sq,
+                         speed, road.offset(side, lane, offset_long, 0.5),
+                         road.heading(side, lane, offset_long), 0.0_rad);
+    locate(car);
+    return car;
 }
 
 //------------------------------------------------------------------------------
@@ -152,9 +534,23 @@ Car& City::addCar(const char* model, Parking& parking)
     Car& car = addCar(model, sf::Vector2<Meter>(0.0_m, 0.0_m), 0.0_deg,
                       0.0_mps, 0.0_deg);
     parking.bind(car);
+    locate(car);
+    sleep(m_cars.handle(car));
     return car;
 }
 
+//------------------------------------------------------------------------------
+size_t City::addPedestrian(std::vector<sf::Vector2<Meter>> const& path,
+                           MeterPerSecond const speed)
+{
+    char name[24];
+    snprintf(name, 24, "pedestrian%zu", m_pedestrian_id++);
+
+    LOGI("Add pedestrian '%s': %zu waypoints, speed %g m/s", name, path.size(),
+         speed.value());
+    return m_crowd.add(name, path, speed);
+}
+
 //------------------------------------------------------------------------------
 Car& City::addGhost(const char* model, sf::Vector2<Meter> const& position,
                     Radian const heading, Radian const steering)
@@ -165,7 +561,6 @@ Car& City::addGhost(const char* model, sf::Vector2<Meter> const& position,
     LOGI("Add ghost car '%s': position (%g m, %g m), heading %g deg",
          name, position.x, position.y, Degree(heading));
 
-    m_ghosts.push_back(createCar<Car>(model, name, sf::Color::White, 0.0_mps_sq,
-                                      0.0_mps, position, heading, steering));
-    return *m_ghosts.back();
+    return createCar(CarGroup::Ghost, model, name, sf::Color::White, 0.0_mps_sq,
+                     0.0_mps, position, heading, steering);
 }
@@ -23,9 +23,13 @@
 #  define CITY_HPP
 
 // #  include "City/Drivers.hpp" FIXME TBD
+#  include "Common/Registry.hpp"
 #  include "Common/SpatialHashGrid.hpp"
 #  include "City/Parking.hpp"
 #  include "City/Road.hpp"
+#  include "City/RoadGraph.hpp"
+#  include "City/Terrain.hpp"
+#  include "City/Tiles.hpp"
 #  include "City/Pedestrian.hpp"
 #  include "Vehicle/Vehicles.hpp"
 
@@ -43,6 +47,27 @@
 // ****************************************************************************
 class City
 {
+    //! \brief Exports and loads roads, parkings and their indices.
+    friend class CityFile;
+
+public:
+
+    // *************************************************************************
+    //! \brief Kind of cars held by the city (bits, see Registry): scripted
+    //! cars, autonomous cars, debug cars not interacting with the city,
+    //! background traffic cars driven by the Traffic class and sleeping cars
+    //! (parked or idle scripted cars) which are no longer simulated.
+    // *************************************************************************
+    enum CarGroup : uint8_t { Traffic = 1, Ego = 2, Ghost = 4, Agent = 8, Static = 16 };
+
+    //! \brief Cars which can be hit or detected by other cars.
+    static constexpr uint8_t COLLIDABLES = CarGroup::Traffic | CarGroup::Agent | CarGroup::Static;
+
+    //! \brief Container of cars.
+    using Cars = Registry<Car>;
+    //! \brief Reference on a car which does not dangle when the car is removed.
+    using CarHandle = Cars::Handle;
+
 public:
 
     City(/*TrafficSide const side*/);
@@ -53,9 +78,27 @@ public:
     //-------------------------------------------------------------------------
     void reset();
 
+    //-------------------------------------------------------------------------
+    //! \brief Add a road passing through the given centers (straight lines or
+    //! cubic spline).
+    //-------------------------------------------------------------------------
     Road& addRoad(std::vector<sf::Vector2<Meter>> const& centers,
+                  Meter const width, std::array<size_t, TrafficSide::Max> lanes,
+                  Road::Curve const curve = Road::Curve::Polyline);
+
+    //-------------------------------------------------------------------------
+    //! \brief Add a road made of consecutive clothoids (lines, arcs, spirals).
+    //-------------------------------------------------------------------------
+    Road& addRoad(sf::Vector2<Meter> const& start, Radian const heading,
+                  std::vector<math::Clothoid> const& segments,
                   Meter const width, std::array<size_t, TrafficSide::Max> lanes);
 
+    //-------------------------------------------------------------------------
+    //! \brief Add a road built beforehand (i.e. by the worker threads of the
+    //! map importer). Not logged.
+    //-------------------------------------------------------------------------
+    Road& addRoad(std::unique_ptr<Road> road);
+
     //-------------------------------------------------------------------------
     //! \brief Add a parking slot in the world at the given position. The
     //! parking instance is hold by the simulation instance.
@@ -178,9 +221,27 @@ public:
                 size_t const lane, double const offset_long, double const offset_lat,
                 MeterPerSecond const speed = 0.0_mps);
 
+    //-------------------------------------------------------------------------
+    //! \brief Add a background traffic car placed on a road. Contrary to cars
+    //! added by addCar(), its physics is not simulated: it is driven along
+    //! lanes by the Traffic class (see Traffic::spawn()).
+    //! \param[in] model: non NULL string of the mark of the vehicle for its
+    //! dimension.
+    //! \param[in] road: the road reference.
+    //! \param[in] side: traffic side.
+    //! \param[in] lane: the lane index.
+    //! \param[in] offset_long: [0 .. 1] position along the lane.
+    //! \param[in] speed: initial longitudinal speed (m/s).
+    //! \return the reference of the created vehicle.
+    //-------------------------------------------------------------------------
+    Car& addAgent(const char* model, Road const& road, TrafficSide const side,
+                  size_t const lane, double const offset_long,
+                  MeterPerSecond const speed);
+
     //-------------------------------------------------------------------------
     //! \brief Create a parked car. The car instance is hold by the simulation
-    //! instance.
+    //! instance. The car is sleeping (see sleep()) until it is hit or woken
+    //! by the scenario.
     //! \param[in] model: non NULL string of the mark of the vehicle for its
     //! dimension.
     //! \param[in] parking: the reference of the parking slot in which the car
@@ -204,35 +265,118 @@ public:
     //! \return the reference of the created vehicle.
     //-------------------------------------------------------------------------
     Car& addGhost(const char* model, sf::Vector2<Meter> const& position, Radian const heading,
-                  Radian const steering); // FIXME stored in m_cars or m_ghosts or move it simulator
+                  Radian const steering); // FIXME move it simulator
+
+    //-------------------------------------------------------------------------
+    //! \brief Create a pedestrian walking along the given path (i.e. along
+    //! sidewalks and crossings).
+    //! \param[in] path: waypoints in world coordinates, the first one is the
+    //! initial position.
+    //! \param[in] speed: desired walking speed.
+    //! \return the index of the created pedestrian in crowd().pedestrians().
+    //-------------------------------------------------------------------------
+    size_t addPedestrian(std::vector<sf::Vector2<Meter>> const& path,
+                         MeterPerSecond const speed);
+
+    //-------------------------------------------------------------------------
+    //! \brief Remove a car (ego, traffic or ghost car) from the city. Handles
+    //! on it become invalid, lanes and parkings no longer refer to it.
+    //! \return false if the car was already removed.
+    //-------------------------------------------------------------------------
+    bool removeCar(CarHandle const handle);
 
     //-------------------------------------------------------------------------
     //! \brief Find and return the address of the desired car from its name.
-    //! return nullptr in case if not found.
+    //! return nullptr in case if not found. O(1) in average.
     //-------------------------------------------------------------------------
     Car* get(const char* name);
 
     //-------------------------------------------------------------------------
-    //! \brief Return the list of vehicles.
+    //! \brief Return the car referred by the handle or nullptr if it has been
+    //! removed. O(1).
+    //-------------------------------------------------------------------------
+    inline Car* get(CarHandle const handle) const
+    {
+        return m_cars.get(handle);
+    }
+
+    //-------------------------------------------------------------------------
+    //! \brief Return the handle on a car held by the city. O(1).
     //-------------------------------------------------------------------------
-    std::vector<std::unique_ptr<Car>>& cars()
+    inline CarHandle handle(Car const& car) const
     {
-        return m_cars;
+        return m_cars.handle(car);
     }
 
-    std::vector<std::unique_ptr<Car>> const& cars() const
+    //-------------------------------------------------------------------------
+    //! \brief Return the list of vehicles. By default scripted, background
+    //! traffic and sleeping cars (ego and ghost cars excluded).
+    //! \param[in] groups: bitwise or of CarGroup.
+    //-------------------------------------------------------------------------
+    inline Cars::Entities cars(uint8_t const groups = COLLIDABLES)
+    {
+        return m_cars.entities(groups);
+    }
+
+    inline Cars::ConstEntities cars(uint8_t const groups = COLLIDABLES) const
     {
-        return m_cars;
+        return m_cars.entities(groups);
     }
 
-    std::vector<std::unique_ptr<Car>> const& ghosts() const
+    inline Cars::ConstEntities ghosts() const
     {
-        return m_ghosts;
+        return m_cars.entities(CarGroup::Ghost);
     }
 
-    std::unique_ptr<Car> const& ego() const
+    //-------------------------------------------------------------------------
+    //! \brief Put a scripted car to sleep: it is no longer updated by the
+    //! simulation, its lane occupancy is frozen and sensors find it through
+    //! the static broad phase (see statics()). Use it for cars at rest.
+    //! \return false if the car does not exist or is not a scripted car.
+    //-------------------------------------------------------------------------
+    bool sleep(CarHandle const handle);
+
+    //-------------------------------------------------------------------------
+    //! \brief Wake up a sleeping car (i.e. when hit or when the scenario makes
+    //! it drive again): it is simulated again as a scripted car.
+    //! \return false if the car does not exist or is not sleeping.
+    //-------------------------------------------------------------------------
+    bool wake(CarHandle const handle);
+
+    //-------------------------------------------------------------------------
+    //! \brief Is the car sleeping ?
+    //-------------------------------------------------------------------------
+    inline bool sleeping(Car const& car) const
     {
-        return m_ego;
+        return m_cars.group(m_cars.handle(car)) == CarGroup::Static;
+    }
+
+    //-------------------------------------------------------------------------
+    //! \brief Return the sleeping cars whose bounding box may overlap the given
+    //! world area (i.e. the bounding box of a sensor). The grid holding them is
+    //! only built again when cars fall asleep or are woken.
+    //-------------------------------------------------------------------------
+    void statics(sf::FloatRect const& area, std::vector<Car const*>& result) const;
+
+    //-------------------------------------------------------------------------
+    //! \brief Return the pedestrians.
+    //-------------------------------------------------------------------------
+    inline Crowd& crowd()
+    {
+        return m_crowd;
+    }
+
+    inline Crowd const& crowd() const
+    {
+        return m_crowd;
+    }
+
+    //-------------------------------------------------------------------------
+    //! \brief Return the ego car or nullptr if not created.
+    //-------------------------------------------------------------------------
+    inline Car* ego() const
+    {
+        return m_cars.get(m_ego);
     }
 
     //-------------------------------------------------------------------------
@@ -243,6 +387,14 @@ public:
         return m_parkings;
     }
 
+    //-------------------------------------------------------------------------
+    //! \brief Return the list of parkings.
+    //-------------------------------------------------------------------------
+    std::vector<std::unique_ptr<Parking>> const& parkings() const
+    {
+        return m_parkings;
+    }
+
     //-------------------------------------------------------------------------
     //! \brief Return the list of parkings.
     //-------------------------------------------------------------------------
@@ -252,13 +404,90 @@ public:
     }
 
     //-------------------------------------------------------------------------
-    //! \brief Return the altitude at the given coordinates. TODO
+    //! \brief Return the lane-level graph of roads for routing cars. The graph
+    //! is built on the first call after roads have been added, so all cars
+    //! share the same preprocessing.
+    //! \param[in] contracted: also compute the contraction hierarchy (slow on
+    //! large cities) for faster routes. Callers only walking the edges of the
+    //! road network (i.e. during simulation ticks) shall pass false.
+    //-------------------------------------------------------------------------
+    RoadGraph const& graph(bool const contracted = true);
+
+    //-------------------------------------------------------------------------
+    //! \brief Update the occupancy of lanes once cars have moved. Shall be
+    //! called at each tick of the simulation. Cars inside frozen tiles are
+    //! skipped.
+    //-------------------------------------------------------------------------
+    void updateLanes();
+
+    //-------------------------------------------------------------------------
+    //! \brief Activate the tiles of the world around the given points of
+    //! interest (egos, camera): only cars inside active tiles are simulated.
+    //! By default, all tiles are active.
+    //-------------------------------------------------------------------------
+    inline void activate(std::vector<sf::Vector2<Meter>> const& centers, Meter const radius)
+    {
+        m_tiles.activate(centers, radius);
+    }
+
+    //-------------------------------------------------------------------------
+    //! \brief Is the given position inside an active tile ?
+    //-------------------------------------------------------------------------
+    inline bool active(sf::Vector2<Meter> const& position) const
+    {
+        return m_tiles.active(position);
+    }
+
+    //-------------------------------------------------------------------------
+    //! \brief Return the partition of the world into tiles.
+    //-------------------------------------------------------------------------
+    inline Tiles const& tiles() const
+    {
+        return m_tiles;
+    }
+
+    //-------------------------------------------------------------------------
+    //! \brief Move pedestrians, avoiding cars. Shall be called at each tick of
+    //! the simulation.
+    //-------------------------------------------------------------------------
+    void updatePedestrians(Second const dt);
+
+    //-------------------------------------------------------------------------
+    //! \brief Return the lane holding the car or nullptr if the car is outside
+    //! lanes (i.e. parked).
+    //-------------------------------------------------------------------------
+    Lane* lane(Car const& car) const;
+
+    //-------------------------------------------------------------------------
+    //! \brief Return the altitude of the ground at the given coordinates (0
+    //! when the terrain has no heightmap).
+    //-------------------------------------------------------------------------
+    inline Meter altitude(sf::Vector2<Meter> const& position) const
+    {
+        return m_terrain.altitude(position);
+    }
+
+    //-------------------------------------------------------------------------
+    //! \brief Return the elevation of the ground, to load a heightmap.
     //-------------------------------------------------------------------------
-    Meter altitude(sf::Vector2f const& position)
+    inline Terrain& terrain()
+    {
+        return m_terrain;
+    }
+
+    inline Terrain const& terrain() const
     {
-        return 0.0_m; // Not implemented yet
+        return m_terrain;
     }
 
+    //-------------------------------------------------------------------------
+    //! \brief Give to the physics of moving cars inside active tiles the
+    //! slope of the ground under their wheels. The altitudes of all wheels
+    //! are queried in a single batch. Does nothing on a flat terrain. Shall
+    //! be called at each tick of the simulation, before updating cars.
+    //-------------------------------------------------------------------------
+    void updateSlopes();
+
     //-------------------------------------------------------------------------
     //! \brief Return ref const to the hash grid.
     //-------------------------------------------------------------------------
@@ -270,11 +499,11 @@ public:
 protected:
 
     //-------------------------------------------------------------------------
-    //! \brief Create or replace the ego vehicle (the autonomous vehicle). The
-    //! instance is hold by the simulation instance.
-    //! \note: Only one ego vehicle is managed for the moment.
+    //! \brief Create a vehicle inside the container of cars.
+    //! \param[in] group: ego, traffic or ghost car.
     //! \param[in] model: non NULL string of the mark of the vehicle for its
     //! dimension.
+    //! \param[in] name: unique name of the vehicle.
     //! \param[in] position: the position of the middle of the rear axle inside
     //! the world coordinates.
     //! \param[in] heading: the vehicle direction (yaw angle) in rad.
@@ -282,41 +511,103 @@ protected:
     //! \param[in] steering: initial steering angle (in rad). By default: 0
     //! rad.
     //! \return the reference of the created vehicle.
+    //! \throw std::runtime_error if the name is already used.
     //-------------------------------------------------------------------------
-    template<class CAR>
-    std::unique_ptr<CAR> createCar(const char* model, const char* name, sf::Color color,
-                                   MeterPerSecondSquared const acceleration, MeterPerSecond const speed,
-                                   sf::Vector2<Meter> const& position, Radian const heading,
-                                   Radian const steering)
+    Car& createCar(CarGroup const group, const char* model, const char* name,
+                   sf::Color color, MeterPerSecondSquared const acceleration,
+                   MeterPerSecond const speed, sf::Vector2<Meter> const& position,
+                   Radian const heading, Radian const steering);
+
+protected:
+
+    // *************************************************************************
+    //! \brief Where a car has been found the last time lanes were updated.
+    // *************************************************************************
+    struct Location
     {
-        std::unique_ptr<CAR> car = std::make_unique<CAR>(model, color);
-        car->name = name;
-        car->init(acceleration, speed, position, heading, steering);
-        return car;
-    }
+        //! \brief The lane holding the car (nullptr if none).
+        Lane* lane;
+        //! \brief Curvilinear abscissa of the car in the lane.
+        Meter s;
+        //! \brief World position of the car when its lane has been looked for.
+        sf::Vector2<Meter> position;
+        //! \brief Segment of the lane holding the car (warm start of Frenet
+        //! conversions).
+        size_t segment;
+    };
+
+    //-------------------------------------------------------------------------
+    //! \brief Update the occupancy of the lanes by the given car.
+    //-------------------------------------------------------------------------
+    void locate(Car& car);
+
+    //-------------------------------------------------------------------------
+    //! \brief Remove the car from the occupancy of lanes.
+    //-------------------------------------------------------------------------
+    void unlocate(Car const& car);
+
+    //-------------------------------------------------------------------------
+    //! \brief Insert sleeping cars in the static grid if they have changed.
+    //-------------------------------------------------------------------------
+    void index() const;
+
+    //-------------------------------------------------------------------------
+    //! \brief Find the lane holding the given position. Neighbors of the
+    //! previous lane (next lanes, adjacent lanes) are checked first.
+    //-------------------------------------------------------------------------
+    Lane* findLane(sf::Vector2<Meter> const& position, Lane const* previous);
 
 protected:
 
     //! \brief
     //SpatialHashGrid m_grid; FIXME https://github.com/Lecrapouille/Highway/issues/23
-    //! \brief Container of cars
-    std::vector<std::unique_ptr<Car>> m_cars; // FIXME weak_ptr
-    //! \brief Container of purely displayed cars
-    std::vector<std::unique_ptr<Car>> m_ghosts;
+    //! \brief Container of ego, traffic and purely displayed (ghost) cars.
+    Cars m_cars;
     //! \brief The autonomous cars (TODO for the moment only one is managed)
-    std::unique_ptr<Car> m_ego = nullptr;
+    CarHandle m_ego;
     //! \brief Container of roads
-    std::vector<std::unique_ptr<Road>> m_roads; // FIXME: graph<Road, Carrefour> or Lanes https://github.com/Lecrapouille/Highway/issues/24
+    std::vector<std::unique_ptr<Road>> m_roads;
+    //! \brief Graph of lanes for routing cars.
+    RoadGraph m_graph;
+    //! \brief Shall m_graph be rebuilt ?
+    bool m_graph_outdated = true;
+    //! \brief Lanes holding cars.
+    std::unordered_map<Car const*, Location> m_locations;
     //! \brief Container of parking slots
     std::vector<std::unique_ptr<Parking>> m_parkings; // FIXME non pointers
-    // TODO roads and bounding boxes of static objects, pedestrians
+    //! \brief Pedestrians.
+    Crowd m_crowd;
+    //! \brief Roads and parkings per tile of the world.
+    Tiles m_tiles;
+    //! \brief Elevation of the ground.
+    Terrain m_terrain;
+    //! \brief Wheels of cars given to updateSlopes() (avoid allocations).
+    std::vector<sf::Vector2<Meter>> m_wheels;
+    //! \brief Altitudes of m_wheels.
+    std::vector<Meter> m_wheel_altitudes;
+    //! \brief Cars owning m_wheels.
+    std::vector<Car*> m_sloped_cars;
+    //! \brief Broad phase of sleeping cars. Mutable since queries of sensors
+    //! are made on a const city and reindex lazily.
+    mutable SpatialHashGrid m_statics{ sf::FloatRect(0.0f, 0.0f, 1.0f, 1.0f), { 1u, 1u } };
+    //! \brief Items of sleeping cars in the grid.
+    mutable std::vector<SpatialHashGrid::Item> m_static_items;
+    //! \brief Sleeping cars referred by items.
+    mutable std::vector<Car const*> m_static_cars;
+    //! \brief Neighbours queries (avoid allocations).
+    mutable std::vector<SpatialHashGrid::Item*> m_static_found;
+    //! \brief Shall sleeping cars be inserted again in the grid ?
+    mutable bool m_statics_outdated = true;
+    // TODO roads and bounding boxes of static objects
     // TODO grid to detect collisions and detect objects around
 
 private:
 
     size_t m_car_id = 0u;
+    size_t m_agent_id = 0u;
     size_t m_ego_id = 0u;
     size_t m_ghost_id = 0u;
+    size_t m_pedestrian_id = 0u;
 };
 
 #endif
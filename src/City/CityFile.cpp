@@ -0,0 +1,522 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "City/CityFile.hpp"
+#include "City/City.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr char MAGIC[4] = { 'H', 'W', 'C', 'F' };
+static constexpr uint32_t ENDIANNESS = 0x01020304u;
+//! \brief Alignment of tables [byte].
+static constexpr size_t ALIGNMENT = 8u;
+
+static_assert(sizeof(CityFile::Header) % ALIGNMENT == 0u, "Unaligned header");
+static_assert(sizeof(CityFile::Road) == 16u, "Unexpected padding");
+static_assert(sizeof(CityFile::Parking) == 24u, "Unexpected padding");
+static_assert(sizeof(CityFile::Vertex) == 16u, "Unexpected padding");
+static_assert(sizeof(CityFile::Edge) == 12u, "Unexpected padding");
+static_assert(sizeof(CityFile::Shortcut) == 16u, "Unexpected padding");
+static_assert(sizeof(CityFile::Tile) == 24u, "Unexpected padding");
+
+//------------------------------------------------------------------------------
+//! \brief Append the records of a table to the buffer of the file.
+//------------------------------------------------------------------------------
+template<class T>
+static void append(std::vector<uint8_t>& buffer, CityFile::Section& section,
+                   std::vector<T> const& records)
+{
+    buffer.resize((buffer.size() + ALIGNMENT - 1u) / ALIGNMENT * ALIGNMENT, 0u);
+    section.offset = buffer.size();
+    section.count = records.size();
+    uint8_t const* data = reinterpret_cast<uint8_t const*>(records.data());
+    buffer.insert(buffer.end(), data, data + records.size() * sizeof(T));
+}
+
+//------------------------------------------------------------------------------
+//! \brief Convert offsets of compressed rows.
+//------------------------------------------------------------------------------
+static std::vector<uint32_t> offsets(std::vector<size_t> const& values)
+{
+    return std::vector<uint32_t>(values.begin(), values.end());
+}
+
+//------------------------------------------------------------------------------
+//! \brief Convert edges of the road graph.
+//------------------------------------------------------------------------------
+static std::vector<CityFile::Edge> edges(std::vector<RoadGraph::Edge> const& values)
+{
+    std::vector<CityFile::Edge> records;
+    records.reserve(values.size());
+    for (RoadGraph::Edge const& e: values)
+    {
+        records.push_back({ e.to, e.cost, e.middle });
+    }
+    return records;
+}
+
+//------------------------------------------------------------------------------
+bool CityFile::save(City& city, std::string const& path)
+{
+    RoadGraph const& graph = city.graph();
+    auto const& roads = city.m_roads;
+    auto const& parkings = city.m_parkings;
+
+    // Stored positions are relative to the corner of the city.
+    double x0 = std::numeric_limits<double>::max();
+    double y0 = std::numeric_limits<double>::max();
+    for (auto const& road: roads)
+    {
+        for (sf::Vector2<Meter> const& p: road->centers())
+        {
+            x0 = std::min(x0, p.x.value());
+            y0 = std::min(y0, p.y.value());
+        }
+    }
+    for (auto const& parking: parkings)
+    {
+        x0 = std::min(x0, parking->position().x.value());
+        y0 = std::min(y0, parking->position().y.value());
+    }
+    if (x0 == std::numeric_limits<double>::max())
+    {
+        x0 = y0 = 0.0;
+    }
+    auto point = [x0, y0](sf::Vector2<Meter> const& p)
+    {
+        return Point{ float(p.x.value() - x0), float(p.y.value() - y0) };
+    };
+
+    // Roads and the lanes they hold.
+    std::vector<Road> road_records;
+    std::vector<Point> centers;
+    std::unordered_map<::Road const*, uint32_t> road_ids;
+    std::unordered_map<Lane const*, Vertex> lanes;
+    for (auto const& road: roads)
+    {
+        uint32_t const id = uint32_t(road_records.size());
+        road_ids[road.get()] = id;
+        road_records.push_back({ uint32_t(centers.size()), uint32_t(road->centers().size()),
+                float(road->width().value()),
+                { uint8_t(road->m_lanes[0].size()), uint8_t(road->m_lanes[1].size()) }, 0u });
+        for (sf::Vector2<Meter> const& p: road->centers())
+        {
+            centers.push_back(point(p));
+        }
+        for (uint8_t side = 0u; side < TrafficSide::Max; ++side)
+        {
+            for (size_t i = 0u; i < road->m_lanes[side].size(); ++i)
+            {
+                lanes[road->m_lanes[side][i].get()] = { {}, id, side, uint8_t(i), 0u };
+            }
+        }
+    }
+
+    // Parkings.
+    std::vector<Parking> parking_records;
+    std::unordered_map<::Parking const*, uint32_t> parking_ids;
+    for (auto const& parking: parkings)
+    {
+        parking_ids[parking.get()] = uint32_t(parking_records.size());
+        parking_records.push_back({ point(parking->position()), float(parking->heading().value()),
+                float(parking->blueprint.length.value()), float(parking->blueprint.width.value()),
+                float(parking->blueprint.angle.value()) });
+    }
+
+    // Road graph and its contraction hierarchy.
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> edge_offsets(1u, 0u);
+    std::vector<Edge> edge_records;
+    for (RoadGraph::Id v = 0u; v < graph.size(); ++v)
+    {
+        Vertex vertex = { point(graph.position(v)), NONE, 0u, 0u, 0u };
+        if (Lane const* lane = graph.lane(v))
+        {
+            Vertex const& location = lanes.at(lane);
+            vertex.road = location.road;
+            vertex.side = location.side;
+            vertex.lane = location.lane;
+        }
+        vertices.push_back(vertex);
+        std::vector<Edge> const e = edges(graph.edges(v));
+        edge_records.insert(edge_records.end(), e.begin(), e.end());
+        edge_offsets.push_back(uint32_t(edge_records.size()));
+    }
+    std::vector<Shortcut> shortcuts;
+    for (auto const& it: graph.m_shortcuts)
+    {
+        shortcuts.push_back({ it.first, it.second, 0u });
+    }
+    std::sort(shortcuts.begin(), shortcuts.end(), [](Shortcut const& a, Shortcut const& b)
+    {
+        return a.key < b.key;
+    });
+
+    // Partition of the world (sorted for reproducible files: the tiles are
+    // held by a hash table).
+    std::vector<::Tiles::Key> keys;
+    keys.reserve(city.m_tiles.tiles().size());
+    for (auto const& it: city.m_tiles.tiles())
+    {
+        keys.push_back(it.first);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<Tile> tile_records;
+    std::vector<uint32_t> tile_roads, tile_parkings;
+    for (::Tiles::Key const key: keys)
+    {
+        auto const& entry = city.m_tiles.tiles().at(key);
+        Tile tile = { key, uint32_t(tile_roads.size()), uint32_t(entry.roads.size()),
+                      uint32_t(tile_parkings.size()), uint32_t(entry.parkings.size()) };
+        for (::Road const* road: entry.roads)
+        {
+            tile_roads.push_back(road_ids.at(road));
+        }
+        for (::Parking const* parking: entry.parkings)
+        {
+            tile_parkings.push_back(parking_ids.at(parking));
+        }
+        tile_records.push_back(tile);
+    }
+
+    // Header then tables.
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.endianness = ENDIANNESS;
+    header.tile_size = float(city.m_tiles.size().value());
+    header.origin[0] = x0;
+    header.origin[1] = y0;
+
+    std::vector<uint8_t> buffer(sizeof(Header), 0u);
+    append(buffer, header.sections[Table::Roads], road_records);
+    append(buffer, header.sections[Table::Centers], centers);
+    append(buffer, header.sections[Table::Parkings], parking_records);
+    append(buffer, header.sections[Table::Vertices], vertices);
+    append(buffer, header.sections[Table::EdgeOffsets], edge_offsets);
+    append(buffer, header.sections[Table::Edges], edge_records);
+    append(buffer, header.sections[Table::Ranks], graph.m_ranks);
+    append(buffer, header.sections[Table::UpwardOffsets], offsets(graph.m_upward_offsets));
+    append(buffer, header.sections[Table::Upward], edges(graph.m_upward));
+    append(buffer, header.sections[Table::DownwardOffsets], offsets(graph.m_downward_offsets));
+    append(buffer, header.sections[Table::Downward], edges(graph.m_downward));
+    append(buffer, header.sections[Table::Shortcuts], shortcuts);
+    append(buffer, header.sections[Table::Tiles], tile_records);
+    append(buffer, header.sections[Table::TileRoads], tile_roads);
+    append(buffer, header.sections[Table::TileParkings], tile_parkings);
+    std::memcpy(buffer.data(), &header, sizeof(header));
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.write(reinterpret_cast<char const*>(buffer.data()), std::streamsize(buffer.size())))
+    {
+        LOGE("Failed writing the city file '%s'", path.c_str());
+        return false;
+    }
+
+    LOGI("Saved city '%s': %zu roads, %zu parkings, %zu bytes", path.c_str(),
+         road_records.size(), parking_records.size(), buffer.size());
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool CityFile::open(std::string const& path)
+{
+    close();
+
+    int const fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        LOGE("Failed opening the city file '%s'", path.c_str());
+        return false;
+    }
+
+    struct stat st;
+    if ((::fstat(fd, &st) != 0) || (size_t(st.st_size) < sizeof(Header)))
+    {
+        LOGE("Invalid city file '%s'", path.c_str());
+        ::close(fd);
+        return false;
+    }
+
+    // The mapping stays valid once the file descriptor is closed.
+    void* data = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        LOGE("Failed mapping the city file '%s'", path.c_str());
+        return false;
+    }
+
+    m_data = static_cast<uint8_t const*>(data);
+    m_size = size_t(st.st_size);
+    if (!check())
+    {
+        LOGE("Corrupted or obsolete city file '%s'", path.c_str());
+        close();
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void CityFile::close()
+{
+    if (m_data != nullptr)
+    {
+        ::munmap(const_cast<uint8_t*>(m_data), m_size);
+        m_data = nullptr;
+        m_size = 0u;
+    }
+}
+
+//------------------------------------------------------------------------------
+//! \brief Check that compressed rows are sorted and refer to existing records.
+//------------------------------------------------------------------------------
+static bool rows(uint32_t const* offsets, size_t const count, size_t const records)
+{
+    for (size_t i = 1u; i < count; ++i)
+    {
+        if (offsets[i] < offsets[i - 1u])
+            return false;
+    }
+    return (count == 0u) || (offsets[count - 1u] <= records);
+}
+
+//------------------------------------------------------------------------------
+//! \brief Check that edges go to existing vertices.
+//------------------------------------------------------------------------------
+static bool targets(CityFile::Edge const* edges, size_t const count, size_t const vertices)
+{
+    for (size_t i = 0u; i < count; ++i)
+    {
+        if ((edges[i].to >= vertices) ||
+            ((edges[i].middle != CityFile::NONE) && (edges[i].middle >= vertices)))
+            return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool CityFile::check() const
+{
+    static size_t const SIZES[TABLES] = {
+        sizeof(Road), sizeof(Point), sizeof(Parking), sizeof(Vertex),
+        sizeof(uint32_t), sizeof(Edge), sizeof(uint32_t), sizeof(uint32_t),
+        sizeof(Edge), sizeof(uint32_t), sizeof(Edge), sizeof(Shortcut),
+        sizeof(Tile), sizeof(uint32_t), sizeof(uint32_t)
+    };
+
+    Header const& h = header();
+    if ((std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0) ||
+        (h.version != VERSION) || (h.endianness != ENDIANNESS) ||
+        !(h.tile_size > 0.0f))
+        return false;
+
+    for (size_t t = 0u; t < TABLES; ++t)
+    {
+        Section const& s = h.sections[t];
+        if ((s.offset % ALIGNMENT != 0u) || (s.offset < sizeof(Header)) ||
+            (s.offset > m_size) || (s.count > (m_size - s.offset) / SIZES[t]))
+            return false;
+    }
+
+    // Roads
+    size_t const roads = count(Table::Roads);
+    Road const* road = table<Road>(Table::Roads);
+    for (size_t i = 0u; i < roads; ++i)
+    {
+        if ((road[i].count < 2u) || (road[i].first > count(Table::Centers)) ||
+            (road[i].count > count(Table::Centers) - road[i].first))
+            return false;
+    }
+
+    // Road graph
+    size_t const vertices = count(Table::Vertices);
+    Vertex const* vertex = table<Vertex>(Table::Vertices);
+    for (size_t i = 0u; i < vertices; ++i)
+    {
+        if ((vertex[i].road != NONE) && ((vertex[i].road >= roads) ||
+            (vertex[i].side >= TrafficSide::Max) ||
+            (vertex[i].lane >= road[vertex[i].road].lanes[vertex[i].side])))
+            return false;
+    }
+    if ((count(Table::EdgeOffsets) != vertices + 1u) ||
+        !rows(table<uint32_t>(Table::EdgeOffsets), count(Table::EdgeOffsets), count(Table::Edges)) ||
+        !targets(table<Edge>(Table::Edges), count(Table::Edges), vertices))
+        return false;
+    if (count(Table::Ranks) != 0u)
+    {
+        uint32_t const* ranks = table<uint32_t>(Table::Ranks);
+        if ((count(Table::Ranks) != vertices) ||
+            (count(Table::UpwardOffsets) != vertices + 1u) ||
+            (count(Table::DownwardOffsets) != vertices + 1u) ||
+            !std::all_of(ranks, ranks + vertices, [vertices](uint32_t r) { return r < vertices; }) ||
+            !rows(table<uint32_t>(Table::UpwardOffsets), count(Table::UpwardOffsets), count(Table::Upward)) ||
+            !rows(table<uint32_t>(Table::DownwardOffsets), count(Table::DownwardOffsets), count(Table::Downward)) ||
+            !targets(table<Edge>(Table::Upward), count(Table::Upward), vertices) ||
+            !targets(table<Edge>(Table::Downward), count(Table::Downward), vertices))
+            return false;
+    }
+
+    // Tiles
+    size_t const parkings = count(Table::Parkings);
+    Tile const* tile = table<Tile>(Table::Tiles);
+    for (size_t i = 0u; i < count(Table::Tiles); ++i)
+    {
+        if ((tile[i].first_road > count(Table::TileRoads)) ||
+            (tile[i].roads > count(Table::TileRoads) - tile[i].first_road) ||
+            (tile[i].first_parking > count(Table::TileParkings)) ||
+            (tile[i].parkings > count(Table::TileParkings) - tile[i].first_parking))
+            return false;
+    }
+    uint32_t const* ids = table<uint32_t>(Table::TileRoads);
+    if (!std::all_of(ids, ids + count(Table::TileRoads), [roads](uint32_t id) { return id < roads; }))
+        return false;
+    ids = table<uint32_t>(Table::TileParkings);
+    return std::all_of(ids, ids + count(Table::TileParkings), [parkings](uint32_t id) { return id < parkings; });
+}
+
+//------------------------------------------------------------------------------
+bool CityFile::load(City& city) const
+{
+    if (!opened() || !city.m_roads.empty())
+        return false;
+
+    Header const& h = header();
+    auto position = [&h](Point const& p)
+    {
+        return sf::Vector2<Meter>(Meter(double(p.x) + h.origin[0]), Meter(double(p.y) + h.origin[1]));
+    };
+
+    // Roads: lanes are built from the sampled center line.
+    size_t const roads = count(Table::Roads);
+    Road const* road = table<Road>(Table::Roads);
+    Point const* centers = table<Point>(Table::Centers);
+    std::vector<sf::Vector2<Meter>> line;
+    city.m_roads.reserve(roads);
+    for (size_t i = 0u; i < roads; ++i)
+    {
+        line.clear();
+        for (uint32_t j = 0u; j < road[i].count; ++j)
+        {
+            line.push_back(position(centers[road[i].first + j]));
+        }
+        city.m_roads.push_back(std::make_unique<::Road>(
+            line, Meter(road[i].width),
+            std::array<size_t, TrafficSide::Max>{ road[i].lanes[0], road[i].lanes[1] }));
+    }
+
+    // Parkings
+    size_t const parkings = count(Table::Parkings);
+    Parking const* parking = table<Parking>(Table::Parkings);
+    size_t const first_parking = city.m_parkings.size();
+    for (size_t i = 0u; i < parkings; ++i)
+    {
+        city.m_parkings.push_back(std::make_unique<::Parking>(
+            ParkingBluePrint(Meter(parking[i].length), Meter(parking[i].width),
+                             Degree(parking[i].angle)),
+            position(parking[i].position), Radian(parking[i].heading)));
+    }
+
+    // Partition of the world: reuse it when tiles have the same size.
+    if (city.m_tiles.size() == Meter(h.tile_size))
+    {
+        Tile const* tile = table<Tile>(Table::Tiles);
+        uint32_t const* tile_roads = table<uint32_t>(Table::TileRoads);
+        uint32_t const* tile_parkings = table<uint32_t>(Table::TileParkings);
+        for (size_t i = 0u; i < count(Table::Tiles); ++i)
+        {
+            for (uint32_t j = 0u; j < tile[i].roads; ++j)
+            {
+                city.m_tiles.insert(tile[i].key, *city.m_roads[tile_roads[tile[i].first_road + j]]);
+            }
+            for (uint32_t j = 0u; j < tile[i].parkings; ++j)
+            {
+                city.m_tiles.insert(tile[i].key,
+                    *city.m_parkings[first_parking + tile_parkings[tile[i].first_parking + j]]);
+            }
+        }
+    }
+    else
+    {
+        for (auto const& it: city.m_roads)
+        {
+            city.m_tiles.insert(*it);
+        }
+        for (size_t i = first_parking; i < city.m_parkings.size(); ++i)
+        {
+            city.m_tiles.insert(*city.m_parkings[i]);
+        }
+    }
+
+    // Road graph and its contraction hierarchy.
+    RoadGraph& graph = city.m_graph;
+    graph.clear();
+    Vertex const* vertex = table<Vertex>(Table::Vertices);
+    uint32_t const* edge_offsets = table<uint32_t>(Table::EdgeOffsets);
+    Edge const* edge = table<Edge>(Table::Edges);
+    for (size_t i = 0u; i < count(Table::Vertices); ++i)
+    {
+        Lane* lane = (vertex[i].road == NONE) ? nullptr
+            : city.m_roads[vertex[i].road]->m_lanes[vertex[i].side][vertex[i].lane].get();
+        RoadGraph::Id const id = graph.addVertex(position(vertex[i].position), lane);
+        for (uint32_t e = edge_offsets[i]; e < edge_offsets[i + 1u]; ++e)
+        {
+            graph.m_edges[id].push_back({ edge[e].to, edge[e].cost, edge[e].middle });
+        }
+    }
+    auto restore = [this](Table const offsets, Table const edges,
+                          std::vector<size_t>& rows, std::vector<RoadGraph::Edge>& values)
+    {
+        uint32_t const* o = table<uint32_t>(offsets);
+        Edge const* e = table<Edge>(edges);
+        rows.assign(o, o + count(offsets));
+        values.clear();
+        values.reserve(count(edges));
+        for (size_t i = 0u; i < count(edges); ++i)
+        {
+            values.push_back({ e[i].to, e[i].cost, e[i].middle });
+        }
+    };
+    restore(Table::UpwardOffsets, Table::Upward, graph.m_upward_offsets, graph.m_upward);
+    restore(Table::DownwardOffsets, Table::Downward, graph.m_downward_offsets, graph.m_downward);
+    Shortcut const* shortcut = table<Shortcut>(Table::Shortcuts);
+    for (size_t i = 0u; i < count(Table::Shortcuts); ++i)
+    {
+        graph.m_shortcuts[shortcut[i].key] = shortcut[i].middle;
+    }
+    uint32_t const* ranks = table<uint32_t>(Table::Ranks);
+    graph.m_ranks.assign(ranks, ranks + count(Table::Ranks));
+    city.m_graph_outdated = false;
+
+    LOGI("Loaded city: %zu roads, %zu parkings, %zu lanes in the road graph",
+         roads, parkings, graph.size());
+    return true;
+}
@@ -0,0 +1,238 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef CITY_FILE_HPP
+#  define CITY_FILE_HPP
+
+#  include "Common/NonCopyable.hpp"
+#  include <string>
+#  include <cstddef>
+#  include <cstdint>
+
+class City;
+
+// *****************************************************************************
+//! \brief Compact binary file of the static part of a city: roads (their
+//! sampled center line, from which lanes are built), parkings, the contracted
+//! road graph and the partition of the world into tiles. The file is a header
+//! followed by tables of fixed-size little-endian records (8 bytes aligned):
+//! it is memory-mapped and read in place, nothing is parsed, and several
+//! simulation processes loading the same map share it through the page cache.
+//! Loading a city then only costs the creation of lanes: splines, the road
+//! graph and its contraction hierarchy are not computed again.
+//!
+//! Positions are stored in single precision relatively to the origin of the
+//! city (the corner of its bounding box): the precision is about 1 mm for
+//! cities 10 km large (the step of floats between 8 and 16 km).
+// *****************************************************************************
+class CityFile : public NonCopyable
+{
+public:
+
+    //! \brief Change the version when the layout of records changes.
+    static constexpr uint32_t VERSION = 1u;
+
+    // *************************************************************************
+    //! \brief Tables of the file.
+    // *************************************************************************
+    enum Table : uint32_t
+    {
+        Roads, Centers, Parkings, Vertices, EdgeOffsets, Edges, Ranks,
+        UpwardOffsets, Upward, DownwardOffsets, Downward, Shortcuts,
+        Tiles, TileRoads, TileParkings, TABLES
+    };
+
+    // *************************************************************************
+    //! \brief Location of a table in the file.
+    // *************************************************************************
+    struct Section
+    {
+        //! \brief Offset from the beginning of the file [byte].
+        uint64_t offset;
+        //! \brief Number of records.
+        uint64_t count;
+    };
+
+    // *************************************************************************
+    //! \brief Beginning of the file.
+    // *************************************************************************
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        //! \brief Detect files written on a big-endian machine.
+        uint32_t endianness;
+        //! \brief Length of the side of tiles [meter].
+        float tile_size;
+        //! \brief World position of the origin of stored positions [meter].
+        double origin[2];
+        Section sections[TABLES];
+    };
+
+    //! \brief Position relative to the origin [meter].
+    struct Point { float x, y; };
+
+    //! \brief Road: its center line is Centers[first .. first + count[.
+    struct Road
+    {
+        uint32_t first;
+        uint32_t count;
+        float width;
+        uint8_t lanes[2];
+        uint16_t padding;
+    };
+
+    //! \brief Parking slot: position [meter], heading [radian] and blueprint
+    //! (length, width [meter], angle [degree]).
+    struct Parking
+    {
+        Point position;
+        float heading;
+        float length;
+        float width;
+        float angle;
+    };
+
+    //! \brief Vertex of the road graph and the lane it stands for (road NONE
+    //! when none).
+    struct Vertex
+    {
+        Point position;
+        uint32_t road;
+        uint8_t side;
+        uint8_t lane;
+        uint16_t padding;
+    };
+
+    //! \brief Edge of the road graph (see RoadGraph::Edge).
+    struct Edge
+    {
+        uint32_t to;
+        float cost;
+        uint32_t middle;
+    };
+
+    //! \brief Middle vertex of a shortcut of the contraction hierarchy.
+    struct Shortcut
+    {
+        uint64_t key;
+        uint32_t middle;
+        uint32_t padding;
+    };
+
+    //! \brief Tile: its roads are TileRoads[first_road .. first_road + roads[
+    //! and its parkings TileParkings[first_parking .. first_parking + parkings[.
+    struct Tile
+    {
+        uint64_t key;
+        uint32_t first_road;
+        uint32_t roads;
+        uint32_t first_parking;
+        uint32_t parkings;
+    };
+
+    //! \brief Invalid index.
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+public:
+
+    CityFile() = default;
+
+    ~CityFile()
+    {
+        close();
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Write the roads, parkings, road graph and tiles of the city. The
+    //! road graph is built if needed.
+    //! \return false if the file cannot be written.
+    //--------------------------------------------------------------------------
+    static bool save(City& city, std::string const& path);
+
+    //--------------------------------------------------------------------------
+    //! \brief Map the file in memory and check its header and tables.
+    //! \return false if the file is missing, corrupted or of another version.
+    //--------------------------------------------------------------------------
+    bool open(std::string const& path);
+
+    //--------------------------------------------------------------------------
+    //! \brief Unmap the file.
+    //--------------------------------------------------------------------------
+    void close();
+
+    //--------------------------------------------------------------------------
+    //! \brief Is a file mapped ?
+    //--------------------------------------------------------------------------
+    inline bool opened() const
+    {
+        return m_data != nullptr;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Add the roads and parkings of the opened file to the city, which
+    //! shall not have roads yet.
+    //! \return false if no file is opened or the city already has roads.
+    //--------------------------------------------------------------------------
+    bool load(City& city) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the header of the opened file.
+    //--------------------------------------------------------------------------
+    inline Header const& header() const
+    {
+        return *reinterpret_cast<Header const*>(m_data);
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the records of a table of the opened file.
+    //--------------------------------------------------------------------------
+    template<class T>
+    inline T const* table(Table const table) const
+    {
+        return reinterpret_cast<T const*>(m_data + header().sections[table].offset);
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the number of records of a table of the opened file.
+    //--------------------------------------------------------------------------
+    inline size_t count(Table const table) const
+    {
+        return size_t(header().sections[table].count);
+    }
+
+private:
+
+    //--------------------------------------------------------------------------
+    //! \brief Check that tables are inside the file and that records refer to
+    //! existing records.
+    //--------------------------------------------------------------------------
+    bool check() const;
+
+private:
+
+    //! \brief Mapped file.
+    uint8_t const* m_data = nullptr;
+    //! \brief Size of the mapped file [byte].
+    size_t m_size = 0u;
+};
+
+#endif
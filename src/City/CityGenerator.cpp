@@ -21,13 +21,30 @@
 
 #include "City/CityGenerator.hpp"
 #include "City/CityGeneratorRules.hpp"
-#include "project_info.hpp"
+#include "City/Network.hpp"
 #include "Math/Random.hpp"
 #include <iostream>
 #include <algorithm>
+#include <unordered_map>
+#include <cmath>
 
 std::atomic<size_t> CityGenerator::Road::m_next_id(1U);
 
+//! \brief Size of cells of the grid of accepted roads [meter].
+static constexpr double GRID_CELL_SIZE = 256.0;
+
+// -----------------------------------------------------------------------------
+static inline int32_t grid_cell(Meter const coordinate)
+{
+    return int32_t(std::floor(coordinate.value() / GRID_CELL_SIZE));
+}
+
+// -----------------------------------------------------------------------------
+static inline uint64_t grid_key(int32_t const x, int32_t const y)
+{
+    return (uint64_t(uint32_t(x)) << 32) | uint64_t(uint32_t(y));
+}
+
 // -----------------------------------------------------------------------------
 static double non_linear_distribution(double const limit)
 {
@@ -49,45 +66,70 @@ static Radian random_angle(Radian const limit)
 }
 
 // -----------------------------------------------------------------------------
-void CityGenerator::HeatMap::generate(sf::Vector2<Meter> const &world_dimension, sf::Vector2u map_dimension)
+void CityGenerator::HeatMap::generate(sf::Vector2<Meter> const &world_dimension, sf::Vector2u map_dimension,
+                                      size_t const threads)
 {
     m_world_dimension = world_dimension;
     m_map_dimension = map_dimension;
-    m_scaling.x = world_dimension.x.value() / double(map_dimension.x);
-    m_scaling.y = world_dimension.y.value() / double(map_dimension.y);
+    m_scaling.x = double(map_dimension.x) / world_dimension.x.value();
+    m_scaling.y = double(map_dimension.y) / world_dimension.y.value();
 
-    perlin(m_heatmap, m_map_dimension, [](double const x, double const y) -> sf::Color
-           {
+    perlin(m_density, m_map_dimension, [](double const x, double const y) -> float
+    {
         double const dt = 1.0;
         auto const noise = (
             db::perlin(x / 64.0, y / 64.0, dt * 0.25) * 1.0 +
             db::perlin(x / 32.0, y / 32.0, dt * 0.75) * 0.5
         ) / 1.5;
 
-        auto const brightness = sf::Uint8((noise * 0.5 + 0.5) * 255.0);
-        return { brightness, brightness, brightness, 255 }; });
+        return float((noise * 0.5 + 0.5) * 255.0);
+    }, threads);
 }
 
 // -----------------------------------------------------------------------------
-bool CityGenerator::HeatMap::save(fs::path const &path)
+bool CityGenerator::HeatMap::save(fs::path const &path) const
 {
-    sf::Texture texture;
-    texture.loadFromImage(m_heatmap);
-    return texture.copyToImage().saveToFile(path);
+    sf::Image image;
+    image.create(m_map_dimension.x, m_map_dimension.y);
+    for (unsigned int y = 0u; y < m_map_dimension.y; ++y)
+    {
+        for (unsigned int x = 0u; x < m_map_dimension.x; ++x)
+        {
+            float const density = m_density[size_t(y) * m_map_dimension.x + x];
+            auto const brightness = sf::Uint8(std::clamp(density, 0.0f, 255.0f));
+            image.setPixel(x, y, { brightness, brightness, brightness, 255 });
+        }
+    }
+    return image.saveToFile(path.string());
 }
 
 // -----------------------------------------------------------------------------
-double CityGenerator::HeatMap::get(sf::Vector2<Meter> const &p)
+double CityGenerator::HeatMap::get(sf::Vector2<Meter> const &p) const
 {
-    const Meter x = math::map(p.x, -m_world_dimension.x / 2.0, m_world_dimension.x / 2.0, 0.0_m, Meter(m_map_dimension.x));
-    const Meter y = math::map(p.y, -m_world_dimension.y / 2.0, m_world_dimension.y / 2.0, 0.0_m, Meter(m_map_dimension.y));
-    const unsigned int u = static_cast<unsigned int>(x.value());
-    const unsigned int v = static_cast<unsigned int>(y.value());
-
-    // std::cout << "Heatmap(" << p.x << ", " << p.y << ") => (" << u << ", " << v << "): "
-    //<< int(m_heatmap.getPixel(u, v).r) << std::endl;
+    if (m_density.empty())
+        return 0.0;
+
+    // Position in samples (samples are the centers of pixels).
+    size_t const w = m_map_dimension.x, h = m_map_dimension.y;
+    double const fx = std::clamp((p.x + m_world_dimension.x / 2.0).value() * m_scaling.x - 0.5,
+                                 0.0, double(w - 1u));
+    double const fy = std::clamp((p.y + m_world_dimension.y / 2.0).value() * m_scaling.y - 0.5,
+                                 0.0, double(h - 1u));
+    size_t const x = std::min(size_t(fx), (w > 1u) ? w - 2u : 0u);
+    size_t const y = std::min(size_t(fy), (h > 1u) ? h - 2u : 0u);
+    double const u = fx - double(x), v = fy - double(y);
+
+    float const* s = m_density.data() + y * w + x;
+    size_t const dx = (w > 1u) ? 1u : 0u, dy = (h > 1u) ? w : 0u;
+    double const bottom = s[0] + u * (s[dx] - s[0]);
+    double const top = s[dy] + u * (s[dy + dx] - s[dy]);
+    return bottom + v * (top - bottom);
+}
 
-    return double(m_heatmap.getPixel(u, v).r);
+// -----------------------------------------------------------------------------
+bool CityGenerator::exportPopulationMap(fs::path const &path)
+{
+    return m_population.save(path);
 }
 
 // -----------------------------------------------------------------------------
@@ -116,17 +158,12 @@ void CityGenerator::Road::setup_branch_links()
     if (previous_segment_to_link == nullptr)
         return;
 
+    // The branch starts at the end of the previous road: it is linked to the
+    // roads already linked to this end.
     for (auto &link : previous_segment_to_link->forwards)
     {
         backwards.push_back(link);
-        if (std::find(backwards.begin(), backwards.end(), previous_segment_to_link) != backwards.end())
-        {
-            backwards.push_back(this);
-        }
-        else if (std::find(forwards.begin(), forwards.end(), previous_segment_to_link) != forwards.end())
-        {
-            forwards.push_back(this);
-        }
+        link->links_for_end_containing(previous_segment_to_link).push_back(this);
     }
     previous_segment_to_link->forwards.push_back(this);
     backwards.push_back(previous_segment_to_link);
@@ -153,9 +190,13 @@ void CityGenerator::junction(CityGenerator::Road &road, CityGenerator::Road &oth
     //           |                                  |
     //          road                               road
 
+    // Which links correspond to which end of the split segment: to be known
+    // before moving the ends of the road.
+    bool const inversed = other.isInversed();
+
     // Create a new road segment
     m_branches.push_back(CityGenerator::Road(other));
-    m_roads.push_back(&m_branches.back());
+    accept(m_branches.back());
     CityGenerator::Road &new_road = m_branches.back();
     new_road.to = intersection;
 
@@ -164,8 +205,7 @@ void CityGenerator::junction(CityGenerator::Road &road, CityGenerator::Road &oth
     road.has_severed = true;
     other.from = intersection;
 
-    // Which links correspond to which end of the split segment
-    if (other.isInversed())
+    if (inversed)
     {
         // Before:                           After:
         //           ^
@@ -191,10 +231,8 @@ void CityGenerator::junction(CityGenerator::Road &road, CityGenerator::Road &oth
             }
         }
 
-        new_road.forwards.push_back(&road);
-        new_road.forwards.push_back(&other);
-        other.backwards.push_back(&road);
-        other.backwards.push_back(&new_road);
+        new_road.forwards = { &road, &other };
+        other.backwards = { &road, &new_road };
         road.forwards.push_back(&new_road);
         road.forwards.push_back(&other);
     }
@@ -224,10 +262,8 @@ void CityGenerator::junction(CityGenerator::Road &road, CityGenerator::Road &oth
             }
         }
 
-        other.forwards.push_back(&road);
-        other.forwards.push_back(&new_road);
-        new_road.backwards.push_back(&road);
-        new_road.backwards.push_back(&other);
+        other.forwards = { &road, &new_road };
+        new_road.backwards = { &road, &other };
         road.forwards.push_back(&other);
         road.forwards.push_back(&new_road);
     }
@@ -247,22 +283,52 @@ CityGenerator::CityGenerator()
 }
 
 // -----------------------------------------------------------------------------
-std::list<CityGenerator::Road *> const &
+void CityGenerator::network(Path& path, Meter const snap) const
+{
+    // Nodes indexed by their quantized position.
+    std::unordered_map<uint64_t, Node*> nodes;
+    auto node = [&](sf::Vector2<Meter> const& p) -> Node&
+    {
+        int32_t const x = int32_t(std::round(p.x.value() / snap.value()));
+        int32_t const y = int32_t(std::round(p.y.value() / snap.value()));
+        uint64_t const key = (uint64_t(uint32_t(x)) << 32) | uint64_t(uint32_t(y));
+        auto it = nodes.find(key);
+        if (it != nodes.end())
+            return *it->second;
+
+        Node& n = path.addNode(p);
+        nodes[key] = &n;
+        return n;
+    };
+
+    for (auto const* road: m_roads)
+    {
+        Node& from = node(road->from);
+        Node& to = node(road->to);
+        if ((&from != &to) && (from.getWayToNode(to) == nullptr))
+        {
+            path.addWay(from, to);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+std::vector<CityGenerator::Road *> const &
 CityGenerator::generate(sf::Vector2<Meter> const &dimension)
 {
     // Reset internal states
-    std::cout << "CityGenerator::generate clear" << std::endl;
+    CITYGEN_DEBUG("CityGenerator::generate clear");
     m_pendings.clear();
     m_roads.clear();
+    m_grid.clear();
     m_branches.clear();
 
     //
     m_dimension = dimension;
     m_population.generate(dimension, sf::Vector2u(512u, 512u));
-    m_population.save(project::info::tmp_path + "heatmap.png");
-    std::cout << "CityGenerator::generate init roads" << std::endl;
+    CITYGEN_DEBUG("CityGenerator::generate init roads");
     generateInitialRoads(sf::Vector2<Meter>(0.0_m, 0.0_m), true); // dimension.x / 2.0, dimension.y / 2.0), true);
-    std::cout << "CityGenerator::generate algo" << std::endl;
+    CITYGEN_DEBUG("CityGenerator::generate algo");
     return generateRoads();
 }
 
@@ -272,10 +338,12 @@ bool CityGenerator::localConstraints(CityGenerator::Road &road)
     size_t priority = 0u;
     size_t action = 0u;
 
-    std::cout << "localConstraints " << road << std::endl;
-    for (auto &other : m_roads)
+    CITYGEN_DEBUG("localConstraints " << road);
+    neighbours(road);
+    for (size_t const n : m_neighbours)
     {
-        std::cout << "  vs. Other " << *other << std::endl;
+        Road* other = m_roads[n];
+        CITYGEN_DEBUG("  vs. Other " << *other);
         size_t i = m_rules.size();
         while (i--)
         {
@@ -293,6 +361,55 @@ bool CityGenerator::localConstraints(CityGenerator::Road &road)
     return m_rules[action]->apply(road);
 }
 
+// -----------------------------------------------------------------------------
+void CityGenerator::accept(CityGenerator::Road &road)
+{
+    size_t const index = m_roads.size();
+    m_roads.push_back(&road);
+
+    int32_t const x0 = grid_cell(units::math::min(road.from.x, road.to.x));
+    int32_t const x1 = grid_cell(units::math::max(road.from.x, road.to.x));
+    int32_t const y0 = grid_cell(units::math::min(road.from.y, road.to.y));
+    int32_t const y1 = grid_cell(units::math::max(road.from.y, road.to.y));
+    for (int32_t x = x0; x <= x1; ++x)
+    {
+        for (int32_t y = y0; y <= y1; ++y)
+        {
+            m_grid[grid_key(x, y)].push_back(index);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+void CityGenerator::neighbours(CityGenerator::Road const &road)
+{
+    // Rules need roads crossing the road, or closer than the snapping distance
+    // to its destination.
+    Meter const margin = config.max_snap_distance;
+    int32_t const x0 = grid_cell(units::math::min(road.from.x, road.to.x) - margin);
+    int32_t const x1 = grid_cell(units::math::max(road.from.x, road.to.x) + margin);
+    int32_t const y0 = grid_cell(units::math::min(road.from.y, road.to.y) - margin);
+    int32_t const y1 = grid_cell(units::math::max(road.from.y, road.to.y) + margin);
+
+    m_neighbours.clear();
+    for (int32_t x = x0; x <= x1; ++x)
+    {
+        for (int32_t y = y0; y <= y1; ++y)
+        {
+            auto it = m_grid.find(grid_key(x, y));
+            if (it != m_grid.end())
+            {
+                m_neighbours.insert(m_neighbours.end(), it->second.begin(), it->second.end());
+            }
+        }
+    }
+
+    // Rules keep the last accepted road: check roads in the same order than
+    // without the grid.
+    std::sort(m_neighbours.begin(), m_neighbours.end());
+    m_neighbours.erase(std::unique(m_neighbours.begin(), m_neighbours.end()), m_neighbours.end());
+}
+
 // -----------------------------------------------------------------------------
 void CityGenerator::generateInitialRoads(sf::Vector2<Meter> const &initial_position,
                                          bool const highway)
@@ -325,19 +442,18 @@ void CityGenerator::generateInitialRoads(sf::Vector2<Meter> const &initial_posit
 }
 
 // -----------------------------------------------------------------------------
-std::list<CityGenerator::Road *> const &CityGenerator::generateRoads()
+std::vector<CityGenerator::Road *> const &CityGenerator::generateRoads()
 {
     while ((m_pendings.size() >= 1u) && (m_roads.size() < config.max_roads))
     {
         // Get the road with the hightest priority (lower value)
         Road &road = *m_pendings.pop();
 
-        std::cout << "\n-----------------\n"
-                  << road << std::endl;
+        CITYGEN_DEBUG("\n-----------------\n" << road);
         if (localConstraints(road))
         {
             road.setup_branch_links();
-            m_roads.push_back(&road);
+            accept(road);
             globalGoals(road);
         }
     }
@@ -349,7 +465,7 @@ std::list<CityGenerator::Road *> const &CityGenerator::generateRoads()
 CityGenerator::Road
 CityGenerator::continueRoad(CityGenerator::Road const &previous, Radian const direction)
 {
-    std::cout << "       segment_continue" << std::endl;
+    CITYGEN_DEBUG("       segment_continue");
     size_t const priority = 0u;
     Meter const &l = previous.length();
     sf::Vector2<Meter> const to(previous.to.x + l * units::math::cos(direction),
@@ -361,7 +477,7 @@ CityGenerator::continueRoad(CityGenerator::Road const &previous, Radian const di
 CityGenerator::Road
 CityGenerator::branchRoad(CityGenerator::Road const &previous, Radian const direction)
 {
-    std::cout << "       segment_branch" << std::endl;
+    CITYGEN_DEBUG("       segment_branch");
     const size_t priority = (previous.highway)
                                 ? config.normal_branch_time_delay_from_highway
                                 : 0u;
@@ -384,10 +500,10 @@ double CityGenerator::samplePopulation(Road const &road)
 // -----------------------------------------------------------------------------
 void CityGenerator::globalGoals(CityGenerator::Road &previous)
 {
-    std::cout << "global_goals_generate " << previous << std::endl;
+    CITYGEN_DEBUG("global_goals_generate " << previous);
     if (previous.has_severed)
     {
-        std::cout << "       severed" << std::endl;
+        CITYGEN_DEBUG("       severed");
         return;
     }
 
@@ -398,7 +514,7 @@ void CityGenerator::globalGoals(CityGenerator::Road &previous)
     const double population_straight = samplePopulation(next_straight);
     if (previous.highway)
     {
-        std::cout << "         highway" << std::endl;
+        CITYGEN_DEBUG("         highway");
         // Direction of the previous road straight with deviation
         const Road &&next_random = continueRoad(previous, previous.heading() + random_angle(config.straight_angle_deviation));
         const double population_random = samplePopulation(next_random);
@@ -406,18 +522,17 @@ void CityGenerator::globalGoals(CityGenerator::Road &previous)
         // Compare populations between the two choices. Select the
         // direction where the gradient of population density increases.
         double road_pop;
-        std::cout << "         random pop " << population_random
-                  << " straight pop " << population_straight
-                  << std::endl;
+        CITYGEN_DEBUG("         random pop " << population_random
+                      << " straight pop " << population_straight);
         if (true) // population_random > population_straight)
         {
-            std::cout << "         random selected" << std::endl;
+            CITYGEN_DEBUG("         random selected");
             new_branches.push_back(next_random);
             road_pop = population_random;
         }
         else
         {
-            std::cout << "         straight selected" << std::endl;
+            CITYGEN_DEBUG("         straight selected");
             new_branches.push_back(next_random);
             road_pop = population_straight;
         }
@@ -428,26 +543,26 @@ void CityGenerator::globalGoals(CityGenerator::Road &previous)
             // Left branch for the highway
             if (true) // Random::get<bool>(config.highway_branch_probability))
             {
-                std::cout << "         left_highway_branch" << std::endl;
+                CITYGEN_DEBUG("         left_highway_branch");
                 const Radian angle = previous.heading() + 90.0_deg + random_angle(config.straight_angle_deviation);
                 new_branches.push_back(continueRoad(previous, angle));
             }
             // Right branch for the highway
             else if (Random::get<bool>(config.highway_branch_probability))
             {
-                std::cout << "         right_highway_branch" << std::endl;
+                CITYGEN_DEBUG("         right_highway_branch");
                 const Radian angle = previous.heading() - 90.0_deg + random_angle(config.straight_angle_deviation);
                 new_branches.push_back(continueRoad(previous, angle));
             }
             else
             {
-                std::cout << "         no highway branch" << std::endl;
+                CITYGEN_DEBUG("         no highway branch");
             }
         }
     }
     else if (population_straight > config.normal_branch_population_threshold)
     {
-        std::cout << "         straight pop" << std::endl;
+        CITYGEN_DEBUG("         straight pop");
         new_branches.push_back(next_straight);
     }
 
@@ -457,30 +572,30 @@ void CityGenerator::globalGoals(CityGenerator::Road &previous)
         // Left branch for the road
         if (true) // Random::get<bool>(config.default_branch_probability))
         {
-            std::cout << "         left_road_branch" << std::endl;
+            CITYGEN_DEBUG("         left_road_branch");
             const Radian angle = previous.heading() + 90.0_deg + random_angle(config.straight_angle_deviation);
             new_branches.push_back(branchRoad(previous, angle));
         }
         // Right branch for the road
         else if (Random::get<bool>(config.default_branch_probability))
         {
-            std::cout << "         right_road_branch" << std::endl;
+            CITYGEN_DEBUG("         right_road_branch");
             const Radian angle = previous.heading() - 90.0_deg + random_angle(config.straight_angle_deviation);
             new_branches.push_back(branchRoad(previous, angle));
         }
         else
         {
-            std::cout << "         no road branch" << std::endl;
+            CITYGEN_DEBUG("         no road branch");
         }
     }
 
-    std::cout << "       new branches: " << std::endl;
+    CITYGEN_DEBUG("       new branches: ");
     for (auto &branch : new_branches)
     {
         branch.previous_segment_to_link = &previous;
         branch.priority += previous.priority + 1u;
         m_branches.push_back(branch);
-        std::cout << "          new branch: " << branch << std::endl;
+        CITYGEN_DEBUG("          new branch: " << branch);
         m_pendings.push(&m_branches.back());
     }
 }
\ No newline at end of file
@@ -23,14 +23,31 @@
 #  define CITY_GENERATOR_HPP
 
 #  include <queue>
+#  include <algorithm>
+#  include <cassert>
 #  include <vector>
 #  include <list>
 #  include <atomic>
+#  include <ostream>
+#  include <unordered_map>
 #  include "Math/Math.hpp"
 #  include "Math/Units.hpp"
 #  include "Math/Perlin.hpp"
 #  include "Common/FileSystem.hpp"
 
+//-----------------------------------------------------------------------------
+//! \brief Traces of the city generator are compiled only when CITYGEN_TRACE is
+//! defined (i.e. -DCITYGEN_TRACE). By default, they do not cost anything.
+//-----------------------------------------------------------------------------
+#  if defined(CITYGEN_TRACE)
+#    include <iostream>
+#    define CITYGEN_DEBUG(x) std::cout << x << std::endl
+#  else
+#    define CITYGEN_DEBUG(x)
+#  endif
+
+class Path;
+
 // *****************************************************************************
 //! \brief
 // *****************************************************************************
@@ -45,16 +62,35 @@ public:
     {
     public:
 
-        void generate(sf::Vector2<Meter> const& world_dimension, sf::Vector2u map_dimension);
-        bool save(fs::path const& path);
-        double get(sf::Vector2<Meter> const& p);
+        //----------------------------------------------------------------------
+        //! \brief Fill the density grid with Perlin noise (values in [0 255]).
+        //! \param[in] world_dimension: size of the world centered on the
+        //! origin covered by the map [meter].
+        //! \param[in] map_dimension: number of samples along each axis.
+        //! \param[in] threads: number of worker threads (0: CPU cores).
+        //----------------------------------------------------------------------
+        void generate(sf::Vector2<Meter> const& world_dimension, sf::Vector2u map_dimension,
+                      size_t const threads = 0u);
+
+        //----------------------------------------------------------------------
+        //! \brief Export the density grid as a grayscale PNG file.
+        //----------------------------------------------------------------------
+        bool save(fs::path const& path) const;
+
+        //----------------------------------------------------------------------
+        //! \brief Return the density at the given world position (bilinear
+        //! interpolation of samples, clamped to the borders of the map).
+        //----------------------------------------------------------------------
+        double get(sf::Vector2<Meter> const& p) const;
 
     private:
 
         sf::Vector2<Meter> m_world_dimension;
         sf::Vector2u m_map_dimension;
+        //! \brief Number of samples per meter.
         sf::Vector2<double> m_scaling;
-        sf::Image m_heatmap;
+        //! \brief Row major density samples.
+        std::vector<float> m_density;
     };
 
     // *************************************************************************
@@ -74,7 +110,7 @@ public:
              size_t const priority_, bool const highway_)
             : id(m_next_id++), from(from_), to(to_), priority(priority_), highway(highway_)
         {
-            std::cout << "       Constructor: " << *this << std::endl;
+            CITYGEN_DEBUG("       Constructor: " << *this);
         }
 
         //----------------------------------------------------------------------
@@ -279,13 +315,20 @@ public:
     //! \brief Generate city roads.
     //! \param[in] dimension city dimension [Meter x Meter].
     //-------------------------------------------------------------------------
-    std::list<CityGenerator::Road*> const& generate(sf::Vector2<Meter> const& dimension);
+    std::vector<CityGenerator::Road*> const& generate(sf::Vector2<Meter> const& dimension);
 
     //-------------------------------------------------------------------------
     //! \brief Export the map of population density as PNG file.
     //-------------------------------------------------------------------------
     bool exportPopulationMap(fs::path const& path);
 
+    //-------------------------------------------------------------------------
+    //! \brief Convert the generated roads into a network of nodes and ways
+    //! (i.e. for building a RoadGraph). Extremities of roads closer than the
+    //! given distance are merged into the same node.
+    //-------------------------------------------------------------------------
+    void network(Path& path, Meter const snap = 1.0_m) const;
+
     //-------------------------------------------------------------------------
     //! FIXME shall not be public
     //! \brief The new road \c road will cross the road \c other at the given
@@ -316,14 +359,27 @@ private:
     //! \brief Generate all the roads from initial roads.
     //! \return Return the reference to the list of created roads.
     //-------------------------------------------------------------------------
-    std::list<CityGenerator::Road*> const& generateRoads();
+    std::vector<CityGenerator::Road*> const& generateRoads();
 
     //-------------------------------------------------------------------------
     //! \brief Adjust the parameter values proposed by the \c globalGoals()
-    //! function to the local environment.
+    //! function to the local environment. Rules are only checked against
+    //! the accepted roads near the given road (see neighbours()).
     //-------------------------------------------------------------------------
     bool localConstraints(CityGenerator::Road& road);
 
+    //-------------------------------------------------------------------------
+    //! \brief Accept the road: store it in m_roads and in the grid.
+    //-------------------------------------------------------------------------
+    void accept(CityGenerator::Road& road);
+
+    //-------------------------------------------------------------------------
+    //! \brief Store in m_neighbours, in the order of their acceptance, the
+    //! accepted roads whose bounding box is closer to the given road than the
+    //! snapping distance: the only roads that rules can accept.
+    //-------------------------------------------------------------------------
+    void neighbours(CityGenerator::Road const& road);
+
     //-------------------------------------------------------------------------
     //! \brief
     //-------------------------------------------------------------------------
@@ -361,7 +417,10 @@ public:
 private:
 
     // *************************************************************************
-    //! \brief
+    //! \brief Pending roads ordered by their priority (lower value first).
+    //! Roads of same priority are popped in the order they were pushed, so
+    //! the generation is deterministic. Binary heap stored in a vector:
+    //! push() and pop() are O(log n).
     // *************************************************************************
     class PriorityQueue
     {
@@ -369,38 +428,65 @@ private:
 
         void push(Road* r)
         {
-            m_queue.push_back(r);
+            m_heap.push_back({ r->priority, m_sequence++, r });
+            std::push_heap(m_heap.begin(), m_heap.end(), Entry::after);
+        }
+
+        Road* top() const
+        {
+            assert(!m_heap.empty());
+            return m_heap.front().road;
         }
 
         Road* pop()
         {
-            // Find the segment with the hightest priority (lower value)
-            auto it = std::min_element(m_queue.begin(), m_queue.end(), [](Road const* lhs, Road const* rhs)
-            {
-                return lhs->priority < rhs->priority;
-            });
-            Road* road = *it;
-            m_queue.erase(it);
+            assert(!m_heap.empty());
+            std::pop_heap(m_heap.begin(), m_heap.end(), Entry::after);
+            Road* road = m_heap.back().road;
+            m_heap.pop_back();
             return road;
         }
 
         size_t size() const
         {
-            return m_queue.size();
+            return m_heap.size();
+        }
+
+        bool empty() const
+        {
+            return m_heap.empty();
         }
 
         void clear()
         {
-            m_queue.clear();
+            m_heap.clear();
+            m_sequence = 0u;
         }
 
     private:
 
-        std::list<Road*> m_queue;
-    };
+        // *********************************************************************
+        //! \brief Element of the heap. The priority is copied from the road
+        //! when pushed.
+        // *********************************************************************
+        struct Entry
+        {
+            size_t priority;
+            //! \brief Number of roads pushed before this one.
+            size_t sequence;
+            Road* road;
 
-    //! \brief
-    //using PriorityQueue = std::priority_queue<Road*, std::vector<Road*>, Priority>;
+            //! \brief Shall lhs be popped after rhs ?
+            static bool after(Entry const& lhs, Entry const& rhs)
+            {
+                return (lhs.priority != rhs.priority) ? (lhs.priority > rhs.priority)
+                                                      : (lhs.sequence > rhs.sequence);
+            }
+        };
+
+        std::vector<Entry> m_heap;
+        size_t m_sequence = 0u;
+    };
 
     //! \brief Pending roads waiting for their operation.
     PriorityQueue m_pendings;
@@ -409,8 +495,14 @@ private:
     HeatMap m_population;
     //! \brief Generated roads (valid and invalid)
     std::list<CityGenerator::Road> m_branches;
-    //! \brief Hold accepted roads.
-    std::list<CityGenerator::Road*> m_roads;
+    //! \brief Accepted roads in the order of their acceptance.
+    std::vector<CityGenerator::Road*> m_roads;
+    //! \brief Uniform grid of accepted roads: indices in m_roads of roads
+    //! whose bounding box overlaps the cell. Roads are only shortened once
+    //! accepted (by junctions), so their cells stay valid.
+    std::unordered_map<uint64_t, std::vector<size_t>> m_grid;
+    //! \brief Roads found by neighbours() (avoid allocations).
+    std::vector<size_t> m_neighbours;
 
     std::vector<std::unique_ptr<CityGenerator::GenerationRule>> m_rules;
 
@@ -51,7 +51,7 @@ public:
     //-------------------------------------------------------------------------
     virtual bool apply(CityGenerator::Road&) override
     {
-        std::cout << "    YES (default)" << std::endl;
+        CITYGEN_DEBUG("    YES (default)");
         return true;
     }
 };
@@ -75,36 +75,38 @@ public:
     //-------------------------------------------------------------------------
     virtual bool accept(CityGenerator::Road& road, CityGenerator::Road& other) override
     {
-        std::cout << "    Checking roads intersecting:" << std::endl;
+        CITYGEN_DEBUG("    Checking roads intersecting:");
         // Roads do not intersect ?
+        sf::Vector2<Meter> intersection;
         if (!math::intersect(std::make_tuple(road.from, road.to),
                              std::make_tuple(other.from, other.to),
-                             m_intersection))
+                             intersection))
         {
-            std::cout << "        NO (do not intersect)" << std::endl;
+            CITYGEN_DEBUG("        NO (do not intersect)");
             return false;
         }
 
         // Check the distance to the intersection.
         // (note: we are using [Meter^2] to avoid using sqrt())
-        SquareMeter const d2 = math::distance2(road.from, m_intersection);
+        SquareMeter const d2 = math::distance2(road.from, intersection);
         if (d2 < m_previous_intersection_distance_squared)
         {
             // If intersecting lines are too similar don't accept
             Degree const deviation = math::wrap_angle(other.heading() - road.heading());
             if (deviation < m_context.config.minimum_intersection_deviation)
             {
-                std::cout << "        NO (previously)" << std::endl;
+                CITYGEN_DEBUG("        NO (previously)");
                 return false;
             }
 
             m_previous_intersection_distance_squared = d2;
+            m_intersection = intersection;
             m_other = &other;
-            std::cout << "        YES" << std::endl;
+            CITYGEN_DEBUG("        YES");
             return true;
         }
 
-        std::cout << "        NO (previously)" << std::endl;
+        CITYGEN_DEBUG("        NO (previously)");
         return false;
     }
 
@@ -113,7 +115,7 @@ public:
     //-------------------------------------------------------------------------
     virtual bool apply(CityGenerator::Road& road) override
     {
-        std::cout << "IntersectingRoadsRule::apply" << std::endl;
+        CITYGEN_DEBUG("IntersectingRoadsRule::apply");
         assert(m_other != nullptr);
 
         m_context.junction(road, *m_other, m_intersection);
@@ -146,17 +148,17 @@ public:
     //-------------------------------------------------------------------------
     virtual bool accept(CityGenerator::Road& road, CityGenerator::Road& other) override
     {
-        std::cout << "    Checking snap to crossing:" << std::endl;
+        CITYGEN_DEBUG("    Checking snap to crossing:");
         if (math::distance2(road.to, other.to) <=
             units::math::pow<2>(m_context.config.max_snap_distance))
         {
             m_other = &other;
             road.has_severed = true;
-            std::cout << "        YES" << std::endl;
+            CITYGEN_DEBUG("        YES");
             return true;
         }
 
-        std::cout << "        NO" << std::endl;
+        CITYGEN_DEBUG("        NO");
         return false;
     }
 
@@ -165,7 +167,7 @@ public:
     //-------------------------------------------------------------------------
     virtual bool apply(CityGenerator::Road& road) override
     {
-        std::cout << "SnapToCrossingRule::apply" << std::endl;
+        CITYGEN_DEBUG("SnapToCrossingRule::apply");
         assert(m_other != nullptr);
         road.to = m_other->to;
         road.has_severed = true;
@@ -177,7 +179,7 @@ public:
             if ((math::is_equal_approx(link->from, road.to) && math::is_equal_approx(link->to, road.from)) ||
                 (math::is_equal_approx(link->from, road.from) && math::is_equal_approx(link->to, road.to)))
             {
-                std::cout << "Snap action not done" << std::endl;
+                CITYGEN_DEBUG("Snap action not done");
                 return false;
             }
         }
@@ -220,34 +222,35 @@ public:
     //-------------------------------------------------------------------------
     virtual bool accept(CityGenerator::Road& road, CityGenerator::Road& other) override
     {
-        std::cout << "    Checking radius intersection:" << std::endl;
+        CITYGEN_DEBUG("    Checking radius intersection:");
 
         math::Segment<Meter> seg(other.from, other.to);
         if (math::aligned(road.to, seg))
         {
-            m_intersection = math::project(road.to, seg, false);
-            SquareMeter d2 = math::dot(road.to, m_intersection);
+            sf::Vector2<Meter> const intersection = math::project(road.to, seg, false);
+            SquareMeter d2 = math::distance2(road.to, intersection);
             if (d2 < units::math::pow<2>(m_context.config.max_snap_distance))
             {
                 // If intersecting lines are too similar don't accept
                 Degree const deviation = math::wrap_angle(other.heading() - road.heading());
                 if (deviation < m_context.config.minimum_intersection_deviation)
                 {
-                    std::cout << "        NO (similar)" << std::endl;
+                    CITYGEN_DEBUG("        NO (similar)");
                     return false;
                 }
+                m_intersection = intersection;
                 m_other = &other;
-                std::cout << "        YES" << std::endl;
+                CITYGEN_DEBUG("        YES");
                 return true;
             }
             else
             {
-                std::cout << "        NO (distance)" << std::endl;
+                CITYGEN_DEBUG("        NO (distance)");
                 return false;
             }
         }
 
-        std::cout << "        NO (alig)" << std::endl;
+        CITYGEN_DEBUG("        NO (alig)");
         return false;
     }
 
@@ -256,7 +259,7 @@ public:
     //-------------------------------------------------------------------------
     virtual bool apply(CityGenerator::Road& road) override
     {
-        std::cout << "RadiusIntersectionRule::apply" << std::endl;
+        CITYGEN_DEBUG("RadiusIntersectionRule::apply");
         assert(m_other != nullptr);
 
         m_context.junction(road, *m_other, m_intersection);
@@ -0,0 +1,647 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "City/MapImporter.hpp"
+#include "City/City.hpp"
+#include "Common/FileSystem.hpp"
+#include "Common/ThreadPool.hpp"
+#include "Common/XmlReader.hpp"
+#include "City/CityFile.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+//! \brief Mean radius of the Earth [meter].
+static constexpr double EARTH_RADIUS = 6371008.8;
+//! \brief Maximum number of lanes per traffic side.
+static constexpr size_t MAX_LANES = 8u;
+
+//------------------------------------------------------------------------------
+static bool drivable(const char* highway)
+{
+    static const char* HIGHWAYS[] = {
+        "motorway", "trunk", "primary", "secondary", "tertiary", "unclassified",
+        "residential", "service", "living_street", "road", "motorway_link",
+        "trunk_link", "primary_link", "secondary_link", "tertiary_link"
+    };
+    for (const char* h: HIGHWAYS)
+    {
+        if (std::strcmp(h, highway) == 0)
+            return true;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+//! \brief Parse the integer tag value (i.e. "2") or return the default value.
+//------------------------------------------------------------------------------
+static size_t count(std::string const& value, size_t const otherwise)
+{
+    char* end;
+    long const n = std::strtol(value.c_str(), &end, 10);
+    return ((end == value.c_str()) || (n < 0)) ? otherwise : std::min(size_t(n), MAX_LANES);
+}
+
+// *****************************************************************************
+//! \brief First pass on OpenStreetMap files: keep drivable ways and parkings,
+//! and index the nodes they refer to.
+// *****************************************************************************
+class OsmWays : public XmlReader::Listener
+{
+public:
+
+    enum class Kind { Road, ParkingArea, ParkingSpace };
+
+    struct Way
+    {
+        Kind kind;
+        //! \brief Indices of nodes.
+        std::vector<uint32_t> nodes;
+        std::array<size_t, TrafficSide::Max> lanes;
+        //! \brief Width of the whole road [meter] or 0 if unknown.
+        double width;
+    };
+
+    void onStart(std::string const& name, XmlReader::Attributes const& attributes) override
+    {
+        if (name == "way")
+        {
+            m_inside = true;
+            m_refs.clear();
+            m_tags.clear();
+        }
+        else if (!m_inside)
+        {
+            return ;
+        }
+        else if (name == "nd")
+        {
+            if (const char* ref = attributes.get("ref"))
+                m_refs.push_back(std::strtoll(ref, nullptr, 10));
+        }
+        else if (name == "tag")
+        {
+            const char* k = attributes.get("k");
+            const char* v = attributes.get("v");
+            if ((k != nullptr) && (v != nullptr))
+                m_tags.emplace(k, v);
+        }
+    }
+
+    void onEnd(std::string const& name) override
+    {
+        if (name != "way")
+            return ;
+        m_inside = false;
+        if (m_refs.size() < 2u)
+            return ;
+
+        Way way;
+        std::string const amenity = tag("amenity");
+        std::string const highway = tag("highway");
+        if (amenity == "parking")
+            way.kind = Kind::ParkingArea;
+        else if (amenity == "parking_space")
+            way.kind = Kind::ParkingSpace;
+        else if (drivable(highway.c_str()) && (tag("area") != "yes"))
+            way.kind = Kind::Road;
+        else
+            return ;
+
+        if (way.kind == Kind::Road)
+        {
+            // Lanes of each direction (the right-hand traffic side follows
+            // the direction of the way).
+            std::string const oneway = tag("oneway");
+            bool const reverse = (oneway == "-1");
+            bool const one = reverse || (oneway == "yes") || (oneway == "true") ||
+                (oneway == "1") || (tag("junction") == "roundabout") ||
+                (((highway == "motorway") || (highway == "motorway_link")) && (oneway != "no"));
+            size_t const total = count(tag("lanes"), 0u);
+            size_t forward, backward;
+            if (one)
+            {
+                forward = std::max<size_t>(total, 1u);
+                backward = 0u;
+            }
+            else
+            {
+                forward = count(tag("lanes:forward"), (total > 1u) ? (total + 1u) / 2u : 1u);
+                backward = count(tag("lanes:backward"), (total > forward) ? total - forward : 1u);
+                forward = std::max<size_t>(forward, 1u);
+                backward = std::max<size_t>(backward, 1u);
+            }
+            way.lanes[TrafficSide::RightHand] = forward;
+            way.lanes[TrafficSide::LeftHand] = backward;
+            way.width = std::strtod(tag("width").c_str(), nullptr);
+            if (reverse)
+                std::reverse(m_refs.begin(), m_refs.end());
+        }
+
+        // Index nodes. Nodes shared by several roads are junctions.
+        way.nodes.reserve(m_refs.size());
+        for (int64_t const ref: m_refs)
+        {
+            auto it = indices.emplace(ref, uint32_t(usages.size()));
+            if (it.second)
+                usages.push_back(0u);
+            if (way.kind == Kind::Road)
+                ++usages[it.first->second];
+            way.nodes.push_back(it.first->second);
+        }
+        ways.push_back(std::move(way));
+    }
+
+    //! \brief Kept ways.
+    std::vector<Way> ways;
+    //! \brief Index of the nodes referred by kept ways.
+    std::unordered_map<int64_t, uint32_t> indices;
+    //! \brief Number of references of each node by roads.
+    std::vector<uint32_t> usages;
+
+private:
+
+    inline std::string tag(const char* key) const
+    {
+        auto it = m_tags.find(key);
+        return (it == m_tags.end()) ? std::string() : it->second;
+    }
+
+    bool m_inside = false;
+    std::vector<int64_t> m_refs;
+    std::unordered_map<std::string, std::string> m_tags;
+};
+
+// *****************************************************************************
+//! \brief Second pass on OpenStreetMap files: positions of the indexed nodes.
+// *****************************************************************************
+class OsmNodes : public XmlReader::Listener
+{
+public:
+
+    OsmNodes(std::unordered_map<int64_t, uint32_t> const& indices)
+        : m_indices(indices),
+          latitudes(indices.size(), std::numeric_limits<double>::quiet_NaN()),
+          longitudes(indices.size(), std::numeric_limits<double>::quiet_NaN())
+    {}
+
+    void onStart(std::string const& name, XmlReader::Attributes const& attributes) override
+    {
+        if (name != "node")
+            return ;
+        const char* id = attributes.get("id");
+        if (id == nullptr)
+            return ;
+        auto it = m_indices.find(std::strtoll(id, nullptr, 10));
+        if (it == m_indices.end())
+            return ;
+        latitudes[it->second] = attributes.number("lat", std::numeric_limits<double>::quiet_NaN());
+        longitudes[it->second] = attributes.number("lon", std::numeric_limits<double>::quiet_NaN());
+    }
+
+    void onEnd(std::string const& /*name*/) override
+    {}
+
+private:
+
+    std::unordered_map<int64_t, uint32_t> const& m_indices;
+
+public:
+
+    //! \brief Coordinates of indexed nodes [degree] (NaN if missing).
+    std::vector<double> latitudes;
+    std::vector<double> longitudes;
+};
+
+// *****************************************************************************
+//! \brief OpenDRIVE roads.
+// *****************************************************************************
+class OpenDriveRoads : public XmlReader::Listener
+{
+public:
+
+    struct ParkingSpace
+    {
+        double s, t, heading;
+    };
+
+    struct Road
+    {
+        double x = 0.0, y = 0.0, heading = 0.0;
+        std::vector<math::Clothoid> segments;
+        std::array<size_t, TrafficSide::Max> lanes{ 0u, 0u };
+        double width = 0.0;
+        std::vector<ParkingSpace> parkings;
+    };
+
+    void onStart(std::string const& name, XmlReader::Attributes const& a) override
+    {
+        if (name == "road")
+        {
+            m_road = Road();
+            m_inside = true;
+            m_sections = 0u;
+            m_geometries = 0u;
+        }
+        else if (!m_inside)
+        {
+            return ;
+        }
+        else if (name == "geometry")
+        {
+            if (m_geometries++ == 0u)
+            {
+                m_road.x = a.number("x");
+                m_road.y = a.number("y");
+                m_road.heading = a.number("hdg");
+            }
+            m_length = a.number("length");
+        }
+        else if (name == "line")
+        {
+            m_road.segments.push_back({ m_length, 0.0, 0.0 });
+        }
+        else if (name == "arc")
+        {
+            double const c = a.number("curvature");
+            m_road.segments.push_back({ m_length, c, c });
+        }
+        else if (name == "spiral")
+        {
+            m_road.segments.push_back({ m_length, a.number("curvStart"), a.number("curvEnd") });
+        }
+        else if ((name == "poly3") || (name == "paramPoly3"))
+        {
+            // Approximated by a straight line of the same length.
+            m_road.segments.push_back({ m_length, 0.0, 0.0 });
+            ++approximations;
+        }
+        else if (name == "laneSection")
+        {
+            ++m_sections;
+        }
+        else if ((name == "left") || (name == "right") || (name == "center"))
+        {
+            m_side = (name == "left") ? TrafficSide::LeftHand
+                   : ((name == "right") ? TrafficSide::RightHand : TrafficSide::Max);
+        }
+        else if (name == "lane")
+        {
+            const char* type = a.get("type");
+            m_driving = (m_sections == 1u) && (m_side != TrafficSide::Max) &&
+                        (type != nullptr) && (std::strcmp(type, "driving") == 0);
+            if (m_driving)
+                m_road.lanes[m_side] = std::min(m_road.lanes[m_side] + 1u, MAX_LANES);
+        }
+        else if (name == "width")
+        {
+            if (m_driving && (m_road.width <= 0.0))
+                m_road.width = a.number("a");
+        }
+        else if (name == "object")
+        {
+            const char* type = a.get("type");
+            if ((type != nullptr) && (std::strcmp(type, "parkingSpace") == 0))
+                m_road.parkings.push_back({ a.number("s"), a.number("t"), a.number("hdg") });
+        }
+    }
+
+    void onEnd(std::string const& name) override
+    {
+        if (name == "lane")
+        {
+            m_driving = false;
+        }
+        else if ((name == "road") && m_inside)
+        {
+            m_inside = false;
+            if (!m_road.segments.empty() && (m_road.lanes[0] + m_road.lanes[1] > 0u))
+                roads.push_back(std::move(m_road));
+        }
+    }
+
+    //! \brief Roads having driving lanes.
+    std::vector<Road> roads;
+    //! \brief Number of geometries approximated by lines.
+    size_t approximations = 0u;
+
+private:
+
+    Road m_road;
+    bool m_inside = false;
+    bool m_driving = false;
+    size_t m_sections = 0u;
+    size_t m_geometries = 0u;
+    size_t m_side = TrafficSide::Max;
+    double m_length = 0.0;
+};
+
+//------------------------------------------------------------------------------
+//! \brief Add a row of slots along the longest side of the polygon, inside it.
+//! \param[in] type: blueprint of slots.
+//! \param[in] max: maximum number of slots.
+//------------------------------------------------------------------------------
+static size_t parkings(City& city, std::vector<sf::Vector2<Meter>> const& polygon,
+                       const char* type, size_t const max)
+{
+    if (polygon.size() < 3u)
+        return 0u;
+
+    // Longest side and centroid.
+    size_t longest = 0u;
+    double length = 0.0;
+    sf::Vector2<double> centroid(0.0, 0.0);
+    for (size_t i = 0u; i < polygon.size(); ++i)
+    {
+        sf::Vector2<Meter> const& a = polygon[i];
+        sf::Vector2<Meter> const& b = polygon[(i + 1u) % polygon.size()];
+        double const l = math::distance(a, b).value();
+        if (l > length)
+        {
+            length = l;
+            longest = i;
+        }
+        centroid.x += a.x.value() / double(polygon.size());
+        centroid.y += a.y.value() / double(polygon.size());
+    }
+
+    // Slots extend on the right of the side: take the side in the direction
+    // having the centroid on its right.
+    sf::Vector2<Meter> a = polygon[longest];
+    sf::Vector2<Meter> b = polygon[(longest + 1u) % polygon.size()];
+    double ux = (b.x - a.x).value() / length, uy = (b.y - a.y).value() / length;
+    if (uy * (centroid.x - a.x.value()) - ux * (centroid.y - a.y.value()) < 0.0)
+    {
+        std::swap(a, b);
+        ux = -ux; uy = -uy;
+    }
+    Radian const heading(std::atan2(uy, ux));
+
+    ParkingBluePrint const& blueprint = BluePrints::get<ParkingBluePrint>(type);
+    double const step = (blueprint.angle.value() == 0.0) ? blueprint.length.value()
+                                                          : blueprint.width.value();
+    size_t const n = std::min(max, size_t(length / step));
+    for (size_t i = 0u; i < n; ++i)
+    {
+        double const k = double(i + ((blueprint.angle.value() == 0.0) ? 0u : 1u)) * step;
+        city.addParking(type, sf::Vector2<Meter>(a.x + Meter(k * ux), a.y + Meter(k * uy)),
+                        -heading);
+    }
+    return n;
+}
+
+//------------------------------------------------------------------------------
+bool MapImporter::fail(std::string const& reason)
+{
+    m_error = reason;
+    LOGE("%s", reason.c_str());
+    return false;
+}
+
+//------------------------------------------------------------------------------
+size_t MapImporter::build(std::vector<Plan> const& plans, City& city) const
+{
+    std::vector<std::unique_ptr<Road>> roads(plans.size());
+    {
+        ThreadPool pool(m_config.threads);
+        size_t const jobs = std::min(plans.size(), 4u * pool.size());
+        std::vector<std::future<void>> futures;
+        for (size_t j = 0u; j < jobs; ++j)
+        {
+            futures.push_back(pool.submit([&plans, &roads, j, jobs]()
+            {
+                for (size_t i = j; i < plans.size(); i += jobs)
+                {
+                    Plan const& p = plans[i];
+                    if (p.segments.empty())
+                        roads[i] = std::make_unique<Road>(p.centers, p.width, p.lanes);
+                    else
+                        roads[i] = std::make_unique<Road>(p.start, p.heading, p.segments,
+                                                          p.width, p.lanes);
+                }
+            }));
+        }
+        for (auto& future: futures)
+        {
+            future.get();
+        }
+    }
+
+    size_t lanes = 0u;
+    for (size_t i = 0u; i < roads.size(); ++i)
+    {
+        lanes += plans[i].lanes[TrafficSide::RightHand] + plans[i].lanes[TrafficSide::LeftHand];
+        city.addRoad(std::move(roads[i]));
+    }
+    return lanes;
+}
+
+//------------------------------------------------------------------------------
+bool MapImporter::importOSM(std::string const& path, City& city, Path* network)
+{
+    // Ways then the nodes they refer to.
+    XmlReader reader;
+    OsmWays ways;
+    if (!reader.parse(path, ways))
+        return fail("Failed reading '" + path + "': " + reader.error());
+    OsmNodes nodes(ways.indices);
+    if (!reader.parse(path, nodes))
+        return fail("Failed reading '" + path + "': " + reader.error());
+
+    // Projection on the plane tangent to the center of the map.
+    double lat0 = 90.0, lat1 = -90.0, lon0 = 180.0, lon1 = -180.0;
+    for (size_t i = 0u; i < nodes.latitudes.size(); ++i)
+    {
+        if (std::isnan(nodes.latitudes[i]) || std::isnan(nodes.longitudes[i]))
+            continue ;
+        lat0 = std::min(lat0, nodes.latitudes[i]); lat1 = std::max(lat1, nodes.latitudes[i]);
+        lon0 = std::min(lon0, nodes.longitudes[i]); lon1 = std::max(lon1, nodes.longitudes[i]);
+    }
+    double const latc = (lat0 + lat1) / 2.0, lonc = (lon0 + lon1) / 2.0;
+    double const rad = Radian(1.0_deg).value();
+    double const scale = std::cos(latc * rad);
+    auto project = [&](uint32_t const i, sf::Vector2<Meter>& p)
+    {
+        if (std::isnan(nodes.latitudes[i]) || std::isnan(nodes.longitudes[i]))
+            return false;
+        p.x = Meter(EARTH_RADIUS * (nodes.longitudes[i] - lonc) * rad * scale);
+        p.y = Meter(EARTH_RADIUS * (nodes.latitudes[i] - latc) * rad);
+        return true;
+    };
+
+    // Roads split at junctions.
+    std::vector<Plan> plans;
+    std::vector<std::pair<uint32_t, uint32_t>> extremities;
+    std::vector<std::vector<sf::Vector2<Meter>>> areas, spaces;
+    for (OsmWays::Way const& way: ways.ways)
+    {
+        std::vector<sf::Vector2<Meter>> points;
+        sf::Vector2<Meter> p;
+        if (way.kind != OsmWays::Kind::Road)
+        {
+            for (uint32_t const n: way.nodes)
+            {
+                if (project(n, p))
+                    points.push_back(p);
+            }
+            // Closed ways repeat their first node.
+            if ((points.size() > 1u) && (math::distance(points.front(), points.back()) < 0.01_m))
+                points.pop_back();
+            ((way.kind == OsmWays::Kind::ParkingArea) ? areas : spaces).push_back(std::move(points));
+            continue ;
+        }
+
+        size_t const total = way.lanes[0] + way.lanes[1];
+        Meter const width = (way.width > 0.0) ? Meter(way.width / double(total))
+                                              : Meter(m_config.lane_width);
+        uint32_t first = way.nodes.front();
+        for (size_t i = 0u; i < way.nodes.size(); ++i)
+        {
+            uint32_t const n = way.nodes[i];
+            if (project(n, p) && (points.empty() || (math::distance(points.back(), p) > 0.01_m)))
+                points.push_back(p);
+
+            bool const last = (i + 1u == way.nodes.size());
+            if ((i > 0u) && (last || (ways.usages[n] > 1u)))
+            {
+                if (points.size() >= 2u)
+                {
+                    plans.push_back({ points, {}, Radian(0.0), {}, width, way.lanes });
+                    extremities.emplace_back(first, n);
+                }
+                points.clear();
+                if (project(n, p))
+                    points.push_back(p);
+                first = n;
+            }
+        }
+    }
+
+    size_t const first_road = city.roads().size();
+    size_t const lanes = build(plans, city);
+
+    // Junctions and roads of the network.
+    if (network != nullptr)
+    {
+        std::unordered_map<uint32_t, Node*> junctions;
+        for (size_t i = 0u; i < plans.size(); ++i)
+        {
+            Road const& road = *city.roads()[first_road + i];
+            Node*& from = junctions[extremities[i].first];
+            if (from == nullptr)
+                from = &network->addNode(road.origin());
+            Node*& to = junctions[extremities[i].second];
+            if (to == nullptr)
+                to = &network->addNode(road.destination());
+            if (from != to)
+                network->addWay(*from, *to);
+        }
+    }
+
+    // Parkings.
+    size_t slots = 0u;
+    for (auto const& area: areas)
+    {
+        slots += parkings(city, area, "epi.90", std::numeric_limits<size_t>::max());
+    }
+    for (auto const& space: spaces)
+    {
+        slots += parkings(city, space, "epi.0", 1u);
+    }
+
+    LOGI("Imported '%s': %zu roads, %zu lanes, %zu parking slots", path.c_str(),
+         plans.size(), lanes, slots);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool MapImporter::importOpenDRIVE(std::string const& path, City& city)
+{
+    XmlReader reader;
+    OpenDriveRoads listener;
+    if (!reader.parse(path, listener))
+        return fail("Failed reading '" + path + "': " + reader.error());
+    if (listener.approximations != 0u)
+    {
+        LOGW("'%s': %zu polynomial geometries approximated by lines", path.c_str(),
+             listener.approximations);
+    }
+
+    std::vector<Plan> plans;
+    for (OpenDriveRoads::Road const& road: listener.roads)
+    {
+        Meter const width = (road.width > 0.0) ? Meter(road.width) : Meter(m_config.lane_width);
+        plans.push_back({ {}, { Meter(road.x), Meter(road.y) }, Radian(road.heading),
+                          road.segments, width, road.lanes });
+    }
+
+    size_t const first_road = city.roads().size();
+    size_t const lanes = build(plans, city);
+
+    // Parking spaces are placed relatively to the reference line of roads.
+    size_t slots = 0u;
+    for (size_t i = 0u; i < listener.roads.size(); ++i)
+    {
+        math::Frenet const& frenet = city.roads()[first_road + i]->frenet();
+        for (OpenDriveRoads::ParkingSpace const& space: listener.roads[i].parkings)
+        {
+            math::Frenet::Position const p = frenet.toCartesian({ space.s, space.t });
+            Radian const heading(frenet.heading(space.s) + space.heading);
+            city.addParking("epi.0", { Meter(p.x), Meter(p.y) }, -heading);
+            ++slots;
+        }
+    }
+
+    LOGI("Imported '%s': %zu roads, %zu lanes, %zu parking slots", path.c_str(),
+         plans.size(), lanes, slots);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool MapImporter::load(std::string const& path, City& city, std::string const& cache)
+{
+    // The cache is used when more recent than the map.
+    std::error_code ec1, ec2;
+    if (!cache.empty() && city.roads().empty() && fs::exists(cache, ec1) &&
+        (fs::last_write_time(cache, ec1) >= fs::last_write_time(path, ec2)) && !ec1 && !ec2)
+    {
+        CityFile file;
+        if (file.open(cache) && file.load(city))
+            return true;
+    }
+
+    std::string const extension = fs::path(path).extension().string();
+    bool imported;
+    if (extension == ".osm")
+        imported = importOSM(path, city);
+    else if (extension == ".xodr")
+        imported = importOpenDRIVE(path, city);
+    else
+        return fail("Unknown map format '" + path + "'");
+
+    if (imported && !cache.empty())
+    {
+        CityFile::save(city, cache);
+    }
+    return imported;
+}
@@ -0,0 +1,147 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef MAP_IMPORTER_HPP
+#  define MAP_IMPORTER_HPP
+
+#  include "City/Road.hpp"
+#  include <string>
+
+class City;
+class Path;
+
+// *****************************************************************************
+//! \brief Create roads and parkings of a city from real maps:
+//!   - OpenStreetMap XML files (.osm): ways tagged as drivable highways become
+//!     roads (lanes from the lanes, lanes:forward, lanes:backward, oneway and
+//!     width tags), split at junctions. Parking areas become rows of
+//!     perpendicular slots along their longest side and parking spaces become
+//!     parallel slots. Optionally, junctions and roads are added to a Path
+//!     (network).
+//!   - OpenDRIVE files (.xodr): the plan view (lines, arcs, spirals) of roads
+//!     becomes clothoid roads, the driving lanes of their first lane section
+//!     give the number and width of lanes, and parkingSpace objects become
+//!     parallel slots.
+//! Files are read by a streaming XML reader: the memory only holds what is
+//! kept from the map. OpenStreetMap files are read twice (ways then the nodes
+//! they refer to) so unused nodes are never stored. Roads are built by worker
+//! threads. The result can be written in a CityFile loaded instead of the map
+//! the next times.
+// *****************************************************************************
+class MapImporter
+{
+public:
+
+    // *************************************************************************
+    //! \brief Tuning of the import.
+    // *************************************************************************
+    struct Config
+    {
+        //! \brief Width of lanes when the map does not give it [meter].
+        double lane_width = 3.0;
+        //! \brief Number of threads building roads (0: number of CPU cores).
+        size_t threads = 0u;
+    };
+
+public:
+
+    MapImporter()
+        : m_config()
+    {}
+
+    MapImporter(Config const& config)
+        : m_config(config)
+    {}
+
+    //--------------------------------------------------------------------------
+    //! \brief Import the map (the format is given by the extension of the
+    //! file: .osm or .xodr) into the city.
+    //! \param[in] cache: if not empty, path of a CityFile: loaded instead of
+    //! the map if more recent than the map, else written after the import.
+    //! The city shall not have roads for using the cache.
+    //! \return false if the map cannot be read (see error()).
+    //--------------------------------------------------------------------------
+    bool load(std::string const& path, City& city, std::string const& cache = "");
+
+    //--------------------------------------------------------------------------
+    //! \brief Import an OpenStreetMap XML file into the city. Positions are
+    //! projected on the plane tangent to the center of the map (meters, x to
+    //! the east, y to the north).
+    //! \param[out] network: if not null, junctions and roads are added as
+    //! nodes and ways.
+    //--------------------------------------------------------------------------
+    bool importOSM(std::string const& path, City& city, Path* network = nullptr);
+
+    //--------------------------------------------------------------------------
+    //! \brief Import an OpenDRIVE file into the city.
+    //--------------------------------------------------------------------------
+    bool importOpenDRIVE(std::string const& path, City& city);
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the reason of the last failure.
+    //--------------------------------------------------------------------------
+    inline std::string const& error() const
+    {
+        return m_error;
+    }
+
+private:
+
+    // *************************************************************************
+    //! \brief Road to be built: either a polyline or consecutive clothoids.
+    // *************************************************************************
+    struct Plan
+    {
+        //! \brief Center line (when segments are empty).
+        std::vector<sf::Vector2<Meter>> centers;
+        //! \brief Start of the clothoids.
+        sf::Vector2<Meter> start;
+        //! \brief Initial heading of the clothoids.
+        Radian heading;
+        //! \brief Clothoids of the center line.
+        std::vector<math::Clothoid> segments;
+        //! \brief Width of lanes.
+        Meter width;
+        //! \brief Number of lanes of each traffic side.
+        std::array<size_t, TrafficSide::Max> lanes;
+    };
+
+    //--------------------------------------------------------------------------
+    //! \brief Build roads by worker threads and add them to the city in the
+    //! order of plans. Roads and lanes are not logged one by one.
+    //! \return the number of lanes built.
+    //--------------------------------------------------------------------------
+    size_t build(std::vector<Plan> const& plans, City& city) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Memorize the reason of the failure.
+    //--------------------------------------------------------------------------
+    bool fail(std::string const& reason);
+
+private:
+
+    //! \brief Tuning of the import.
+    Config m_config;
+    //! \brief Reason of the last failure.
+    std::string m_error;
+};
+
+#endif
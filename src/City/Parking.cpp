@@ -109,23 +109,43 @@ void Parking::update(Second const /*dt*/)
     }
 }
 
+//------------------------------------------------------------------------------
+void Parking::goal(CarBluePrint const& car, sf::Vector2<Meter>& position_,
+                   Radian& heading_) const
+{
+    // Parking coordinates: center the car along the parking slot length.
+    Meter x = car.back_overhang + (blueprint.length - car.length) / 2.0;
+    sf::Vector2<Meter> const offset(x, -blueprint.width / 2.0);
+
+    // Convert the offset in the world coordinates. The car is aligned on the
+    // slot shape.
+    heading_ = axis();
+    position_ = position() + math::heading(offset, heading_);
+}
+
 //------------------------------------------------------------------------------
 bool Parking::bind(Car& car)
 {
     if (!setOccupied(car))
         return false;
 
-    // Parking coordinates: center the car along the parking slot length.
-    Meter x = car.blueprint.back_overhang +
-              (blueprint.length - car.blueprint.length) / 2.0f;
-    sf::Vector2<Meter> const offset(x, -blueprint.width / 2.0);
-
-    // Convert the offset in the world coordinates.
-    sf::Vector2<Meter> const p = position() + math::heading(offset, blueprint.angle - m_heading);
+    sf::Vector2<Meter> p;
+    Radian heading_;
+    goal(car.blueprint, p, heading_);
 
     // Init vehicle states.
-    car.init(0.0_mps_sq, 0.0_mps, p, blueprint.angle - m_heading, 0.0_rad);
+    car.init(0.0_mps_sq, 0.0_mps, p, heading_, 0.0_rad);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool Parking::unbind(Car const& car)
+{
+    if (m_car != &car)
+        return false;
 
+    m_car = nullptr;
     return true;
 }
 
@@ -30,6 +30,7 @@
 #  include <map>
 
 class Car;
+struct CarBluePrint;
 
 // *************************************************************************
 //! \brief Class holding parking slot dimensions
@@ -133,11 +134,35 @@ public:
     //--------------------------------------------------------------------------
     bool bind(Car& car);
 
+    //--------------------------------------------------------------------------
+    //! \brief Set the slot free if it was occupied by the given car (i.e. when
+    //! the car is removed from the city).
+    //! \return true if the car was occupying the slot.
+    //--------------------------------------------------------------------------
+    bool unbind(Car const& car);
+
+    //--------------------------------------------------------------------------
+    //! \brief Compute the pose of a car once parked in the middle of this slot.
+    //! This is the pose used by bind() and the destination of auto-parking
+    //! trajectories.
+    //! \param[in] car: the dimension of the car to park.
+    //! \param[out] position: the world position of the middle of the rear
+    //! axle of the parked car.
+    //! \param[out] heading: the heading of the parked car.
+    //--------------------------------------------------------------------------
+    void goal(CarBluePrint const& car, sf::Vector2<Meter>& position,
+              Radian& heading) const;
+
     //--------------------------------------------------------------------------
     //! \brief Is the parking occupied by a parked car ?
     //--------------------------------------------------------------------------
     inline bool empty() const { return m_car == nullptr; }
 
+    //--------------------------------------------------------------------------
+    //! \brief Is the given car parked in this slot ?
+    //--------------------------------------------------------------------------
+    inline bool holds(Car const& car) const { return m_car == &car; }
+
     //--------------------------------------------------------------------------
     //! \brief Parked car getter (non const).
     //--------------------------------------------------------------------------
@@ -151,8 +176,7 @@ public:
     sf::Vector2<Meter> origin() const
     {
         return position() + math::heading(
-            sf::Vector2<Meter>(0.0_m, -blueprint.width / 2.0),
-            blueprint.angle - m_heading);
+            sf::Vector2<Meter>(0.0_m, -blueprint.width / 2.0), axis());
     }
 
     //--------------------------------------------------------------------------
@@ -167,10 +191,18 @@ public:
     }
 
     //-------------------------------------------------------------------------
-    //! \brief Const getter: return the oriented bounding box of the parking.
+    //! \brief Const getter: return the heading of the parking (the opposite
+    //! of the road heading).
     //-------------------------------------------------------------------------
     inline Radian const& heading() const { return m_heading; }
 
+    //-------------------------------------------------------------------------
+    //! \brief Return the direction of the length of the slot in the world
+    //! coordinate, i.e. the heading of the parked car. The slot shape is
+    //! rotated by this angle.
+    //-------------------------------------------------------------------------
+    inline Radian axis() const { return -(Radian(blueprint.angle) + m_heading); }
+
     //-------------------------------------------------------------------------
     //! \brief Const getter: return the oriented bounding box of the parking.
     //-------------------------------------------------------------------------
@@ -182,8 +214,7 @@ public:
     sf::Vector2<Meter> delta() const
     {
         return position() + math::heading(
-            sf::Vector2<Meter>(blueprint.length, 0.0_m),
-            blueprint.angle - m_heading);
+            sf::Vector2<Meter>(blueprint.length, 0.0_m), axis());
     }
 
     //--------------------------------------------------------------------------
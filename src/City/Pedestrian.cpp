@@ -20,3 +20,306 @@
 //=====================================================================
 
 #include "City/Pedestrian.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+// Max number of cells of the spatial hash grid along each axis.
+static constexpr uint32_t MAX_CELLS = 512u;
+
+//------------------------------------------------------------------------------
+Pedestrian::Pedestrian(const char* name_, std::vector<sf::Vector2<Meter>> const& path,
+                       MeterPerSecond const speed, Meter const radius)
+    : name(name_), m_path(path), m_waypoint(1u), m_desired_speed(speed),
+      m_max_speed(speed), m_radius(radius), m_velocity(0.0, 0.0),
+      m_force(0.0, 0.0)
+{
+    assert(!path.empty() && "Pedestrian with no path");
+
+    float const r = float(radius.value());
+    m_obb.setSize(sf::Vector2f(2.0f * r, 2.0f * r));
+    m_obb.setOrigin(sf::Vector2f(r, r));
+    Movable::init(MeterPerSecondSquared(0.0), MeterPerSecond(0.0), path[0], Radian(0.0));
+    m_obb.setPosition(float(m_position.x.value()), float(m_position.y.value()));
+}
+
+//------------------------------------------------------------------------------
+void Pedestrian::update(Second const dt)
+{
+    double const t = dt.value();
+    m_velocity += m_force * t;
+
+    double const max_speed = m_max_speed.value();
+    double const speed = std::sqrt(m_velocity.x * m_velocity.x + m_velocity.y * m_velocity.y);
+    if (speed > max_speed)
+    {
+        m_velocity = m_velocity * (max_speed / speed);
+    }
+
+    m_position.x += Meter(m_velocity.x * t);
+    m_position.y += Meter(m_velocity.y * t);
+    m_speed = MeterPerSecond(std::min(speed, max_speed));
+    m_acceleration = MeterPerSecondSquared(std::sqrt(m_force.x * m_force.x + m_force.y * m_force.y));
+    if (speed > 1e-3)
+    {
+        m_heading = Radian(std::atan2(m_velocity.y, m_velocity.x));
+    }
+
+    m_obb.setPosition(float(m_position.x.value()), float(m_position.y.value()));
+    m_obb.setRotation(float(Degree(m_heading).value()));
+}
+
+//------------------------------------------------------------------------------
+size_t Crowd::add(const char* name, std::vector<sf::Vector2<Meter>> const& path,
+                  MeterPerSecond const speed, Meter const radius)
+{
+    m_pedestrians.emplace_back(name, path, speed, radius);
+    m_pedestrians.back().m_max_speed = speed * m_config.max_speed_factor;
+    m_outdated = true;
+    return m_pedestrians.size() - 1u;
+}
+
+//------------------------------------------------------------------------------
+void Crowd::clear()
+{
+    m_pedestrians.clear();
+    m_items.clear();
+    m_grid.clear();
+    m_obstacle_items.clear();
+    m_obstacles.clear();
+    m_outdated = true;
+}
+
+//------------------------------------------------------------------------------
+void Crowd::index() const
+{
+    if (!m_outdated)
+        return ;
+    m_outdated = false;
+
+    // Grow the grid when pedestrians have walked outside it. Pedestrians
+    // outside the grid are still found (they are hold by border cells) but
+    // neighbour queries become slower.
+    sf::FloatRect const& bounds = m_grid.bounds();
+    float x0 = bounds.left, x1 = bounds.left + bounds.width;
+    float y0 = bounds.top, y1 = bounds.top + bounds.height;
+    bool resize = false;
+    for (Pedestrian const& p: m_pedestrians)
+    {
+        float const x = float(p.position().x.value());
+        float const y = float(p.position().y.value());
+        if ((x < x0) || (x > x1) || (y < y0) || (y > y1))
+        {
+            resize = true;
+            x0 = std::min(x0, x - float(m_config.horizon));
+            x1 = std::max(x1, x + float(m_config.horizon));
+            y0 = std::min(y0, y - float(m_config.horizon));
+            y1 = std::max(y1, y + float(m_config.horizon));
+        }
+    }
+    if (resize)
+    {
+        sf::Vector2u const dimensions(
+            std::min(MAX_CELLS, uint32_t(std::ceil((x1 - x0) / m_config.cell_size))),
+            std::min(MAX_CELLS, uint32_t(std::ceil((y1 - y0) / m_config.cell_size))));
+        m_grid.resize(sf::FloatRect(x0, y0, x1 - x0, y1 - y0),
+                      sf::Vector2u(std::max(1u, dimensions.x), std::max(1u, dimensions.y)));
+    }
+    else
+    {
+        m_grid.clear();
+    }
+
+    m_items.resize(m_pedestrians.size());
+    for (size_t i = 0u; i < m_pedestrians.size(); ++i)
+    {
+        Pedestrian const& p = m_pedestrians[i];
+        SpatialHashGrid::Item& item = m_items[i];
+        float const diameter = 2.0f * float(p.radius().value());
+        item.position = sf::Vector2f(float(p.position().x.value()), float(p.position().y.value()));
+        item.dimension = sf::Vector2f(diameter, diameter);
+        item.id = i;
+        m_grid.add(item);
+    }
+}
+
+//------------------------------------------------------------------------------
+void Crowd::index(std::vector<sf::RectangleShape const*> const& obstacles)
+{
+    m_obstacle_items.resize(obstacles.size());
+    if (obstacles.empty())
+    {
+        m_obstacles.clear();
+        return ;
+    }
+
+    // The grid is fitted to the obstacles.
+    float x0 = std::numeric_limits<float>::max(), y0 = x0;
+    float x1 = -x0, y1 = -x0;
+    for (size_t i = 0u; i < obstacles.size(); ++i)
+    {
+        sf::FloatRect const box = obstacles[i]->getGlobalBounds();
+        SpatialHashGrid::Item& item = m_obstacle_items[i];
+        item.position = sf::Vector2f(box.left + box.width / 2.0f, box.top + box.height / 2.0f);
+        item.dimension = sf::Vector2f(box.width, box.height);
+        item.id = i;
+        x0 = std::min(x0, box.left);
+        y0 = std::min(y0, box.top);
+        x1 = std::max(x1, box.left + box.width);
+        y1 = std::max(y1, box.top + box.height);
+    }
+
+    float const cell = m_config.obstacle_cell_size;
+    sf::Vector2u const dimensions(
+        std::min(MAX_CELLS, uint32_t(std::ceil((x1 - x0) / cell))),
+        std::min(MAX_CELLS, uint32_t(std::ceil((y1 - y0) / cell))));
+    m_obstacles.resize(sf::FloatRect(x0, y0, x1 - x0, y1 - y0),
+                       sf::Vector2u(std::max(1u, dimensions.x), std::max(1u, dimensions.y)));
+    for (SpatialHashGrid::Item& item: m_obstacle_items)
+    {
+        m_obstacles.add(item);
+    }
+}
+
+//------------------------------------------------------------------------------
+void Crowd::update(Second const dt, std::vector<sf::RectangleShape const*> const& obstacles,
+                   Tiles const* tiles)
+{
+    index();
+    index(obstacles);
+
+    double const horizon = m_config.horizon;
+    float const area = float(2.0 * horizon);
+
+    // Social forces from the current positions.
+    for (size_t i = 0u; i < m_pedestrians.size(); ++i)
+    {
+        Pedestrian& p = m_pedestrians[i];
+        if ((tiles != nullptr) && !tiles->active(p.position()))
+            continue ;
+
+        double const x = p.position().x.value();
+        double const y = p.position().y.value();
+        double const r = p.radius().value();
+
+        // Attraction of the next waypoint.
+        sf::Vector2<double> desired(0.0, 0.0);
+        if (!p.arrived())
+        {
+            double dx = p.m_path[p.m_waypoint].x.value() - x;
+            double dy = p.m_path[p.m_waypoint].y.value() - y;
+            double d = std::sqrt(dx * dx + dy * dy);
+            if ((d < m_config.waypoint_radius) && (++p.m_waypoint < p.m_path.size()))
+            {
+                dx = p.m_path[p.m_waypoint].x.value() - x;
+                dy = p.m_path[p.m_waypoint].y.value() - y;
+                d = std::sqrt(dx * dx + dy * dy);
+            }
+            if ((!p.arrived()) && (d > 1e-6))
+            {
+                desired = sf::Vector2<double>(dx, dy) * (p.m_desired_speed.value() / d);
+            }
+        }
+        sf::Vector2<double> force = (desired - p.m_velocity) / m_config.relaxation;
+
+        // Repulsion of neighbours.
+        sf::FloatRect const around(float(x - horizon), float(y - horizon), area, area);
+        m_grid.findNear(around, m_neighbours);
+        for (SpatialHashGrid::Item const* item: m_neighbours)
+        {
+            if (item->id == i)
+                continue ;
+            Pedestrian const& o = m_pedestrians[item->id];
+            double const dx = x - o.position().x.value();
+            double const dy = y - o.position().y.value();
+            double const d = std::sqrt(dx * dx + dy * dy);
+            if ((d > horizon) || (d < 1e-6))
+                continue ;
+            double const f = m_config.repulsion *
+                             std::exp((r + o.radius().value() - d) / m_config.range) / d;
+            force.x += f * dx;
+            force.y += f * dy;
+        }
+
+        // Repulsion of the nearest point of obstacles.
+        m_near_obstacles.clear();
+        if (!m_obstacle_items.empty() && m_obstacles.bounds().intersects(around))
+        {
+            m_obstacles.findNear(around, m_near_obstacles);
+        }
+        for (SpatialHashGrid::Item const* item: m_near_obstacles)
+        {
+            sf::RectangleShape const* obb = obstacles[item->id];
+            sf::Vector2f const& size = obb->getSize();
+            sf::Vector2f const& center = obb->getPosition();
+            double const cx = x - double(center.x);
+            double const cy = y - double(center.y);
+            double const reach = horizon + double(size.x + size.y);
+            if (cx * cx + cy * cy > reach * reach)
+                continue ;
+
+            sf::Vector2f const local = obb->getInverseTransform().transformPoint(float(x), float(y));
+            sf::Vector2f const nearest = obb->getTransform().transformPoint(
+                std::min(std::max(local.x, 0.0f), size.x),
+                std::min(std::max(local.y, 0.0f), size.y));
+            double dx = x - double(nearest.x);
+            double dy = y - double(nearest.y);
+            double d = std::sqrt(dx * dx + dy * dy);
+            if (d < 1e-6)
+            {
+                // Inside the obstacle: push away from its origin.
+                dx = cx; dy = cy; d = -std::sqrt(dx * dx + dy * dy);
+                if (d > -1e-6)
+                    continue ;
+            }
+            else if (d > horizon)
+            {
+                continue ;
+            }
+            double const f = m_config.obstacle_repulsion *
+                             std::exp((r - d) / m_config.obstacle_range);
+            double const nx = dx / std::abs(d);
+            double const ny = dy / std::abs(d);
+            force.x += f * nx;
+            force.y += f * ny;
+
+            // When walking toward the obstacle, slide along it on the side of
+            // the pedestrian, else the repulsion just stops the pedestrian.
+            double const facing = (p.m_desired_speed.value() <= 0.0) ? 0.0
+                : (desired.x * nx + desired.y * ny) / p.m_desired_speed.value();
+            if (facing < 0.0)
+            {
+                sf::Vector2f const middle = obb->getTransform().transformPoint(size / 2.0f);
+                double const side = (x - double(middle.x)) * -ny + (y - double(middle.y)) * nx;
+                double const t = (side >= 0.0) ? -f * facing : f * facing;
+                force.x -= t * ny;
+                force.y += t * nx;
+            }
+        }
+
+        p.m_force = force;
+    }
+
+    // Then move all pedestrians.
+    for (Pedestrian& p: m_pedestrians)
+    {
+        if ((tiles == nullptr) || tiles->active(p.position()))
+        {
+            p.update(dt);
+        }
+    }
+    m_outdated = true;
+}
+
+//------------------------------------------------------------------------------
+void Crowd::find(sf::FloatRect const& area, std::vector<Pedestrian const*>& result) const
+{
+    index();
+    m_grid.findNear(area, m_neighbours);
+    result.clear();
+    for (SpatialHashGrid::Item const* item: m_neighbours)
+    {
+        result.push_back(&m_pedestrians[item->id]);
+    }
+}
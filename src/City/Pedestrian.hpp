@@ -23,19 +23,223 @@
 #  define PEDESTRIAN_HPP
 
 #  include "Math/Movable.hpp"
+#  include "Common/SpatialHashGrid.hpp"
+#  include "City/Tiles.hpp"
+#  include <SFML/Graphics/RectangleShape.hpp>
+#  include <string>
+#  include <vector>
 
+// *****************************************************************************
+//! \brief Pedestrian walking along a path of waypoints (on sidewalks and
+//! crossings). Pedestrians are moved by the Crowd they belong to.
 // https://github.com/Stanford-ILIAD/CARLO/blob/master/example_intersection.py#L44
+// *****************************************************************************
 class Pedestrian: public Movable //, public DynamicActor
 {
+    friend class Crowd;
+
 public:
 
     //--------------------------------------------------------------------------
-    //! \brief Update discrete time equations from continuous time equations.
+    //! \brief Create a pedestrian standing at the first waypoint of the path.
+    //! \param[in] name: unique pedestrian name.
+    //! \param[in] path: waypoints to walk through (at least one).
+    //! \param[in] speed: desired walking speed [m/s].
+    //! \param[in] radius: radius of the body [meter].
+    //--------------------------------------------------------------------------
+    Pedestrian(const char* name, std::vector<sf::Vector2<Meter>> const& path,
+               MeterPerSecond const speed, Meter const radius);
+
     //--------------------------------------------------------------------------
-    virtual void update(Second const dt) override
+    //! \brief Integrate the force applied by the crowd.
+    //--------------------------------------------------------------------------
+    virtual void update(Second const dt) override;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the oriented bounding box (for sensors and collisions).
+    //--------------------------------------------------------------------------
+    inline sf::RectangleShape const& obb() const
     {
+        return m_obb;
+    }
 
+    //--------------------------------------------------------------------------
+    //! \brief Return the radius of the body.
+    //--------------------------------------------------------------------------
+    inline Meter radius() const
+    {
+        return m_radius;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Has the pedestrian reached the end of its path ?
+    //--------------------------------------------------------------------------
+    inline bool arrived() const
+    {
+        return m_waypoint >= m_path.size();
     }
+
+public:
+
+    //! \brief Unique pedestrian name.
+    std::string name;
+
+private:
+
+    //! \brief Waypoints to walk through.
+    std::vector<sf::Vector2<Meter>> m_path;
+    //! \brief Index of the current waypoint.
+    size_t m_waypoint = 0u;
+    //! \brief Desired walking speed [m/s].
+    MeterPerSecond m_desired_speed;
+    //! \brief Max walking speed when avoiding others [m/s].
+    MeterPerSecond m_max_speed;
+    //! \brief Radius of the body.
+    Meter m_radius;
+    //! \brief Velocity [m/s].
+    sf::Vector2<double> m_velocity;
+    //! \brief Social force computed by the crowd [m/s/s].
+    sf::Vector2<double> m_force;
+    //! \brief Bounding box.
+    sf::RectangleShape m_obb;
+};
+
+// *****************************************************************************
+//! \brief Pedestrians moved by the social force model (Helbing, Molnar,
+//! "Social force model for pedestrian dynamics", 1995): each pedestrian is
+//! attracted by its next waypoint and repulsed by its neighbours and by
+//! obstacles (i.e. cars). Neighbours and obstacles are found with spatial hash
+//! grids rebuilt at each update, so the cost is linear in the number of
+//! pedestrians and obstacles.
+//! Updates are batched: all forces are computed from the current positions,
+//! then all pedestrians are moved.
+// *****************************************************************************
+class Crowd
+{
+public:
+
+    // *************************************************************************
+    //! \brief Parameters of the social force model.
+    // *************************************************************************
+    struct Config
+    {
+        //! \brief Time to reach the desired velocity [s].
+        double relaxation = 0.5;
+        //! \brief Strength of the repulsion between pedestrians [m/s/s].
+        double repulsion = 10.0;
+        //! \brief Range of the repulsion between pedestrians [m].
+        double range = 0.3;
+        //! \brief Strength of the repulsion of obstacles [m/s/s].
+        double obstacle_repulsion = 5.0;
+        //! \brief Range of the repulsion of obstacles [m].
+        double obstacle_range = 0.4;
+        //! \brief Distance beyond which neighbours and obstacles are ignored [m].
+        double horizon = 2.0;
+        //! \brief Max speed relative to the desired speed.
+        double max_speed_factor = 1.3;
+        //! \brief Distance to a waypoint to consider it reached [m].
+        double waypoint_radius = 0.5;
+        //! \brief Size of the cells of the spatial hash grid [m].
+        float cell_size = 2.0f;
+        //! \brief Size of the cells of the grid of obstacles [m].
+        float obstacle_cell_size = 8.0f;
+    };
+
+public:
+
+    Crowd() = default;
+
+    Crowd(Config const& config)
+        : m_config(config)
+    {}
+
+    //--------------------------------------------------------------------------
+    //! \brief Add a pedestrian standing at the first waypoint of the path.
+    //! \return the index of the pedestrian in pedestrians(). Indices stay
+    //! valid until clear() while references are invalidated by add().
+    //--------------------------------------------------------------------------
+    size_t add(const char* name, std::vector<sf::Vector2<Meter>> const& path,
+               MeterPerSecond const speed, Meter const radius = Meter(0.3));
+
+    //--------------------------------------------------------------------------
+    //! \brief Remove all pedestrians.
+    //--------------------------------------------------------------------------
+    void clear();
+
+    //--------------------------------------------------------------------------
+    //! \brief Move pedestrians.
+    //! \param[in] obstacles: oriented bounding boxes the pedestrians avoid.
+    //! \param[in] tiles: if given, pedestrians inside frozen tiles do not move.
+    //--------------------------------------------------------------------------
+    void update(Second const dt, std::vector<sf::RectangleShape const*> const& obstacles,
+                Tiles const* tiles = nullptr);
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the pedestrians whose bounding box may overlap the given
+    //! world area (i.e. the bounding box of a sensor).
+    //--------------------------------------------------------------------------
+    void find(sf::FloatRect const& area, std::vector<Pedestrian const*>& result) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return all pedestrians.
+    //--------------------------------------------------------------------------
+    inline std::vector<Pedestrian> const& pedestrians() const
+    {
+        return m_pedestrians;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the world area holding all pedestrians and their horizon
+    //! (i.e. for searching obstacles near them).
+    //--------------------------------------------------------------------------
+    inline sf::FloatRect const& bounds() const
+    {
+        index();
+        return m_grid.bounds();
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the tuning of the social force model.
+    //--------------------------------------------------------------------------
+    inline Config& config()
+    {
+        return m_config;
+    }
+
+private:
+
+    //--------------------------------------------------------------------------
+    //! \brief Insert pedestrians in the grid if they have moved or have been
+    //! added.
+    //--------------------------------------------------------------------------
+    void index() const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Insert obstacles in their grid.
+    //--------------------------------------------------------------------------
+    void index(std::vector<sf::RectangleShape const*> const& obstacles);
+
+private:
+
+    //! \brief Tuning of the social force model.
+    Config m_config;
+    //! \brief Pedestrians.
+    std::vector<Pedestrian> m_pedestrians;
+    //! \brief Neighbours queries. Mutable since queries of sensors are made
+    //! on a const city and reindex lazily.
+    mutable SpatialHashGrid m_grid{ sf::FloatRect(0.0f, 0.0f, 1.0f, 1.0f), { 1u, 1u } };
+    //! \brief Items of pedestrians in the grid.
+    mutable std::vector<SpatialHashGrid::Item> m_items;
+    //! \brief Shall pedestrians be inserted again in the grid ?
+    mutable bool m_outdated = true;
+    //! \brief Neighbours of a pedestrian (avoid allocations).
+    mutable std::vector<SpatialHashGrid::Item*> m_neighbours;
+    //! \brief Obstacles queries, rebuilt at each update.
+    SpatialHashGrid m_obstacles{ sf::FloatRect(0.0f, 0.0f, 1.0f, 1.0f), { 1u, 1u } };
+    //! \brief Items of obstacles in their grid.
+    std::vector<SpatialHashGrid::Item> m_obstacle_items;
+    //! \brief Obstacles near a pedestrian (avoid allocations).
+    std::vector<SpatialHashGrid::Item*> m_near_obstacles;
 };
 
 // TODO Driver: public DynamicActor
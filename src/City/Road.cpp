@@ -23,43 +23,265 @@
 #include "Vehicle/Car.hpp"
 #include <random>
 #include <algorithm>
+#include <cmath>
 
 static std::mt19937 rng;
 
+//------------------------------------------------------------------------------
+static std::vector<math::Frenet::Position>
+toPolyline(std::vector<sf::Vector2<Meter>> const& points)
+{
+    std::vector<math::Frenet::Position> polyline(points.size());
+    for (size_t i = 0u; i < points.size(); ++i)
+    {
+        polyline[i] = { points[i].x.value(), points[i].y.value() };
+    }
+    return polyline;
+}
+
+//------------------------------------------------------------------------------
+static std::vector<sf::Vector2<Meter>>
+fromPolyline(std::vector<math::Frenet::Position> const& polyline)
+{
+    std::vector<sf::Vector2<Meter>> points(polyline.size());
+    for (size_t i = 0u; i < polyline.size(); ++i)
+    {
+        points[i] = sf::Vector2<Meter>(Meter(polyline[i].x), Meter(polyline[i].y));
+    }
+    return points;
+}
+
 //------------------------------------------------------------------------------
 Lane::Lane(sf::Vector2<Meter> const& start, sf::Vector2<Meter> const& stop,
            Meter const width, TrafficSide s)
-    : blueprint(start, stop, width), side(s), m_start(start), m_stop(stop),
-      m_normal(math::normal(stop - start)),
-      m_shape(sf::Vector2f(float(blueprint.length.value()),
-                           float(blueprint.width.value())))
-{
-    // The origin of the lane is placed on its Top-Left corner.
-    // Note that initially the origin of the parking was placed on its
-    // Center-Left side but this not nice for placing things along roads (like
-    // parking slots) because we to add the offset "Top-Left" => "Center-Left"
-    // in the formula.
-    m_shape.setOrigin(sf::Vector2f(0.0f, float(blueprint.width.value()))); // Top-Left
-    // m_shape.setOrigin(sf::Vector2f(0.0f, float(blueprint.width.value() / 2.0))); // Center-Left
-    m_shape.setRotation(float(Degree(blueprint.angle)));
-    m_shape.setPosition(float(start.x), float(start.y));
-    LOGI("Add lane %s: start (%g m, %g m), stop (%g m, %g m)",
-         (s == TrafficSide::RightHand ? "right" : "left"),
-         start.x, start.y, m_stop.x, m_stop.y);
-    if (s == TrafficSide::RightHand)
-        m_shape.setFillColor(COLOR_DRIVING_LANE);
-    else
-        m_shape.setFillColor(COLOR_RESTRICTED_LANE);
-    m_shape.setOutlineThickness(0.1f);
-    m_shape.setOutlineColor(sf::Color(255, 161, 7));
+    : Lane(std::vector<sf::Vector2<Meter>>{ start, stop }, width, s)
+{}
+
+//------------------------------------------------------------------------------
+//! \brief The lane lies on the right of its left border. Its center line is
+//! used as reference for the Frenet frame.
+static math::Frenet centerLine(math::Frenet const& left, Meter const width)
+{
+    return math::Frenet(left.offset(-width.value() / 2.0));
+}
+
+//------------------------------------------------------------------------------
+Lane::Lane(std::vector<sf::Vector2<Meter>> const& border, Meter const width,
+           TrafficSide s)
+    : Lane(math::Frenet(toPolyline(border)), width, s)
+{}
+
+//------------------------------------------------------------------------------
+Lane::Lane(math::Frenet const& left, Meter const width, TrafficSide s)
+    : blueprint(Meter(centerLine(left, width).length()),
+                Radian(left.heading(0.0)), width),
+      side(s), m_start(Meter(left.vertices().front().x), Meter(left.vertices().front().y)),
+      m_stop(Meter(left.vertices().back().x), Meter(left.vertices().back().y)),
+      m_normal(math::normal(sf::Vector2<Meter>(Meter(std::cos(blueprint.angle.value())),
+                                               Meter(std::sin(blueprint.angle.value()))))),
+      m_frenet(centerLine(left, width))
+{
+    // Geometry for the rendering, computed once.
+    std::vector<math::Frenet::Position> const borders[2] = {
+        left.vertices(), left.offset(-width.value())
+    };
+    sf::Color const color = (s == TrafficSide::RightHand)
+                            ? COLOR_DRIVING_LANE : COLOR_RESTRICTED_LANE;
+    sf::Color const outline(255, 161, 7);
+    size_t const n = borders[0].size();
+    m_vertices.setPrimitiveType(sf::TriangleStrip);
+    m_outline.setPrimitiveType(sf::LineStrip);
+    for (size_t i = 0u; i < n; ++i)
+    {
+        for (auto const& b: borders)
+        {
+            m_vertices.append(sf::Vertex(sf::Vector2f(float(b[i].x), float(b[i].y)), color));
+        }
+        m_outline.append(sf::Vertex(sf::Vector2f(float(borders[0][i].x),
+                                                 float(borders[0][i].y)), outline));
+    }
+    for (size_t i = n; i--; )
+    {
+        m_outline.append(sf::Vertex(sf::Vector2f(float(borders[1][i].x),
+                                                 float(borders[1][i].y)), outline));
+    }
+    m_outline.append(m_outline[0]);
+
+    // Bounding box for quick rejection of positions.
+    float xmin = m_vertices[0].position.x, xmax = xmin;
+    float ymin = m_vertices[0].position.y, ymax = ymin;
+    for (size_t i = 1u; i < m_vertices.getVertexCount(); ++i)
+    {
+        sf::Vector2f const& p = m_vertices[i].position;
+        xmin = std::min(xmin, p.x); xmax = std::max(xmax, p.x);
+        ymin = std::min(ymin, p.y); ymax = std::max(ymax, p.y);
+    }
+    m_bounds = sf::FloatRect(xmin, ymin, xmax - xmin, ymax - ymin);
+}
+
+//------------------------------------------------------------------------------
+Meter Lane::abscissa(sf::Vector2<Meter> const& position, size_t& hint) const
+{
+    return Meter(m_frenet.toFrenet({ position.x.value(), position.y.value() }, hint).s);
+}
+
+//------------------------------------------------------------------------------
+bool Lane::contains(sf::Vector2<Meter> const& position, size_t& hint) const
+{
+    float const x = float(position.x.value());
+    float const y = float(position.y.value());
+    if ((x < m_bounds.left) || (x > m_bounds.left + m_bounds.width) ||
+        (y < m_bounds.top) || (y > m_bounds.top + m_bounds.height))
+        return false;
+
+    // The lane covers [0 length] x [-width/2 width/2] in its Frenet frame.
+    math::Frenet::Coordinates const c =
+            m_frenet.toFrenet({ position.x.value(), position.y.value() }, hint);
+    return (c.s >= 0.0) && (c.s <= m_frenet.length()) &&
+           (std::abs(c.d) <= blueprint.width.value() / 2.0);
+}
+
+//------------------------------------------------------------------------------
+Lane::Occupant Lane::occupant(Car& car, size_t& hint) const
+{
+    Occupant occupant;
+    occupant.s = abscissa(car.position(), hint);
+    occupant.rear = occupant.front = occupant.s;
+    occupant.car = &car;
+
+    // Extent of the bounding box along the lane.
+    sf::RectangleShape const& obb = car.obb();
+    sf::Transform const& T = obb.getTransform();
+    for (size_t i = 0u; i < obb.getPointCount(); ++i)
+    {
+        sf::Vector2f const c = T.transformPoint(obb.getPoint(i));
+        size_t corner = hint;
+        Meter const s = abscissa(sf::Vector2<Meter>(Meter(c.x), Meter(c.y)), corner);
+        occupant.rear = units::math::min(occupant.rear, s);
+        occupant.front = units::math::max(occupant.front, s);
+    }
+    return occupant;
+}
+
+//------------------------------------------------------------------------------
+void Lane::insert(Occupant const& occupant)
+{
+    auto it = std::upper_bound(m_occupants.begin(), m_occupants.end(), occupant.s,
+                               [](Meter const s, Occupant const& o) { return s < o.s; });
+    m_occupants.insert(it, occupant);
+}
+
+//------------------------------------------------------------------------------
+size_t Lane::find(Car const& car, Meter const s) const
+{
+    auto it = std::lower_bound(m_occupants.begin(), m_occupants.end(), s,
+                               [](Occupant const& o, Meter const s) { return o.s < s; });
+    for (; (it != m_occupants.end()) && (it->s == s); ++it)
+    {
+        if (it->car == &car)
+            return size_t(it - m_occupants.begin());
+    }
+    return m_occupants.size();
+}
+
+//------------------------------------------------------------------------------
+bool Lane::remove(Car const& car, Meter const s)
+{
+    size_t const i = find(car, s);
+    if (i == m_occupants.size())
+        return false;
+
+    m_occupants.erase(m_occupants.begin() + std::ptrdiff_t(i));
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool Lane::move(Meter const s, Occupant const& occupant)
+{
+    size_t i = find(*occupant.car, s);
+    if (i == m_occupants.size())
+        return false;
+
+    m_occupants[i] = occupant;
+    while ((i > 0u) && (m_occupants[i - 1u].s > m_occupants[i].s))
+    {
+        std::swap(m_occupants[i - 1u], m_occupants[i]);
+        --i;
+    }
+    while ((i + 1u < m_occupants.size()) && (m_occupants[i + 1u].s < m_occupants[i].s))
+    {
+        std::swap(m_occupants[i + 1u], m_occupants[i]);
+        ++i;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+Lane::Occupant const* Lane::leader(Meter const s) const
+{
+    auto it = std::upper_bound(m_occupants.begin(), m_occupants.end(), s,
+                               [](Meter const s, Occupant const& o) { return s < o.s; });
+    return (it == m_occupants.end()) ? nullptr : &*it;
+}
+
+//------------------------------------------------------------------------------
+Lane::Occupant const* Lane::follower(Meter const s) const
+{
+    auto it = std::lower_bound(m_occupants.begin(), m_occupants.end(), s,
+                               [](Occupant const& o, Meter const s) { return o.s < s; });
+    return (it == m_occupants.begin()) ? nullptr : &*(it - 1);
+}
+
+//------------------------------------------------------------------------------
+Meter Lane::gap(Meter const s) const
+{
+    // Cars placed at s are considered as followers.
+    auto it = std::upper_bound(m_occupants.begin(), m_occupants.end(), s,
+                               [](Meter const s, Occupant const& o) { return s < o.s; });
+    Meter const start = (it == m_occupants.begin()) ? 0.0_m : (it - 1)->front;
+    Meter const stop = (it == m_occupants.end()) ? blueprint.length : it->rear;
+    return stop - start;
 }
 
 //------------------------------------------------------------------------------
 Road::Road(std::vector<sf::Vector2<Meter>> const& centers,
-           Meter const width, std::array<size_t, TrafficSide::Max> const& lanes)
-    : m_start(centers[0]), m_stop(centers[1]), m_width(width),
-      m_heading(math::orientation(centers[0], centers[1]))
+           Meter const width, std::array<size_t, TrafficSide::Max> const& lanes,
+           Curve const curve)
+    : m_width(width)
+{
+    std::vector<math::Frenet::Position> const polyline = toPolyline(centers);
+    if (curve == Curve::Spline)
+    {
+        build(math::spline(polyline, SAMPLING_STEP), lanes);
+    }
+    else
+    {
+        build(polyline, lanes);
+    }
+}
+
+//------------------------------------------------------------------------------
+Road::Road(sf::Vector2<Meter> const& start, Radian const heading,
+           std::vector<math::Clothoid> const& segments, Meter const width,
+           std::array<size_t, TrafficSide::Max> const& lanes)
+    : m_width(width)
 {
+    build(math::clothoids({ start.x.value(), start.y.value() }, heading.value(),
+                          segments, SAMPLING_STEP), lanes);
+}
+
+//------------------------------------------------------------------------------
+void Road::build(std::vector<math::Frenet::Position> const& centers,
+                 std::array<size_t, TrafficSide::Max> const& lanes)
+{
+    // The center line is sampled once and shared by lanes, the rendering and
+    // Frenet conversions.
+    m_frenet.build(centers);
+    m_centers = fromPolyline(m_frenet.vertices());
+    m_start = m_centers.front();
+    m_stop = m_centers.back();
+    m_heading = Radian(m_frenet.heading(0.0));
+
     // Allocate memory. FIXME manage lanes[] with 0 size
     size_t side = TrafficSide::Max;
     while (side--)
@@ -67,35 +289,27 @@ Road::Road(std::vector<sf::Vector2<Meter>> const& centers,
         m_lanes[side].resize(lanes[side]);
     }
 
-    // Road normal needed for translating its lanes.
-    sf::Vector2<Meter> n = normal();
-
-    // The center of the lane is offseted relatively from the center of the road by 0.5 * lane width
-    //sf::Vector2<Meter> center_offset = sf::Vector2<Meter>(n.x * 0.5 * width.value(), n.y * 0.5 * width.value());
-
-    // Translate lanes by their width along the normal
-    sf::Vector2<Meter> lane_offset = sf::Vector2<Meter>(n.x * width.value(), n.y * width.value());
-
-    // Create the right-hand lanes
-    sf::Vector2<Meter> start = m_start;// - center_offset;
-    sf::Vector2<Meter> stop = m_stop;// - center_offset;
+    // Create the right-hand lanes: their left border is translated from the
+    // center of the road by their width along the normal.
     size_t i = lanes[TrafficSide::RightHand];
+    double offset = 0.0;
     while (i--)
     {
-        m_lanes[TrafficSide::RightHand][i] = std::make_unique<Lane>(start, stop, width, TrafficSide::RightHand);
-        start = start - lane_offset;
-        stop = stop - lane_offset;
+        m_lanes[TrafficSide::RightHand][i] = std::make_unique<Lane>(
+            fromPolyline(m_frenet.offset(offset)), m_width, TrafficSide::RightHand);
+        offset -= m_width.value();
     }
 
-    // Create the left-hand lanes
-    start = m_start;// + center_offset;
-    stop = m_stop;// + center_offset;
+    // Create the left-hand lanes: same thing but in the opposite direction.
     i = lanes[TrafficSide::LeftHand];
+    offset = 0.0;
     while (i--)
     {
-        m_lanes[TrafficSide::LeftHand][i] = std::make_unique<Lane>(stop, start, width, TrafficSide::LeftHand);
-        start = start + lane_offset;
-        stop = stop + lane_offset;
+        std::vector<sf::Vector2<Meter>> border = fromPolyline(m_frenet.offset(offset));
+        std::reverse(border.begin(), border.end());
+        m_lanes[TrafficSide::LeftHand][i] = std::make_unique<Lane>(
+            border, m_width, TrafficSide::LeftHand);
+        offset += m_width.value();
     }
 }
 
@@ -108,13 +322,19 @@ sf::Vector2<Meter> Road::offset(TrafficSide const side, size_t const desired_lan
     Lane const& lane = *m_lanes[side][i];
 
     // Compute offset along the lane
-    sf::Vector2<Meter> const offset(
-        math::lerp(0.0_m, lane.blueprint.length, x),
-        math::lerp(0.0_m, -lane.blueprint.width, y)
-    );
+    math::Frenet::Position const p = lane.frenet().toCartesian({
+        x * lane.blueprint.length.value(),
+        (0.5 - y) * lane.blueprint.width.value() });
+    return sf::Vector2<Meter>(Meter(p.x), Meter(p.y));
+}
 
-    sf::Vector2<Meter> const lane_offset = math::heading(offset, lane.blueprint.angle);
-    return lane.origin() + lane_offset;
+//------------------------------------------------------------------------------
+Radian Road::heading(TrafficSide const side, size_t const desired_lane,
+                     double const x) const
+{
+    size_t const i = math::constrain(desired_lane, size_t(0), m_lanes[side].size());
+    Lane const& lane = *m_lanes[side][i];
+    return lane.heading(x * lane.blueprint.length);
 }
 
 #if 0
@@ -23,6 +23,7 @@
 #  define ROAD_HPP
 
 #  include "City/Network.hpp"
+#  include "Math/Curves.hpp"
 //#  include "Actor.hpp"
 
 // https://fr.mathworks.com/help/driving/ref/drivingscenario.road.html
@@ -73,19 +74,53 @@ struct LaneBluePrint
 // ****************************************************************************
 class Lane
 {
+public:
+
+    // *************************************************************************
+    //! \brief Car driving inside the lane.
+    // *************************************************************************
+    struct Occupant
+    {
+        //! \brief Curvilinear abscissa of the middle of the rear axle [meter].
+        Meter s;
+        //! \brief Curvilinear abscissa of the rearmost point of the car [meter].
+        Meter rear;
+        //! \brief Curvilinear abscissa of the frontmost point of the car [meter].
+        Meter front;
+        //! \brief The car.
+        Car* car;
+    };
+
+    //! \brief Cars inside the lane sorted by their curvilinear abscissa.
+    using Occupants = std::vector<Occupant>;
+
 public:
 
     //--------------------------------------------------------------------------
-    //! \brief
+    //! \brief Straight lane.
     //--------------------------------------------------------------------------
     Lane(sf::Vector2<Meter> const& start, sf::Vector2<Meter> const& stop,
          Meter const width, TrafficSide side);
 
+    //--------------------------------------------------------------------------
+    //! \brief Curved lane.
+    //! \param[in] border: sampled left border of the lane (when looking in the
+    //! direction of the traffic). The lane lies on its right side.
+    //! \param[in] width: lane width.
+    //! \param[in] side: traffic side.
+    //--------------------------------------------------------------------------
+    Lane(std::vector<sf::Vector2<Meter>> const& border, Meter const width,
+         TrafficSide side);
+
     //--------------------------------------------------------------------------
     //! \brief
     //--------------------------------------------------------------------------
     Lane(Lane const& other)
-        : blueprint(other.blueprint), side(other.side), m_cars(other.m_cars)
+        : blueprint(other.blueprint), side(other.side), m_start(other.m_start),
+          m_stop(other.m_stop), m_normal(other.m_normal),
+          m_vertices(other.m_vertices), m_outline(other.m_outline),
+          m_bounds(other.m_bounds), m_frenet(other.m_frenet),
+          m_occupants(other.m_occupants)
     {}
 
     //--------------------------------------------------------------------------
@@ -105,9 +140,28 @@ public:
     inline Radian heading() const { return blueprint.angle; }
 
     //--------------------------------------------------------------------------
-    //! \brief
+    //! \brief Return the heading [radian] of the lane at the curvilinear
+    //! abscissa s.
+    //--------------------------------------------------------------------------
+    inline Radian heading(Meter const s) const
+    {
+        return Radian(m_frenet.heading(s.value()));
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the triangle strip of the lane surface, computed once.
+    //--------------------------------------------------------------------------
+    inline sf::VertexArray const& vertices() const { return m_vertices; }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the line strip of the lane borders, computed once.
+    //--------------------------------------------------------------------------
+    inline sf::VertexArray const& outline() const { return m_outline; }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the axis-aligned bounding box of the lane.
     //--------------------------------------------------------------------------
-    inline sf::RectangleShape const& shape() const { return m_shape; }
+    inline sf::FloatRect const& bounds() const { return m_bounds; }
 
     //--------------------------------------------------------------------------
     //! \brief Return the origin position [meter] of the road in the world
@@ -127,6 +181,96 @@ public:
     //--------------------------------------------------------------------------
     inline sf::Vector2<Meter> const& normal() const { return m_normal; }
 
+    //--------------------------------------------------------------------------
+    //! \brief Return the Frenet frame along the center line of the lane for
+    //! converting world positions into lane coordinates (s, d).
+    //--------------------------------------------------------------------------
+    inline math::Frenet const& frenet() const { return m_frenet; }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the curvilinear abscissa of the projection of the given
+    //! world position on the lane (0 at the origin of the lane).
+    //! \param[inout] hint: segment of the lane found by the previous call
+    //! (see math::Frenet::toFrenet).
+    //--------------------------------------------------------------------------
+    Meter abscissa(sf::Vector2<Meter> const& position, size_t& hint) const;
+
+    inline Meter abscissa(sf::Vector2<Meter> const& position) const
+    {
+        size_t hint = math::Frenet::NONE;
+        return abscissa(position, hint);
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Does the lane hold the given world position ?
+    //! \param[inout] hint: segment of the lane found by the previous call
+    //! (see math::Frenet::toFrenet).
+    //--------------------------------------------------------------------------
+    bool contains(sf::Vector2<Meter> const& position, size_t& hint) const;
+
+    inline bool contains(sf::Vector2<Meter> const& position) const
+    {
+        size_t hint = math::Frenet::NONE;
+        return contains(position, hint);
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Compute the occupancy of the car (its curvilinear abscissas).
+    //! \param[inout] hint: segment of the lane found by the previous call
+    //! (see math::Frenet::toFrenet).
+    //--------------------------------------------------------------------------
+    Occupant occupant(Car& car, size_t& hint) const;
+
+    inline Occupant occupant(Car& car) const
+    {
+        size_t hint = math::Frenet::NONE;
+        return occupant(car, hint);
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return cars inside the lane sorted by curvilinear abscissa.
+    //--------------------------------------------------------------------------
+    inline Occupants const& occupants() const { return m_occupants; }
+
+    //--------------------------------------------------------------------------
+    //! \brief Add a car inside the lane. O(n) worst case.
+    //--------------------------------------------------------------------------
+    void insert(Occupant const& occupant);
+
+    //--------------------------------------------------------------------------
+    //! \brief Remove the car which was placed at the curvilinear abscissa s.
+    //! \return false if the car was not found.
+    //--------------------------------------------------------------------------
+    bool remove(Car const& car, Meter const s);
+
+    //--------------------------------------------------------------------------
+    //! \brief Update the occupancy of a car which was placed at the curvilinear
+    //! abscissa s. Since cars rarely overtake between two updates, the order is
+    //! restored by swapping the car with its neighbors: O(log n) when no car
+    //! is overtaken.
+    //! \return false if the car was not found.
+    //--------------------------------------------------------------------------
+    bool move(Meter const s, Occupant const& occupant);
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the first car ahead of the curvilinear abscissa s or
+    //! nullptr. O(log n).
+    //--------------------------------------------------------------------------
+    Occupant const* leader(Meter const s) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the first car behind the curvilinear abscissa s or
+    //! nullptr. O(log n).
+    //--------------------------------------------------------------------------
+    Occupant const* follower(Meter const s) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the free length around the curvilinear abscissa s: from
+    //! the front of the follower (or the origin of the lane) to the rear of the
+    //! leader (or the end of the lane). O(log n). Negative if cars overlap.
+    //--------------------------------------------------------------------------
+    Meter gap(Meter const s) const;
+
 public:
 
     //! \brief
@@ -139,13 +283,31 @@ public:
     sf::Vector2<Meter> m_stop;
     //! \brief The unit normal vector to the lane.
     sf::Vector2<Meter> m_normal;
-    //! \brief
-    std::vector<Car*> m_cars;
+private:
+
+    //--------------------------------------------------------------------------
+    //! \brief Lane given its sampled left border.
+    //--------------------------------------------------------------------------
+    Lane(math::Frenet const& left, Meter const width, TrafficSide side);
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the position of the car placed at the curvilinear
+    //! abscissa s inside m_occupants or m_occupants.size() if not found.
+    //--------------------------------------------------------------------------
+    size_t find(Car const& car, Meter const s) const;
 
 private:
 
-    //! \brief Oriented bounding box for attitude and collision
-    sf::RectangleShape m_shape;
+    //! \brief Triangle strip of the lane surface.
+    sf::VertexArray m_vertices;
+    //! \brief Line strip of the lane borders.
+    sf::VertexArray m_outline;
+    //! \brief Axis-aligned bounding box for quick rejection.
+    sf::FloatRect m_bounds;
+    //! \brief Frenet frame along the center line of the lane.
+    math::Frenet m_frenet;
+    //! \brief Cars inside the lane sorted by curvilinear abscissa.
+    Occupants m_occupants;
 };
 
 // ****************************************************************************
@@ -153,20 +315,47 @@ private:
 // ****************************************************************************
 class Road//: public StaticActor // TODO https://www.youtube.com/watch?v=tHXIwijaERg
 {
+public:
+
+    // *************************************************************************
+    //! \brief How the center line passes through the given centers.
+    // *************************************************************************
+    enum class Curve { Polyline, Spline };
+
+    //! \brief Max distance between two samples of curved center lines.
+    static constexpr double SAMPLING_STEP = 0.5; // [meter]
+
 public:
 
     //--------------------------------------------------------------------------
     //! \brief Empty road segment with given ways.
-    //! \param[in] blueprint: parking slot dimension.
-    //! \param[in] position: position in the world coordinates of the middle of
-    //! the left side lane.
+    //! \param[in] centers: positions in the world coordinates of the center
+    //! line of the road (at least two).
+    //! \param[in] width: width of lanes.
     //! \param[in] lanes nuber of lanes for right- and left-hand drive.
+    //! \param[in] curve: straight lines between centers or cubic spline
+    //! passing through centers.
     //--------------------------------------------------------------------------
     Road(std::vector<sf::Vector2<Meter>> const& centers,
-         Meter const width, std::array<size_t, TrafficSide::Max> const& lanes);
+         Meter const width, std::array<size_t, TrafficSide::Max> const& lanes,
+         Curve const curve = Curve::Polyline);
 
     //--------------------------------------------------------------------------
-    //! \brief
+    //! \brief Empty road made of consecutive clothoids (lines, arcs, spirals).
+    //! \param[in] start: initial position of the center line.
+    //! \param[in] heading: initial heading of the center line.
+    //! \param[in] segments: clothoids of the center line.
+    //! \param[in] width: width of lanes.
+    //! \param[in] lanes nuber of lanes for right- and left-hand drive.
+    //--------------------------------------------------------------------------
+    Road(sf::Vector2<Meter> const& start, Radian const heading,
+         std::vector<math::Clothoid> const& segments, Meter const width,
+         std::array<size_t, TrafficSide::Max> const& lanes);
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the world position of a point of a lane.
+    //! \param[in] x: [0 .. 1] position along the lane (0: origin of the lane).
+    //! \param[in] y: [0 .. 1] position across the lane (0: left border).
     //--------------------------------------------------------------------------
     sf::Vector2<Meter> offset(TrafficSide const side, size_t const lane,
                               double const x, double const y) const;
@@ -186,6 +375,22 @@ public:
         return m_lanes[side][0]->heading();
     }
 
+    //--------------------------------------------------------------------------
+    //! \brief Return the heading [radian] of a lane at the given position.
+    //! \param[in] x: [0 .. 1] position along the lane (0: origin of the lane).
+    //--------------------------------------------------------------------------
+    Radian heading(TrafficSide const side, size_t const lane, double const x) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the sampled center line, computed once.
+    //--------------------------------------------------------------------------
+    inline std::vector<sf::Vector2<Meter>> const& centers() const { return m_centers; }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the Frenet frame along the center line.
+    //--------------------------------------------------------------------------
+    inline math::Frenet const& frenet() const { return m_frenet; }
+
     //--------------------------------------------------------------------------
     //! \brief
     //--------------------------------------------------------------------------
@@ -208,6 +413,18 @@ public:
 
 private:
 
+    //--------------------------------------------------------------------------
+    //! \brief Sample the center line and create lanes along it.
+    //--------------------------------------------------------------------------
+    void build(std::vector<math::Frenet::Position> const& centers,
+               std::array<size_t, TrafficSide::Max> const& lanes);
+
+private:
+
+    //! \brief Sampled center line of the road.
+    std::vector<sf::Vector2<Meter>> m_centers;
+    //! \brief Frenet frame along the center line.
+    math::Frenet m_frenet;
     //! \brief Initial center position of the road
     sf::Vector2<Meter> m_start;
     //! \brief Final center position of the road
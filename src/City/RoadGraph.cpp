@@ -0,0 +1,718 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "City/RoadGraph.hpp"
+#include <queue>
+#include <functional>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+// Cost of changing of lane [meter].
+static const Meter LANE_CHANGE_COST = 20.0_m;
+// Contraction: maximum number of vertices settled by a witness search.
+static const size_t MAX_WITNESS_SETTLED = 64u;
+
+static constexpr float INF = std::numeric_limits<float>::infinity();
+
+// *****************************************************************************
+//! \brief Distances and parents of a Dijkstra search. Entries are lazily reset
+//! by comparing their stamp with the stamp of the current search, so starting
+//! a new search does not depend on the size of the graph.
+// *****************************************************************************
+class Search
+{
+public:
+
+    using Id = RoadGraph::Id;
+
+    //! \brief Element of the priority queue: (distance, vertex).
+    using Item = std::pair<float, Id>;
+    using Queue = std::priority_queue<Item, std::vector<Item>, std::greater<Item>>;
+
+    //--------------------------------------------------------------------------
+    //! \brief Start a new search on a graph of the given size.
+    //--------------------------------------------------------------------------
+    void reset(size_t const size)
+    {
+        if (m_stamps.size() < size)
+        {
+            m_distances.resize(size);
+            m_parents.resize(size);
+            m_stamps.resize(size, 0u);
+        }
+        if (++m_stamp == 0u)
+        {
+            std::fill(m_stamps.begin(), m_stamps.end(), 0u);
+            m_stamp = 1u;
+        }
+        queue = Queue();
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the distance to the vertex (infinite if not reached).
+    //--------------------------------------------------------------------------
+    inline float distance(Id const v) const
+    {
+        return (m_stamps[v] == m_stamp) ? m_distances[v] : INF;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the previous vertex on the path to the vertex.
+    //--------------------------------------------------------------------------
+    inline Id parent(Id const v) const
+    {
+        return m_parents[v];
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Update the distance to the vertex if shorter.
+    //! \return true if updated.
+    //--------------------------------------------------------------------------
+    inline bool relax(Id const v, float const d, Id const parent)
+    {
+        if (d >= distance(v))
+            return false;
+
+        m_stamps[v] = m_stamp;
+        m_distances[v] = d;
+        m_parents[v] = parent;
+        return true;
+    }
+
+public:
+
+    //! \brief Vertices to be settled.
+    Queue queue;
+
+private:
+
+    std::vector<float> m_distances;
+    std::vector<Id> m_parents;
+    std::vector<uint32_t> m_stamps;
+    uint32_t m_stamp = 0u;
+};
+
+//------------------------------------------------------------------------------
+//! \brief Scratch spaces of searches: one per thread to allow concurrent
+//! queries without allocating memory at each query.
+//------------------------------------------------------------------------------
+static Search& forwardSearch()
+{
+    static thread_local Search search;
+    return search;
+}
+
+static Search& backwardSearch()
+{
+    static thread_local Search search;
+    return search;
+}
+
+//------------------------------------------------------------------------------
+void RoadGraph::clear()
+{
+    m_positions.clear();
+    m_lanes.clear();
+    m_vertices.clear();
+    m_edges.clear();
+    m_ranks.clear();
+    m_upward.clear();
+    m_upward_offsets.clear();
+    m_downward.clear();
+    m_downward_offsets.clear();
+    m_shortcuts.clear();
+    m_cells.clear();
+}
+
+//------------------------------------------------------------------------------
+RoadGraph::Id RoadGraph::addVertex(sf::Vector2<Meter> const& position, Lane* lane)
+{
+    Id const id = Id(m_positions.size());
+    m_positions.push_back(position);
+    m_lanes.push_back(lane);
+    m_edges.emplace_back();
+    if (lane != nullptr)
+    {
+        m_vertices[lane] = id;
+    }
+    m_ranks.clear();
+
+    // Grid of vertices.
+    sf::Vector2<int32_t> const c = cell(position);
+    if (m_cells.empty())
+    {
+        m_cells_min = m_cells_max = c;
+    }
+    else
+    {
+        m_cells_min = { std::min(m_cells_min.x, c.x), std::min(m_cells_min.y, c.y) };
+        m_cells_max = { std::max(m_cells_max.x, c.x), std::max(m_cells_max.y, c.y) };
+    }
+    m_cells[key(c)].push_back(id);
+    return id;
+}
+
+//------------------------------------------------------------------------------
+void RoadGraph::addEdge(Id const from, Id const to, Meter const cost)
+{
+    assert((from < size()) && (to < size()));
+
+    Meter const distance = math::distance(m_positions[from], m_positions[to]);
+    m_edges[from].push_back({ to, float(std::max(cost, distance).value()), NONE });
+    m_ranks.clear();
+}
+
+//------------------------------------------------------------------------------
+void RoadGraph::build(std::vector<std::unique_ptr<Road>> const& roads, Meter const junction)
+{
+    clear();
+
+    // One vertex per lane and the road holding it.
+    std::vector<Road const*> owners;
+    for (auto const& road: roads)
+    {
+        for (size_t side = 0u; side < TrafficSide::Max; ++side)
+        {
+            for (auto const& lane: road->m_lanes[side])
+            {
+                addVertex(lane->destination(), lane.get());
+                owners.push_back(road.get());
+            }
+        }
+    }
+
+    // Spatial hash of the start of lanes for finding successors.
+    double const cell = std::max(junction.value(), 1.0);
+    auto hash = [cell](sf::Vector2<Meter> const& p, int const dx, int const dy)
+    {
+        int32_t const x = int32_t(std::floor(p.x.value() / cell)) + dx;
+        int32_t const y = int32_t(std::floor(p.y.value() / cell)) + dy;
+        return (uint64_t(uint32_t(x)) << 32) | uint64_t(uint32_t(y));
+    };
+    std::unordered_map<uint64_t, std::vector<Id>> starts;
+    for (Id v = 0u; v < size(); ++v)
+    {
+        starts[hash(m_lanes[v]->origin(), 0, 0)].push_back(v);
+    }
+
+    // Successors: lanes starting near the end of the lane. U-turns on the same
+    // road are not allowed.
+    for (Id a = 0u; a < size(); ++a)
+    {
+        Lane const& A = *m_lanes[a];
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                auto it = starts.find(hash(A.destination(), dx, dy));
+                if (it == starts.end())
+                    continue;
+
+                for (Id const b: it->second)
+                {
+                    Lane const& B = *m_lanes[b];
+                    if ((a == b) || ((owners[a] == owners[b]) && (A.side != B.side)))
+                        continue;
+
+                    Meter const gap = math::distance(A.destination(), B.origin());
+                    if (gap <= junction)
+                    {
+                        addEdge(a, b, gap + B.blueprint.length);
+                    }
+                }
+            }
+        }
+    }
+
+    // Changes of lane.
+    for (auto const& road: roads)
+    {
+        for (size_t side = 0u; side < TrafficSide::Max; ++side)
+        {
+            auto const& lanes = road->m_lanes[side];
+            for (size_t i = 1u; i < lanes.size(); ++i)
+            {
+                Id const a = m_vertices[lanes[i - 1u].get()];
+                Id const b = m_vertices[lanes[i].get()];
+                addEdge(a, b, LANE_CHANGE_COST);
+                addEdge(b, a, LANE_CHANGE_COST);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void RoadGraph::build(Path const& path)
+{
+    clear();
+
+    std::unordered_map<Node const*, Id> ids;
+    for (auto const& node: path.nodes())
+    {
+        ids[node.get()] = addVertex(node->position());
+    }
+
+    for (auto const& way: path.ways())
+    {
+        Id const a = ids[&way->from()];
+        Id const b = ids[&way->to()];
+        addEdge(a, b, way->magnitude());
+        addEdge(b, a, way->magnitude());
+    }
+}
+
+//------------------------------------------------------------------------------
+RoadGraph::Id RoadGraph::vertex(Lane const& lane) const
+{
+    auto it = m_vertices.find(&lane);
+    return (it == m_vertices.end()) ? NONE : it->second;
+}
+
+//------------------------------------------------------------------------------
+RoadGraph::Id RoadGraph::nearest(sf::Vector2<Meter> const& position) const
+{
+    Id best = NONE;
+    SquareMeter min(std::numeric_limits<double>::infinity());
+    if (m_cells.empty())
+        return best;
+
+    auto visit = [&](int32_t const x, int32_t const y)
+    {
+        auto it = m_cells.find(key({ x, y }));
+        if (it == m_cells.end())
+            return ;
+
+        for (Id const v: it->second)
+        {
+            SquareMeter const d = math::distance2(position, m_positions[v]);
+            if ((d < min) || (!(min < d) && (v < best)))
+            {
+                min = d;
+                best = v;
+            }
+        }
+    };
+
+    // Visit rings of cells around the cell holding the position, clipped to
+    // the bounding box of non empty cells. Vertices outside the ring r are at
+    // least r cells away: stop once the best vertex is nearer.
+    sf::Vector2<int32_t> const c = cell(position);
+    int32_t const first = std::max({ m_cells_min.x - c.x, c.x - m_cells_max.x,
+                                     m_cells_min.y - c.y, c.y - m_cells_max.y, 0 });
+    int32_t const last = std::max({ c.x - m_cells_min.x, m_cells_max.x - c.x,
+                                    c.y - m_cells_min.y, m_cells_max.y - c.y });
+    for (int32_t r = first; r <= last; ++r)
+    {
+        int32_t const x0 = std::max(c.x - r, m_cells_min.x);
+        int32_t const x1 = std::min(c.x + r, m_cells_max.x);
+        int32_t const y0 = std::max(c.y - r + 1, m_cells_min.y);
+        int32_t const y1 = std::min(c.y + r - 1, m_cells_max.y);
+        for (int32_t x = x0; x <= x1; ++x)
+        {
+            if (c.y - r >= m_cells_min.y)
+                visit(x, c.y - r);
+            if ((r > 0) && (c.y + r <= m_cells_max.y))
+                visit(x, c.y + r);
+        }
+        for (int32_t y = y0; y <= y1; ++y)
+        {
+            if (c.x - r >= m_cells_min.x)
+                visit(c.x - r, y);
+            if (c.x + r <= m_cells_max.x)
+                visit(c.x + r, y);
+        }
+
+        Meter const reached(double(r) * CELL_SIZE);
+        if (min <= reached * reached)
+            break;
+    }
+    return best;
+}
+
+//------------------------------------------------------------------------------
+bool RoadGraph::route(Id const from, Id const to, Route& route) const
+{
+    return contracted() ? hierarchy(from, to, route) : astar(from, to, route);
+}
+
+//------------------------------------------------------------------------------
+bool RoadGraph::astar(Id const from, Id const to, Route& route) const
+{
+    route.vertices.clear();
+    route.length = 0.0_m;
+    if ((from >= size()) || (to >= size()))
+        return false;
+
+    // Heuristic: distance as the crow flies to the destination.
+    sf::Vector2<Meter> const& goal = m_positions[to];
+    auto heuristic = [&](Id const v)
+    {
+        return float(math::distance(m_positions[v], goal).value());
+    };
+
+    Search& search = forwardSearch();
+    search.reset(size());
+    search.relax(from, 0.0f, NONE);
+    search.queue.push({ heuristic(from), from });
+    while (!search.queue.empty())
+    {
+        Id const u = search.queue.top().second;
+        float const f = search.queue.top().first;
+        search.queue.pop();
+
+        float const g = search.distance(u);
+        if (f > g + heuristic(u))
+            continue; // Outdated entry
+
+        if (u == to)
+        {
+            for (Id v = to; v != NONE; v = search.parent(v))
+            {
+                route.vertices.push_back(v);
+            }
+            std::reverse(route.vertices.begin(), route.vertices.end());
+            route.length = Meter(double(g));
+            return true;
+        }
+
+        for (Edge const& e: m_edges[u])
+        {
+            float const d = g + e.cost;
+            if (search.relax(e.to, d, u))
+            {
+                search.queue.push({ d + heuristic(e.to), e.to });
+            }
+        }
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+void RoadGraph::contract()
+{
+    const Id N = Id(size());
+
+    // Working graph: edges of the road network and shortcuts, in both
+    // directions. Only the cheapest edge between two vertices is kept.
+    std::vector<std::vector<Edge>> out(N), in(N);
+    auto add = [&](Id const u, Id const w, float const cost, Id const middle)
+    {
+        for (Edge& e: out[u])
+        {
+            if (e.to == w)
+            {
+                if (cost < e.cost)
+                {
+                    e.cost = cost;
+                    e.middle = middle;
+                    for (Edge& r: in[w])
+                    {
+                        if (r.to == u)
+                        {
+                            r.cost = cost;
+                            r.middle = middle;
+                        }
+                    }
+                }
+                return ;
+            }
+        }
+        out[u].push_back({ w, cost, middle });
+        in[w].push_back({ u, cost, middle });
+    };
+    for (Id u = 0u; u < N; ++u)
+    {
+        for (Edge const& e: m_edges[u])
+        {
+            if (e.to != u)
+            {
+                add(u, e.to, e.cost, NONE);
+            }
+        }
+    }
+
+    std::vector<Id> ranks(N, NONE);
+    std::vector<uint32_t> neighbors(N, 0u); // Number of contracted neighbors
+    std::vector<uint32_t> levels(N, 0u); // Depth in the hierarchy
+
+    // Local Dijkstra from u ignoring the vertex v and contracted vertices,
+    // bounded by a maximum distance and number of settled vertices.
+    Search witness;
+    auto search = [&](Id const u, Id const v, float const limit)
+    {
+        witness.reset(N);
+        witness.relax(u, 0.0f, NONE);
+        witness.queue.push({ 0.0f, u });
+        size_t settled = 0u;
+        while (!witness.queue.empty() && (settled < MAX_WITNESS_SETTLED))
+        {
+            auto const [d, x] = witness.queue.top();
+            witness.queue.pop();
+            if ((d > witness.distance(x)) || (d > limit))
+                continue;
+
+            ++settled;
+            for (Edge const& e: out[x])
+            {
+                if ((e.to != v) && (ranks[e.to] == NONE) &&
+                    witness.relax(e.to, d + e.cost, x))
+                {
+                    witness.queue.push({ d + e.cost, e.to });
+                }
+            }
+        }
+    };
+
+    // Shortcuts needed for contracting v: for each pair u -> v -> w, a
+    // shortcut is needed if no shorter witness path u -> w exists.
+    auto shortcuts = [&](Id const v, bool const apply) -> int
+    {
+        int count = 0;
+        for (Edge const& a: in[v])
+        {
+            Id const u = a.to;
+            if (ranks[u] != NONE)
+                continue;
+
+            float limit = -1.0f;
+            for (Edge const& b: out[v])
+            {
+                if ((b.to != u) && (ranks[b.to] == NONE))
+                {
+                    limit = std::max(limit, a.cost + b.cost);
+                }
+            }
+            if (limit < 0.0f)
+                continue;
+
+            search(u, v, limit);
+            for (Edge const& b: out[v])
+            {
+                Id const w = b.to;
+                if ((w == u) || (ranks[w] != NONE))
+                    continue;
+
+                float const via = a.cost + b.cost;
+                if (witness.distance(w) > via)
+                {
+                    ++count;
+                    if (apply)
+                    {
+                        add(u, w, via, v);
+                    }
+                }
+            }
+        }
+        return count;
+    };
+
+    // Importance of a vertex: edge difference plus the number of contracted
+    // neighbors and the depth in the hierarchy (for contracting uniformly the
+    // graph and keeping the hierarchy shallow).
+    auto priority = [&](Id const v) -> int
+    {
+        int degree = 0;
+        for (Edge const& e: in[v])
+            degree += (ranks[e.to] == NONE) ? 1 : 0;
+        for (Edge const& e: out[v])
+            degree += (ranks[e.to] == NONE) ? 1 : 0;
+        return shortcuts(v, false) - degree + int(neighbors[v]) + int(levels[v]);
+    };
+
+    // Contract vertices by increasing importance. Importances are lazily
+    // updated: a popped vertex is contracted only if it is still the least
+    // important.
+    using Item = std::pair<int, Id>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+    for (Id v = 0u; v < N; ++v)
+    {
+        queue.push({ priority(v), v });
+    }
+
+    Id rank = 0u;
+    while (!queue.empty())
+    {
+        Id const v = queue.top().second;
+        queue.pop();
+
+        int const p = priority(v);
+        if (!queue.empty() && (p > queue.top().first))
+        {
+            queue.push({ p, v });
+            continue;
+        }
+
+        shortcuts(v, true);
+        ranks[v] = rank++;
+        for (auto const* edges: { &in[v], &out[v] })
+        {
+            for (Edge const& e: *edges)
+            {
+                neighbors[e.to] += 1u;
+                levels[e.to] = std::max(levels[e.to], levels[v] + 1u);
+            }
+        }
+    }
+
+    // Split edges into the upward and downward graphs.
+    m_shortcuts.clear();
+    std::vector<std::vector<Edge>> upward(N), downward(N);
+    for (Id u = 0u; u < N; ++u)
+    {
+        for (Edge const& e: out[u])
+        {
+            if (ranks[u] < ranks[e.to])
+                upward[u].push_back(e);
+            else
+                downward[e.to].push_back({ u, e.cost, e.middle });
+
+            if (e.middle != NONE)
+                m_shortcuts[key(u, e.to)] = e.middle;
+        }
+    }
+
+    auto compress = [N](std::vector<std::vector<Edge>> const& rows,
+                        std::vector<Edge>& edges, std::vector<size_t>& offsets)
+    {
+        edges.clear();
+        offsets.assign(N + 1u, 0u);
+        for (Id u = 0u; u < N; ++u)
+        {
+            offsets[u] = edges.size();
+            edges.insert(edges.end(), rows[u].begin(), rows[u].end());
+        }
+        offsets[N] = edges.size();
+    };
+    compress(upward, m_upward, m_upward_offsets);
+    compress(downward, m_downward, m_downward_offsets);
+    m_ranks = std::move(ranks);
+}
+
+//------------------------------------------------------------------------------
+bool RoadGraph::hierarchy(Id const from, Id const to, Route& route) const
+{
+    route.vertices.clear();
+    route.length = 0.0_m;
+    if ((from >= size()) || (to >= size()))
+        return false;
+
+    Search& forward = forwardSearch();
+    Search& backward = backwardSearch();
+    forward.reset(size());
+    backward.reset(size());
+    forward.relax(from, 0.0f, NONE);
+    forward.queue.push({ 0.0f, from });
+    backward.relax(to, 0.0f, NONE);
+    backward.queue.push({ 0.0f, to });
+
+    // Both searches only climb the hierarchy. They stop when they cannot find
+    // a shorter meeting vertex.
+    float best = INF;
+    Id meeting = NONE;
+    auto step = [&](Search& search, Search const& other,
+                    std::vector<Edge> const& edges, std::vector<size_t> const& offsets,
+                    std::vector<Edge> const& reversed, std::vector<size_t> const& stalls)
+    {
+        auto const [d, u] = search.queue.top();
+        search.queue.pop();
+        if (d > search.distance(u))
+            return ;
+
+        float const total = d + other.distance(u);
+        if (total < best)
+        {
+            best = total;
+            meeting = u;
+        }
+
+        // Stall-on-demand: u is reached shorter from a more important vertex
+        // so no shortest path climbs the hierarchy through u.
+        for (size_t i = stalls[u]; i < stalls[u + 1u]; ++i)
+        {
+            Edge const& e = reversed[i];
+            if (search.distance(e.to) + e.cost < d)
+                return ;
+        }
+
+        for (size_t i = offsets[u]; i < offsets[u + 1u]; ++i)
+        {
+            Edge const& e = edges[i];
+            if (search.relax(e.to, d + e.cost, u))
+            {
+                search.queue.push({ d + e.cost, e.to });
+            }
+        }
+    };
+
+    while (true)
+    {
+        bool const f = !forward.queue.empty() && (forward.queue.top().first < best);
+        bool const b = !backward.queue.empty() && (backward.queue.top().first < best);
+        if (!f && !b)
+            break;
+
+        if (f && (!b || (forward.queue.top().first <= backward.queue.top().first)))
+            step(forward, backward, m_upward, m_upward_offsets, m_downward, m_downward_offsets);
+        else
+            step(backward, forward, m_downward, m_downward_offsets, m_upward, m_upward_offsets);
+    }
+
+    if (meeting == NONE)
+        return false;
+
+    // Vertices of the hierarchy: from -> meeting -> to.
+    std::vector<Id> vertices;
+    for (Id v = meeting; v != NONE; v = forward.parent(v))
+    {
+        vertices.push_back(v);
+    }
+    std::reverse(vertices.begin(), vertices.end());
+    for (Id v = backward.parent(meeting); v != NONE; v = backward.parent(v))
+    {
+        vertices.push_back(v);
+    }
+
+    // Replace shortcuts by the vertices they bypass.
+    route.vertices.push_back(from);
+    for (size_t i = 1u; i < vertices.size(); ++i)
+    {
+        unpack(vertices[i - 1u], vertices[i], route.vertices);
+    }
+    route.length = Meter(double(best));
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void RoadGraph::unpack(Id const from, Id const to, std::vector<Id>& vertices) const
+{
+    auto it = m_shortcuts.find(key(from, to));
+    if (it == m_shortcuts.end())
+    {
+        vertices.push_back(to);
+        return ;
+    }
+
+    Id const middle = it->second;
+    unpack(from, middle, vertices);
+    unpack(middle, to, vertices);
+}
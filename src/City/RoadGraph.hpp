@@ -0,0 +1,274 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef ROAD_GRAPH_HPP
+#  define ROAD_GRAPH_HPP
+
+#  include "City/Road.hpp"
+#  include <unordered_map>
+#  include <limits>
+#  include <cstdint>
+#  include <cmath>
+
+// ****************************************************************************
+//! \brief Directed graph of the road network used for routing cars. Vertices
+//! are lanes (built from Road) or junctions (built from a network Path) and
+//! edges are weighted by the driving distance.
+//!
+//! Two kinds of queries are available:
+//!   - A* search on the raw graph (the distance as the crow flies is the
+//!     heuristic). No preprocessing needed: good while the graph is edited.
+//!   - Contraction hierarchy: contract() orders vertices by importance and
+//!     adds shortcut edges preserving shortest paths. Queries are then made by
+//!     a bidirectional Dijkstra only climbing the hierarchy, settling a few
+//!     hundred vertices even on city-scale networks.
+//! route() uses the contraction hierarchy once computed else A*. Queries do
+//! not modify the graph and can be made concurrently from several threads.
+// ****************************************************************************
+class RoadGraph
+{
+    //! \brief Saves and restores the contraction hierarchy.
+    friend class CityFile;
+
+public:
+
+    //! \brief Index of vertices.
+    using Id = uint32_t;
+    //! \brief Invalid vertex.
+    static constexpr Id NONE = std::numeric_limits<Id>::max();
+
+    // *************************************************************************
+    //! \brief Directed weighted edge.
+    // *************************************************************************
+    struct Edge
+    {
+        //! \brief Destination vertex.
+        Id to;
+        //! \brief Driving distance [meter].
+        float cost;
+        //! \brief For shortcuts: the contracted vertex the shortcut bypasses.
+        //! NONE for edges of the road network.
+        Id middle;
+    };
+
+    // *************************************************************************
+    //! \brief Result of a routing query.
+    // *************************************************************************
+    struct Route
+    {
+        //! \brief Traversed vertices from the origin to the destination
+        //! (included).
+        std::vector<Id> vertices;
+        //! \brief Driving distance [meter].
+        Meter length = 0.0_m;
+    };
+
+public:
+
+    //--------------------------------------------------------------------------
+    //! \brief Remove all vertices and edges.
+    //--------------------------------------------------------------------------
+    void clear();
+
+    //--------------------------------------------------------------------------
+    //! \brief Build the lane-level graph of the given roads: one vertex per
+    //! lane, placed at the end of the lane. A lane is linked to the lanes
+    //! starting near its end (junctions, U-turns on the same road excepted)
+    //! and to the adjacent lanes of the same road and traffic side (change of
+    //! lane).
+    //! \param[in] roads: the roads of the city.
+    //! \param[in] junction: maximum distance between the end of a lane and
+    //! the start of the next lane.
+    //--------------------------------------------------------------------------
+    void build(std::vector<std::unique_ptr<Road>> const& roads,
+               Meter const junction = 10.0_m);
+
+    //--------------------------------------------------------------------------
+    //! \brief Build the graph of the given network (i.e. from the city
+    //! generator): one vertex per node and two opposite edges per way.
+    //--------------------------------------------------------------------------
+    void build(Path const& path);
+
+    //--------------------------------------------------------------------------
+    //! \brief Add a vertex at the given world position.
+    //! \param[in] lane: the lane it stands for (if any).
+    //! \return the index of the vertex.
+    //--------------------------------------------------------------------------
+    Id addVertex(sf::Vector2<Meter> const& position, Lane* lane = nullptr);
+
+    //--------------------------------------------------------------------------
+    //! \brief Add a directed edge. The cost is saturated to the distance
+    //! between vertices to keep the A* heuristic admissible. Adding an edge
+    //! discards the contraction hierarchy.
+    //--------------------------------------------------------------------------
+    void addEdge(Id const from, Id const to, Meter const cost);
+
+    //--------------------------------------------------------------------------
+    //! \brief Compute the contraction hierarchy for faster route() queries.
+    //--------------------------------------------------------------------------
+    void contract();
+
+    //--------------------------------------------------------------------------
+    //! \brief Has the contraction hierarchy been computed ?
+    //--------------------------------------------------------------------------
+    inline bool contracted() const
+    {
+        return !m_ranks.empty();
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Shortest route between two vertices. Use the contraction
+    //! hierarchy when computed else A*.
+    //! \return false if the destination cannot be reached.
+    //--------------------------------------------------------------------------
+    bool route(Id const from, Id const to, Route& route) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Shortest route between two vertices with an A* search on the
+    //! graph (the contraction hierarchy is not used).
+    //! \return false if the destination cannot be reached.
+    //--------------------------------------------------------------------------
+    bool astar(Id const from, Id const to, Route& route) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the vertex standing for the given lane or NONE.
+    //--------------------------------------------------------------------------
+    Id vertex(Lane const& lane) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the vertex the nearest to the given world position or
+    //! NONE if the graph is empty. Only the cells of the grid of vertices
+    //! around the position are visited.
+    //--------------------------------------------------------------------------
+    Id nearest(sf::Vector2<Meter> const& position) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the world position of the vertex.
+    //--------------------------------------------------------------------------
+    inline sf::Vector2<Meter> const& position(Id const id) const
+    {
+        return m_positions[id];
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the lane the vertex stands for (nullptr if none).
+    //--------------------------------------------------------------------------
+    inline Lane* lane(Id const id) const
+    {
+        return m_lanes[id];
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the edges leaving the given vertex.
+    //--------------------------------------------------------------------------
+    inline std::vector<Edge> const& edges(Id const id) const
+    {
+        return m_edges[id];
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the number of vertices.
+    //--------------------------------------------------------------------------
+    inline size_t size() const
+    {
+        return m_positions.size();
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the number of shortcuts added by contract().
+    //--------------------------------------------------------------------------
+    inline size_t shortcuts() const
+    {
+        return m_shortcuts.size();
+    }
+
+private:
+
+    //--------------------------------------------------------------------------
+    //! \brief Bidirectional Dijkstra on the contraction hierarchy.
+    //--------------------------------------------------------------------------
+    bool hierarchy(Id const from, Id const to, Route& route) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Append to the route the vertices of the road network bypassed by
+    //! the edge from -> to (excluding from, including to).
+    //--------------------------------------------------------------------------
+    void unpack(Id const from, Id const to, std::vector<Id>& vertices) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the cell of the grid of vertices holding the position.
+    //--------------------------------------------------------------------------
+    static inline sf::Vector2<int32_t> cell(sf::Vector2<Meter> const& position)
+    {
+        return { int32_t(std::floor(position.x.value() / CELL_SIZE)),
+                 int32_t(std::floor(position.y.value() / CELL_SIZE)) };
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Key of the cell for the grid of vertices.
+    //--------------------------------------------------------------------------
+    static inline uint64_t key(sf::Vector2<int32_t> const& cell)
+    {
+        return (uint64_t(uint32_t(cell.x)) << 32) | uint64_t(uint32_t(cell.y));
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Key of the edge from -> to for the table of shortcuts.
+    //--------------------------------------------------------------------------
+    static inline uint64_t key(Id const from, Id const to)
+    {
+        return (uint64_t(from) << 32) | uint64_t(to);
+    }
+
+private:
+
+    //! \brief World position of vertices.
+    std::vector<sf::Vector2<Meter>> m_positions;
+    //! \brief Lanes standing for vertices (nullptr for network nodes).
+    std::vector<Lane*> m_lanes;
+    //! \brief Vertices standing for lanes.
+    std::unordered_map<Lane const*, Id> m_vertices;
+    //! \brief Edges of the road network leaving each vertex.
+    std::vector<std::vector<Edge>> m_edges;
+    //! \brief Contraction hierarchy: order of contraction of vertices. Empty
+    //! when not computed.
+    std::vector<Id> m_ranks;
+    //! \brief Contraction hierarchy: edges from -> to with rank(from) <
+    //! rank(to), stored in compressed rows (m_upward_offsets[from]).
+    std::vector<Edge> m_upward;
+    std::vector<size_t> m_upward_offsets;
+    //! \brief Contraction hierarchy: edges from -> to with rank(from) >
+    //! rank(to), stored reversed in the row of the destination.
+    std::vector<Edge> m_downward;
+    std::vector<size_t> m_downward_offsets;
+    //! \brief Middle vertex of shortcuts for unpacking routes.
+    std::unordered_map<uint64_t, Id> m_shortcuts;
+    //! \brief Size of the cells of the grid of vertices [meter].
+    static constexpr double CELL_SIZE = 50.0;
+    //! \brief Grid of vertices for nearest() queries: vertices indexed by
+    //! the key of their cell. Only non empty cells are stored.
+    std::unordered_map<uint64_t, std::vector<Id>> m_cells;
+    //! \brief Bounding box of the non empty cells.
+    sf::Vector2<int32_t> m_cells_min;
+    sf::Vector2<int32_t> m_cells_max;
+};
+
+#endif
@@ -0,0 +1,149 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "City/Terrain.hpp"
+#include <algorithm>
+#include <cmath>
+
+//! \brief Number of samples per tile.
+static constexpr size_t SAMPLES = (Terrain::TILE + 1u) * (Terrain::TILE + 1u);
+
+//------------------------------------------------------------------------------
+bool Terrain::load(sf::Vector2<Meter> const& origin, Meter const cell,
+                   size_t const columns, size_t const rows,
+                   std::vector<float> const& heights)
+{
+    clear();
+    if ((columns < 2u) || (rows < 2u) || (cell.value() <= 0.0) ||
+        (heights.size() != columns * rows))
+        return false;
+
+    m_x = origin.x.value();
+    m_y = origin.y.value();
+    m_cell = cell.value();
+    m_inv_cell = 1.0 / m_cell;
+    m_columns = columns - 1u;
+    m_rows = rows - 1u;
+    m_tiles_x = (m_columns + TILE - 1u) / TILE;
+    size_t const tiles_y = (m_rows + TILE - 1u) / TILE;
+
+    // Copy samples of each tile, including their border shared with the next
+    // tiles. Samples beyond the heightmap repeat its border.
+    m_tiles.resize(m_tiles_x * tiles_y * SAMPLES);
+    float* sample = m_tiles.data();
+    for (size_t ty = 0u; ty < tiles_y; ++ty)
+    {
+        for (size_t tx = 0u; tx < m_tiles_x; ++tx)
+        {
+            for (size_t j = 0u; j <= TILE; ++j)
+            {
+                size_t const y = std::min(ty * TILE + j, m_rows);
+                for (size_t i = 0u; i <= TILE; ++i)
+                {
+                    size_t const x = std::min(tx * TILE + i, m_columns);
+                    *sample++ = heights[y * columns + x];
+                }
+            }
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void Terrain::clear()
+{
+    m_tiles.clear();
+    m_tiles.shrink_to_fit();
+    m_columns = m_rows = m_tiles_x = 0u;
+}
+
+//------------------------------------------------------------------------------
+double Terrain::interpolate(sf::Vector2<Meter> const& position,
+                            sf::Vector2<double>* gradient) const
+{
+    // Position in cells, clamped to the heightmap.
+    double const fx = std::clamp((position.x.value() - m_x) * m_inv_cell, 0.0, double(m_columns));
+    double const fy = std::clamp((position.y.value() - m_y) * m_inv_cell, 0.0, double(m_rows));
+    size_t const x = std::min(size_t(fx), m_columns - 1u);
+    size_t const y = std::min(size_t(fy), m_rows - 1u);
+    double const u = fx - double(x);
+    double const v = fy - double(y);
+
+    // Samples (x0, y0), (x1, y0), (x0, y1), (x1, y1) of the cell inside its
+    // tile.
+    float const* tile = m_tiles.data() + ((y / TILE) * m_tiles_x + (x / TILE)) * SAMPLES;
+    float const* s = tile + (y % TILE) * (TILE + 1u) + (x % TILE);
+    double const bottom = s[0] + u * (s[1] - s[0]);
+    double const top = s[TILE + 1u] + u * (s[TILE + 2u] - s[TILE + 1u]);
+    if (gradient != nullptr)
+    {
+        gradient->x = ((s[1] - s[0]) * (1.0 - v) + (s[TILE + 2u] - s[TILE + 1u]) * v) * m_inv_cell;
+        gradient->y = (top - bottom) * m_inv_cell;
+    }
+    return bottom + v * (top - bottom);
+}
+
+//------------------------------------------------------------------------------
+Meter Terrain::altitude(sf::Vector2<Meter> const& position) const
+{
+    if (m_tiles.empty())
+        return 0.0_m;
+
+    return Meter(interpolate(position, nullptr));
+}
+
+//------------------------------------------------------------------------------
+Meter Terrain::altitude(sf::Vector2<Meter> const& position, sf::Vector2<double>& gradient) const
+{
+    if (m_tiles.empty())
+    {
+        gradient = { 0.0, 0.0 };
+        return 0.0_m;
+    }
+
+    return Meter(interpolate(position, &gradient));
+}
+
+//------------------------------------------------------------------------------
+Radian Terrain::slope(sf::Vector2<Meter> const& position, Radian const heading) const
+{
+    sf::Vector2<double> gradient;
+    altitude(position, gradient);
+    double const h = heading.value();
+    return Radian(std::atan(gradient.x * std::cos(h) + gradient.y * std::sin(h)));
+}
+
+//------------------------------------------------------------------------------
+void Terrain::altitudes(std::vector<sf::Vector2<Meter>> const& positions,
+                        std::vector<Meter>& altitudes) const
+{
+    altitudes.resize(positions.size());
+    if (m_tiles.empty())
+    {
+        std::fill(altitudes.begin(), altitudes.end(), 0.0_m);
+        return ;
+    }
+
+    for (size_t i = 0u; i < positions.size(); ++i)
+    {
+        altitudes[i] = Meter(interpolate(positions[i], nullptr));
+    }
+}
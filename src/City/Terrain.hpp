@@ -0,0 +1,121 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef TERRAIN_HPP
+#  define TERRAIN_HPP
+
+#  include "Math/Units.hpp"
+#  include <SFML/System/Vector2.hpp>
+#  include <vector>
+
+// *****************************************************************************
+//! \brief Elevation of the ground given by a heightmap (altitudes sampled on a
+//! regular grid). The heightmap is split into square tiles of TILE x TILE
+//! cells, stored contiguously and holding their own border samples, so a
+//! bilinear interpolation only reads 4 floats of a single tile of a few
+//! kilobytes. Outside the heightmap, the altitude of its nearest border is
+//! returned. A flat terrain (no heightmap) costs a single test per query.
+// *****************************************************************************
+class Terrain
+{
+public:
+
+    //! \brief Number of cells on each side of a tile.
+    static constexpr size_t TILE = 32u;
+
+    //--------------------------------------------------------------------------
+    //! \brief Replace the heightmap.
+    //! \param[in] origin: world position of the first sample.
+    //! \param[in] cell: distance between two consecutive samples.
+    //! \param[in] columns: number of samples along the X-axis (>= 2).
+    //! \param[in] rows: number of samples along the Y-axis (>= 2).
+    //! \param[in] heights: row major altitudes [meter] (rows x columns).
+    //! \return false if dimensions are not valid (the terrain is then flat).
+    //--------------------------------------------------------------------------
+    bool load(sf::Vector2<Meter> const& origin, Meter const cell,
+              size_t const columns, size_t const rows,
+              std::vector<float> const& heights);
+
+    //--------------------------------------------------------------------------
+    //! \brief Remove the heightmap: the terrain becomes flat at altitude 0.
+    //--------------------------------------------------------------------------
+    void clear();
+
+    //--------------------------------------------------------------------------
+    //! \brief Return true if there is no heightmap.
+    //--------------------------------------------------------------------------
+    inline bool flat() const
+    {
+        return m_tiles.empty();
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the altitude at the given position (bilinear
+    //! interpolation of the heightmap).
+    //--------------------------------------------------------------------------
+    Meter altitude(sf::Vector2<Meter> const& position) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the altitude and its gradient (dz/dx, dz/dy without
+    //! dimension) at the given position.
+    //--------------------------------------------------------------------------
+    Meter altitude(sf::Vector2<Meter> const& position, sf::Vector2<double>& gradient) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the slope of the ground in the given direction (positive
+    //! when climbing).
+    //--------------------------------------------------------------------------
+    Radian slope(sf::Vector2<Meter> const& position, Radian const heading) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Batched altitude queries (i.e. of all wheels of all cars).
+    //! \param[in] positions: positions to query.
+    //! \param[out] altitudes: altitudes of positions (resized).
+    //--------------------------------------------------------------------------
+    void altitudes(std::vector<sf::Vector2<Meter>> const& positions,
+                   std::vector<Meter>& altitudes) const;
+
+private:
+
+    //--------------------------------------------------------------------------
+    //! \brief Bilinear interpolation of the 4 samples of the cell holding the
+    //! position. The heightmap shall not be empty.
+    //! \param[out] gradient: if not NULL, the gradient (dz/dx, dz/dy).
+    //! \return the altitude [meter].
+    //--------------------------------------------------------------------------
+    double interpolate(sf::Vector2<Meter> const& position,
+                       sf::Vector2<double>* gradient) const;
+
+private:
+
+    //! \brief Samples of tiles: (TILE + 1) x (TILE + 1) floats per tile.
+    std::vector<float> m_tiles;
+    //! \brief World position of the first sample [meter].
+    double m_x = 0.0, m_y = 0.0;
+    //! \brief Distance between samples [meter] and its inverse.
+    double m_cell = 1.0, m_inv_cell = 1.0;
+    //! \brief Number of cells along each axis.
+    size_t m_columns = 0u, m_rows = 0u;
+    //! \brief Number of tiles along the X-axis.
+    size_t m_tiles_x = 0u;
+};
+
+#endif
@@ -0,0 +1,157 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "City/Tiles.hpp"
+#include "City/Road.hpp"
+#include "City/Parking.hpp"
+#include <algorithm>
+#include <cassert>
+
+//------------------------------------------------------------------------------
+Tiles::Tiles(Meter const size)
+    : m_size(size)
+{
+    assert(size > Meter(0.0));
+}
+
+//------------------------------------------------------------------------------
+Tiles::Key Tiles::key(sf::Vector2<Meter> const& position) const
+{
+    return pack(index(position.x), index(position.y));
+}
+
+//------------------------------------------------------------------------------
+void Tiles::insert(Road& road)
+{
+    for (size_t side = 0u; side < TrafficSide::Max; ++side)
+    {
+        for (auto const& lane: road.m_lanes[side])
+        {
+            sf::FloatRect const& bounds = lane->bounds();
+            int32_t const x0 = index(Meter(bounds.left));
+            int32_t const x1 = index(Meter(bounds.left + bounds.width));
+            int32_t const y0 = index(Meter(bounds.top));
+            int32_t const y1 = index(Meter(bounds.top + bounds.height));
+            for (int32_t y = y0; y <= y1; ++y)
+            {
+                for (int32_t x = x0; x <= x1; ++x)
+                {
+                    std::vector<Road*>& roads = m_tiles[pack(x, y)].roads;
+                    if (roads.empty() || (roads.back() != &road))
+                    {
+                        roads.push_back(&road);
+                    }
+                }
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+void Tiles::insert(Parking& parking)
+{
+    m_tiles[key(parking.position())].parkings.push_back(&parking);
+}
+
+//------------------------------------------------------------------------------
+void Tiles::insert(Key const key, Road& road)
+{
+    m_tiles[key].roads.push_back(&road);
+}
+
+//------------------------------------------------------------------------------
+void Tiles::insert(Key const key, Parking& parking)
+{
+    m_tiles[key].parkings.push_back(&parking);
+}
+
+//------------------------------------------------------------------------------
+void Tiles::clearParkings()
+{
+    for (auto it = m_tiles.begin(); it != m_tiles.end();)
+    {
+        it->second.parkings.clear();
+        if (it->second.roads.empty())
+            it = m_tiles.erase(it);
+        else
+            ++it;
+    }
+}
+
+//------------------------------------------------------------------------------
+void Tiles::clear()
+{
+    m_tiles.clear();
+    activate();
+}
+
+//------------------------------------------------------------------------------
+Tiles::Tile const* Tiles::tile(Key const key) const
+{
+    auto it = m_tiles.find(key);
+    return (it == m_tiles.end()) ? nullptr : &it->second;
+}
+
+//------------------------------------------------------------------------------
+Tiles::Tile const* Tiles::tile(sf::Vector2<Meter> const& position) const
+{
+    return tile(key(position));
+}
+
+//------------------------------------------------------------------------------
+void Tiles::activate(std::vector<sf::Vector2<Meter>> const& centers, Meter const radius)
+{
+    m_all_active = false;
+    m_active.clear();
+    m_actives.clear();
+
+    double const s = m_size.value();
+    double const r = radius.value();
+    for (sf::Vector2<Meter> const& center: centers)
+    {
+        double const cx = center.x.value();
+        double const cy = center.y.value();
+        int32_t const x0 = index(Meter(cx - r)), x1 = index(Meter(cx + r));
+        int32_t const y0 = index(Meter(cy - r)), y1 = index(Meter(cy + r));
+        for (int32_t y = y0; y <= y1; ++y)
+        {
+            for (int32_t x = x0; x <= x1; ++x)
+            {
+                // Distance from the center to the tile.
+                double const dx = std::max(0.0, std::max(double(x) * s - cx, cx - double(x + 1) * s));
+                double const dy = std::max(0.0, std::max(double(y) * s - cy, cy - double(y + 1) * s));
+                if ((dx * dx + dy * dy <= r * r) && m_active.insert(pack(x, y)).second)
+                {
+                    m_actives.push_back(pack(x, y));
+                }
+            }
+        }
+    }
+    std::sort(m_actives.begin(), m_actives.end());
+}
+
+//------------------------------------------------------------------------------
+void Tiles::activate()
+{
+    m_all_active = true;
+    m_active.clear();
+    m_actives.clear();
+}
@@ -0,0 +1,202 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef TILES_HPP
+#  define TILES_HPP
+
+#  include "Math/Units.hpp"
+#  include <SFML/System/Vector2.hpp>
+#  include <unordered_map>
+#  include <unordered_set>
+#  include <vector>
+#  include <cstdint>
+#  include <cmath>
+
+class Road;
+class Parking;
+
+// *****************************************************************************
+//! \brief Partition of the world into square tiles, each one referring to the
+//! roads and parkings overlapping it. Tiles near the points of interest (egos,
+//! camera) are active: they are fully simulated. Other tiles are frozen: their
+//! cars are not simulated, or are advanced with a cheap model (see Traffic).
+//! Queries by position (i.e. looking for the lane holding a car) only visit the
+//! content of one tile, so their cost does not grow with the size of the city.
+// *****************************************************************************
+class Tiles
+{
+public:
+
+    //! \brief Packed (x, y) indices of a tile.
+    using Key = uint64_t;
+
+    // *************************************************************************
+    //! \brief Content of a tile.
+    // *************************************************************************
+    struct Tile
+    {
+        //! \brief Roads having a lane overlapping the tile.
+        std::vector<Road*> roads;
+        //! \brief Parkings whose position is inside the tile.
+        std::vector<Parking*> parkings;
+    };
+
+public:
+
+    //--------------------------------------------------------------------------
+    //! \brief Empty partition where all tiles are active.
+    //! \param[in] size: length of the side of tiles.
+    //--------------------------------------------------------------------------
+    Tiles(Meter const size = Meter(250.0));
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the key of the tile holding the given world position.
+    //--------------------------------------------------------------------------
+    Key key(sf::Vector2<Meter> const& position) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Refer the road in all tiles overlapped by its lanes.
+    //--------------------------------------------------------------------------
+    void insert(Road& road);
+
+    //--------------------------------------------------------------------------
+    //! \brief Refer the parking in the tile holding its position.
+    //--------------------------------------------------------------------------
+    void insert(Parking& parking);
+
+    //--------------------------------------------------------------------------
+    //! \brief Refer the road or the parking in the given tile (i.e. when the
+    //! partition has been computed beforehand, see CityFile).
+    //--------------------------------------------------------------------------
+    void insert(Key const key, Road& road);
+    void insert(Key const key, Parking& parking);
+
+    //--------------------------------------------------------------------------
+    //! \brief Forget parkings (i.e. when the city is reset).
+    //--------------------------------------------------------------------------
+    void clearParkings();
+
+    //--------------------------------------------------------------------------
+    //! \brief Forget everything. All tiles become active.
+    //--------------------------------------------------------------------------
+    void clear();
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the tile holding the given position or nullptr if the
+    //! tile is empty.
+    //--------------------------------------------------------------------------
+    Tile const* tile(sf::Vector2<Meter> const& position) const;
+
+    Tile const* tile(Key const key) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Activate the tiles overlapping the disks of the given radius
+    //! centered on the given positions. Others tiles are frozen.
+    //--------------------------------------------------------------------------
+    void activate(std::vector<sf::Vector2<Meter>> const& centers, Meter const radius);
+
+    //--------------------------------------------------------------------------
+    //! \brief Activate all tiles (default).
+    //--------------------------------------------------------------------------
+    void activate();
+
+    //--------------------------------------------------------------------------
+    //! \brief Is the given position inside an active tile ?
+    //--------------------------------------------------------------------------
+    inline bool active(sf::Vector2<Meter> const& position) const
+    {
+        return m_all_active || (m_active.count(key(position)) != 0u);
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the active tiles (sorted) or an empty list when all tiles
+    //! are active.
+    //--------------------------------------------------------------------------
+    inline std::vector<Key> const& actives() const
+    {
+        return m_actives;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Are all tiles active ?
+    //--------------------------------------------------------------------------
+    inline bool allActive() const
+    {
+        return m_all_active;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the length of the side of tiles.
+    //--------------------------------------------------------------------------
+    inline Meter size() const
+    {
+        return m_size;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the number of non empty tiles.
+    //--------------------------------------------------------------------------
+    inline size_t count() const
+    {
+        return m_tiles.size();
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the non empty tiles.
+    //--------------------------------------------------------------------------
+    inline std::unordered_map<Key, Tile> const& tiles() const
+    {
+        return m_tiles;
+    }
+
+private:
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the key of the tile of indices (x, y).
+    //--------------------------------------------------------------------------
+    static inline Key pack(int32_t const x, int32_t const y)
+    {
+        return (Key(uint32_t(x)) << 32) | Key(uint32_t(y));
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the index of the tile along an axis.
+    //--------------------------------------------------------------------------
+    inline int32_t index(Meter const coordinate) const
+    {
+        return int32_t(std::floor(coordinate.value() / m_size.value()));
+    }
+
+private:
+
+    //! \brief Length of the side of tiles.
+    Meter m_size;
+    //! \brief Non empty tiles.
+    std::unordered_map<Key, Tile> m_tiles;
+    //! \brief Active tiles.
+    std::unordered_set<Key> m_active;
+    //! \brief Active tiles, sorted for deterministic iterations.
+    std::vector<Key> m_actives;
+    //! \brief No point of interest given ?
+    bool m_all_active = true;
+};
+
+#endif
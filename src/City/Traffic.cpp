@@ -0,0 +1,460 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "City/Traffic.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+static constexpr double INF = std::numeric_limits<double>::infinity();
+// Gap below which cars are considered as colliding [meter].
+static constexpr double MIN_GAP = 0.1;
+// Lateral offset below which a change of lane is considered as done [meter].
+static constexpr double LANE_CHANGED = 0.3;
+// Period of refresh of the pose of cars with a coarse level of detail [tick].
+static constexpr uint32_t COARSE_PERIOD = 10u;
+// Max distance between the origins of lanes following the same lane [meter].
+static const Meter SAME_JUNCTION = 0.5_m;
+
+//------------------------------------------------------------------------------
+// Deterministic hash of an agent and a lane (for choices at junctions).
+static inline uint32_t hash(uint32_t const id, uint32_t const lane)
+{
+    uint32_t h = id * 0x9E3779B1u ^ lane * 0x85EBCA77u;
+    h ^= h >> 15; h *= 0x2C1B3C6Du;
+    h ^= h >> 12; h *= 0x297A2D39u;
+    return h ^ (h >> 15);
+}
+
+//------------------------------------------------------------------------------
+// First car ahead of the abscissa s in the lane, ignoring the given car.
+static Lane::Occupant const* ahead(Lane const& lane, Meter const s, Car const* self)
+{
+    Lane::Occupant const* o = lane.leader(s);
+    while ((o != nullptr) && (o->car == self))
+        o = lane.leader(o->s);
+    return o;
+}
+
+//------------------------------------------------------------------------------
+// First car behind the abscissa s in the lane, ignoring the given car.
+static Lane::Occupant const* behind(Lane const& lane, Meter const s, Car const* self)
+{
+    Lane::Occupant const* o = lane.follower(s);
+    while ((o != nullptr) && (o->car == self))
+        o = lane.follower(o->s);
+    return o;
+}
+
+//------------------------------------------------------------------------------
+Car& Traffic::spawn(City& city, const char* model, Road const& road,
+                    TrafficSide const side, size_t const lane, double const offset_long,
+                    MeterPerSecond const speed, MeterPerSecond const desired_speed)
+{
+    Car& car = city.addAgent(model, road, side, lane, offset_long, speed);
+    connect(city);
+
+    Lane const& l = *road.m_lanes[side][lane];
+    m_cars.push_back(city.handle(car));
+    m_ids.push_back(m_next_id++);
+    m_lanes.push_back(city.graph(false).vertex(l));
+    m_s.push_back(offset_long * l.frenet().length());
+    m_d.push_back(0.0);
+    m_v.push_back(speed.value());
+    m_v0.push_back(desired_speed.value());
+    m_a.push_back(0.0);
+    m_front.push_back((car.blueprint.length - car.blueprint.back_overhang).value());
+    assert(m_lanes.back() != RoadGraph::NONE);
+    return car;
+}
+
+//------------------------------------------------------------------------------
+void Traffic::clear()
+{
+    m_connections.clear();
+    m_graph_size = 0u;
+    m_ticks = 0u;
+    m_next_id = 0u;
+    m_cars.clear();
+    m_ids.clear();
+    m_lanes.clear();
+    m_s.clear();
+    m_d.clear();
+    m_v.clear();
+    m_v0.clear();
+    m_a.clear();
+    m_front.clear();
+    m_gaps.clear();
+    m_leader_speeds.clear();
+    m_frozen.clear();
+}
+
+//------------------------------------------------------------------------------
+Lane const& Traffic::lane(size_t const i) const
+{
+    return *m_connections[m_lanes[i]].lane;
+}
+
+//------------------------------------------------------------------------------
+void Traffic::remove(size_t const i)
+{
+    size_t const last = m_cars.size() - 1u;
+    m_cars[i] = m_cars[last]; m_cars.pop_back();
+    m_ids[i] = m_ids[last]; m_ids.pop_back();
+    m_lanes[i] = m_lanes[last]; m_lanes.pop_back();
+    m_s[i] = m_s[last]; m_s.pop_back();
+    m_d[i] = m_d[last]; m_d.pop_back();
+    m_v[i] = m_v[last]; m_v.pop_back();
+    m_v0[i] = m_v0[last]; m_v0.pop_back();
+    m_a[i] = m_a[last]; m_a.pop_back();
+    m_front[i] = m_front[last]; m_front.pop_back();
+    if (m_frozen.size() == last + 1u)
+    {
+        // Removed during the update.
+        m_frozen[i] = m_frozen[last]; m_frozen.pop_back();
+    }
+}
+
+//------------------------------------------------------------------------------
+void Traffic::connect(City& city)
+{
+    RoadGraph const& graph = city.graph(false);
+    if (graph.size() == m_graph_size)
+        return ;
+
+    // Vertices of the road graph have been renumbered: remap agents through
+    // their lanes.
+    std::vector<Lane*> lanes(m_lanes.size());
+    for (size_t i = 0u; i < m_lanes.size(); ++i)
+    {
+        lanes[i] = m_connections[m_lanes[i]].lane;
+    }
+
+    m_graph_size = graph.size();
+    m_connections.clear();
+    m_connections.resize(m_graph_size, { nullptr, { RoadGraph::NONE, RoadGraph::NONE }, {} });
+    for (auto const& road: city.roads())
+    {
+        for (size_t side = 0u; side < TrafficSide::Max; ++side)
+        {
+            auto const& lanes_ = road->m_lanes[side];
+            for (size_t i = 0u; i < lanes_.size(); ++i)
+            {
+                RoadGraph::Id const v = graph.vertex(*lanes_[i]);
+                Connection& c = m_connections[v];
+                c.lane = lanes_[i].get();
+                if (i > 0u)
+                    c.adjacent[0] = graph.vertex(*lanes_[i - 1u]);
+                if (i + 1u < lanes_.size())
+                    c.adjacent[1] = graph.vertex(*lanes_[i + 1u]);
+            }
+        }
+    }
+
+    // Lanes starting where lanes end (edges of the graph also hold changes
+    // of lane). Only the nearest ones are kept so cars do not jump over lanes
+    // when driving from a road to the next one.
+    for (RoadGraph::Id v = 0u; v < m_graph_size; ++v)
+    {
+        Connection& c = m_connections[v];
+        if (c.lane == nullptr)
+            continue ;
+
+        Meter nearest = Meter(m_config.junction);
+        for (RoadGraph::Edge const& e: graph.edges(v))
+        {
+            Lane const* next = m_connections[e.to].lane;
+            if ((next != nullptr) && (e.to != c.adjacent[0]) && (e.to != c.adjacent[1]))
+            {
+                nearest = units::math::min(nearest, math::distance(c.lane->destination(),
+                                                                   next->origin()));
+            }
+        }
+        for (RoadGraph::Edge const& e: graph.edges(v))
+        {
+            Lane const* next = m_connections[e.to].lane;
+            Meter const distance = (next == nullptr) ? nearest + SAME_JUNCTION
+                : math::distance(c.lane->destination(), next->origin());
+            if ((e.to != c.adjacent[0]) && (e.to != c.adjacent[1]) &&
+                (distance <= Meter(m_config.junction)) && (distance < nearest + SAME_JUNCTION))
+            {
+                c.next.push_back(e.to);
+            }
+        }
+    }
+
+    for (size_t i = 0u; i < m_lanes.size(); ++i)
+    {
+        m_lanes[i] = graph.vertex(*lanes[i]);
+    }
+}
+
+//------------------------------------------------------------------------------
+RoadGraph::Id Traffic::next(size_t const i) const
+{
+    std::vector<RoadGraph::Id> const& next = m_connections[m_lanes[i]].next;
+    if (next.empty())
+        return RoadGraph::NONE;
+    return next[hash(m_ids[i], m_lanes[i]) % next.size()];
+}
+
+//------------------------------------------------------------------------------
+double Traffic::idm(double const v, double const v0, double const gap, double const dv) const
+{
+    double const a = m_config.acceleration;
+    double const b = m_config.deceleration;
+    double const desired_gap = m_config.min_gap +
+        std::max(0.0, v * m_config.time_gap + v * dv / (2.0 * std::sqrt(a * b)));
+    double const r = v / v0;
+    double const z = desired_gap / std::max(gap, MIN_GAP);
+    double const acc = a * (1.0 - (r * r) * (r * r) - z * z);
+    return std::min(std::max(acc, -m_config.max_deceleration), a);
+}
+
+//------------------------------------------------------------------------------
+void Traffic::leader(size_t const i, Car const* self, double& gap, double& speed) const
+{
+    Lane const& l = *m_connections[m_lanes[i]].lane;
+    double const front = m_s[i] + m_front[i];
+
+    if (Lane::Occupant const* o = ahead(l, Meter(m_s[i]), self))
+    {
+        gap = o->rear.value() - front;
+        speed = o->car->speed().value();
+        return ;
+    }
+
+    // Look at the rearmost car of the next lane.
+    gap = INF; speed = 0.0;
+    double const remaining = l.frenet().length() - front;
+    if (remaining > m_config.horizon)
+        return ;
+    RoadGraph::Id const n = next(i);
+    if (n == RoadGraph::NONE)
+        return ;
+    Lane::Occupants const& occupants = m_connections[n].lane->occupants();
+    if (!occupants.empty())
+    {
+        gap = remaining + occupants.front().rear.value();
+        speed = occupants.front().car->speed().value();
+    }
+}
+
+//------------------------------------------------------------------------------
+void Traffic::changeLane(City& city, size_t const i)
+{
+    if (std::abs(m_d[i]) > LANE_CHANGED)
+        return ;
+
+    Car* car = city.get(m_cars[i]);
+    Connection const& current = m_connections[m_lanes[i]];
+    double const s = m_s[i];
+    double const v = m_v[i];
+    double const front = m_front[i];
+    double const rear = car->blueprint.back_overhang.value();
+    double const v0 = m_config.desired_speed;
+    sf::Vector2<Meter> const& p = car->position();
+
+    // Acceleration of the old follower with and without the agent.
+    double old_follower_gain = 0.0;
+    if (Lane::Occupant const* f = behind(*current.lane, Meter(s), car))
+    {
+        double const vf = f->car->speed().value();
+        double const with = idm(vf, v0, s - rear - f->front.value(), vf - v);
+        double const without = idm(vf, v0, m_gaps[i] + s + front - f->front.value(),
+                                   vf - m_leader_speeds[i]);
+        old_follower_gain = without - with;
+    }
+
+    double best = m_config.threshold;
+    double acceleration = m_a[i];
+    RoadGraph::Id target = RoadGraph::NONE;
+    math::Frenet::Coordinates coordinates{ 0.0, 0.0 };
+    for (RoadGraph::Id const k: current.adjacent)
+    {
+        if (k == RoadGraph::NONE)
+            continue ;
+
+        Lane const& lane = *m_connections[k].lane;
+        math::Frenet::Coordinates const c = lane.frenet().toFrenet({ p.x.value(), p.y.value() });
+        if ((c.s - rear < 0.0) || (c.s + front > lane.frenet().length()))
+            continue ;
+
+        // Agent behind the new leader.
+        double gap = INF, vl = 0.0;
+        Lane::Occupant const* l = ahead(lane, Meter(c.s), car);
+        if (l != nullptr)
+        {
+            gap = l->rear.value() - c.s - front;
+            vl = l->car->speed().value();
+            if (gap < MIN_GAP)
+                continue ;
+        }
+        double const a = idm(v, m_v0[i], gap, v - vl);
+        double const self_gain = a - m_a[i];
+
+        // Safety and disadvantage of the new follower.
+        double new_follower_gain = 0.0;
+        if (Lane::Occupant const* f = behind(lane, Meter(c.s), car))
+        {
+            double const vf = f->car->speed().value();
+            double const gap_after = c.s - rear - f->front.value();
+            if (gap_after < MIN_GAP)
+                continue ;
+            double const after = idm(vf, v0, gap_after, vf - v);
+            if (after < -m_config.safe_deceleration)
+                continue ;
+            double const before = (l == nullptr) ? idm(vf, v0, INF, 0.0)
+                : idm(vf, v0, l->rear.value() - f->front.value(), vf - vl);
+            new_follower_gain = after - before;
+        }
+
+        double const incentive = self_gain + m_config.politeness *
+                                 (new_follower_gain + old_follower_gain);
+        if (incentive > best)
+        {
+            best = incentive;
+            acceleration = a;
+            target = k;
+            coordinates = c;
+        }
+    }
+
+    if (target != RoadGraph::NONE)
+    {
+        m_lanes[i] = target;
+        m_s[i] = coordinates.s;
+        m_d[i] = coordinates.d;
+        m_a[i] = acceleration;
+    }
+}
+
+//------------------------------------------------------------------------------
+void Traffic::update(City& city, Second const dt)
+{
+    connect(city);
+
+    // Forget agents removed from the city.
+    for (size_t i = 0u; i < m_cars.size();)
+    {
+        if (city.get(m_cars[i]) == nullptr)
+            remove(i);
+        else
+            ++i;
+    }
+
+    size_t const count = m_cars.size();
+    double const t = dt.value();
+    m_gaps.resize(count);
+    m_leader_speeds.resize(count);
+    m_frozen.resize(count);
+
+    // Agents inside frozen tiles of the world just keep their speed.
+    for (size_t i = 0u; i < count; ++i)
+    {
+        math::Frenet::Position const p =
+            m_connections[m_lanes[i]].lane->frenet().toCartesian({ m_s[i], m_d[i] });
+        m_frozen[i] = !city.active(sf::Vector2<Meter>(Meter(p.x), Meter(p.y)));
+    }
+
+    // Leaders from the lanes occupancy.
+    for (size_t i = 0u; i < count; ++i)
+    {
+        if (m_frozen[i])
+        {
+            m_gaps[i] = INF;
+            m_leader_speeds[i] = m_v[i];
+        }
+        else
+        {
+            leader(i, city.get(m_cars[i]), m_gaps[i], m_leader_speeds[i]);
+        }
+    }
+
+    // Intelligent Driver Model.
+    for (size_t i = 0u; i < count; ++i)
+    {
+        m_a[i] = m_frozen[i] ? 0.0 : idm(m_v[i], m_v0[i], m_gaps[i], m_v[i] - m_leader_speeds[i]);
+    }
+
+    // MOBIL: staggered over agents so each one is evaluated once per period.
+    size_t const period = std::max(size_t(1),
+        size_t(std::lround(m_config.lane_change_period / t)));
+    for (size_t i = (period - m_ticks % period) % period; i < count; i += period)
+    {
+        if ((!m_frozen[i]) && (city.get(m_cars[i])->lod() != LOD::Coarse))
+        {
+            changeLane(city, i);
+        }
+    }
+    ++m_ticks;
+
+    // Ballistic integration: cars do not drive backward.
+    double const decay = std::max(0.0, 1.0 - 3.0 * t / m_config.lane_change_duration);
+    for (size_t i = 0u; i < count; ++i)
+    {
+        double const v = m_v[i] + m_a[i] * t;
+        m_s[i] += (v >= 0.0) ? (m_v[i] + v) * 0.5 * t
+                             : -m_v[i] * m_v[i] / (2.0 * m_a[i]);
+        m_v[i] = std::max(v, 0.0);
+        m_d[i] *= decay;
+    }
+
+    // Next lanes at the end of lanes, else leave the city.
+    for (size_t i = 0u; i < m_cars.size();)
+    {
+        double const length = m_connections[m_lanes[i]].lane->frenet().length();
+        if (m_s[i] <= length)
+        {
+            ++i;
+            continue ;
+        }
+        RoadGraph::Id const n = next(i);
+        if (n == RoadGraph::NONE)
+        {
+            city.removeCar(m_cars[i]);
+            remove(i);
+            continue ;
+        }
+        m_s[i] -= length;
+        m_lanes[i] = n;
+    }
+
+    // Car poses (refreshed when their tile becomes active).
+    double const rate = 3.0 / m_config.lane_change_duration;
+    for (size_t i = 0u; i < m_cars.size(); ++i)
+    {
+        // Far cars only know their lane position: their pose is refreshed
+        // from time to time.
+        Car* car = city.get(m_cars[i]);
+        if (m_frozen[i] || ((car->lod() == LOD::Coarse) &&
+                            ((m_ticks + m_ids[i]) % COARSE_PERIOD != 0u)))
+            continue ;
+
+        math::Frenet const& frenet = m_connections[m_lanes[i]].lane->frenet();
+        math::Frenet::Position const p = frenet.toCartesian({ m_s[i], m_d[i] });
+        double const heading = frenet.heading(m_s[i]) +
+            std::atan2(-rate * m_d[i], std::max(m_v[i], 1.0));
+        car->init(MeterPerSecondSquared(m_a[i]), MeterPerSecond(m_v[i]),
+                  sf::Vector2<Meter>(Meter(p.x), Meter(p.y)), Radian(heading), 0.0_rad);
+    }
+}
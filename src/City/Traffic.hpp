@@ -0,0 +1,240 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef TRAFFIC_HPP
+#  define TRAFFIC_HPP
+
+#  include "City/City.hpp"
+
+// *****************************************************************************
+//! \brief Background traffic: drives the agent cars of the city (see
+//! City::addAgent()) along lanes with the Intelligent Driver Model (Treiber,
+//! Hennecke, Helbing, "Congested traffic states in empirical observations and
+//! microscopic simulations", 2000) for the longitudinal motion, and MOBIL
+//! (Kesting, Treiber, Helbing, "General lane-changing model MOBIL for
+//! car-following models", 2007) for changes of lane.
+//!
+//! Agents are kinematic: their (s, d) Frenet coordinates along their lane are
+//! integrated and their car pose is set from them, so the cost of an agent is a
+//! few arithmetic operations plus the lookup of its leader in the occupancy of
+//! its lane (which also holds the ego and scripted cars, so agents react to
+//! them). States are stored as structure of arrays and each tick is made of
+//! batched passes: gathering leaders, IDM accelerations, lane changes for a
+//! staggered subset of agents, integration, then poses. The update is
+//! deterministic: agents are processed in the order of their creation and
+//! random choices (next lane at junctions) are hashes of the agent identifier.
+//! Agents leaving the road network are removed from the city. Agents inside
+//! frozen tiles of the world (see Tiles) keep their speed along their lanes
+//! and their car pose is only refreshed once their tile becomes active. Cars
+//! with a coarse level of detail do not change of lane and their pose is only
+//! refreshed every few ticks.
+// *****************************************************************************
+class Traffic
+{
+public:
+
+    // *************************************************************************
+    //! \brief Parameters of the driver models.
+    // *************************************************************************
+    struct Config
+    {
+        //! \brief IDM max acceleration [m/s/s].
+        double acceleration = 1.5;
+        //! \brief IDM comfortable deceleration [m/s/s].
+        double deceleration = 2.0;
+        //! \brief IDM desired time gap [s].
+        double time_gap = 1.5;
+        //! \brief IDM minimal distance to the leader [m].
+        double min_gap = 2.0;
+        //! \brief Physical limit of the deceleration [m/s/s].
+        double max_deceleration = 9.0;
+        //! \brief Desired speed of cars not driven by the traffic [m/s].
+        double desired_speed = 13.9;
+        //! \brief Distance beyond which the leader is ignored [m].
+        double horizon = 200.0;
+        //! \brief MOBIL politeness factor.
+        double politeness = 0.3;
+        //! \brief MOBIL acceleration gain needed for changing of lane [m/s/s].
+        double threshold = 0.2;
+        //! \brief MOBIL max deceleration imposed to the new follower [m/s/s].
+        double safe_deceleration = 4.0;
+        //! \brief Period of evaluation of changes of lane by agents [s].
+        double lane_change_period = 1.0;
+        //! \brief Duration of a change of lane [s].
+        double lane_change_duration = 3.0;
+        //! \brief Max distance between the end of a lane and the start of the
+        //! next one [m].
+        double junction = 10.0;
+    };
+
+public:
+
+    Traffic() = default;
+
+    Traffic(Config const& config)
+        : m_config(config)
+    {}
+
+    //--------------------------------------------------------------------------
+    //! \brief Add an agent car on a road, driven by the traffic.
+    //! \param[in] model: non NULL string of the mark of the vehicle.
+    //! \param[in] road: the road reference.
+    //! \param[in] side: traffic side.
+    //! \param[in] lane: the lane index.
+    //! \param[in] offset_long: [0 .. 1] position along the lane.
+    //! \param[in] speed: initial speed.
+    //! \param[in] desired_speed: speed the driver wants to reach.
+    //! \return the reference of the created vehicle.
+    //--------------------------------------------------------------------------
+    Car& spawn(City& city, const char* model, Road const& road,
+               TrafficSide const side, size_t const lane, double const offset_long,
+               MeterPerSecond const speed, MeterPerSecond const desired_speed);
+
+    //--------------------------------------------------------------------------
+    //! \brief Move agents. Shall be called at each tick of the simulation,
+    //! after City::updateLanes() has been called at least once.
+    //--------------------------------------------------------------------------
+    void update(City& city, Second const dt);
+
+    //--------------------------------------------------------------------------
+    //! \brief Forget agents (i.e. when the city is reset).
+    //--------------------------------------------------------------------------
+    void clear();
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the number of agents.
+    //--------------------------------------------------------------------------
+    inline size_t size() const
+    {
+        return m_cars.size();
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the lane in which the i-th agent is driving.
+    //--------------------------------------------------------------------------
+    Lane const& lane(size_t const i) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the handle on the car of the i-th agent.
+    //--------------------------------------------------------------------------
+    inline City::CarHandle car(size_t const i) const
+    {
+        return m_cars[i];
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the tuning of the driver models.
+    //--------------------------------------------------------------------------
+    inline Config& config()
+    {
+        return m_config;
+    }
+
+private:
+
+    // *************************************************************************
+    //! \brief Lanes connectivity, indexed as the vertices of the road graph.
+    // *************************************************************************
+    struct Connection
+    {
+        //! \brief Lane of the vertex.
+        Lane* lane;
+        //! \brief Adjacent lanes on the same road and the same side.
+        RoadGraph::Id adjacent[2];
+        //! \brief Lanes starting at the end of the lane.
+        std::vector<RoadGraph::Id> next;
+    };
+
+    //--------------------------------------------------------------------------
+    //! \brief Build lanes connectivity when the road graph has changed.
+    //--------------------------------------------------------------------------
+    void connect(City& city);
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the lane following the lane of the i-th agent (or NONE).
+    //--------------------------------------------------------------------------
+    RoadGraph::Id next(size_t const i) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief IDM acceleration [m/s/s].
+    //! \param[in] v: speed [m/s].
+    //! \param[in] v0: desired speed [m/s].
+    //! \param[in] gap: bumper to bumper distance to the leader [m].
+    //! \param[in] dv: approaching rate to the leader [m/s].
+    //--------------------------------------------------------------------------
+    double idm(double const v, double const v0, double const gap, double const dv) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Find the leader of the i-th agent.
+    //! \param[in] self: the car of the agent.
+    //! \param[out] gap: bumper to bumper distance [m] (infinity if none).
+    //! \param[out] speed: speed of the leader [m/s].
+    //--------------------------------------------------------------------------
+    void leader(size_t const i, Car const* self, double& gap, double& speed) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief MOBIL: change the lane of the i-th agent if worth and safe.
+    //--------------------------------------------------------------------------
+    void changeLane(City& city, size_t const i);
+
+    //--------------------------------------------------------------------------
+    //! \brief Remove the i-th agent (swapped with the last one).
+    //--------------------------------------------------------------------------
+    void remove(size_t const i);
+
+private:
+
+    //! \brief Tuning of the driver models.
+    Config m_config;
+    //! \brief Lanes connectivity.
+    std::vector<Connection> m_connections;
+    //! \brief Number of vertices of the road graph when m_connections was built.
+    size_t m_graph_size = 0u;
+    //! \brief Number of updates.
+    size_t m_ticks = 0u;
+    //! \brief Identifier given to the next agent.
+    uint32_t m_next_id = 0u;
+
+    //! \brief Agents states (structure of arrays).
+    std::vector<City::CarHandle> m_cars;
+    std::vector<uint32_t> m_ids;
+    //! \brief Current lane (vertex of the road graph).
+    std::vector<RoadGraph::Id> m_lanes;
+    //! \brief Curvilinear abscissa of the rear axle along the lane [m].
+    std::vector<double> m_s;
+    //! \brief Lateral offset to the center of the lane (changes of lane) [m].
+    std::vector<double> m_d;
+    //! \brief Speed [m/s].
+    std::vector<double> m_v;
+    //! \brief Desired speed [m/s].
+    std::vector<double> m_v0;
+    //! \brief Acceleration [m/s/s].
+    std::vector<double> m_a;
+    //! \brief Distance from the rear axle to the front bumper [m].
+    std::vector<double> m_front;
+    //! \brief Gap and speed of leaders gathered at each tick.
+    std::vector<double> m_gaps;
+    std::vector<double> m_leader_speeds;
+    //! \brief Is the agent inside a frozen tile of the world ?
+    std::vector<uint8_t> m_frozen;
+};
+
+#endif
@@ -1,44 +1,42 @@
-#include <queue>
-#include <iostream>
-#include <vector>
-
-class Road
-{
-public:
+#include "../../Common/FileSystem.hpp"
 
-    Road(size_t p)
-        : priority(p)
-    {}
-
-    size_t priority;
-};
-
-class Compare
-{
-public:
+#define protected public
+#define private public
+#include "../CityGenerator.hpp"
+#undef protected
+#undef private
 
-    bool operator() (Road const* road1, Road const* road2)
-    {
-        return road1->priority > road2->priority;
-    }
-};
-
-using PriorityQueue = std::priority_queue<Road*, std::vector<Road*>, Compare>;
+#include <iostream>
 
+// Roads are popped by increasing priority and, for the same priority, in the
+// order they were pushed.
 int main()
 {
-    PriorityQueue q;
-    std::vector<Road> roads{
-        Road(42), Road(0), Road(3), Road(82), Road(5), Road(32)
+    CityGenerator::PriorityQueue q;
+    std::vector<CityGenerator::Road> roads{
+        CityGenerator::Road({0.0_m, 0.0_m}, {1.0_m, 0.0_m}, 42u, false),
+        CityGenerator::Road({0.0_m, 0.0_m}, {2.0_m, 0.0_m}, 0u, false),
+        CityGenerator::Road({0.0_m, 0.0_m}, {3.0_m, 0.0_m}, 3u, false),
+        CityGenerator::Road({0.0_m, 0.0_m}, {4.0_m, 0.0_m}, 0u, false),
+        CityGenerator::Road({0.0_m, 0.0_m}, {5.0_m, 0.0_m}, 3u, false),
+        CityGenerator::Road({0.0_m, 0.0_m}, {6.0_m, 0.0_m}, 82u, false),
+        CityGenerator::Road({0.0_m, 0.0_m}, {7.0_m, 0.0_m}, 0u, false),
+        CityGenerator::Road({0.0_m, 0.0_m}, {8.0_m, 0.0_m}, 32u, false)
     };
+    const double expected[] = { 2.0, 4.0, 7.0, 3.0, 5.0, 8.0, 1.0, 6.0 };
 
     for (auto& it: roads)
         q.push(&it);
 
+    size_t i = 0u;
+    bool ok = (q.size() == roads.size());
     while (!q.empty())
     {
-        std::cout << q.top()->priority << std::endl;
-        q.pop();
+        CityGenerator::Road* road = q.pop();
+        std::cout << road->to.x << ": " << road->priority << std::endl;
+        ok = ok && (road->to.x.value() == expected[i++]);
     }
-    return 0;
+
+    std::cout << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
 }
@@ -0,0 +1,379 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef REGISTRY_HPP
+#  define REGISTRY_HPP
+
+#  include "Common/NonCopyable.hpp"
+#  include <array>
+#  include <cassert>
+#  include <cstdint>
+#  include <limits>
+#  include <memory>
+#  include <new>
+#  include <string>
+#  include <type_traits>
+#  include <unordered_map>
+#  include <utility>
+#  include <vector>
+
+//******************************************************************************
+//! \brief Container of entities (cars, pedestrians ...) referred by generational
+//! handles instead of raw pointers.
+//!   - Entities are constructed in place inside fixed-size slabs which are
+//!     never moved nor released before the registry: spawning and despawning
+//!     entities reuses free slots (no fragmentation, no reallocation) and the
+//!     address of an entity stays valid until it is destroyed.
+//!   - A handle is the index of the slot and its generation. The generation of
+//!     the slot is incremented when its entity is destroyed, so handles on a
+//!     destroyed entity resolve to nullptr instead of dangling. Resolving a
+//!     handle is O(1).
+//!   - Entities are indexed by their unique name in a hash table.
+//!   - Each entity belongs to a group (i.e. ego, traffic, ghost cars). Groups
+//!     are bits, so entities of several groups can be iterated together, in
+//!     the order of slots.
+//******************************************************************************
+template<class T, size_t SLAB = 64u>
+class Registry : public NonCopyable
+{
+public:
+
+    //! \brief Groups used when iterating on all entities.
+    static constexpr uint8_t ALL = std::numeric_limits<uint8_t>::max();
+
+    // *************************************************************************
+    //! \brief Generational reference to an entity. Default handles are never
+    //! valid.
+    // *************************************************************************
+    struct Handle
+    {
+        static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+        uint32_t index = NONE;
+        uint32_t generation = 0u;
+
+        inline bool operator==(Handle const& other) const
+        {
+            return (index == other.index) && (generation == other.generation);
+        }
+
+        inline bool operator!=(Handle const& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+private:
+
+    // *************************************************************************
+    //! \brief Storage of an entity. The entity is the first member, so the slot
+    //! is found from the address of its entity.
+    // *************************************************************************
+    struct Slot
+    {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        uint32_t index;
+        //! \brief Odd when the slot holds an entity.
+        uint32_t generation;
+        uint8_t group;
+
+        inline bool alive() const { return (generation & 1u) != 0u; }
+        inline T& entity() { return *std::launder(reinterpret_cast<T*>(&storage)); }
+        inline T const& entity() const { return *std::launder(reinterpret_cast<T const*>(&storage)); }
+    };
+
+    static_assert(std::is_standard_layout<Slot>::value, "Slot shall be standard layout");
+
+    using Slab = std::array<Slot, SLAB>;
+
+public:
+
+    // *************************************************************************
+    //! \brief Iterator on entities of a group.
+    // *************************************************************************
+    template<class R, class E>
+    class Iterator
+    {
+    public:
+
+        Iterator(R& registry, uint32_t index, uint8_t group)
+            : m_registry(registry), m_index(index), m_group(group)
+        {
+            skip();
+        }
+
+        inline E& operator*() const { return m_registry.slot(m_index).entity(); }
+        inline E* operator->() const { return &m_registry.slot(m_index).entity(); }
+        inline bool operator!=(Iterator const& other) const { return m_index != other.m_index; }
+        inline bool operator==(Iterator const& other) const { return m_index == other.m_index; }
+        inline Iterator& operator++() { ++m_index; skip(); return *this; }
+
+    private:
+
+        void skip()
+        {
+            while ((m_index < m_registry.m_count) && !m_registry.matches(m_index, m_group))
+                ++m_index;
+        }
+
+        R& m_registry;
+        uint32_t m_index;
+        uint8_t m_group;
+    };
+
+    // *************************************************************************
+    //! \brief Iterable entities of a group (for range-based for loops).
+    // *************************************************************************
+    template<class R, class E>
+    class Range
+    {
+    public:
+
+        Range(R& registry, uint8_t group)
+            : m_registry(registry), m_group(group)
+        {}
+
+        inline Iterator<R, E> begin() const { return { m_registry, 0u, m_group }; }
+        inline Iterator<R, E> end() const { return { m_registry, m_registry.m_count, m_group }; }
+
+    private:
+
+        R& m_registry;
+        uint8_t m_group;
+    };
+
+    using Entities = Range<Registry, T>;
+    using ConstEntities = Range<Registry const, T const>;
+
+public:
+
+    Registry() = default;
+
+    ~Registry()
+    {
+        clear();
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Construct in place a new entity.
+    //! \param[in] name: unique name of the entity.
+    //! \param[in] group: group of the entity (a single bit).
+    //! \param[in] args: parameters of the constructor of the entity.
+    //! \return the handle on the entity or an invalid handle if the name is
+    //! already used.
+    //--------------------------------------------------------------------------
+    template<class... Args>
+    Handle create(std::string const& name, uint8_t const group, Args&&... args)
+    {
+        assert((group != 0u) && ((group & (group - 1u)) == 0u));
+        if (m_names.find(name) != m_names.end())
+            return Handle();
+
+        // Reuse the last freed slot, else take the next one, allocating a new
+        // slab when needed.
+        uint32_t index;
+        if (!m_free.empty())
+        {
+            index = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            index = m_count++;
+            if (index / SLAB >= m_slabs.size())
+            {
+                m_slabs.push_back(std::make_unique<Slab>());
+                m_keys.resize(m_slabs.size() * SLAB);
+            }
+        }
+
+        Slot& s = slot(index);
+        new (&s.storage) T(std::forward<Args>(args)...);
+        s.index = index;
+        s.generation = (index < m_generations.size()) ? m_generations[index] + 1u : 1u;
+        s.group = group;
+        if (index >= m_generations.size())
+            m_generations.resize(index + 1u);
+        m_generations[index] = s.generation;
+
+        Handle handle{ index, s.generation };
+        m_keys[index] = name;
+        m_names[name] = handle;
+        ++m_size;
+        return handle;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Destroy the entity referred by the handle. Handles on it become
+    //! invalid.
+    //! \return false if the handle was already invalid.
+    //--------------------------------------------------------------------------
+    bool destroy(Handle const handle)
+    {
+        if (get(handle) == nullptr)
+            return false;
+
+        Slot& s = slot(handle.index);
+        s.entity().~T();
+        m_generations[handle.index] = ++s.generation;
+        m_names.erase(m_keys[handle.index]);
+        m_keys[handle.index].clear();
+        m_free.push_back(handle.index);
+        --m_size;
+        return true;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Destroy all entities. Slabs are kept for next entities.
+    //--------------------------------------------------------------------------
+    void clear()
+    {
+        for (uint32_t i = 0u; i < m_count; ++i)
+        {
+            Slot& s = slot(i);
+            if (s.alive())
+            {
+                destroy(Handle{ i, s.generation });
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the entity referred by the handle or nullptr if it has
+    //! been destroyed. O(1).
+    //--------------------------------------------------------------------------
+    T* get(Handle const handle) const
+    {
+        if ((handle.index >= m_count) ||
+            (m_generations[handle.index] != handle.generation) ||
+            ((handle.generation & 1u) == 0u))
+            return nullptr;
+        return const_cast<T*>(&slot(handle.index).entity());
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the handle on the given entity, which shall be hold by
+    //! this registry. O(1).
+    //--------------------------------------------------------------------------
+    Handle handle(T const& entity) const
+    {
+        Slot const& s = *reinterpret_cast<Slot const*>(&entity);
+        assert(s.alive() && (&slot(s.index).entity() == &entity));
+        return Handle{ s.index, s.generation };
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the handle on the entity of the given name or an invalid
+    //! handle. O(1) in average.
+    //--------------------------------------------------------------------------
+    Handle find(std::string const& name) const
+    {
+        auto it = m_names.find(name);
+        return (it == m_names.end()) ? Handle() : it->second;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the group of the given alive entity.
+    //--------------------------------------------------------------------------
+    uint8_t group(Handle const handle) const
+    {
+        assert(get(handle) != nullptr);
+        return slot(handle.index).group;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Move the alive entity to another group (a single bit). Handles
+    //! on it stay valid.
+    //--------------------------------------------------------------------------
+    void regroup(Handle const handle, uint8_t const group)
+    {
+        assert(get(handle) != nullptr);
+        assert((group != 0u) && ((group & (group - 1u)) == 0u));
+        slot(handle.index).group = group;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return entities of the given groups (bitwise or of groups).
+    //--------------------------------------------------------------------------
+    inline Entities entities(uint8_t const groups = ALL)
+    {
+        return Entities(*this, groups);
+    }
+
+    inline ConstEntities entities(uint8_t const groups = ALL) const
+    {
+        return ConstEntities(*this, groups);
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the number of entities.
+    //--------------------------------------------------------------------------
+    inline size_t size() const
+    {
+        return m_size;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the number of allocated slots.
+    //--------------------------------------------------------------------------
+    inline size_t capacity() const
+    {
+        return m_slabs.size() * SLAB;
+    }
+
+private:
+
+    inline Slot& slot(uint32_t const index)
+    {
+        return (*m_slabs[index / SLAB])[index % SLAB];
+    }
+
+    inline Slot const& slot(uint32_t const index) const
+    {
+        return (*m_slabs[index / SLAB])[index % SLAB];
+    }
+
+    inline bool matches(uint32_t const index, uint8_t const groups) const
+    {
+        Slot const& s = slot(index);
+        return s.alive() && ((s.group & groups) != 0u);
+    }
+
+private:
+
+    //! \brief Fixed-size arrays of slots.
+    std::vector<std::unique_ptr<Slab>> m_slabs;
+    //! \brief Copy of the generation of each used slot (odd: alive), kept
+    //! contiguous for checking handles without touching slabs.
+    std::vector<uint32_t> m_generations;
+    //! \brief Name of the entity of each slot.
+    std::vector<std::string> m_keys;
+    //! \brief Entities indexed by their names.
+    std::unordered_map<std::string, Handle> m_names;
+    //! \brief Freed slots.
+    std::vector<uint32_t> m_free;
+    //! \brief Number of used slots (alive or freed).
+    uint32_t m_count = 0u;
+    //! \brief Number of alive entities.
+    size_t m_size = 0u;
+};
+
+#endif
@@ -19,15 +19,27 @@
 // along with Highway.  If not, see <http://www.gnu.org/licenses/>.
 //=====================================================================
 #include "SpatialHashGrid.hpp"
+#include <algorithm>
 #include <cassert>
 
 //------------------------------------------------------------------------------
 SpatialHashGrid::SpatialHashGrid(sf::Rect<float> const& bounds,
                                  sf::Vector2u const& dimensions)
-    : m_bounds(bounds), m_dimensions(dimensions)
+{
+    resize(bounds, dimensions);
+}
+
+//------------------------------------------------------------------------------
+void SpatialHashGrid::resize(sf::Rect<float> const& bounds,
+                             sf::Vector2u const& dimensions)
 {
     assert(dimensions.x >= 1u);
     assert(dimensions.y >= 1u);
+    assert((bounds.width > 0.0f) && (bounds.height > 0.0f));
+
+    m_bounds = bounds;
+    m_dimensions = dimensions;
+    clear();
     m_cells.resize(dimensions.x * dimensions.y);
 }
 
@@ -35,77 +47,83 @@ SpatialHashGrid::SpatialHashGrid(sf::Rect<float> const& bounds,
 void SpatialHashGrid::clear()
 {
     m_query_ids = 1u;
-    for (auto cell: m_cells)
+    for (auto& cell: m_cells)
     {
         cell.clear();
     }
-    m_cells.clear();
 }
 
 //------------------------------------------------------------------------------
 void SpatialHashGrid::add(Item& item)
 {
-    // query_id is to be sure to insert only once the item
-    size_t query_id = m_query_ids++;
-
     const float x = item.position.x;
     const float y = item.position.y;
-    const float w = item.dimension.x;
-    const float h = item.dimension.y;
+    const float w = item.dimension.x / 2.0f;
+    const float h = item.dimension.y / 2.0f;
 
-    item.spatial_indices[0] = getIndices({(x - w) / 2.0f, (y - h) / 2.0f});
-    item.spatial_indices[1] = getIndices({(x + w) / 2.0f, (y + h) / 2.0f});
+    item.spatial_indices[0] = getIndices({x - w, y - h});
+    item.spatial_indices[1] = getIndices({x + w, y + h});
+    item.query_id = 0u;
 
     const sf::Vector2u i0 = item.spatial_indices[0];
     const sf::Vector2u i1 = item.spatial_indices[1];
-    for (uint32_t xn = i0.x; xn <= i1.x; ++xn)
+    for (uint32_t yn = i0.y; yn <= i1.y; ++yn)
     {
-        for (uint32_t yn = i0.y; yn <= i1.y; ++yn)
+        for (uint32_t xn = i0.x; xn <= i1.x; ++xn)
         {
-            if (item.query_id != query_id)
-            {
-                item.query_id = query_id;
-                m_cells[cell(xn, yn)].push_back(&item);
-            }
+            m_cells[cell(xn, yn)].push_back(&item);
         }
     }
 }
 
 //------------------------------------------------------------------------------
-sf::Vector2u SpatialHashGrid::getIndices(sf::Vector2f position)
+sf::Vector2u SpatialHashGrid::getIndices(sf::Vector2f position) const
 {
     const float x = (position.x - m_bounds.left) / m_bounds.width;
     const float y = (position.y - m_bounds.top) / m_bounds.height;
 
-    // We assume the position is not ouside the grid.
-    assert((x >= 0.0f) && (x <= 1.0f));
-    assert((y >= 0.0f) && (y <= 1.0f));
-
-    const uint32_t xIndex = int(x * float(m_dimensions.x - 1u));
-    const uint32_t yIndex = int(y * float(m_dimensions.y - 1u));
+    // Positions outside the grid are hold by border cells.
+    const float X = std::min(std::max(x * float(m_dimensions.x), 0.0f),
+                             float(m_dimensions.x - 1u));
+    const float Y = std::min(std::max(y * float(m_dimensions.y), 0.0f),
+                             float(m_dimensions.y - 1u));
 
-    return { xIndex, yIndex };
+    return { uint32_t(X), uint32_t(Y) };
 }
 
 //------------------------------------------------------------------------------
 void SpatialHashGrid::findNear(Item& item, std::vector<Item*>& res)
 {
-    const float x = item.position.x;
-    const float y = item.position.y;
-    const float w = item.dimension.x;
-    const float h = item.dimension.y;
+    const sf::Rect<float> area(item.position.x - item.dimension.x / 2.0f,
+                               item.position.y - item.dimension.y / 2.0f,
+                               item.dimension.x, item.dimension.y);
 
-    const sf::Vector2u i0 = getIndices({(x - w) / 2.0f, (y - h) / 2.0f});
-    const sf::Vector2u i1 = getIndices({(x + w) / 2.0f, (y + h) / 2.0f});
+    // Mark the item as already returned.
+    item.query_id = m_query_ids;
+    findNear(area, res);
+}
+
+//------------------------------------------------------------------------------
+void SpatialHashGrid::findNear(sf::Rect<float> const& area, std::vector<Item*>& res)
+{
+    // query_id is to be sure to return only once an item
+    const size_t query_id = m_query_ids++;
+
+    const sf::Vector2u i0 = getIndices({area.left, area.top});
+    const sf::Vector2u i1 = getIndices({area.left + area.width, area.top + area.height});
 
     res.clear();
-    for (uint32_t xn = i0.x; xn <= i1.x; ++xn)
+    for (uint32_t yn = i0.y; yn <= i1.y; ++yn)
     {
-        for (uint32_t yn = i0.y; yn <= i1.y; ++yn)
+        for (uint32_t xn = i0.x; xn <= i1.x; ++xn)
         {
             for (auto& it: m_cells[cell(xn, yn)])
             {
-                res.push_back(it);
+                if (it->query_id != query_id)
+                {
+                    it->query_id = query_id;
+                    res.push_back(it);
+                }
             }
         }
     }
@@ -124,9 +142,9 @@ void SpatialHashGrid::remove(Item& item)
     const sf::Vector2u i0 = item.spatial_indices[0];
     const sf::Vector2u i1 = item.spatial_indices[1];
 
-    for (uint32_t xn = i0.x; xn <= i1.x; ++xn)
+    for (uint32_t yn = i0.y; yn <= i1.y; ++yn)
     {
-        for (uint32_t yn = i0.y; yn <= i1.y; ++yn)
+        for (uint32_t xn = i0.x; xn <= i1.x; ++xn)
         {
             std::vector<Item*>& items = m_cells[cell(xn, yn)];
 
@@ -138,7 +156,7 @@ void SpatialHashGrid::remove(Item& item)
                 {
                     items[i] = items[items.size() - 1u];
                     items.pop_back();
-                    return ;
+                    break ;
                 }
             }
         }
@@ -47,8 +47,10 @@ public:
         sf::Vector2f position;
         //! \brief bounding box of the item.
         sf::Vector2f dimension;
-        //! \brief Unique id of the insertion query to be sure to insert only
-        //! once an item since it can overlaps several cells.
+        //! \brief Index of the item in the container of the caller.
+        size_t id = 0u;
+        //! \brief Unique id of the last query which has returned the item to be
+        //! sure to return it only once since it can overlaps several cells.
         size_t query_id = 0u;
     };
 
@@ -60,30 +62,44 @@ public:
     SpatialHashGrid(sf::Rect<float> const& bounds, sf::Vector2u const& dimensions);
 
     //--------------------------------------------------------------------------
-    //! \brief
+    //! \brief Change the area covered by the grid. Items are removed.
+    //--------------------------------------------------------------------------
+    void resize(sf::Rect<float> const& bounds, sf::Vector2u const& dimensions);
+
+    //--------------------------------------------------------------------------
+    //! \brief Insert the item in all cells overlapped by its bounding box
+    //! (centered on its position). Items outside the grid are clamped to its
+    //! borders.
     //--------------------------------------------------------------------------
     void add(Item& item);
 
     //--------------------------------------------------------------------------
-    //! \brief
+    //! \brief Remove the item from the cells it has been inserted into.
     //--------------------------------------------------------------------------
     void remove(Item& item);
 
     //--------------------------------------------------------------------------
-    //! \brief
+    //! \brief Reinsert the item after it has moved.
     //--------------------------------------------------------------------------
     void update(Item& item);
 
     //--------------------------------------------------------------------------
-    //! \brief
+    //! \brief Remove all items but keep the memory of cells.
     //--------------------------------------------------------------------------
     void clear();
 
     //--------------------------------------------------------------------------
-    //! \brief
+    //! \brief Return the other items inside cells overlapped by the bounding box
+    //! of the given item. Each item is returned once.
     //--------------------------------------------------------------------------
     void findNear(Item& item, std::vector<Item*>& res);
 
+    //--------------------------------------------------------------------------
+    //! \brief Return the items inside cells overlapped by the given area. Each
+    //! item is returned once.
+    //--------------------------------------------------------------------------
+    void findNear(sf::Rect<float> const& area, std::vector<Item*>& res);
+
     //--------------------------------------------------------------------------
     //! \brief
     //--------------------------------------------------------------------------
@@ -111,9 +127,10 @@ private:
     }
 
     //--------------------------------------------------------------------------
-    //! \brief
+    //! \brief Return the cell holding the given world position (clamped to the
+    //! grid borders).
     //--------------------------------------------------------------------------
-    sf::Vector2u getIndices(sf::Vector2f p);
+    sf::Vector2u getIndices(sf::Vector2f p) const;
 
 private:
 
@@ -123,7 +140,7 @@ private:
     sf::Vector2u m_dimensions;
     //! \brief
     std::vector<std::vector<Item*>> m_cells;
-    //! \brief Is to be sure to insert only once an item since it can overlaps
+    //! \brief Is to be sure to return only once an item since it can overlaps
     //! several cells.
     size_t m_query_ids = 1u;
 };
@@ -22,23 +22,20 @@
 #ifndef STATE_MACHINE_HPP
 #  define STATE_MACHINE_HPP
 
-#  include <map>
-#  include <iostream>
+#  include <array>
+#  include <cstddef>
 #  include <cstdio>
 #  include <cassert>
 
-#  if defined(NDEBUG)
-#    define DEBUG(...)
-#  else
-#    define DEBUG printf
-#  endif
-
 //-----------------------------------------------------------------------------
-//! \brief Return the given state as string (shall not be free'ed).
-//! \note implement this method in derived class.
+//! \brief Traces of state machines are compiled only when FSM_TRACE is defined
+//! (i.e. -DFSM_TRACE). By default, they do not cost a single instruction.
 //-----------------------------------------------------------------------------
-template<class STATES_ID>
-const char* stringify(STATES_ID const state);
+#  if defined(FSM_TRACE)
+#    define FSM_DEBUG(...) printf(__VA_ARGS__)
+#  else
+#    define FSM_DEBUG(...)
+#  endif
 
 // *****************************************************************************
 //! \brief Base class of the structure depicting small Finite State Machine
@@ -46,14 +43,6 @@ const char* stringify(STATES_ID const state);
 //! state machine (HSM). See this document for more information about FSM:
 //! http://niedercorn.free.fr/iris/iris1/uml/uml09.pdf
 //!
-//! This class holds the list of states \c State and the current active state.
-//! Each of state holds  actions to perform, as function pointers (such as
-//! 'on entering', 'on leaving' ...). This class does not hold directly tables
-//! for transitioning origin state to destination state when an external event
-//! occured. Instead each external event shall be implemented as member function
-//! in the derived FSM class and in each member function shall implement this
-//! table. This is a compromise to minimize the number of virtual methods.
-//!
 //! Example: the following state machine, in plantuml syntax:
 //! @startuml
 //! [*] --> Idle
@@ -68,49 +57,71 @@ const char* stringify(STATES_ID const state);
 //! A FSM can be depicted by a graph (nodes: states; arcs: transitions) which can
 //! be represented by table:
 //!
-//! +-----------------+------------+-----------+-----------+
-//! | States \\ Event | Set Speed  | Halt      | --        |
-//! +=================+============+===========+===========+
-//! | IDLE            | STARTING   |           |           |
-//! +-----------------+------------+-----------+-----------+
-//! | STOPPING        |            |           | IDLE      |
-//! +-----------------+------------+-----------+-----------+
-//! | STARTING        | SPINNING   | STOPPING  |           |
-//! +-----------------+------------+-----------+-----------+
-//! | SPINNING        | SPINNING   | STOPPING  |           |
-//! +-----------------+------------+-----------+-----------+
+//! +-----------------+------------+-----------+
+//! | States \\ Event | Set Speed  | Halt      |
+//! +=================+============+===========+
+//! | IDLE            | STARTING   |           |
+//! +-----------------+------------+-----------+
+//! | STOPPING        | FORBIDDEN  |           |
+//! +-----------------+------------+-----------+
+//! | STARTING        | SPINNING   | STOPPING  |
+//! +-----------------+------------+-----------+
+//! | SPINNING        | SPINNING   | STOPPING  |
+//! +-----------------+------------+-----------+
 //!
 //! The first column contains all states. The first line contains all events.
-//! Each column depict a transition: given the current state (i.e. IDLE) and a
-//! given event (i.e. Set Speed) the next state of the state machine will be
-//! STARTING. Empty cells are forbiddent transitions. Usually the table is
-//! sparse.
+//! Given the current state (i.e. IDLE) and a given event (i.e. Set Speed) the
+//! next state of the state machine will be STARTING. Empty cells are ignored
+//! events, FORBIDDEN cells are events that shall never happen.
 //!
-//! \tparam FSM the concrete Finite State Machine deriving from this base class.
-//! \tparam STATES_ID enumerate for giving an unique identifier for each state.
+//! The derived class \c FSM shall define, as constexpr static members (and make
+//! this class friend if they are private):
+//!   - \c transitions: the table above, of type \c Transitions, indexed by
+//!     [state][event]. Reacting to an event is a single indexed load.
+//!   - \c states: the actions of each state, of type \c States, as member
+//!     function pointers bound at compile time (guard, on entering, on leaving,
+//!     during).
+//!   - \c names: the name of each state, of type \c Names, for traces.
 //!
-//! In this class, states are enums \c STATES_ID like: enum StatesID
-//! { IDLE = 0, STOPPING, STARTING, SPINNING, MAX_STATES }; and the table of
-//! states \c m_states shall be filled with these enums and pointer functions
-//! such as 'on entering' set. Each event (i.e. Set Speed) shall be a method
-//! having a static table of state transition.
+//! \tparam FSM the concrete Finite State Machine deriving from this base class.
+//! \tparam STATES_ID enumerate giving an unique identifier for each state. It
+//! shall end with MAX_STATES followed by IGNORING_EVENT and CANNOT_HAPPEN, i.e.
+//! enum States { IDLE, STOPPING, STARTING, SPINNING, MAX_STATES, IGNORING_EVENT,
+//! CANNOT_HAPPEN };
+//! \tparam EVENTS_ID enumerate giving an unique identifier for each event. It
+//! shall end with MAX_EVENTS followed by NO_EVENT, i.e. enum Events { SET_SPEED,
+//! HALT, MAX_EVENTS, NO_EVENT };
+//! \tparam ARGS the type of parameters given to the "during" actions (i.e. the
+//! delta time).
 //!
-//! This class is fine for small Finite State Machine (FSM) and is limited due
-//! to memory footprint (therefore no complex C++ designs, no dynamic containers
-//! and few virtual methods). The code is based on the following link
-//! https://www.codeproject.com/Articles/1087619/State-Machine-Design-in-Cplusplus-2
-//! For bigger state machines, please use something more robust such as Esterel
-//! SyncCharts.
+//! This class is fine for small Finite State Machine (FSM): no dynamic memory,
+//! no virtual methods. For bigger state machines, please use something more
+//! robust such as Esterel SyncCharts.
 // *****************************************************************************
-template<typename FSM, class STATES_ID>
+template<typename FSM, class STATES_ID, class EVENTS_ID, typename... ARGS>
 class StateMachine
 {
 public:
 
+    static_assert(STATES_ID::IGNORING_EVENT > STATES_ID::MAX_STATES,
+                  "IGNORING_EVENT shall be placed after MAX_STATES");
+    static_assert(STATES_ID::CANNOT_HAPPEN > STATES_ID::MAX_STATES,
+                  "CANNOT_HAPPEN shall be placed after MAX_STATES");
+    static_assert(EVENTS_ID::NO_EVENT > EVENTS_ID::MAX_EVENTS,
+                  "NO_EVENT shall be placed after MAX_EVENTS");
+
+    //! \brief Number of states.
+    static constexpr size_t MAX_STATES = static_cast<size_t>(STATES_ID::MAX_STATES);
+    //! \brief Number of events.
+    static constexpr size_t MAX_EVENTS = static_cast<size_t>(EVENTS_ID::MAX_EVENTS);
+
     //! \brief Pointer function with no argument and returning a boolean.
     using bFuncPtr = bool (FSM::*)();
     //! \brief Pointer function with no argument and returning void.
     using xFuncPtr = void (FSM::*)();
+    //! \brief Pointer function doing the activity of a state and returning the
+    //! event to react to (or NO_EVENT).
+    using eFuncPtr = EVENTS_ID (FSM::*)(ARGS...);
 
     //--------------------------------------------------------------------------
     //! \brief Class depicting a state of the state machine and hold pointer
@@ -118,43 +129,63 @@ public:
     //--------------------------------------------------------------------------
     struct State
     {
-        //! \brief Call the guard fonction validating the event if return true
-        //! or set to nullptr. It invalidate the event if return false.
+        //! \brief Call the guard fonction validating the transition to this
+        //! state if return true or set to nullptr. It refuses the transition if
+        //! return false.
         bFuncPtr guard = nullptr;
-        //! \brief Call the "on entry" fonction when entering for the first time
-        //! (AND ONLY WHEN ONCE) in the state. Note: the guard prevent this
-        //! function.
+        //! \brief Call the "on entry" fonction when entering in the state from
+        //! another state. Note: the guard prevent this function.
         xFuncPtr entering = nullptr;
-        //! \brief Call the "on leaving" fonction when leavinging for the first
-        //! time (AND ONLY WHEN ONCE) the state. Note: the guard prevent this
+        //! \brief Call the "on leaving" fonction when leaving the state for
+        //! another state. Note: the guard of the next state prevent this
         //! function.
         xFuncPtr leaving = nullptr;
-        //! \brief Call the "on event" fonction when the event occured. Note:
-        //! the guard prevent this function. Entry and leaving actions are not
-        //! made if this function is not nullptr and return true.
-        xFuncPtr onevent = nullptr;
+        //! \brief Call the "during" fonction each time update() is called
+        //! while this state is active. The returned event is reacted to.
+        eFuncPtr during = nullptr;
     };
 
-    //! \brief Define the type of container holding all stated of the state
+    //! \brief Define the type of container holding all states of the state
     //! machine.
-    using States = std::array<State, STATES_ID::MAX_STATES>;
-    //! \brief Define the type of container holding states transitions. Since
-    //! a state machine is generally a sparse matrix we use red-back tree.
-    using Transitions = std::map<STATES_ID, STATES_ID>;
+    using States = std::array<State, MAX_STATES>;
+    //! \brief Define the type of the table of transitions: destination state
+    //! indexed by [origin state][event].
+    using Transitions = std::array<std::array<STATES_ID, MAX_EVENTS>, MAX_STATES>;
+    //! \brief Define the type of the table holding the name of states.
+    using Names = std::array<const char*, MAX_STATES>;
 
     //--------------------------------------------------------------------------
-    //! \brief Default constructor. Pass the number of states the FSM will use,
-    //! set the initial state and if mutex shall have to be used.
+    //! \brief Default constructor.
     //! \param[in] initial the initial state to start with.
     //--------------------------------------------------------------------------
-    StateMachine(STATES_ID const initial) // FIXME should be ok for constexpr
+    constexpr StateMachine(STATES_ID const initial)
         : m_current_state(initial), m_initial_state(initial)
+    {}
+
+    //--------------------------------------------------------------------------
+    //! \brief Check at compile time that a table of transitions only contains
+    //! states or IGNORING_EVENT or CANNOT_HAPPEN. Usage:
+    //! static_assert(Base::check(FSM::transitions), "Bad table");
+    //--------------------------------------------------------------------------
+    static constexpr bool check(Transitions const& table)
     {
-        assert(initial < STATES_ID::MAX_STATES); // FIXME static_assert not working
+        for (size_t s = 0u; s < MAX_STATES; ++s)
+        {
+            for (size_t e = 0u; e < MAX_EVENTS; ++e)
+            {
+                STATES_ID const d = table[s][e];
+                if ((d >= STATES_ID::MAX_STATES) &&
+                    (d != STATES_ID::IGNORING_EVENT) &&
+                    (d != STATES_ID::CANNOT_HAPPEN))
+                    return false;
+            }
+        }
+        return true;
     }
 
     //--------------------------------------------------------------------------
-    //! \brief Restore the state machin to its initial state.
+    //! \brief Restore the state machine to its initial state. No action is
+    //! called.
     //--------------------------------------------------------------------------
     inline void reset()
     {
@@ -176,43 +207,69 @@ public:
     //--------------------------------------------------------------------------
     inline const char* c_str() const
     {
-        return stringify(m_current_state);
+        return name(m_current_state);
     }
 
     //--------------------------------------------------------------------------
-    //! \brief Internal transition: jump to the desired state from internal event.
-    //! This will call the guard, leaving actions, entering actions ...
-    //! \param[in] new_state the destination state.
+    //! \brief Return the given state as string (shall not be free'ed).
+    //--------------------------------------------------------------------------
+    static constexpr const char* name(STATES_ID const state)
+    {
+        return (state < STATES_ID::MAX_STATES)
+            ? FSM::names[static_cast<size_t>(state)] : "???";
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Call the "during" action of the current state and react to the
+    //! returned event.
+    //! \return false if the returned event was forbidden or refused by a guard.
     //--------------------------------------------------------------------------
-    void transition(STATES_ID const new_state);
+    bool update(ARGS... args)
+    {
+        eFuncPtr const during = FSM::states[index(m_current_state)].during;
+        if (during == nullptr)
+            return true;
 
-protected:
+        EVENTS_ID const event = (static_cast<FSM*>(this)->*during)(args...);
+        return (event == EVENTS_ID::NO_EVENT) ? true : react(event);
+    }
 
     //--------------------------------------------------------------------------
-    //! \brief From current state, jump to the destination state from external
-    //! event.
-    //! \param[in] transitions the table of transitions.
+    //! \brief External event: jump to the state given by the table of
+    //! transitions. This will call the guard, leaving actions, entering
+    //! actions ...
+    //! \return false if the event was forbidden or refused by a guard.
     //--------------------------------------------------------------------------
-    void transition(Transitions const& transitions)
+    bool react(EVENTS_ID const event)
     {
-        auto const& it = transitions.find(m_current_state);
-        transition(it != transitions.end() ? it->second : STATES_ID::IGNORING_EVENT);
+        assert(event < EVENTS_ID::MAX_EVENTS);
+        FSM_DEBUG("[STATE MACHINE] Reacting to event %zu from state %s\n",
+                  static_cast<size_t>(event), c_str());
+        return transition(FSM::transitions[index(m_current_state)]
+                          [static_cast<size_t>(event)]);
     }
 
-protected:
+    //--------------------------------------------------------------------------
+    //! \brief Internal transition: jump to the desired state from internal event.
+    //! This will call the guard, leaving actions, entering actions ...
+    //! \param[in] new_state the destination state.
+    //! \return false if the transition was forbidden or refused by a guard.
+    //--------------------------------------------------------------------------
+    bool transition(STATES_ID const new_state);
 
-    //! \brief Container of states.
-    States m_states;
+private:
 
-    //! \brief Current active state.
-    STATES_ID m_current_state;
+    static constexpr size_t index(STATES_ID const state)
+    {
+        return static_cast<size_t>(state);
+    }
 
 private:
 
+    //! \brief Current active state.
+    STATES_ID m_current_state;
     //! \brief Save the initial state need for restoring initial state.
     STATES_ID m_initial_state;
-    //! \brief Temporary variable saving the next state.
-    STATES_ID m_next_state;
     //! \brief Temporary variable saving the nesting state (needed for internal
     //! event).
     STATES_ID m_nesting_state = STATES_ID::CANNOT_HAPPEN;
@@ -221,19 +278,9 @@ private:
 };
 
 //------------------------------------------------------------------------------
-template<class FSM, class STATES_ID> // FIXME use new version
-void StateMachine<FSM, STATES_ID>::transition(STATES_ID const new_state) // FIXME std::any
+template<typename FSM, class STATES_ID, class EVENTS_ID, typename... ARGS>
+bool StateMachine<FSM, STATES_ID, EVENTS_ID, ARGS...>::transition(STATES_ID const new_state)
 {
-    DEBUG("[STATE MACHINE] Reacting to event from state %s\n",
-          stringify(m_current_state));
-
-#if defined(THREAD_SAFETY)
-    // If try_lock failed it is not important: it just means that we have called
-    // an internal event from this method and internal states are still
-    // protected.
-    m_mutex.try_lock();
-#endif
-
     m_nesting_state = new_state;
 
     // Reaction from internal event (therefore coming from this method called by
@@ -241,114 +288,73 @@ void StateMachine<FSM, STATES_ID>::transition(STATES_ID const new_state) // FIXM
     // continue thank to the while loop. This avoids recursion.
     if (m_nesting)
     {
-        DEBUG("[STATE MACHINE] Internal event. Memorize state %s\n",
-              stringify(new_state));
-        return ;
+        FSM_DEBUG("[STATE MACHINE] Internal event. Memorize state %s\n",
+                  name(new_state));
+        return true;
     }
 
     do
     {
-        m_next_state = m_nesting_state;
+        STATES_ID const next_state = m_nesting_state;
         m_nesting_state = STATES_ID::CANNOT_HAPPEN;
 
-        // Forbidden event: kill the system
-        if (m_next_state == STATES_ID::CANNOT_HAPPEN)
-        {
-            std::cerr << "[STATE MACHINE] Forbidden event. Aborting!"
-                      << std::endl;
-            exit(EXIT_FAILURE);
-        }
-
         // Do not react to this event
-        else if (m_next_state == STATES_ID::IGNORING_EVENT)
+        if (next_state == STATES_ID::IGNORING_EVENT)
         {
-            DEBUG("[STATE MACHINE] Ignoring external event\n");
-            return ;
+            FSM_DEBUG("[STATE MACHINE] Ignoring external event\n");
+            return true;
         }
 
-        // Unknown state: kill the system
-        else if (m_next_state >= STATES_ID::MAX_STATES)
+        // Forbidden event or unknown state: stay in the current state and let
+        // the caller decide what to do.
+        if (next_state >= STATES_ID::MAX_STATES)
         {
-            std::cerr << "[STATE MACHINE] Unknown state. Aborting!"
-                      << std::endl;
-            exit(EXIT_FAILURE);
+            FSM_DEBUG("[STATE MACHINE] Forbidden event from state %s\n",
+                      c_str());
+            return false;
         }
 
-        // Transition to new new state. Local variable mandatory since state
-        // reactions can modify current state (side effect).
-        STATES_ID current_state = m_current_state;
-        m_current_state = m_next_state;
-
-        // Reaction: call the member function associated to the current state
-        StateMachine<FSM, STATES_ID>::State const& nst = m_states[m_next_state];
-        StateMachine<FSM, STATES_ID>::State const& cst = m_states[current_state];
+        State const& nst = FSM::states[index(next_state)];
+        State const& cst = FSM::states[index(m_current_state)];
+        FSM* fsm = static_cast<FSM*>(this);
 
         // Call the guard
         m_nesting = true;
-        bool guard_res = (nst.guard == nullptr);
-        if (!guard_res)
-        {
-            guard_res = (reinterpret_cast<FSM*>(this)->*nst.guard)();
-        }
-
-        if (!guard_res)
+        if ((nst.guard != nullptr) && !(fsm->*nst.guard)())
         {
-            DEBUG("[STATE MACHINE] Transition refused by the %s guard. Stay"
-                  " in state %s\n", stringify(new_state), stringify(current_state));
-            m_current_state = current_state;
+            FSM_DEBUG("[STATE MACHINE] Transition refused by the %s guard. Stay"
+                      " in state %s\n", name(next_state), c_str());
             m_nesting = false;
-            return ;
+            return false;
         }
-        else
+
+        // Transition to new new state. Local variable mandatory since state
+        // reactions can modify current state (side effect).
+        STATES_ID const current_state = m_current_state;
+        m_current_state = next_state;
+
+        if (current_state != next_state)
         {
-            // The guard allowed the transition to the next state
-            DEBUG("[STATE MACHINE] Transitioning to new state %s\n",
-                  stringify(new_state));
+            FSM_DEBUG("[STATE MACHINE] Transitioning from state %s to state %s\n",
+                      name(current_state), name(next_state));
 
-            // Entry and leaving actions are not made if the event specified by
-            // the "on event" clause happened.
-            if (cst.onevent != nullptr)
+            // Do reactions when leaving the current state
+            if (cst.leaving != nullptr)
             {
-                DEBUG("[STATE MACHINE] Do the state %s 'on event' action\n",
-                      stringify(current_state));
-                (reinterpret_cast<FSM*>(this)->*cst.onevent)();
-                return ;
+                (fsm->*cst.leaving)();
             }
 
-            // Transitioning to a new state ?
-            else if (current_state != m_next_state)
-            {
-                if (cst.leaving != nullptr)
-                {
-                    DEBUG("[STATE MACHINE] Do the state %s 'on leaving' action\n",
-                          stringify(current_state));
-
-                    // Do reactions when leaving the current state
-                    (reinterpret_cast<FSM*>(this)->*cst.leaving)();
-                }
-
-                if (nst.entering != nullptr)
-                {
-                    DEBUG("[STATE MACHINE] Do the state %s 'on entry' action\n",
-                          stringify(new_state));
-
-                    // Do reactions when entring into the new state
-                    (reinterpret_cast<FSM*>(this)->*nst.entering)();
-                }
-            }
-            else
+            // Do reactions when entring into the new state
+            if (nst.entering != nullptr)
             {
-                DEBUG("[STATE MACHINE] Was previously in this mode: no "
-                      "actions to perform\n");
+                (fsm->*nst.entering)();
             }
         }
         m_nesting = false;
     }
     while (m_nesting_state != STATES_ID::CANNOT_HAPPEN);
 
-#if defined(THREAD_SAFETY)
-    m_mutex.unlock();
-#endif
+    return true;
 }
 
 #endif // STATE_MACHINE_HPP
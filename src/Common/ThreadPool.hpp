@@ -0,0 +1,150 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef THREAD_POOL_HPP
+#  define THREAD_POOL_HPP
+
+#  include "Common/NonCopyable.hpp"
+#  include <condition_variable>
+#  include <functional>
+#  include <future>
+#  include <mutex>
+#  include <queue>
+#  include <thread>
+#  include <vector>
+
+//******************************************************************************
+//! \brief Fixed-size pool of worker threads consuming a FIFO of jobs. Used for
+//! running expensive computations (i.e. trajectory planning) outside the
+//! simulation thread. Submitted jobs return a std::future. Contrary to
+//! std::async, destroying a future does not block the caller until the job
+//! has been completed.
+//******************************************************************************
+class ThreadPool : public NonCopyable
+{
+public:
+
+    //--------------------------------------------------------------------------
+    //! \brief Start the given number of worker threads.
+    //! \param[in] workers: number of threads. If 0 use the number of CPU cores
+    //! minus one for the simulation thread (at least one worker).
+    //--------------------------------------------------------------------------
+    explicit ThreadPool(size_t workers = 0u)
+    {
+        if (workers == 0u)
+        {
+            const size_t cores = std::thread::hardware_concurrency();
+            workers = (cores > 1u) ? cores - 1u : 1u;
+        }
+
+        m_workers.reserve(workers);
+        for (size_t i = 0u; i < workers; ++i)
+        {
+            m_workers.emplace_back([this]() { run(); });
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Wait for the end of the running jobs and stop threads. Jobs not
+    //! yet started are dropped (their futures will throw broken_promise).
+    //--------------------------------------------------------------------------
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+            std::queue<std::function<void()>>().swap(m_jobs);
+        }
+        m_condition.notify_all();
+        for (auto& worker: m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Push a job in the queue.
+    //! \param[in] function: the job to execute by one of the worker threads.
+    //! \return the future holding the result of the job.
+    //--------------------------------------------------------------------------
+    template<class Function>
+    auto submit(Function&& function) -> std::future<decltype(function())>
+    {
+        using Result = decltype(function());
+
+        auto task = std::make_shared<std::packaged_task<Result()>>(
+            std::forward<Function>(function));
+        std::future<Result> future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.emplace([task]() { (*task)(); });
+        }
+        m_condition.notify_one();
+        return future;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the number of worker threads.
+    //--------------------------------------------------------------------------
+    inline size_t size() const
+    {
+        return m_workers.size();
+    }
+
+private:
+
+    //--------------------------------------------------------------------------
+    //! \brief Worker thread: consume jobs until the pool is destroyed.
+    //--------------------------------------------------------------------------
+    void run()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_condition.wait(lock, [this]() {
+                    return m_stopping || !m_jobs.empty();
+                });
+                if (m_stopping)
+                    return ;
+                job = std::move(m_jobs.front());
+                m_jobs.pop();
+            }
+            job();
+        }
+    }
+
+private:
+
+    //! \brief Worker threads.
+    std::vector<std::thread> m_workers;
+    //! \brief Pending jobs.
+    std::queue<std::function<void()>> m_jobs;
+    //! \brief Protect the queue of jobs.
+    std::mutex m_mutex;
+    //! \brief Wake up workers when a job is pushed or when stopping.
+    std::condition_variable m_condition;
+    //! \brief Set when the pool is destroyed.
+    bool m_stopping = false;
+};
+
+#endif
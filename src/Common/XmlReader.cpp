@@ -0,0 +1,342 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "Common/XmlReader.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+//------------------------------------------------------------------------------
+const char* XmlReader::Attributes::get(const char* name) const
+{
+    for (size_t i = 0u; i < m_size; ++i)
+    {
+        if (m_entries[i].first == name)
+            return m_entries[i].second.c_str();
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+double XmlReader::Attributes::number(const char* name, double const otherwise) const
+{
+    const char* value = get(name);
+    if (value == nullptr)
+        return otherwise;
+
+    char* end;
+    double const result = std::strtod(value, &end);
+    return (end == value) ? otherwise : result;
+}
+
+//------------------------------------------------------------------------------
+//! \brief Append the UTF-8 encoding of the code point.
+//------------------------------------------------------------------------------
+static void utf8(std::string& s, unsigned long const c)
+{
+    if (c < 0x80u)
+    {
+        s += char(c);
+    }
+    else if (c < 0x800u)
+    {
+        s += char(0xC0u | (c >> 6));
+        s += char(0x80u | (c & 0x3Fu));
+    }
+    else if (c < 0x10000u)
+    {
+        s += char(0xE0u | (c >> 12));
+        s += char(0x80u | ((c >> 6) & 0x3Fu));
+        s += char(0x80u | (c & 0x3Fu));
+    }
+    else
+    {
+        s += char(0xF0u | (c >> 18));
+        s += char(0x80u | ((c >> 12) & 0x3Fu));
+        s += char(0x80u | ((c >> 6) & 0x3Fu));
+        s += char(0x80u | (c & 0x3Fu));
+    }
+}
+
+//------------------------------------------------------------------------------
+//! \brief Replace character entities of the attribute value.
+//------------------------------------------------------------------------------
+static void unescape(std::string& value)
+{
+    size_t amp = value.find('&');
+    if (amp == std::string::npos)
+        return ;
+
+    std::string result(value, 0u, amp);
+    while (amp < value.size())
+    {
+        size_t const semicolon = value.find(';', amp);
+        if ((value[amp] != '&') || (semicolon == std::string::npos))
+        {
+            result += value[amp++];
+            continue ;
+        }
+
+        std::string const entity(value, amp + 1u, semicolon - amp - 1u);
+        if (entity == "amp") result += '&';
+        else if (entity == "lt") result += '<';
+        else if (entity == "gt") result += '>';
+        else if (entity == "quot") result += '"';
+        else if (entity == "apos") result += '\'';
+        else if ((entity.size() > 1u) && (entity[0] == '#'))
+        {
+            bool const hexa = (entity[1] == 'x') || (entity[1] == 'X');
+            utf8(result, std::strtoul(entity.c_str() + (hexa ? 2 : 1), nullptr, hexa ? 16 : 10));
+        }
+        else
+        {
+            // Unknown entity: kept as is.
+            result.append(value, amp, semicolon - amp + 1u);
+        }
+        amp = semicolon + 1u;
+    }
+    value.swap(result);
+}
+
+//------------------------------------------------------------------------------
+static inline bool isSpace(int const c)
+{
+    return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r');
+}
+
+//------------------------------------------------------------------------------
+bool XmlReader::parse(std::string const& path, Listener& listener)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        m_error = "Cannot open '" + path + "'";
+        return false;
+    }
+    return parse(file, listener);
+}
+
+//------------------------------------------------------------------------------
+bool XmlReader::parse(std::istream& stream, Listener& listener)
+{
+    m_stream = &stream;
+    m_buffer.resize(CHUNK);
+    m_position = m_length = 0u;
+    m_line = 1u;
+    m_opened.clear();
+    m_error.clear();
+
+    int c;
+    while ((c = next()) != EOF)
+    {
+        if ((c == '<') && !tag(listener))
+            return false;
+    }
+
+    if (!m_opened.empty())
+        return fail(("Unclosed element '" + m_opened.back() + "'").c_str());
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool XmlReader::fill()
+{
+    if (!m_stream->read(m_buffer.data(), std::streamsize(m_buffer.size())) &&
+        (m_stream->gcount() == 0))
+        return false;
+
+    m_length = size_t(m_stream->gcount());
+    m_position = 0u;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool XmlReader::skip(const char* terminator)
+{
+    size_t const length = std::strlen(terminator);
+    size_t matched = 0u;
+    int c;
+    while ((c = next()) != EOF)
+    {
+        // On mismatch, fall back to the longest prefix of the terminator that
+        // ends the characters read so far (i.e. "]]]>" or "??>").
+        while ((matched > 0u) && (c != terminator[matched]))
+        {
+            size_t shift = 1u;
+            while ((shift < matched) &&
+                   (std::strncmp(terminator, terminator + shift, matched - shift) != 0))
+            {
+                ++shift;
+            }
+            matched -= shift;
+        }
+
+        if ((c == terminator[matched]) && (++matched == length))
+            return true;
+    }
+    return fail("Unexpected end of document");
+}
+
+//------------------------------------------------------------------------------
+bool XmlReader::tag(Listener& listener)
+{
+    int c = next();
+    if (c == '?')
+        return skip("?>");
+
+    if (c == '!')
+    {
+        // Comment, CDATA or DTD. DTD internal subsets [...] may hold '>' and
+        // short declarations (i.e. "<!X>") may end before the prefix is read.
+        m_content.clear();
+        int depth = 0;
+        while ((m_content.size() < 7u) && ((c = next()) != EOF))
+        {
+            if (c == '[') ++depth;
+            else if (c == ']') --depth;
+            else if ((c == '>') && (depth <= 0)) return true;
+            m_content += char(c);
+            if (m_content == "--")
+                return skip("-->");
+            if (m_content == "[CDATA[")
+                return skip("]]>");
+        }
+
+        // The document may be truncated anywhere: stop on its end.
+        while ((c != EOF) && ((c = next()) != EOF))
+        {
+            if (c == '[') ++depth;
+            else if (c == ']') --depth;
+            else if ((c == '>') && (depth <= 0)) return true;
+        }
+        return fail("Unexpected end of document");
+    }
+
+    // Read the tag until '>' outside of quoted attribute values.
+    m_content.clear();
+    char quote = 0;
+    while (true)
+    {
+        if (c == EOF)
+            return fail("Unexpected end of document");
+        if (quote != 0)
+        {
+            if (c == quote)
+                quote = 0;
+        }
+        else if ((c == '"') || (c == '\''))
+        {
+            quote = char(c);
+        }
+        else if (c == '>')
+        {
+            break;
+        }
+        m_content += char(c);
+        c = next();
+    }
+
+    // End tag.
+    if (!m_content.empty() && (m_content[0] == '/'))
+    {
+        size_t end = m_content.size();
+        while ((end > 1u) && isSpace(m_content[end - 1u]))
+            --end;
+        m_name.assign(m_content, 1u, end - 1u);
+        if (m_opened.empty() || (m_opened.back() != m_name))
+            return fail(("Unexpected end of element '" + m_name + "'").c_str());
+        m_opened.pop_back();
+        listener.onEnd(m_name);
+        return true;
+    }
+
+    // Start tag or empty element.
+    bool const empty = !m_content.empty() && (m_content.back() == '/');
+    if (!attributes(m_content, empty ? m_content.size() - 1u : m_content.size()))
+        return false;
+
+    listener.onStart(m_name, m_attributes);
+    if (empty)
+    {
+        listener.onEnd(m_name);
+    }
+    else
+    {
+        m_opened.push_back(m_name);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool XmlReader::attributes(std::string const& content, size_t const end)
+{
+    size_t i = 0u;
+    while ((i < end) && !isSpace(content[i]))
+        ++i;
+    if (i == 0u)
+        return fail("Missing element name");
+    m_name.assign(content, 0u, i);
+
+    m_attributes.m_size = 0u;
+    while (true)
+    {
+        while ((i < end) && isSpace(content[i]))
+            ++i;
+        if (i == end)
+            return true;
+
+        // name = "value"
+        size_t const name = i;
+        while ((i < end) && (content[i] != '=') && !isSpace(content[i]))
+            ++i;
+        size_t const name_end = i;
+        while ((i < end) && isSpace(content[i]))
+            ++i;
+        if ((i == end) || (content[i] != '='))
+            return fail("Missing '=' after attribute name");
+        ++i;
+        while ((i < end) && isSpace(content[i]))
+            ++i;
+        if ((i == end) || ((content[i] != '"') && (content[i] != '\'')))
+            return fail("Missing quote of attribute value");
+        char const quote = content[i++];
+        size_t const value = i;
+        while ((i < end) && (content[i] != quote))
+            ++i;
+        if (i == end)
+            return fail("Missing end quote of attribute value");
+
+        if (m_attributes.m_size == m_attributes.m_entries.size())
+            m_attributes.m_entries.emplace_back();
+        auto& entry = m_attributes.m_entries[m_attributes.m_size++];
+        entry.first.assign(content, name, name_end - name);
+        entry.second.assign(content, value, i - value);
+        unescape(entry.second);
+        ++i;
+    }
+}
+
+//------------------------------------------------------------------------------
+bool XmlReader::fail(const char* reason)
+{
+    m_error = std::string(reason) + " at line " + std::to_string(m_line);
+    return false;
+}
@@ -0,0 +1,175 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef XML_READER_HPP
+#  define XML_READER_HPP
+
+#  include <cstdio>
+#  include <istream>
+#  include <string>
+#  include <vector>
+#  include <utility>
+
+// *****************************************************************************
+//! \brief Streaming (SAX-style) XML reader: the document is read by chunks and
+//! the listener is notified of each start and end of element, so the memory
+//! does not depend on the size of the document. Only elements and their
+//! attributes are reported: text, comments, processing instructions, CDATA
+//! and DTD are skipped. Attribute values are unescaped (predefined and numeric
+//! character entities). Namespaces and encodings other than UTF-8 are not
+//! managed.
+// *****************************************************************************
+class XmlReader
+{
+public:
+
+    // *************************************************************************
+    //! \brief Attributes of an element.
+    // *************************************************************************
+    class Attributes
+    {
+        friend class XmlReader;
+
+    public:
+
+        //----------------------------------------------------------------------
+        //! \brief Return the value of the attribute or nullptr if missing.
+        //----------------------------------------------------------------------
+        const char* get(const char* name) const;
+
+        //----------------------------------------------------------------------
+        //! \brief Return the value of the attribute converted to a number or
+        //! the default value if missing or not a number.
+        //----------------------------------------------------------------------
+        double number(const char* name, double const otherwise = 0.0) const;
+
+    private:
+
+        //! \brief Pairs of name and value. Entries beyond m_size are kept to
+        //! reuse their memory.
+        std::vector<std::pair<std::string, std::string>> m_entries;
+        size_t m_size = 0u;
+    };
+
+    // *************************************************************************
+    //! \brief Receive the elements of the document.
+    // *************************************************************************
+    class Listener
+    {
+    public:
+
+        virtual ~Listener() = default;
+
+        //----------------------------------------------------------------------
+        //! \brief Start of an element (also called for empty elements <a/>).
+        //----------------------------------------------------------------------
+        virtual void onStart(std::string const& name, Attributes const& attributes) = 0;
+
+        //----------------------------------------------------------------------
+        //! \brief End of an element (also called for empty elements <a/>).
+        //----------------------------------------------------------------------
+        virtual void onEnd(std::string const& name) = 0;
+    };
+
+public:
+
+    //--------------------------------------------------------------------------
+    //! \brief Read the whole document and notify the listener.
+    //! \return false if the document is not well formed (see error()).
+    //--------------------------------------------------------------------------
+    bool parse(std::istream& stream, Listener& listener);
+
+    //--------------------------------------------------------------------------
+    //! \brief Read the whole file and notify the listener.
+    //! \return false if the file cannot be read or is not well formed.
+    //--------------------------------------------------------------------------
+    bool parse(std::string const& path, Listener& listener);
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the reason of the last failure.
+    //--------------------------------------------------------------------------
+    inline std::string const& error() const
+    {
+        return m_error;
+    }
+
+private:
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the next character or EOF.
+    //--------------------------------------------------------------------------
+    inline int next()
+    {
+        if ((m_position == m_length) && !fill())
+            return EOF;
+        char const c = m_buffer[m_position++];
+        if (c == '\n')
+            ++m_line;
+        return static_cast<unsigned char>(c);
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Read the next chunk of the document.
+    //--------------------------------------------------------------------------
+    bool fill();
+
+    //--------------------------------------------------------------------------
+    //! \brief Skip characters until the given terminator (included).
+    //--------------------------------------------------------------------------
+    bool skip(const char* terminator);
+
+    //--------------------------------------------------------------------------
+    //! \brief Read a tag after its '<' and notify the listener.
+    //--------------------------------------------------------------------------
+    bool tag(Listener& listener);
+
+    //--------------------------------------------------------------------------
+    //! \brief Split the content of a start tag into its name and attributes.
+    //--------------------------------------------------------------------------
+    bool attributes(std::string const& content, size_t const end);
+
+    //--------------------------------------------------------------------------
+    //! \brief Memorize the reason of the failure.
+    //--------------------------------------------------------------------------
+    bool fail(const char* reason);
+
+private:
+
+    //! \brief Size of chunks read from the stream [byte].
+    static constexpr size_t CHUNK = 64u * 1024u;
+
+    std::istream* m_stream = nullptr;
+    std::vector<char> m_buffer;
+    size_t m_position = 0u;
+    size_t m_length = 0u;
+    size_t m_line = 1u;
+    //! \brief Content of the current tag.
+    std::string m_content;
+    //! \brief Name of the current element.
+    std::string m_name;
+    //! \brief Attributes of the current element.
+    Attributes m_attributes;
+    //! \brief Names of the opened elements.
+    std::vector<std::string> m_opened;
+    std::string m_error;
+};
+
+#endif
@@ -24,255 +24,259 @@
 #include "Vehicle/TurningRadius.hpp"
 #include "Vehicle/Car.hpp"
 #include "City/Parking.hpp"
+#include "City/City.hpp"
+#include "Math/Collide.hpp"
 #include "Simulation/BluePrints.hpp"
 #include <iostream>
 
 // FIXME https://github.com/Lecrapouille/Highway/issues/14
 // How to access to MessageBar to remove std::cout << ?
 
+//! \brief Cars farther than this distance from the parking spot are not
+//! given as obstacles to trajectory planners.
+static const Meter OBSTACLE_RANGE = 25.0_m;
+//! \brief Give up scanning parked cars after this driven distance.
+static const Meter MAX_SCAN_DISTANCE = 12.0_m;
+//! \brief Known parking spots farther than this distance behind the car are
+//! not reused.
+static const Meter MAX_SPOT_DISTANCE = 10.0_m;
+
 //------------------------------------------------------------------------------
-// doc/StateMachines/ScanStateMachine.jpg
-AutoParkECU::Scanner::Status
-AutoParkECU::Scanner::update(Second const dt, Car& car,
-                             Antenna::Detection const& detection)
+// doc/StateMachines/ParkingStateMachine.jpg
+void AutoParkECU::ParkingStateMachine::update(Second const dt)
 {
-    States state = m_state;
+    ParkingStates const previous = state();
 
-    // Estimate the distance made by the vehicle from its speed information.
-    m_distance += car.speed() * dt;
+    // Has the driver aborted the auto-parking system ?
+    if ((previous != ParkingStates::IDLE) &&
+        (m_ecu.m_ego.turningIndicator.state() == TurningIndicator::Off))
+    {
+        m_ecu.logMessage("The driver has aborted the auto-parking");
+        react(ParkingEvents::ABORTED);
+    }
+    else
+    {
+        ParkingFSM::update(dt);
+    }
 
-    // Disable the auto-park ECU if the car travelled too many distance from its
-    // initial position to find an empty parking spot.
-    if (m_distance >= 12.0_m)
+    // Debug purpose
+    if (previous != state())
     {
-        m_ecu.logMessage("Max distance reached: could not found parking slot");
-        m_state = AutoParkECU::Scanner::States::EMPTY_SPOT_NOT_FOUND;
+        const char* name = c_str();
+        m_ecu.logMessage("SelfParkingCar::StateMachine new state: ", name);
     }
+}
 
-    switch (m_state)
+//------------------------------------------------------------------------------
+AutoParkECU::ParkingEvents
+AutoParkECU::ParkingStateMachine::onIdle(Second const /*dt*/)
+{
+    // Waiting the driver has pressed the turning indicator to start the
+    // self-parking process.
+    if ((m_ecu.m_ego.turningIndicator.state() != TurningIndicator::Left) &&
+        (m_ecu.m_ego.turningIndicator.state() != TurningIndicator::Right))
+        return ParkingEvents::NO_EVENT;
+
+    // The car was parked when the self-parking process has started: let
+    // compute the path to leave the spot (LEAVING_REQUESTED). Else, if an
+    // empty spot is already known, compute the path to it directly.
+    if (findParked())
+        return ParkingEvents::LEAVING_REQUESTED;
+
+    Car& car = m_ecu.m_ego;
+    bool const right = (car.turningIndicator.state() == TurningIndicator::Right);
+    if (m_ecu.m_spots.aligned(car.position(), car.heading(), right) && findSpot())
     {
-    case AutoParkECU::Scanner::States::EMPTY_SPOT_NOT_FOUND:
-        // The car did not found the parking spot: reset states.
-        return AutoParkECU::Scanner::Status::FAILED;
-
-    case AutoParkECU::Scanner::States::IDLE:
-        // The car was stopped and now it has to drive along the parking spots
-        // and to scan for parked cars in the aim to find the first empty
-        // parking spot.
-        m_spot_length = 0.0_m;
-        m_distance = 0.0_m;
-        m_state = AutoParkECU::Scanner::States::DETECT_FIRST_CAR;
-        return AutoParkECU::Scanner::Status::IN_PROGRESS;
-
-    case AutoParkECU::Scanner::States::DETECT_FIRST_CAR:
-        // The car has detected the first parked car. Now we have to estimate
-        // the gap length with the next parked car. Depending on the gap length
-        // we can deduce we have found a real parking spot or either the space
-        // between parked cars.
-        if (!detection.valid)
-        {
-            m_position = car.position();
-            m_state = AutoParkECU::Scanner::States::DETECT_EMPTY_SPOT;
-        }
-        return AutoParkECU::Scanner::Status::IN_PROGRESS;
+        car.refSpeed(0.0_mps);
+        return ParkingEvents::SPOT_FOUND;
+    }
 
-    case AutoParkECU::Scanner::States::DETECT_EMPTY_SPOT:
-        // The car is detecting a gap between parked cars but is it a real
-        // parking spot? To confirm it, we have to integrate the vehicle speed
-        // to know the length of the gap.
-        if (detection.valid)
-        {
-            m_state = AutoParkECU::Scanner::States::DETECT_SECOND_CAR;
-        }
-        else if (m_spot_length >= Lmin)
+    // Else, let scan parked cars along the road finding the first empty
+    // parking spot.
+    return ParkingEvents::ENTERING_REQUESTED;
+}
+
+//------------------------------------------------------------------------------
+bool AutoParkECU::ParkingStateMachine::findParked()
+{
+    // Car parked by the city (i.e. when creating the simulation).
+    Car const& car = m_ecu.m_ego;
+    for (auto const& parking: m_ecu.m_city.parkings())
+    {
+        if (parking->holds(car))
         {
-            // If the gap between vehicle is enough large for doing a
-            // single-trial trajectory (i.e. two consecutive empty spots) avoid
-            // to drive up to the next parked car but let do the maneuver
-            // directly.
-            m_state = AutoParkECU::Scanner::States::DETECT_SECOND_CAR;
+            m_parking = std::make_unique<Parking>(*parking);
+            m_ecu.logMessage("Leaving: ", *m_parking);
+            return true;
         }
+    }
 
-        // Estimate the parking spot length by integrating the vehicle
-        // longitunidal speed.
-        m_spot_length += car.speed() * dt;
-        return AutoParkECU::Scanner::Status::IN_PROGRESS;
+    // Car still inside the spot it has been parked in by this ECU.
+    sf::Vector2f p;
+    return (m_parking != nullptr) && math::collide(m_parking->obb(), car.obb(), p);
+}
 
-    case AutoParkECU::Scanner::States::DETECT_SECOND_CAR:
-        if (detection.valid && (m_spot_length <= car.blueprint.length))
-        {
-            // The gap between parked cars is too small: this is not a parking,
-            // so let continuing scanning other parked cars.
-             m_ecu.logMessage("Scan: No way to park at X: ",
-                              m_position.x,
-                              " because distance is too short (",
-                              m_spot_length, ")");
-            m_state = AutoParkECU::Scanner::States::DETECT_FIRST_CAR;
-        }
-        else if (detection.valid || m_spot_length >= Lmin)
-        {
-            // TODO Missing detection of the type of parking type.
-            // https://github.com/Lecrapouille/Highway/issues/32
-            Meter pw = BluePrints::get<ParkingBluePrint>("epi.0").width;
-            ParkingBluePrint dim(m_spot_length, pw, 0.0_deg);
-            //ParkingBluePrint dim = BluePrints::get<ParkingBluePrint>("epi.0");
-            m_parking = std::make_unique<Parking>
-                        (dim, sf::Vector2<Meter>(//107.0_m, 101.0_m),
-                         m_position.x, m_position.y /*- detection.distance*/ - 0.5 * pw),
-                         0.0_deg); // FIXME matrice de passage entre coordonnees monde et coordonnees du parking
-            m_ecu.logMessage("Scan: Parking spot detected: ", *m_parking);
-            m_state = AutoParkECU::Scanner::States::EMPTY_SPOT_FOUND;
-            return AutoParkECU::Scanner::Status::SUCCEEDED;
-        }
-        m_state = AutoParkECU::Scanner::States::IDLE;
-        return AutoParkECU::Scanner::Status::IN_PROGRESS;
+//------------------------------------------------------------------------------
+bool AutoParkECU::ParkingStateMachine::findSpot()
+{
+    Car& car = m_ecu.m_ego;
+    ParkingSpotMap const& spots = m_ecu.m_spots;
+    Meter const s = spots.abscissa(car.position());
+    Meter const from = units::math::max(s - MAX_SPOT_DISTANCE, m_rejected);
 
-    case AutoParkECU::Scanner::States::EMPTY_SPOT_FOUND:
-        // The parking was found, stay in this state and let returning the
-        // currently found parking dimension.
-        return AutoParkECU::Scanner::Status::SUCCEEDED;
-    }
+    if (!spots.find(from, s, car.blueprint.length, Lmin, m_spot))
+        return false;
 
-    // Debug purpose
-    if (state != m_state)
+    Meter const pw = BluePrints::get<ParkingBluePrint>("epi.0").width;
+    m_parking = std::make_unique<Parking>(spots.parking(m_spot, pw));
+    m_ecu.logMessage("Scan: Parking spot detected: ", *m_parking,
+                     " confidence: ", m_spot.confidence);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void AutoParkECU::ParkingStateMachine::onEnteringScan()
+{
+    Car& car = m_ecu.m_ego;
+
+    // Observations are kept while the car drives along the same kerb.
+    bool const right = (car.turningIndicator.state() == TurningIndicator::Right);
+    if (!m_ecu.m_spots.aligned(car.position(), car.heading(), right))
     {
-        auto const& s = AutoParkECU::Scanner::to_string(m_state);
-        m_ecu.logMessage("SelfParkingCar::Scan new state: ", s);
+        m_ecu.m_spots.reset(car.position(), car.heading(), right);
+        m_rejected = Meter(std::numeric_limits<double>::lowest());
     }
+    m_position = car.position();
+    m_distance = 0.0_m;
 
-    return AutoParkECU::Scanner::Status::FAILED;
+    car.showSensors(true);
+    car.refSteering(0.0_deg);
+    car.refSpeed(2.0_mps);
 }
 
 //------------------------------------------------------------------------------
-// doc/StateMachines/ParkingStateMachine.jpg
-void AutoParkECU::StateMachine::update(Second const dt, AutoParkECU& ecu)
+void AutoParkECU::ParkingStateMachine::onLeavingScan()
 {
-    States state = m_state;
+    m_ecu.m_ego.refSpeed(0.0_mps);
+}
 
-    // Has the driver aborted the auto-parking system ?
-    if ((m_state != AutoParkECU::StateMachine::States::IDLE) &&
-        (ecu.m_ego.turningIndicator.state() == TurningIndicator::Off))
+//------------------------------------------------------------------------------
+AutoParkECU::ParkingEvents
+AutoParkECU::ParkingStateMachine::onScanning(Second const /*dt*/)
+{
+    // The car is scanning parked cars to update the map of parking spots.
+    Car& car = m_ecu.m_ego;
+    ParkingSpotMap& spots = m_ecu.m_spots;
+    Antenna::Detection const& detection = m_ecu.detect();
+    Meter const from = spots.abscissa(m_position);
+    Meter const to = spots.abscissa(car.position());
+    spots.observe(from, to, !detection.valid);
+    m_position = car.position();
+    m_distance += units::math::abs(to - from);
+
+    // Empty parking spot detected.
+    if (findSpot())
+        return ParkingEvents::SPOT_FOUND;
+
+    // Disable the auto-park ECU if the car travelled too many distance from
+    // its initial position to find an empty parking spot.
+    if (m_distance >= MAX_SCAN_DISTANCE)
     {
-        m_ecu.logMessage("The driver has aborted the auto-parking");
-        m_state = AutoParkECU::StateMachine::States::TRAJECTORY_DONE;
+        m_ecu.logMessage("Max distance reached: could not found parking slot");
+        return ParkingEvents::SPOT_NOT_FOUND;
     }
 
-    switch (m_state)
-    {
-    case AutoParkECU::StateMachine::States::IDLE:
-        // Waiting the driver has pressed the turning indicator to start the
-        // self-parking process.
-        if ((ecu.m_ego.turningIndicator.state() == TurningIndicator::Left) ||
-            (ecu.m_ego.turningIndicator.state() == TurningIndicator::Right))
-        {
-            if (true) // TODO car.isParked() https://github.com/Lecrapouille/Highway/issues/28
-            {
-                // The car was not parked when the self-parking process has
-                // started: let scan parked cars along the road finding the
-                // first empty parking spot.
-                ecu.m_ego.showSensors(true);
-                m_state = AutoParkECU::StateMachine::States::SCAN_PARKING_SPOTS;
-                m_scanner.start();
-                ecu.m_ego.refSteering(0.0_deg);
-                ecu.m_ego.refSpeed(2.0_mps);
-            }
-            else
-            {
-                // The car was parked when the self-parking process has started:
-                // let compute the path to leave the spot.
-                m_state = AutoParkECU::StateMachine::States::COMPUTE_LEAVING_TRAJECTORY;
-            }
-        }
-        break;
+    // The car is still scanning parked car to find empty parking spot.
+    return ParkingEvents::NO_EVENT;
+}
 
-    case AutoParkECU::StateMachine::States::SCAN_PARKING_SPOTS:
-        {
-            // The car is scanning parked cars to find an empty parking spot.
-            Antenna::Detection const& detection = ecu.detect();
-            AutoParkECU::Scanner::Status scanning = m_scanner.update(dt, ecu.m_ego, detection);
-
-            // Empty parking spot detected.
-            if (scanning == AutoParkECU::Scanner::Status::SUCCEEDED)
-            {
-                ecu.m_ego.refSpeed(0.0_mps);
-                m_state = AutoParkECU::StateMachine::States::COMPUTE_ENTERING_TRAJECTORY;
-            }
-            // Failed to find an empty parking spot.
-            else if (scanning == AutoParkECU::Scanner::Status::FAILED)
-            {
-                ecu.m_ego.refSpeed(0.0_mps);
-                m_state = AutoParkECU::StateMachine::States::TRAJECTORY_DONE;
-            }
-            else // scanning == Scan::Status::IN_PROGRESS
-            {
-                // Do nothing: the car is still scanning parked car to find
-                // empty parking spot.
-            }
-        }
-        break;
+//------------------------------------------------------------------------------
+AutoParkECU::ParkingEvents
+AutoParkECU::ParkingStateMachine::onComputingEnteringTrajectory(Second const /*dt*/)
+{
+    // Empty parking spot detected: ask the planner service to compute a
+    // path to the spot.
+    assert(m_parking != nullptr);
+    m_ecu.park(*m_parking, true);
+    m_entering = true;
+    return ParkingEvents::PLANNING_REQUESTED;
+}
 
-    case AutoParkECU::StateMachine::States::COMPUTE_ENTERING_TRAJECTORY:
-        // Empty parking spot detected: if possible compute a path to the spot
-        if (ecu.park(m_scanner.parking(), true))
-        {
-            m_state = AutoParkECU::StateMachine::States::DRIVE_ALONG_TRAJECTORY;
-        }
-        else
-        {
-            m_state = AutoParkECU::StateMachine::States::IDLE;
-        }
-        break;
+//------------------------------------------------------------------------------
+AutoParkECU::ParkingEvents
+AutoParkECU::ParkingStateMachine::onComputingLeavingTrajectory(Second const /*dt*/)
+{
+    // Leaving the parking spot detected: ask the planner service to compute
+    // a path to exit the spot.
+    assert(m_parking != nullptr);
+    m_ecu.park(*m_parking, false);
+    m_entering = false;
+    return ParkingEvents::PLANNING_REQUESTED;
+}
 
-    case AutoParkECU::StateMachine::States::COMPUTE_LEAVING_TRAJECTORY:
-        // Leaving the parking spot detected: if possible compute a path to exit
-        // the spot.
-        if (ecu.park(m_scanner.parking(), false))
-        {
-            m_state = AutoParkECU::StateMachine::States::DRIVE_ALONG_TRAJECTORY;
-        }
-        else
+//------------------------------------------------------------------------------
+AutoParkECU::ParkingEvents
+AutoParkECU::ParkingStateMachine::onPlanning(Second const /*dt*/)
+{
+    // The car is stopped and waits for the planner service.
+    switch (m_ecu.planning())
+    {
+    case AutoParkECU::Status::SUCCEEDED:
+        return ParkingEvents::PLANNING_SUCCEEDED;
+    case AutoParkECU::Status::FAILED:
+        if (m_entering)
         {
-            // FIXME https://github.com/Lecrapouille/Highway/issues/29
-            m_ecu.logMessage("SORRY I do not know how to leave"
-                             "by myself.Not yet implemented");
-            m_state = AutoParkECU::StateMachine::States::TRAJECTORY_DONE;
+            // Do not select again this spot.
+            m_rejected = m_spot.end;
+            return ParkingEvents::PLANNING_FAILED;
         }
-        break;
 
-    case AutoParkECU::StateMachine::States::DRIVE_ALONG_TRAJECTORY:
-        // The car is driving along its computed path to the parking spot.
-        if (!ecu.hasTrajectory())
-        {
-            m_ecu.logMessage("No trajectory found");
-            m_state = AutoParkECU::StateMachine::States::TRAJECTORY_DONE;
-        }
-        else if (ecu.updateTrajectory(dt) == false)
-        {
-            m_ecu.logMessage("Trajectory done");
-            m_state = AutoParkECU::StateMachine::States::TRAJECTORY_DONE;
-        }
-        else
-        {
-            // Do nothing: the car is currently driving along the trajectory to
-            // the parking spot.
-        }
-        break;
+        // FIXME https://github.com/Lecrapouille/Highway/issues/29
+        m_ecu.logMessage("SORRY I do not know how to leave"
+                         "by myself.Not yet implemented");
+        return ParkingEvents::LEAVING_FAILED;
+    default:
+        // The trajectory is still being computed.
+        return ParkingEvents::NO_EVENT;
+    }
+}
 
-    case AutoParkECU::StateMachine::States::TRAJECTORY_DONE:
-        // Reset the car states
-        m_state = AutoParkECU::StateMachine::States::IDLE;
-        ecu.m_ego.turningIndicator.state(TurningIndicator::Off);
-        ecu.m_ego.refSpeed(0.0_mps);
-        ecu.m_ego.showSensors(false);
-        break;
+//------------------------------------------------------------------------------
+void AutoParkECU::ParkingStateMachine::onLeavingPlanning()
+{
+    // Does nothing if the planning has ended, else the driver has aborted.
+    m_ecu.cancelPlanning();
+}
+
+//------------------------------------------------------------------------------
+AutoParkECU::ParkingEvents
+AutoParkECU::ParkingStateMachine::onDriving(Second const dt)
+{
+    // The car is driving along its computed path to the parking spot.
+    if (!m_ecu.hasTrajectory())
+    {
+        m_ecu.logMessage("No trajectory found");
+        return ParkingEvents::TRAJECTORY_ENDED;
     }
 
-    // Debug purpose
-    if (state != m_state)
+    if (m_ecu.updateTrajectory(dt) == false)
     {
-        auto const& s = AutoParkECU::StateMachine::to_string(m_state);
-        m_ecu.logMessage("SelfParkingCar::StateMachine new state: ", s);
+        m_ecu.logMessage("Trajectory done");
+        return ParkingEvents::TRAJECTORY_ENDED;
     }
+
+    // The car is currently driving along the trajectory to the parking spot.
+    return ParkingEvents::NO_EVENT;
+}
+
+//------------------------------------------------------------------------------
+void AutoParkECU::ParkingStateMachine::onEnteringDone()
+{
+    // Reset the car states
+    m_ecu.m_ego.turningIndicator.state(TurningIndicator::Off);
+    m_ecu.m_ego.refSpeed(0.0_mps);
+    m_ecu.m_ego.showSensors(false);
+    transition(ParkingStates::IDLE);
 }
 
 //------------------------------------------------------------------------------
@@ -295,7 +299,7 @@ AutoParkECU::AutoParkECU(Car& car, City const& city)
 void AutoParkECU::update(Second const dt)
 {
     // doc/StateMachines/ParkingStrategyFig.png
-    m_statemachine.update(dt, *this);
+    m_statemachine.update(dt);
 }
 
 //------------------------------------------------------------------------------
@@ -355,12 +359,58 @@ Antenna::Detection const& AutoParkECU::detect()
 }
 
 //------------------------------------------------------------------------------
-bool AutoParkECU::park(Parking const& parking, bool const entering)
+void AutoParkECU::park(Parking const& parking, bool const entering)
+{
+    cancelPlanning();
+    m_trajectory = nullptr;
+
+    // Parallel, perpendicular, diagonal trajectories are computed by worker
+    // threads on a snapshot of the ego car and of nearby obstacles.
+    TrajectoryRequest request(m_ego, parking, entering);
+    for (Car const& car: m_city.cars())
+    {
+        if (math::distance(car.position(), parking.position()) < OBSTACLE_RANGE)
+        {
+            request.obstacles.push_back(car.obb());
+        }
+    }
+    m_planning = TrajectoryPlanner::instance().submit(request);
+}
+
+//------------------------------------------------------------------------------
+AutoParkECU::Status AutoParkECU::planning()
 {
-    std::cout << "CCCCCCCCCCCCCCCCCCC\n";
-    // Parallel, perpendicular, diagonal trajectories.
-    m_trajectory = CarTrajectory::create(*this, parking.type);
-    return m_trajectory->init(m_ego, parking, entering);
+    if (!m_planning.valid())
+        return AutoParkECU::Status::FAILED;
+
+    if (!m_planning.ready())
+        return AutoParkECU::Status::IN_PROGRESS;
+
+    TrajectoryPlanner::Result result = m_planning.get();
+    if (result.trajectory != nullptr)
+    {
+        // Messages cannot be sent to the GUI from worker threads.
+        for (auto const& message: result.trajectory->messages())
+        {
+            logMessage(message);
+        }
+    }
+
+    if (!result.succeeded)
+        return AutoParkECU::Status::FAILED;
+
+    m_trajectory = std::move(result.trajectory);
+    return AutoParkECU::Status::SUCCEEDED;
+}
+
+//------------------------------------------------------------------------------
+void AutoParkECU::cancelPlanning()
+{
+    if (m_planning.valid())
+    {
+        logMessage("Planning of the trajectory cancelled");
+        m_planning.cancel();
+    }
 }
 
 //------------------------------------------------------------------------------
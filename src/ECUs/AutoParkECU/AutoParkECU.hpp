@@ -23,10 +23,13 @@
 #  define AUTO_PARK_ECU_HPP
 
 #  include "Vehicle/ECU.hpp"
-#  include "ECUs/AutoParkECU/Trajectory.hpp"
+#  include "ECUs/AutoParkECU/TrajectoryPlanner.hpp"
+#  include "ECUs/AutoParkECU/ParkingSpotMap.hpp"
 #  include "Sensors/Sensors.hpp"
+#  include "Common/StateMachine.hpp"
 #  include <atomic>
 #  include <deque>
+#  include <limits>
 
 class Car;
 class Parking;
@@ -43,89 +46,144 @@ class AutoParkECU : public ECU, public Visitor
 {
 private:
 
+    //! \brief Return code of the planner service: planning, trajectory found
+    //! (success), trajectory not found (failure).
+    enum Status { IN_PROGRESS, SUCCEEDED, FAILED };
+
     // *************************************************************************
-    //! \brief Helper class holding the state machine for scanning parked cars
-    //! and detect the first empty parking spot. The implementation is: detect
-    //! the first parked car, then detect the empty spot, then detect the next
-    //! parked car. Distances are made from vehicle speed. The acceptation for
-    //! a "correct empty spot" is made by the state machine calling this one.
-    //! doc/StateMachines/ScanStateMachine.jpg
+    //! \brief Main state machine for self-parking: drive along the parking,
+    //! scan parked cars and detect empty spot (or reuse a spot already known
+    //! by the map of parking spots), compute the path for parking and
+    //! compute the reference speed and reference steering angle for the cruise
+    //! controler. The path is computed by worker threads: the state machine
+    //! waits for it in the PLANNING_TRAJECTORY state.
+    //! doc/StateMachines/ParkingStateMachine.jpg
     // *************************************************************************
-    class Scanner // FIXME https://github.com/Lecrapouille/Highway/issues/25
+    class ParkingStateMachine;
+
+    //! \brief Define the differents states of the state machine: wait the
+    //! event to start parking, scan parked cars, compute the trajectory to
+    //! the spot.
+    enum class ParkingStates {
+        IDLE, SCAN_PARKING_SPOTS, COMPUTE_ENTERING_TRAJECTORY,
+        COMPUTE_LEAVING_TRAJECTORY, PLANNING_TRAJECTORY,
+        DRIVE_ALONG_TRAJECTORY, TRAJECTORY_DONE,
+        MAX_STATES, IGNORING_EVENT, CANNOT_HAPPEN
+    };
+
+    //! \brief Define the events of the self-parking state machine.
+    enum class ParkingEvents {
+        ENTERING_REQUESTED, LEAVING_REQUESTED, SPOT_FOUND, SPOT_NOT_FOUND,
+        PLANNING_REQUESTED, PLANNING_SUCCEEDED, PLANNING_FAILED,
+        LEAVING_FAILED, TRAJECTORY_ENDED, ABORTED, MAX_EVENTS, NO_EVENT
+    };
+
+    //! \brief Base class of the self-parking state machine: its "during"
+    //! actions take the delta time.
+    using ParkingFSM = ::StateMachine<ParkingStateMachine, ParkingStates,
+                                      ParkingEvents, Second>;
+
+    class ParkingStateMachine : public ParkingFSM
     {
-        //! \brief Define the differents states of the state machine: Detect the
-        //! first parked car, then detect the empty spot, then detect the next
-        //! parked car.
-        enum States {
-            EMPTY_SPOT_NOT_FOUND, IDLE, DETECT_FIRST_CAR, DETECT_EMPTY_SPOT,
-            DETECT_SECOND_CAR, EMPTY_SPOT_FOUND
-        };
+        friend ParkingFSM;
 
     public:
 
-        //! \brief Return code to the main state machine (the one used for
-        //! parking): scanning, parking spot found (success), spot not found
-        //! (failure).
-        enum Status { IN_PROGRESS, SUCCEEDED, FAILED };
-
         //----------------------------------------------------------------------
         //! \brief
         //! \param[in] lmin Minimal turning radius for the external point of the
         //! car.
         //----------------------------------------------------------------------
-        Scanner(AutoParkECU& ecu, Meter const lmin)
-            : m_ecu(ecu), Lmin(lmin)
+        ParkingStateMachine(AutoParkECU& ecu, Meter const lmin)
+            : ParkingFSM(ParkingStates::IDLE), m_ecu(ecu), Lmin(lmin)
         {}
 
-        //----------------------------------------------------------------------
-        //! \brief Reset the state machine to the initial state.
-        //----------------------------------------------------------------------
-        inline void start() { m_state = IDLE; }
-
         //----------------------------------------------------------------------
         //! \brief Update the state machine.
         //! \param[in] dt: delta time in seconds.
-        //! \param[inout] car: the reference of the ego car.
-        //! \param[in] detection: bitfield of detection returned by sensors.
-        //! \return if the parking has found, or not found or still searching an
-        //! empty spot.
         //----------------------------------------------------------------------
-        Scanner::Status update(Second const dt, Car& car, Antenna::Detection const& detection);
+        void update(Second const dt);
+
+    private: // Actions of states
+
+        ParkingEvents onIdle(Second const dt);
+        void onEnteringScan();
+        void onLeavingScan();
+        ParkingEvents onScanning(Second const dt);
+        ParkingEvents onComputingEnteringTrajectory(Second const dt);
+        ParkingEvents onComputingLeavingTrajectory(Second const dt);
+        ParkingEvents onPlanning(Second const dt);
+        void onLeavingPlanning();
+        ParkingEvents onDriving(Second const dt);
+        void onEnteringDone();
 
         //----------------------------------------------------------------------
-        //! \brief Return detected parking iff Status == SUCCEEDED.
+        //! \brief Search the parking spot the car is parked in (bound by the
+        //! city or entered with this ECU) and create m_parking.
+        //! \return true if the car is parked.
         //----------------------------------------------------------------------
-        Parking& parking()
-        {
-            assert(m_parking != nullptr);
-            return *m_parking;
-        }
-
-    private:
+        bool findParked();
 
         //----------------------------------------------------------------------
-        //! \brief For debug purpose only.
+        //! \brief Search in the map of parking spots the nearest spot behind
+        //! the car and create m_parking.
+        //! \return true if a spot has been found.
         //----------------------------------------------------------------------
-        std::string to_string(AutoParkECU::Scanner::States s)
-        {
-            switch (s)
-            {
-            case AutoParkECU::Scanner::States::EMPTY_SPOT_NOT_FOUND:
-                return "EMPTY_SPOT_NOT_FOUND";
-            case AutoParkECU::Scanner::States::IDLE:
-                return "IDLE";
-            case AutoParkECU::Scanner::States::DETECT_FIRST_CAR:
-                return "DETECT_FIRST_CAR";
-            case AutoParkECU::Scanner::States::DETECT_EMPTY_SPOT:
-                return "DETECT_EMPTY_SPOT";
-            case AutoParkECU::Scanner::States::DETECT_SECOND_CAR:
-                return "DETECT_SECOND_CAR";
-            case AutoParkECU::Scanner::States::EMPTY_SPOT_FOUND:
-                return "EMPTY_SPOT_FOUND";
-            default:
-                return "???";
-            }
-        }
+        bool findSpot();
+
+    private: // Compile-time tables
+
+        static constexpr ParkingStates X = ParkingStates::IGNORING_EVENT;
+        static constexpr ParkingStates DONE = ParkingStates::TRAJECTORY_DONE;
+
+        //! \brief Destination states indexed by [state][event].
+        static constexpr ParkingFSM::Transitions transitions =
+        {{
+            // ENTERING_REQUESTED, LEAVING_REQUESTED, SPOT_FOUND, SPOT_NOT_FOUND,
+            // PLANNING_REQUESTED, PLANNING_SUCCEEDED, PLANNING_FAILED,
+            // LEAVING_FAILED, TRAJECTORY_ENDED, ABORTED
+            // IDLE
+            {{ ParkingStates::SCAN_PARKING_SPOTS, ParkingStates::COMPUTE_LEAVING_TRAJECTORY,
+               ParkingStates::COMPUTE_ENTERING_TRAJECTORY, X, X, X, X, X, X, X }},
+            // SCAN_PARKING_SPOTS
+            {{ X, X, ParkingStates::COMPUTE_ENTERING_TRAJECTORY, DONE,
+               X, X, X, X, X, DONE }},
+            // COMPUTE_ENTERING_TRAJECTORY
+            {{ X, X, X, X, ParkingStates::PLANNING_TRAJECTORY, X, X, X, X, DONE }},
+            // COMPUTE_LEAVING_TRAJECTORY
+            {{ X, X, X, X, ParkingStates::PLANNING_TRAJECTORY, X, X, X, X, DONE }},
+            // PLANNING_TRAJECTORY
+            {{ X, X, X, X, X, ParkingStates::DRIVE_ALONG_TRAJECTORY,
+               ParkingStates::IDLE, DONE, X, DONE }},
+            // DRIVE_ALONG_TRAJECTORY
+            {{ X, X, X, X, X, X, X, X, DONE, DONE }},
+            // TRAJECTORY_DONE
+            {{ X, X, X, X, X, X, X, X, X, X }},
+        }};
+
+        //! \brief Actions of states: guard, entering, leaving, during.
+        static constexpr ParkingFSM::States states =
+        {{
+            { nullptr, nullptr, nullptr, &ParkingStateMachine::onIdle },
+            { nullptr, &ParkingStateMachine::onEnteringScan,
+              &ParkingStateMachine::onLeavingScan, &ParkingStateMachine::onScanning },
+            { nullptr, nullptr, nullptr, &ParkingStateMachine::onComputingEnteringTrajectory },
+            { nullptr, nullptr, nullptr, &ParkingStateMachine::onComputingLeavingTrajectory },
+            { nullptr, nullptr, &ParkingStateMachine::onLeavingPlanning,
+              &ParkingStateMachine::onPlanning },
+            { nullptr, nullptr, nullptr, &ParkingStateMachine::onDriving },
+            { nullptr, &ParkingStateMachine::onEnteringDone, nullptr, nullptr },
+        }};
+
+        //! \brief Name of states for debug purpose.
+        static constexpr ParkingFSM::Names names =
+        {{
+            "IDLE", "SCAN_PARKING_SPOTS", "COMPUTE_ENTERING_TRAJECTORY",
+            "COMPUTE_LEAVING_TRAJECTORY", "PLANNING_TRAJECTORY",
+            "DRIVE_ALONG_TRAJECTORY", "TRAJECTORY_DONE"
+        }};
+
+        static_assert(ParkingFSM::check(transitions), "Bad parking transitions");
 
     private:
 
@@ -135,88 +193,20 @@ private:
         //! FIXME this is computed when doing the parallel trajectory but we also
         //! need here. Can this be factorized ?
         Meter Lmin;
-        //! \brief Current state of the state machine.
-        AutoParkECU::Scanner::States m_state = AutoParkECU::Scanner::States::IDLE;
-        //! \brief Memorize the car position when the first car has been
-        //! detected.
+        //! \brief Is the trajectory being planned for entering the spot ?
+        bool m_entering = true;
+        //! \brief Car position at the previous scan.
         sf::Vector2<Meter> m_position = sf::Vector2<Meter>(0.0_m, 0.0_m);
-        //! \brief Estimation of the empty spot length.
-        Meter m_spot_length = 0.0_m;
-        //! \brief Total vehicle distance since searching for a parking slot
+        //! \brief Distance driven while scanning.
         Meter m_distance = 0.0_m;
-        //! \brief Memorize the parking spot once detected.
+        //! \brief Spots ending before this abscissa have been rejected by the
+        //! planner.
+        Meter m_rejected = Meter(std::numeric_limits<double>::lowest());
+        //! \brief The spot selected for parking.
+        ParkingSpotMap::Spot m_spot;
+        //! \brief The parking selected for parking (made from m_spot).
         std::unique_ptr<Parking> m_parking = nullptr;
-    }; // class Scanner
-
-    // *************************************************************************
-    //! \brief Main state machine for self-parking: drive along the parking,
-    //! scan parked cars and detect empty spot, compute the path for parking and
-    //! compute the reference speed and reference steering angle for the cruise
-    //! controler.
-    //! doc/StateMachines/ParkingStateMachine.jpg
-    // *************************************************************************
-    class StateMachine // FIXME https://github.com/Lecrapouille/Highway/issues/25
-    {
-        //! \brief Define the differents states of the state machine: wait the
-        //! event to start parking, scan parked cars, compute the trajectory to
-        //! the spot.
-        enum States {
-            IDLE, SCAN_PARKING_SPOTS, COMPUTE_ENTERING_TRAJECTORY,
-            COMPUTE_LEAVING_TRAJECTORY, DRIVE_ALONG_TRAJECTORY,
-            TRAJECTORY_DONE
-        };
-
-    public:
-
-        //----------------------------------------------------------------------
-        //! \brief
-        //! \param[in] lmin Minimal turning radius for the external point of the
-        //! car.
-        //----------------------------------------------------------------------
-        StateMachine(AutoParkECU& ecu, Meter const lmin)
-            : m_ecu(ecu), m_scanner(ecu, lmin)
-        {}
-
-        //----------------------------------------------------------------------
-        //! \brief Update the state machine.
-        //! \param[in] dt: delta time in seconds.
-        //! \param[inout] ecu: the reference of the ego car's ECU.
-        //----------------------------------------------------------------------
-        void update(Second const dt, AutoParkECU& ecu);
-
-    private:
-
-        //----------------------------------------------------------------------
-        //! \brief For debug purpose only.
-        //----------------------------------------------------------------------
-        std::string to_string(StateMachine::States s)
-        {
-            switch (s)
-            {
-            case AutoParkECU::StateMachine::States::IDLE:
-                return "IDLE";
-            case AutoParkECU::StateMachine::States::SCAN_PARKING_SPOTS:
-                return "SCAN_PARKING_SPOTS";
-            case AutoParkECU::StateMachine::States::COMPUTE_ENTERING_TRAJECTORY:
-                return "COMPUTE_ENTERING_TRAJECTORY";
-            case AutoParkECU::StateMachine::States::COMPUTE_LEAVING_TRAJECTORY:
-                return "COMPUTE_LEAVING_TRAJECTORY";
-            case AutoParkECU::StateMachine::States::DRIVE_ALONG_TRAJECTORY:
-                return "DRIVE_ALONG_TRAJECTORY";
-            case AutoParkECU::StateMachine::States::TRAJECTORY_DONE:
-                return "TRAJECTORY_DONE";
-            default:
-                return "???";
-            }
-        }
-
-        //! \brief
-        AutoParkECU& m_ecu;
-        //! \brief Current state of the state machine.
-        States m_state = States::IDLE;
-        //! \brief Parking spot scanner state machine.
-        AutoParkECU::Scanner m_scanner;
-    }; // class StateMachine
+    }; // class ParkingStateMachine
 
 public:
 
@@ -246,6 +236,23 @@ public:
         return *m_trajectory;
     }
 
+    //-------------------------------------------------------------------------
+    //! \brief Return the name of the current state of the parking state
+    //! machine (debug purpose).
+    //-------------------------------------------------------------------------
+    const char* state() const
+    {
+        return m_statemachine.c_str();
+    }
+
+    //-------------------------------------------------------------------------
+    //! \brief Return the map of parking spots observed by the car.
+    //-------------------------------------------------------------------------
+    ParkingSpotMap const& spots() const
+    {
+        return m_spots;
+    }
+
 private: // Inheritance
 
     //-------------------------------------------------------------------------
@@ -268,11 +275,26 @@ private:
     Antenna::Detection const& detect();
 
     //-------------------------------------------------------------------------
-    //! \brief Create the trajectory to the given parking spot.
+    //! \brief Request the planner service to compute the trajectory to the
+    //! given parking spot. Any previous pending request is cancelled. Call
+    //! planning() to know when the trajectory is available.
     //! \param[in] parking: the parking spot to park in.
-    //! \return true if the car can park on it, else return false.
+    //! \param[in] entering: true for entering in the spot, false for leaving.
+    //-------------------------------------------------------------------------
+    void park(Parking const& parking, bool const entering);
+
+    //-------------------------------------------------------------------------
+    //! \brief Non blocking check of the pending planning request. Once the
+    //! planning has succeeded, trajectory() can be used.
+    //! \return IN_PROGRESS while the planner is working, else SUCCEEDED or
+    //! FAILED.
+    //-------------------------------------------------------------------------
+    Status planning();
+
+    //-------------------------------------------------------------------------
+    //! \brief Abort the pending planning request (if any).
     //-------------------------------------------------------------------------
-    bool park(Parking const& parking, bool const entering);
+    void cancelPlanning();
 
     //-------------------------------------------------------------------------
     //! \brief Update the trajectory (get current references and make it use
@@ -288,14 +310,19 @@ private:
     City const& m_city;
     //! \brief Main state machine for searching and entering in the first parking
     //! slot. See doc/ParkingStateMachine.jpg
-    StateMachine m_statemachine;
+    ParkingStateMachine m_statemachine;
     //! \brief If and only if reachable, the trajectory to the parking slot.
     std::unique_ptr<CarTrajectory> m_trajectory = nullptr;
+    //! \brief Pending request to the planner service.
+    TrajectoryPlanner::Ticket m_planning;
     //! \brief Trigger for starting searching the first parking slot and
     //! computing the trajectory to enter in.
     std::atomic<bool> m_clignotant{false};
     //! \brief Has sensor detect a parked vehicle ? Default value is set to invalid
     Antenna::Detection m_detection;
+    //! \brief Free and occupied places observed along the kerb. Kept between
+    //! two parkings.
+    ParkingSpotMap m_spots;
 };
 
 #endif
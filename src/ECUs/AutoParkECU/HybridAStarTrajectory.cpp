@@ -0,0 +1,662 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "ECUs/AutoParkECU/HybridAStarTrajectory.hpp"
+#include "Math/Math.hpp"
+#include "Math/Collide.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <queue>
+
+using Pose = math::ReedsShepp::Pose;
+
+static constexpr double TWO_PI = 2.0 * math::PI;
+static constexpr float INF = std::numeric_limits<float>::infinity();
+
+//! \brief Max speed along the path [m/s]
+static const MeterPerSecond VMAX = 1.0_mps;
+
+//------------------------------------------------------------------------------
+//! \brief Wrap the angle to [0, 2 pi[.
+static inline double wrap(double const a)
+{
+    double v = std::fmod(a, TWO_PI);
+    return (v < 0.0) ? v + TWO_PI : v;
+}
+
+//------------------------------------------------------------------------------
+//! \brief Kinematic bicycle model: move the middle of the rear axle along an
+//! arc of constant steering angle.
+//! \param[in] direction: +1 forward, -1 backward.
+//! \param[in] length: travelled distance (positive) [meter].
+static inline Pose drive(Pose const& p, int const direction, double const steering,
+                         double const wheelbase, double const length)
+{
+    const double s = double(direction) * length;
+    if (std::abs(steering) < 1e-6)
+    {
+        return { p.x + s * std::cos(p.theta), p.y + s * std::sin(p.theta), p.theta };
+    }
+
+    const double R = wheelbase / std::tan(steering);
+    const double theta = p.theta + s / R;
+    return { p.x + R * (std::sin(theta) - std::sin(p.theta)),
+             p.y + R * (std::cos(p.theta) - std::cos(theta)), theta };
+}
+
+// *****************************************************************************
+//! \brief Obstacle-free Reeds-Shepp distances to a goal expressed in the frame
+//! of the car. The table depends only on the turning radius, it is therefore
+//! computed once per car blueprint and shared by all planners. Thanks to the
+//! symmetry (x, y, theta) -> (x, -y, -theta) only the half y >= 0 is stored.
+// *****************************************************************************
+class HeuristicTable
+{
+public:
+
+    static constexpr double RANGE = 12.0;
+    static constexpr double RESOLUTION = 0.5;
+    static constexpr size_t HEADINGS = 36u;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the table for the given turning radius (computed on the
+    //! first call). Thread safe.
+    //--------------------------------------------------------------------------
+    static std::shared_ptr<const HeuristicTable> get(double const radius)
+    {
+        static std::mutex mutex;
+        static std::map<long, std::shared_ptr<const HeuristicTable>> tables;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& table = tables[std::lround(radius * 1000.0)];
+        if (table == nullptr)
+        {
+            table = std::make_shared<const HeuristicTable>(radius);
+        }
+        return table;
+    }
+
+    //--------------------------------------------------------------------------
+    explicit HeuristicTable(double const radius)
+        : m_rs(radius), m_cells(size_t(2.0 * RANGE / RESOLUTION) + 1u),
+          m_distances(m_cells * (m_cells / 2u + 1u) * HEADINGS)
+    {
+        for (size_t j = 0u; j <= m_cells / 2u; ++j)
+        {
+            const double y = double(j) * RESOLUTION;
+            for (size_t i = 0u; i < m_cells; ++i)
+            {
+                const double x = double(i) * RESOLUTION - RANGE;
+                for (size_t k = 0u; k < HEADINGS; ++k)
+                {
+                    const double theta = double(k) * TWO_PI / double(HEADINGS);
+                    m_distances[index(i, j, k)] = float(m_rs.distance(x, y, theta));
+                }
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Reeds-Shepp distance from the pose to the goal.
+    //--------------------------------------------------------------------------
+    double distance(Pose const& from, Pose const& goal) const
+    {
+        const double dx = goal.x - from.x;
+        const double dy = goal.y - from.y;
+        const double c = std::cos(from.theta);
+        const double s = std::sin(from.theta);
+        const double x = c * dx + s * dy;
+        double y = -s * dx + c * dy;
+        double theta = goal.theta - from.theta;
+
+        // Outside the table: compute it.
+        if ((std::abs(x) > RANGE) || (std::abs(y) > RANGE))
+        {
+            return m_rs.distance(x, y, theta);
+        }
+
+        if (y < 0.0)
+        {
+            y = -y;
+            theta = -theta;
+        }
+
+        const size_t i = size_t(std::lround((x + RANGE) / RESOLUTION));
+        const size_t j = size_t(std::lround(y / RESOLUTION));
+        const size_t k = size_t(std::lround(wrap(theta) * double(HEADINGS) / TWO_PI)) % HEADINGS;
+        return double(m_distances[index(i, j, k)]);
+    }
+
+private:
+
+    inline size_t index(size_t const i, size_t const j, size_t const k) const
+    {
+        return (j * m_cells + i) * HEADINGS + k;
+    }
+
+private:
+
+    math::ReedsShepp m_rs;
+    size_t m_cells;
+    std::vector<float> m_distances;
+};
+
+// *****************************************************************************
+//! \brief Check collisions between the car (inflated by a clearance) placed at
+//! a given pose and obstacles. Obstacles too far away are rejected by a
+//! bounding circle test before calling the SAT kernel.
+// *****************************************************************************
+class CollisionChecker
+{
+public:
+
+    CollisionChecker(CarBluePrint const& car, std::vector<sf::RectangleShape> const& obstacles,
+                     double const clearance)
+        : m_obstacles(obstacles)
+    {
+        const float c = float(clearance);
+        const float length = float(car.length.value());
+        const float width = float(car.width.value());
+        m_shape.setSize(sf::Vector2f(length + 2.0f * c, width + 2.0f * c));
+        m_shape.setOrigin(sf::Vector2f(float(car.back_overhang.value()) + c, width / 2.0f + c));
+        m_center_offset = double(length) / 2.0 - car.back_overhang.value();
+        m_radius = std::hypot(double(length) + 2.0 * clearance, double(width) + 2.0 * clearance) / 2.0;
+
+        for (auto const& obstacle: m_obstacles)
+        {
+            const sf::Vector2f size = obstacle.getSize();
+            const sf::Vector2f center = obstacle.getTransform().transformPoint(size / 2.0f);
+            m_circles.push_back({ double(center.x), double(center.y),
+                                  std::hypot(double(size.x), double(size.y)) / 2.0 });
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    bool collides(Pose const& p)
+    {
+        const double cx = p.x + m_center_offset * std::cos(p.theta);
+        const double cy = p.y + m_center_offset * std::sin(p.theta);
+
+        bool placed = false;
+        for (size_t i = 0u; i < m_obstacles.size(); ++i)
+        {
+            const Circle& c = m_circles[i];
+            const double r = m_radius + c.radius;
+            if ((cx - c.x) * (cx - c.x) + (cy - c.y) * (cy - c.y) > r * r)
+                continue;
+
+            if (!placed)
+            {
+                m_shape.setPosition(float(p.x), float(p.y));
+                m_shape.setRotation(float(Degree(Radian(p.theta)).value()));
+                placed = true;
+            }
+
+            sf::Vector2f mtv;
+            if (math::collide(m_shape, m_obstacles[i], mtv))
+                return true;
+        }
+        return false;
+    }
+
+private:
+
+    struct Circle { double x, y, radius; };
+
+    std::vector<sf::RectangleShape> const& m_obstacles;
+    std::vector<Circle> m_circles;
+    sf::RectangleShape m_shape;
+    double m_center_offset;
+    double m_radius;
+};
+
+// *****************************************************************************
+//! \brief Grid covering the search area.
+// *****************************************************************************
+struct Grid
+{
+    Grid(Pose const& a, Pose const& b, double const margin, double const res)
+        : resolution(res)
+    {
+        xmin = std::min(a.x, b.x) - margin;
+        ymin = std::min(a.y, b.y) - margin;
+        width = size_t(std::ceil((std::max(a.x, b.x) + margin - xmin) / res));
+        height = size_t(std::ceil((std::max(a.y, b.y) + margin - ymin) / res));
+    }
+
+    inline bool contains(double const x, double const y) const
+    {
+        return (x >= xmin) && (y >= ymin) &&
+               (x < xmin + double(width) * resolution) &&
+               (y < ymin + double(height) * resolution);
+    }
+
+    inline size_t cell(double const x, double const y) const
+    {
+        return size_t((y - ymin) / resolution) * width + size_t((x - xmin) / resolution);
+    }
+
+    double xmin, ymin, resolution;
+    size_t width, height;
+};
+
+// *****************************************************************************
+//! \brief Holonomic distance to the goal around obstacles (Dijkstra on the 8
+//! connected grid). Obstacles are inflated by the half width of the car.
+// *****************************************************************************
+class DistanceMap
+{
+public:
+
+    DistanceMap(Grid const& grid, std::vector<sf::RectangleShape> const& obstacles,
+                double const inflation, Pose const& goal)
+        : m_grid(grid), m_distances(grid.width * grid.height, INF)
+    {
+        std::vector<bool> occupied(m_distances.size(), false);
+        for (auto const& obstacle: obstacles)
+        {
+            rasterize(obstacle, inflation, occupied);
+        }
+
+        // Dijkstra from the goal.
+        const size_t start = grid.cell(goal.x, goal.y);
+        occupied[start] = false;
+        m_distances[start] = 0.0f;
+
+        using Item = std::pair<float, size_t>;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> open;
+        open.push({ 0.0f, start });
+
+        const float straight = float(grid.resolution);
+        const float diagonal = float(grid.resolution * std::sqrt(2.0));
+        const int W = int(grid.width);
+        const int H = int(grid.height);
+        while (!open.empty())
+        {
+            const Item item = open.top();
+            open.pop();
+            if (item.first > m_distances[item.second])
+                continue;
+
+            const int x = int(item.second % grid.width);
+            const int y = int(item.second / grid.width);
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    const int nx = x + dx;
+                    const int ny = y + dy;
+                    if (((dx == 0) && (dy == 0)) || (nx < 0) || (ny < 0) || (nx >= W) || (ny >= H))
+                        continue;
+
+                    const size_t n = size_t(ny * W + nx);
+                    if (occupied[n])
+                        continue;
+
+                    const float d = item.first + (((dx != 0) && (dy != 0)) ? diagonal : straight);
+                    if (d < m_distances[n])
+                    {
+                        m_distances[n] = d;
+                        open.push({ d, n });
+                    }
+                }
+            }
+        }
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Distance to the goal (0 if unknown, i.e. cell enclosed by the
+    //! inflated obstacles).
+    //--------------------------------------------------------------------------
+    inline double distance(double const x, double const y) const
+    {
+        const float d = m_distances[m_grid.cell(x, y)];
+        return (d == INF) ? 0.0 : double(d);
+    }
+
+private:
+
+    void rasterize(sf::RectangleShape const& obstacle, double const inflation,
+                   std::vector<bool>& occupied) const
+    {
+        const sf::Transform inverse = obstacle.getInverseTransform();
+        const sf::Vector2f size = obstacle.getSize();
+        const sf::Vector2f center = obstacle.getTransform().transformPoint(size / 2.0f);
+        const double r = std::hypot(double(size.x), double(size.y)) / 2.0 + inflation;
+
+        const double res = m_grid.resolution;
+        const long i0 = std::max(0L, long((double(center.x) - r - m_grid.xmin) / res));
+        const long j0 = std::max(0L, long((double(center.y) - r - m_grid.ymin) / res));
+        const long i1 = std::min(long(m_grid.width) - 1L, long((double(center.x) + r - m_grid.xmin) / res));
+        const long j1 = std::min(long(m_grid.height) - 1L, long((double(center.y) + r - m_grid.ymin) / res));
+
+        for (long j = j0; j <= j1; ++j)
+        {
+            for (long i = i0; i <= i1; ++i)
+            {
+                const float x = float(m_grid.xmin + (double(i) + 0.5) * res);
+                const float y = float(m_grid.ymin + (double(j) + 0.5) * res);
+                const sf::Vector2f p = inverse.transformPoint(x, y);
+                const double dx = std::max(0.0, std::max(-double(p.x), double(p.x - size.x)));
+                const double dy = std::max(0.0, std::max(-double(p.y), double(p.y - size.y)));
+                if (dx * dx + dy * dy <= inflation * inflation)
+                {
+                    occupied[size_t(j) * m_grid.width + size_t(i)] = true;
+                }
+            }
+        }
+    }
+
+private:
+
+    Grid const& m_grid;
+    std::vector<float> m_distances;
+};
+
+// *****************************************************************************
+//! \brief Node of the search tree.
+// *****************************************************************************
+struct Node
+{
+    Pose pose;
+    float g;
+    uint32_t parent;
+    int direction;
+    double steering;
+};
+
+static constexpr uint32_t NO_PARENT = std::numeric_limits<uint32_t>::max();
+
+//------------------------------------------------------------------------------
+bool HybridAStarTrajectory::init(TrajectoryRequest const& request)
+{
+    m_path.clear();
+    m_maneuvers = 0u;
+
+    if (!request.entering)
+    {
+        // FIXME https://github.com/Lecrapouille/Highway/issues/29
+        logMessage("Hybrid A*: leaving a parking spot is not yet implemented");
+        return false;
+    }
+
+    sf::Vector2<Meter> position;
+    Radian heading;
+    request.parking.goal(request.car.blueprint, position, heading);
+
+    const Pose start = { request.car.position.x.value(), request.car.position.y.value(),
+                         request.car.heading.value() };
+    const Pose goal = { position.x.value(), position.y.value(), heading.value() };
+
+    if (!search(request, start, goal))
+        return false;
+
+    generateReferences(VMAX);
+    logMessage("Hybrid A*: ", m_maneuvers, " maneuvers");
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool HybridAStarTrajectory::search(TrajectoryRequest const& request,
+                                   Pose const& start, Pose const& goal)
+{
+    CarBluePrint const& car = request.car.blueprint;
+    const double wheelbase = car.wheelbase.value();
+    const double max_steering = std::abs(car.max_steering_angle.value());
+    const double radius = wheelbase / std::tan(max_steering);
+
+    CollisionChecker checker(car, request.obstacles, m_config.clearance);
+    if (checker.collides(goal))
+    {
+        logMessage("Hybrid A*: the parking spot is obstructed");
+        return false;
+    }
+
+    const Grid grid(start, goal, m_config.margin, m_config.resolution);
+    const DistanceMap dmap(grid, request.obstacles, car.width.value() / 2.0, goal);
+    const auto table = HeuristicTable::get(radius);
+    const math::ReedsShepp rs(radius);
+
+    auto heuristic = [&](Pose const& p) -> double
+    {
+        return std::max(table->distance(p, goal), dmap.distance(p.x, p.y));
+    };
+
+    auto state = [&](Pose const& p) -> size_t
+    {
+        const size_t k = size_t(wrap(p.theta) * double(m_config.headings) / TWO_PI) % m_config.headings;
+        return grid.cell(p.x, p.y) * m_config.headings + k;
+    };
+
+    // Steering angles of motion primitives.
+    std::vector<double> steerings(m_config.steerings);
+    for (size_t i = 0u; i < m_config.steerings; ++i)
+    {
+        steerings[i] = (m_config.steerings == 1u) ? 0.0 :
+            -max_steering + 2.0 * max_steering * double(i) / double(m_config.steerings - 1u);
+    }
+
+    const size_t substeps = size_t(std::ceil(m_config.step / m_config.collision_step));
+    std::vector<float> costs(grid.width * grid.height * m_config.headings, INF);
+    std::vector<bool> closed(costs.size(), false);
+    std::vector<Node> nodes;
+    nodes.reserve(1024u);
+
+    using Item = std::pair<float, uint32_t>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> open;
+    nodes.push_back({ start, 0.0f, NO_PARENT, 1, 0.0 });
+    open.push({ float(heuristic(start)), 0u });
+
+    size_t iterations = 0u;
+    while (!open.empty())
+    {
+        if (request.cancelled())
+            return false;
+
+        if (++iterations > m_config.max_iterations)
+        {
+            logMessage("Hybrid A*: no path found after ", iterations, " iterations");
+            return false;
+        }
+
+        const uint32_t current = open.top().second;
+        open.pop();
+        const Node node = nodes[current];
+        const size_t id = state(node.pose);
+        if (closed[id])
+            continue;
+        closed[id] = true;
+
+        // Analytic expansion: try to reach the goal with a Reeds-Shepp path.
+        if ((iterations % m_config.analytic_period == 1u) ||
+            (table->distance(node.pose, goal) < 2.0 * radius))
+        {
+            const auto path = rs.path(node.pose, goal);
+            const auto poses = rs.sample(node.pose, path, m_config.collision_step);
+            if (!poses.empty() && std::none_of(poses.begin(), poses.end(),
+                    [&](Pose const& p) { return checker.collides(p); }))
+            {
+                // Rebuild the path from the start to this node.
+                std::vector<uint32_t> chain;
+                for (uint32_t i = current; i != NO_PARENT; i = nodes[i].parent)
+                {
+                    chain.push_back(i);
+                }
+                std::reverse(chain.begin(), chain.end());
+
+                m_path.push_back({ start, 0.0, nodes[chain.size() > 1u ? chain[1] : 0u].direction });
+                for (size_t c = 1u; c < chain.size(); ++c)
+                {
+                    Node const& n = nodes[chain[c]];
+                    Pose p = nodes[n.parent].pose;
+                    for (size_t i = 1u; i <= substeps; ++i)
+                    {
+                        Pose q = drive(p, n.direction, n.steering, wheelbase,
+                                       m_config.step * double(i) / double(substeps));
+                        m_path.push_back({ q, n.steering, n.direction });
+                    }
+                }
+
+                // Append the Reeds-Shepp path (but its first pose which is
+                // the pose of the node). Segments are sampled separately for
+                // keeping the exact poses where the car changes of gear.
+                size_t segment;
+                double s = 0.0;
+                for (size_t k = 0u; k < path.types.size(); ++k)
+                {
+                    const double length = radius * std::abs(path.lengths[k]);
+                    if ((path.types[k] == math::ReedsShepp::NOP) || (length <= 0.0))
+                        continue;
+
+                    const double delta =
+                        (path.types[k] == math::ReedsShepp::LEFT) ? max_steering :
+                        (path.types[k] == math::ReedsShepp::RIGHT) ? -max_steering : 0.0;
+                    const int direction = (path.lengths[k] < 0.0) ? -1 : 1;
+                    const size_t samples = size_t(std::ceil(length / m_config.collision_step));
+                    for (size_t i = 1u; i <= samples; ++i)
+                    {
+                        const Pose q = rs.interpolate(node.pose, path,
+                            s + length * double(i) / double(samples), segment);
+                        m_path.push_back({ q, delta, direction });
+                    }
+                    s += length;
+                }
+                m_path.back().pose = goal;
+                return true;
+            }
+        }
+
+        // Expand motion primitives.
+        for (int direction = 1; direction >= -1; direction -= 2)
+        {
+            for (double const steering: steerings)
+            {
+                Pose p = node.pose;
+                bool free = true;
+                for (size_t i = 1u; (i <= substeps) && free; ++i)
+                {
+                    p = drive(node.pose, direction, steering, wheelbase,
+                              m_config.step * double(i) / double(substeps));
+                    free = grid.contains(p.x, p.y) && !checker.collides(p);
+                }
+                if (!free)
+                    continue;
+
+                const size_t next = state(p);
+                if (closed[next])
+                    continue;
+
+                double cost = m_config.step * ((direction < 0) ? m_config.reverse_penalty : 1.0);
+                cost += m_config.steering_penalty * m_config.step * std::abs(steering) / max_steering;
+                cost += m_config.steering_change_penalty * std::abs(steering - node.steering) / max_steering;
+                if ((node.parent != NO_PARENT) && (direction != node.direction))
+                {
+                    cost += m_config.gear_penalty;
+                }
+
+                const float g = node.g + float(cost);
+                if (g >= costs[next])
+                    continue;
+
+                costs[next] = g;
+                nodes.push_back({ p, g, current, direction, steering });
+                open.push({ g + float(heuristic(p)), uint32_t(nodes.size() - 1u) });
+            }
+        }
+    }
+
+    logMessage("Hybrid A*: no path found");
+    return false;
+}
+
+//------------------------------------------------------------------------------
+void HybridAStarTrajectory::generateReferences(MeterPerSecond const VMAX)
+{
+    // Duration to turn front wheels when the car is stopped for changing of gear [s]
+    Second const DURATION_TO_TURN_WHEELS = 0.5_s;
+
+    m_speeds.clear();
+    m_steerings.clear();
+    m_vertices.clear();
+    m_vertices.setPrimitiveType(sf::LineStrip);
+
+    // Group consecutive waypoints with the same direction and steering.
+    size_t i = 1u;
+    int direction = 0;
+    while (i < m_path.size())
+    {
+        Waypoint const& w = m_path[i];
+        double length = 0.0;
+        size_t j = i;
+        while ((j < m_path.size()) && (m_path[j].direction == w.direction) &&
+               (std::abs(m_path[j].steering - w.steering) < 1e-6))
+        {
+            length += std::hypot(m_path[j].pose.x - m_path[j - 1u].pose.x,
+                                 m_path[j].pose.y - m_path[j - 1u].pose.y);
+            ++j;
+        }
+
+        // Stop the car and turn the wheels when changing of gear.
+        if (w.direction != direction)
+        {
+            if (direction != 0)
+            {
+                ++m_maneuvers;
+            }
+            m_speeds.add(0.0_mps, DURATION_TO_TURN_WHEELS);
+            m_steerings.add(Radian(w.steering), DURATION_TO_TURN_WHEELS);
+            direction = w.direction;
+        }
+
+        const Second t = Meter(length) / VMAX;
+        m_speeds.add(double(w.direction) * VMAX, t);
+        m_steerings.add(Radian(w.steering), t);
+        i = j;
+    }
+
+    for (auto const& w: m_path)
+    {
+        m_vertices.append(sf::Vertex(sf::Vector2f(float(w.pose.x), float(w.pose.y)),
+                                     (w.direction > 0) ? sf::Color::Blue : sf::Color::Red));
+    }
+}
+
+//------------------------------------------------------------------------------
+void HybridAStarTrajectory::computeTrackingPath(TrajectoryRequest::Ego const& /*car*/)
+{
+    m_tracking_path.clear();
+    m_tracking = false;
+
+    for (auto const& w: m_path)
+    {
+        m_tracking_path.push_back({ { Meter(w.pose.x), Meter(w.pose.y) },
+                                    Radian(w.pose.theta), double(w.direction) * VMAX });
+    }
+}
+
+//------------------------------------------------------------------------------
+void HybridAStarTrajectory::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+    target.draw(m_vertices, states);
+}
@@ -0,0 +1,151 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef HYBRID_ASTAR_TRAJECTORY_HPP
+#  define HYBRID_ASTAR_TRAJECTORY_HPP
+
+#  include "ECUs/AutoParkECU/Trajectory.hpp"
+#  include "Math/ReedsShepp.hpp"
+
+// *****************************************************************************
+//! \brief Search-based trajectory to any kind of parking spot (parallel,
+//! perpendicular, diagonal). Hybrid A* (Dolgov, Thrun, Montemerlo, Diebel,
+//! "Practical Search Techniques in Path Planning for Autonomous Driving")
+//! explores continuous car poses (x, y, heading) discretized on a grid, by
+//! applying short arcs of constant steering angle, forward and backward.
+//! Expansions are guided by two heuristics:
+//!   - the obstacle-free Reeds-Shepp distance, read from a lookup table
+//!     precomputed once per car turning radius (i.e. per CarBluePrint).
+//!   - the 2D distance to the goal around obstacles, computed once per
+//!     planning by a Dijkstra on a grid.
+//! The search periodically tries to reach the goal directly with a Reeds-Shepp
+//! path (analytic expansion). Collisions are checked with the oriented bounding
+//! box (SAT) kernel used by the simulation.
+// *****************************************************************************
+class HybridAStarTrajectory: public CarTrajectory
+{
+public:
+
+    // *************************************************************************
+    //! \brief Tuning of the search.
+    // *************************************************************************
+    struct Config
+    {
+        //! \brief Size of grid cells [meter].
+        double resolution = 0.25;
+        //! \brief Number of heading cells.
+        size_t headings = 72u;
+        //! \brief Arc length of motion primitives [meter].
+        double step = 0.6;
+        //! \brief Number of steering angles in [-max .. +max] (odd number).
+        size_t steerings = 5u;
+        //! \brief Free space added around the start and goal poses [meter].
+        double margin = 8.0;
+        //! \brief Safety distance to obstacles [meter].
+        double clearance = 0.1;
+        //! \brief Distance between collision checks [meter].
+        double collision_step = 0.3;
+        //! \brief Cost factor for driving backward.
+        double reverse_penalty = 1.5;
+        //! \brief Cost for changing of gear [meter].
+        double gear_penalty = 2.0;
+        //! \brief Cost for non null steering (proportional to the steering).
+        double steering_penalty = 0.2;
+        //! \brief Cost for changing the steering angle.
+        double steering_change_penalty = 0.5;
+        //! \brief Try a Reeds-Shepp path to the goal every N expansions.
+        size_t analytic_period = 5u;
+        //! \brief Maximum number of expansions before giving up.
+        size_t max_iterations = 100000u;
+    };
+
+    // *************************************************************************
+    //! \brief A point of the computed path.
+    // *************************************************************************
+    struct Waypoint
+    {
+        //! \brief Pose of the middle of the rear axle [meter, meter, radian].
+        math::ReedsShepp::Pose pose;
+        //! \brief Steering angle to reach this pose [radian].
+        double steering;
+        //! \brief +1 for forward motion, -1 for backward motion.
+        int direction;
+    };
+
+public:
+
+    HybridAStarTrajectory()
+        : m_config()
+    {}
+
+    HybridAStarTrajectory(Config const& config)
+        : m_config(config)
+    {}
+
+    virtual bool init(TrajectoryRequest const& request) override;
+    virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+    virtual void computeTrackingPath(TrajectoryRequest::Ego const& car) override;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the path found by init().
+    //--------------------------------------------------------------------------
+    inline std::vector<Waypoint> const& path() const
+    {
+        return m_path;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the number of changes of gear along the path.
+    //--------------------------------------------------------------------------
+    inline size_t maneuvers() const
+    {
+        return m_maneuvers;
+    }
+
+private:
+
+    //--------------------------------------------------------------------------
+    //! \brief Hybrid A* search from the start pose to the goal pose. The found
+    //! path is stored in m_path.
+    //--------------------------------------------------------------------------
+    bool search(TrajectoryRequest const& request,
+                math::ReedsShepp::Pose const& start,
+                math::ReedsShepp::Pose const& goal);
+
+    //--------------------------------------------------------------------------
+    //! \brief Convert the path into speed and steering references.
+    //! \param[in] VMAX: max speed [m/s]
+    //--------------------------------------------------------------------------
+    void generateReferences(MeterPerSecond const VMAX);
+
+private:
+
+    //! \brief Tuning of the search.
+    Config m_config;
+    //! \brief Found path.
+    std::vector<Waypoint> m_path;
+    //! \brief Number of changes of gear.
+    size_t m_maneuvers = 0u;
+    //! \brief Path for the rendering.
+    sf::VertexArray m_vertices;
+};
+
+#endif
@@ -0,0 +1,167 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "ECUs/AutoParkECU/ManeuverCache.hpp"
+#include "project_info.hpp"
+#include <fstream>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+
+//! \brief Header of the cache file. Change the version when the layout of
+//! buffers exported by trajectories changes.
+static constexpr char MAGIC[4] = { 'H', 'W', 'M', 'C' };
+static constexpr uint32_t VERSION = 3u;
+
+//------------------------------------------------------------------------------
+static inline int32_t quantize(double const value, double const quantum)
+{
+    return int32_t(std::lround(value / quantum));
+}
+
+//------------------------------------------------------------------------------
+ManeuverCache::ManeuverCache()
+    : m_path(project::info::tmp_path + "maneuvers.cache")
+{
+    if (!load(m_path))
+    {
+        // Missing file or obsolete format: start a new one.
+        std::remove(m_path.c_str());
+    }
+}
+
+//------------------------------------------------------------------------------
+ManeuverCache::Key ManeuverCache::key(TrajectoryRequest const& request)
+{
+    CarBluePrint const& car = request.car.blueprint;
+    Parking const& parking = request.parking;
+
+    // Start pose in the frame of the car once parked: identical scenes
+    // rotated around the world share the same key.
+    sf::Vector2<Meter> goal;
+    Radian goal_heading;
+    parking.goal(car, goal, goal_heading);
+    const sf::Vector2<Meter> position =
+        math::heading(request.car.position - goal, -goal_heading);
+    double heading = (request.car.heading - goal_heading).value();
+    heading = std::remainder(heading, Radian(360.0_deg).value());
+
+    return {
+        quantize(car.length.value(), DIMENSION_QUANTUM),
+        quantize(car.width.value(), DIMENSION_QUANTUM),
+        quantize(car.wheelbase.value(), DIMENSION_QUANTUM),
+        quantize(car.back_overhang.value(), DIMENSION_QUANTUM),
+        quantize(Radian(car.max_steering_angle).value(), ANGLE_QUANTUM / 100.0),
+        int32_t(parking.type),
+        quantize(parking.blueprint.length.value(), DIMENSION_QUANTUM),
+        quantize(parking.blueprint.width.value(), DIMENSION_QUANTUM),
+        request.entering ? 1 : 0,
+        quantize(position.x.value(), POSITION_QUANTUM),
+        quantize(position.y.value(), POSITION_QUANTUM),
+        quantize(heading, ANGLE_QUANTUM)
+    };
+}
+
+//------------------------------------------------------------------------------
+bool ManeuverCache::find(Key const& key, Buffer& buffer) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto const it = m_entries.find(key);
+    if (it == m_entries.end())
+        return false;
+
+    buffer = it->second;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void ManeuverCache::store(Key const& key, Buffer const& buffer)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_entries[key] = buffer;
+
+    // Append the entry to the file. When loading, the latest entry of a given
+    // key overrides the previous ones.
+    std::ofstream file(m_path, std::ios::binary | std::ios::app);
+    if (!file)
+        return ;
+
+    if (file.tellp() == 0)
+    {
+        file.write(MAGIC, sizeof(MAGIC));
+        file.write(reinterpret_cast<char const*>(&VERSION), sizeof(VERSION));
+    }
+
+    const uint32_t size = uint32_t(buffer.size());
+    file.write(reinterpret_cast<char const*>(key.data()), sizeof(Key::value_type) * key.size());
+    file.write(reinterpret_cast<char const*>(&size), sizeof(size));
+    file.write(reinterpret_cast<char const*>(buffer.data()), std::streamsize(size));
+}
+
+//------------------------------------------------------------------------------
+bool ManeuverCache::load(std::string const& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    char magic[sizeof(MAGIC)];
+    uint32_t version;
+    if (!file.read(magic, sizeof(magic)) ||
+        !file.read(reinterpret_cast<char*>(&version), sizeof(version)) ||
+        (std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) || (version != VERSION))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Key key;
+    uint32_t size;
+    while (file.read(reinterpret_cast<char*>(key.data()), sizeof(Key::value_type) * key.size()) &&
+           file.read(reinterpret_cast<char*>(&size), sizeof(size)))
+    {
+        Buffer buffer(size);
+        if (!file.read(reinterpret_cast<char*>(buffer.data()), std::streamsize(size)))
+            break; // Truncated entry (i.e. the simulator has been killed)
+        m_entries[key] = std::move(buffer);
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void ManeuverCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_entries.clear();
+    std::remove(m_path.c_str());
+}
+
+//------------------------------------------------------------------------------
+size_t ManeuverCache::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
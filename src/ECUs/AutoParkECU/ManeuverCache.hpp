@@ -0,0 +1,120 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef MANEUVER_CACHE_HPP
+#  define MANEUVER_CACHE_HPP
+
+#  include "ECUs/AutoParkECU/Trajectory.hpp"
+#  include "Common/Singleton.hpp"
+#  include <array>
+#  include <map>
+#  include <mutex>
+
+// *****************************************************************************
+//! \brief Library of maneuvers already computed, shared by all ego cars and
+//! memorized on the disk between two runs of the simulator. Maneuvers only
+//! depend on the car dimensions, the parking dimensions and the start pose of
+//! the car relatively to its pose once parked: in simulations where many identical
+//! cars park in identical spots, the planning is done once.
+//! Entries are opaque buffers produced by CarTrajectory::save(). Key values
+//! are quantized: a hit means the car starts within some centimeters of the
+//! cached start pose.
+// *****************************************************************************
+class ManeuverCache : public Singleton<ManeuverCache>
+{
+    friend class Singleton<ManeuverCache>;
+
+public:
+
+    //! \brief Quantization of car and parking dimensions [meter].
+    static constexpr double DIMENSION_QUANTUM = 0.001;
+    //! \brief Quantization of the start position [meter].
+    static constexpr double POSITION_QUANTUM = 0.05;
+    //! \brief Quantization of angles [radian].
+    static constexpr double ANGLE_QUANTUM = 0.005;
+
+    //! \brief Quantized car dimensions, parking type and dimensions, relative
+    //! start pose and direction (entering or leaving).
+    using Key = std::array<int32_t, 12u>;
+    //! \brief Maneuvers exported by CarTrajectory::save().
+    using Buffer = std::vector<uint8_t>;
+
+    //--------------------------------------------------------------------------
+    //! \brief Compute the key of the given planning request.
+    //--------------------------------------------------------------------------
+    static Key key(TrajectoryRequest const& request);
+
+    //--------------------------------------------------------------------------
+    //! \brief Search maneuvers. Thread safe.
+    //! \param[out] buffer: copy of the found maneuvers.
+    //! \return true if found.
+    //--------------------------------------------------------------------------
+    bool find(Key const& key, Buffer& buffer) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Memorize maneuvers and append them to the cache file. Thread
+    //! safe.
+    //--------------------------------------------------------------------------
+    void store(Key const& key, Buffer const& buffer);
+
+    //--------------------------------------------------------------------------
+    //! \brief Remove all entries (in memory and on the disk).
+    //--------------------------------------------------------------------------
+    void clear();
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the number of memorized maneuvers.
+    //--------------------------------------------------------------------------
+    size_t size() const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Add the entries of the given cache file (i.e. the one of the
+    //! previous runs). A truncated entry ends the loading. Thread safe.
+    //! \return false if the file is missing or has an unexpected header.
+    //--------------------------------------------------------------------------
+    bool load(std::string const& path);
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the path of the file memorizing entries between runs.
+    //--------------------------------------------------------------------------
+    inline std::string const& path() const
+    {
+        return m_path;
+    }
+
+private:
+
+    //--------------------------------------------------------------------------
+    //! \brief Load the cache file of the previous runs.
+    //--------------------------------------------------------------------------
+    ManeuverCache();
+
+private:
+
+    //! \brief Path of the file memorizing entries between runs.
+    std::string m_path;
+    //! \brief Memorized maneuvers.
+    std::map<Key, Buffer> m_entries;
+    //! \brief Planners run concurrently.
+    mutable std::mutex m_mutex;
+};
+
+#endif
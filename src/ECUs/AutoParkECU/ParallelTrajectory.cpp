@@ -21,63 +21,87 @@
 
 #include "Vehicle/TurningRadius.hpp"
 #include "Vehicle/Car.hpp"
-#include "Vehicle/ECU.hpp"
 #include "ECUs/AutoParkECU/ParallelTrajectory.hpp"
 #include "Renderer/Renderer.hpp"
 #include <iostream>
 #include <cassert>
+#include <cstring>
+#include <type_traits>
 
-// Reserve enough memory to store all maneuver states while not information are
-// needed to be saved we keep them for the debug.
-static constexpr size_t MAX_MANEUVERS = 64u;
 static constexpr size_t TWO_LAST_TURNS = 2u;
-static_assert(MAX_MANEUVERS > TWO_LAST_TURNS, "Bad value for MAX_MANEUVERS");
+static_assert(ParallelManeuvers::MAX_MANEUVERS > TWO_LAST_TURNS, "Bad value for MAX_MANEUVERS");
+static_assert(std::is_trivially_copyable<ParallelManeuvers>::value,
+              "ParallelManeuvers is stored as it in the ManeuverCache");
+
+// References
+static const MeterPerSecond VMAX = 1.0_mps; // Max speed [m/s]
+static const MeterPerSecondSquared ADES = 1.0_mps_sq; // Desired acceleration [m/s/s]
+
+//------------------------------------------------------------------------------
+std::vector<ParallelTrajectory::Options> const& ParallelTrajectory::candidates()
+{
+    static const std::vector<Options> options = []()
+    {
+        std::vector<Options> v;
+        for (bool const trials: { false, true })
+        {
+            for (Meter const margin: { 0.0_m, 0.2_m })
+            {
+                for (double const steering: { 1.0, 0.9, 0.8 })
+                {
+                    v.push_back({ steering, margin, trials });
+                }
+            }
+        }
+        return v;
+    }();
+
+    return options;
+}
 
 //------------------------------------------------------------------------------
 // See "Easy Path Planning and Robust Control for Automatic Parallel Parking" by
 // Sungwoo CHOI, Clément Boussard, Brigitte d’Andréa-Novel for the detail of the
 // algorithm.
-bool ParallelTrajectory::init(Car& car, Parking const& parking, bool const entering)
+bool ParallelTrajectory::init(TrajectoryRequest const& request)
 {
+    TrajectoryRequest::Ego const& car = request.car;
+
     // We suppose that the parking spot can hold the ego car. This case is
     // supposed to be checked by the caller function (state machine=. If this is not
     // the case please report an issue.
-    assert(car.blueprint.length < parking.blueprint.length &&
+    assert(car.blueprint.length < request.parking.blueprint.length &&
            "The parking length is too small. This case shall have been detected. "
            "Please report this issue.");
 
+    // Keep a margin with the parked cars: maneuvers are computed for a shorter
+    // parking spot having the same center.
+    ParkingBluePrint dimension(request.parking.blueprint);
+    dimension.length -= 2.0 * m_options.margin;
+    if (dimension.length <= car.blueprint.length)
+    {
+        logMessage("Parking spot too short for a margin of ", m_options.margin);
+        return false;
+    }
+    Parking const parking(dimension, request.parking.position() +
+                          math::heading(sf::Vector2<Meter>(m_options.margin, 0.0_m),
+                                        request.parking.axis()),
+                          request.parking.heading());
+
     // More the steering angle is great more the turning radius is short.
     // doc/Parallel/TurningRadiusEq.png
     // R: turning radius. Re: external turning radius. Ri: internal turning radius.
     // \beta (or \delta): the turning angle.
     // e (or L): the wheel base. w: the width. p (or Pf): front overhang.
     // doc/Parallel/TurningRadius.png
-    TurningRadius radius(car.blueprint, car.blueprint.max_steering_angle);
+    steering = m_options.steering * car.blueprint.max_steering_angle;
+    TurningRadius radius(car.blueprint, steering);
     Remin = radius.external;
     Rimin = radius.internal;
     Rwmin = Rimin + car.blueprint.width / 2.0;
     Lmin = car.blueprint.back_overhang + units::math::sqrt(Remin * Remin - Rimin * Rimin);
-    std::cout << "Steermax=" << Degree(car.blueprint.max_steering_angle)
-              << ", Remin=" << Remin << ", Rimin=" << Rimin
-              << ", Rwmin=" << Rwmin << ", Lmin=" << Lmin
-              << std::endl;
     assert(Remin >= Rimin);
 
-    // Reserve memory
-    theta_E.resize(MAX_MANEUVERS);
-    theta_t.resize(MAX_MANEUVERS);
-    theta_p.resize(MAX_MANEUVERS);
-    theta_s.resize(MAX_MANEUVERS);
-    theta_g.resize(MAX_MANEUVERS);
-    theta_sum.resize(MAX_MANEUVERS);
-    Rrg.resize(MAX_MANEUVERS);
-    C.resize(MAX_MANEUVERS);
-    Em.resize(MAX_MANEUVERS);
-
-    // References
-    const MeterPerSecond VMAX = 1.0_mps; // Max speed [m/s]
-    const MeterPerSecondSquared ADES = 1.0_mps_sq; // Desired acceleration [m/s/s]
-
     // Minimum length of the parallel parking length.
     // doc/Parallel/ParallelLeavingCondition.png
     // We use the Pythagorean theorem of the triangle CBA (90° on B) where C
@@ -85,7 +109,7 @@ bool ParallelTrajectory::init(Car& car, Parking const& parking, bool const enter
     // radius Rimin) and A the front-right wheel (external radius Remin). Since
     // the frame of the car body is placed at the center of the back axle, we
     // have to add the back overhang.
-    if (parking.blueprint.length >= Lmin)
+    if ((parking.blueprint.length >= Lmin) && (!m_options.trials))
     {
         // We can park the car in a single trial.
         // doc/Parallel/ParallelFinalStep.png
@@ -113,19 +137,19 @@ bool ParallelTrajectory::init(Car& car, Parking const& parking, bool const enter
 }
 
 //------------------------------------------------------------------------------
-size_t ParallelTrajectory::computePath1Trial(Car const& car, Parking const& parking)
+size_t ParallelTrajectory::computePath1Trial(TrajectoryRequest::Ego const& car, Parking const& parking)
 {
     // doc/Parallel/ParallelFinalStep.png
-    m_ecu.logMessage("1-trial maneuver");
+    logMessage("1-trial maneuver");
 
     // Initial car position: current position of the car
-    auto P = math::heading(car.position(), -car.heading());
-    Xi = P.x; // car.position().x;
-    Yi = P.y; // car.position().y;
+    auto P = math::heading(car.position, -car.heading);
+    Xi = P.x; // car.position.x;
+    Yi = P.y; // car.position.y;
 
     // Final destination: the parking slot
     //std::cout << "Po: " << parking.origin().x << ", " << parking.origin().y << std::endl;
-    P = math::heading({107.618_m, 108.521_m}, -car.heading());//parking.origin(), -car.heading());
+    P = math::heading(parking.origin(), -car.heading);
     Xf = P.x; // parking.origin().x + parking.blueprint.length / 2.0;
     Yf = P.y; // parking.origin().y - car.blueprint.width / 2.0;
 
@@ -144,7 +168,7 @@ size_t ParallelTrajectory::computePath1Trial(Car const& car, Parking const& park
     {
         // To fix this case: we can add a segment line to reach the two circles but who cares
         // since this happens when the car is outside the road.
-        m_ecu.logMessage("Car is too far away on Y-axis (greater than its turning radius)");
+        logMessage("Car is too far away on Y-axis (greater than its turning radius)");
         return 0u;
     }
     Xt = C[0].x + units::math::sqrt(d);
@@ -159,24 +183,15 @@ size_t ParallelTrajectory::computePath1Trial(Car const& car, Parking const& park
     // Minimal central angle for making the turn = atanf((Xt - C[0].x) / (C[0].y - Yt))
     theta_E[1] = theta_E[0] = units::math::atan2(Xt - C[0].x, C[0].y - Yt);
 
-    std::cout << "### 1-trial maneuver ##########################" << std::endl;
-    std::cout << "Initial position: " << Xi << " " << Yi << std::endl;
-    std::cout << "Turning at position: " << Xs << " " << Ys << std::endl;
-    std::cout << "Center 1st turn: " << C[1].x << " " << C[1].y << std::endl;
-    std::cout << "Center 2nd turn: " << C[0].x << " " << C[0].y << std::endl;
-    std::cout << "Touching point: " << Xt << " " << Yt << std::endl;
-    std::cout << "Angle: " << Degree(theta_E[0]) << std::endl;
-    std::cout << "Final position: " << Xf << " " << Yf << std::endl;
-
     return 2u;
 }
 
 //------------------------------------------------------------------------------
 // FIXME https://github.com/Lecrapouille/Highway/issues/27
-size_t ParallelTrajectory::computePathNTrials(Car const& car, Parking const& parking)
+size_t ParallelTrajectory::computePathNTrials(TrajectoryRequest::Ego const& car, Parking const& parking)
 {
     // doc/Parallel/ParallelManeuversEq.png
-    m_ecu.logMessage("N-trial maneuvers");
+    logMessage("N-trial maneuvers");
 
     const Radian PI_2 = 180.0_deg / 2.0; // pi / 2
     const Radian PI3_2 = 3.0 * 180.0_deg / 2.0; // 3 pi / 2
@@ -192,29 +207,26 @@ size_t ParallelTrajectory::computePathNTrials(Car const& car, Parking const& par
     Em[0].y = car.blueprint.width / 2.0;
 
     // Initial position
-    auto P = math::heading(car.position(), -car.heading());
-    Xi = P.x; // car.position().x;
-    Yi = P.y; // car.position().y;
+    auto P = math::heading(car.position, -car.heading);
+    Xi = P.x; // car.position.x;
+    Yi = P.y; // car.position.y;
 
-    // Final position
-    P = math::heading(parking.origin(), -car.heading());
-    Xf = P.x; // parking.origin().x + parking.blueprint.length / 2.0;
-    Yf = P.y; // parking.origin().y - car.blueprint.width / 2.0;
+    // Origin of the relative frame: middle of the bottom side of the parking
+    // spot (the origin of the parking is the middle of its left side).
+    P = math::heading(parking.origin(), -car.heading);
+    Xf = P.x + parking.blueprint.length / 2.0;
+    Yf = P.y - parking.blueprint.width / 2.0;
 
     // Give extra space to avoid the rear overhang of the ego car collides with
     // the parked car back the ego car.
     //const float MARGIN = 0.0; // [meter]
 
-    std::cout << "Parking: " << parking.origin().x << " " << parking.origin().y << std::endl;
-    std::cout << "Xf: " << Xf << " " << Yf << std::endl;
-    std::cout << "Em0: " << Em[0].x << " " << Em[0].y << std::endl;
-
     while (true)
     {
         // Too many maneuvers: abort and try to find another parking spot
         if (i + TWO_LAST_TURNS >= MAX_MANEUVERS)
         {
-            m_ecu.logMessage("Too many maneuvers needed to park (", i,
+            logMessage("Too many maneuvers needed to park (", i,
                              ". max: ", MAX_MANEUVERS, ")");
             return 0u;
         }
@@ -225,8 +237,6 @@ size_t ParallelTrajectory::computePathNTrials(Car const& car, Parking const& par
         // doc/Parallel/ParallelStep1.png
         else if (i == 0u)
         {
-            std::cout << "#############################" << std::endl;
-            std::cout << "Initial maneuver: forward + left" << std::endl;
             C[i].x = Em[i].x;
             C[i].y = Em[i].y + Rwmin;
             theta_t[i] = units::math::asin((parking.blueprint.length / 2.0 - C[i].x) / Remin);
@@ -236,12 +246,6 @@ size_t ParallelTrajectory::computePathNTrials(Car const& car, Parking const& par
             Em[i + 1].x = C[i].x + Rwmin * units::math::cos(theta_sum[i] + PI3_2);
             Em[i + 1].y = C[i].y + Rwmin * units::math::sin(theta_sum[i] + PI3_2);
 
-            std::cout << "C" << i+1 << ": " << C[i].x << " " << C[i].y << std::endl;
-            std::cout << "Em" << i+1 << ": " << Em[i + 1].x << " " << Em[i + 1].y << std::endl;
-            std::cout << "ThetaT" << i+1 << ": " << theta_t[i] << std::endl;
-            std::cout << "ThetaS" << i+1 << ": " << theta_s[i] << std::endl;
-            std::cout << "ThetaE" << i+1 << ": " << theta_E[i] << std::endl;
-
             i += 1u;
         }
 
@@ -250,8 +254,6 @@ size_t ParallelTrajectory::computePathNTrials(Car const& car, Parking const& par
         // doc/Parallel/ParallelStep2.png
         else if ((i & 1) == 0)
         {
-            std::cout << "#############################" << std::endl;
-            std::cout << "Even iteration: forward + left" << std::endl;
             C[i].x = 2.0 * Em[i].x - C[i - 1].x;
             C[i].y = 2.0 * Em[i].y - C[i - 1].y;
             theta_t[i] = units::math::asin((parking.blueprint.length / 2.0 - C[i].x) / Remin);
@@ -261,12 +263,6 @@ size_t ParallelTrajectory::computePathNTrials(Car const& car, Parking const& par
             Em[i + 1].x = C[i].x + Rwmin * units::math::cos(theta_sum[i] + PI3_2);
             Em[i + 1].y = C[i].y + Rwmin * units::math::sin(theta_sum[i] + PI3_2);
 
-            std::cout << "C" << i+1 << ": " << C[i].x << " " << C[i].y << std::endl;
-            std::cout << "Em" << i+1 << ": " << Em[i + 1].x << " " << Em[i + 1].y << std::endl;
-            std::cout << "ThetaT" << i+1 << ": " << theta_t[i] << std::endl;
-            std::cout << "ThetaS" << i+1 << ": " << theta_s[i] << std::endl;
-            std::cout << "ThetaE" << i+1 << ": " << theta_E[i] << std::endl;
-
             // Can the ego car escape from the parking spot ? Meaning if the
             // Y position of the colliding point with the front parked car is
             // greater than the width of the parking spot ?
@@ -275,11 +271,9 @@ size_t ParallelTrajectory::computePathNTrials(Car const& car, Parking const& par
             Meter y = C[i].y;
 
             const auto w = units::math::pow<2>(Remin) - units::math::pow<2>((parking.blueprint.length / 2.0) - x);
-            std::cout << "Can leave ? " << (y - units::math::sqrt(w)) << " > " << parking.blueprint.width << "?" << std::endl;
-            std::cout << "Putain C.x=" << x << ", C.y=" << y << ", Remin=" << Remin << std::endl;
             if ((w.value() >= 0.0) && (y - units::math::sqrt(w) > parking.blueprint.width))
             {
-                m_ecu.logMessage("Can leave!!!!");
+                logMessage("Can leave!!!!");
                 break;
             }
 
@@ -292,12 +286,9 @@ size_t ParallelTrajectory::computePathNTrials(Car const& car, Parking const& par
         // doc/Parallel/Rrg.png
         else // if ((i & 1) == 1)
         {
-            std::cout << "#############################" << std::endl;
-            std::cout << "Even iteration: backward + right" << std::endl;
             C[i].x = 2.0 * Em[i].x - C[i - 1].x;
             C[i].y = 2.0 * Em[i].y - C[i - 1].y;
             Rrg[i] = units::math::sqrt(units::math::pow<2>(car.blueprint.back_overhang) + units::math::pow<2>(Rimin + car.blueprint.width));
-            std::cout << (Rimin + car.blueprint.width) / Rrg[i] << ", " << (C[i].x + parking.blueprint.length / 2.0) / Rrg[i] << std::endl;
             theta_p[i] = units::math::acos((Rimin + car.blueprint.width) / Rrg[i]);
             theta_g[i] = units::math::acos((C[i].x + parking.blueprint.length / 2.0) / Rrg[i]);
             theta_E[i] = PI_2 - theta_sum[i - 1] - theta_p[i] - theta_g[i];
@@ -305,12 +296,6 @@ size_t ParallelTrajectory::computePathNTrials(Car const& car, Parking const& par
             Em[i + 1].x = C[i].x + Rwmin * units::math::cos(theta_sum[i] + PI_2);
             Em[i + 1].y = C[i].y + Rwmin * units::math::sin(theta_sum[i] + PI_2);
 
-            std::cout << "Rrg" << i+1 << ": " << Rrg[i] << std::endl;
-            std::cout << "C" << i+1 << ": " << C[i].x << " " << C[i].y << std::endl;
-            std::cout << "Em" << i+1 << ": " << Em[i + 1].x << " " << Em[i + 1].y << std::endl;
-            std::cout << "ThetaP" << i+1 << ": " << theta_p[i] << std::endl;
-            std::cout << "ThetaG" << i+1 << ": " << theta_g[i] << std::endl;
-            std::cout << "ThetaE" << i+1 << ": " << theta_E[i] << std::endl;
             i += 1u;
         }
     }
@@ -318,8 +303,6 @@ size_t ParallelTrajectory::computePathNTrials(Car const& car, Parking const& par
     // Last turn for leaving the parking spot and last turn to
     // horizontalize to the road. This code is the same than computePath1trial()
     // doc/Parallel/ParallelFinalStep.png
-    std::cout << "#############################" << std::endl;
-    std::cout << "Final iteration: Two last final turns" << std::endl;
     C[i].x = 2.0 * Em[i].x - C[i - 1].x;
     C[i].y = 2.0 * Em[i].y - C[i - 1].y;
     C[i + 1].y = (Yi - Yf) - Rwmin;
@@ -327,7 +310,7 @@ size_t ParallelTrajectory::computePathNTrials(Car const& car, Parking const& par
     const auto d = units::math::pow<2>(Rwmin) - units::math::pow<2>(Yt - C[i].y);
     if (d.value() < 0.0)
     {
-        m_ecu.logMessage("Car is too far away on Y-axis (greater than its turning radius)");
+        logMessage("Car is too far away on Y-axis (greater than its turning radius)");
         return 0u;
     }
     Xt = C[i].x + units::math::sqrt(d);
@@ -336,9 +319,6 @@ size_t ParallelTrajectory::computePathNTrials(Car const& car, Parking const& par
     theta_E[i + 1] = units::math::atan2(Xt - C[i].x, C[i].y - Yt); // Final angle
     theta_E[i] = theta_E[i + 1] - theta_sum[i - 1];
 
-    std::cout << "ThetaEn-1: " << Degree(theta_E[i]) << std::endl;
-    std::cout << "ThetaEn: " << Degree(theta_E[i+1]) << std::endl;
-
     // From relative coordinates to real world coordinates
     for (auto& it: Em)
     {
@@ -356,28 +336,13 @@ size_t ParallelTrajectory::computePathNTrials(Car const& car, Parking const& par
     Xf = parking.origin().x;
     Yf = parking.origin().y;
 
-    std::cout << "Em0: " << Em[0].x << ", " << Em[0].y << std::endl;
-    std::cout << "Em1: " << Em[1].x << ", " << Em[1].y << std::endl;
-    std::cout << "Em2: " << Em[2].x << ", " << Em[2].y << std::endl;
-
-    std::cout << "#############################" << std::endl;
-    std::cout << "Initial position: " << Xi << " " << Yi << std::endl;
-    std::cout << "Turning at position: " << Xs << " " << Ys << std::endl;
-    std::cout << "Center 1st turn: " << C[3].x << " " << C[3].y << std::endl;
-    std::cout << "Center 2nd turn: " << C[2].x << " " << C[2].y << std::endl;
-    std::cout << "Center 3th turn: " << C[1].x << " " << C[1].y << std::endl;
-    std::cout << "Center 4th turn: " << C[0].x << " " << C[0].y << std::endl;
-    std::cout << "Touching point: " << Xt << " " << Yt << std::endl;
-    std::cout << "Angle: " << Degree(theta_E[2]) << std::endl;
-    std::cout << "Final position: " << Xf << " " << Yf << std::endl;
-
     return i + TWO_LAST_TURNS;
 }
 
 //------------------------------------------------------------------------------
 // doc/Parallel/SpeedReferences.png
 // doc/Parallel/SteeringReferences.png
-void ParallelTrajectory::generateReferences(Car const& car, Parking const& parking,
+void ParallelTrajectory::generateReferences(TrajectoryRequest::Ego const& car, Parking const& parking,
                                             MeterPerSecond const VMAX, MeterPerSecondSquared const ADES)
 {
     // Duration to turn front wheels to the maximal angle [s]
@@ -417,7 +382,7 @@ void ParallelTrajectory::generateReferences(Car const& car, Parking const& parki
 
     // Stop the car to make turn wheels
     m_speeds.add(0.0_mps, DURATION_TO_TURN_WHEELS);
-    m_steerings.add(car.blueprint.max_steering_angle, DURATION_TO_TURN_WHEELS);
+    m_steerings.add(steering, DURATION_TO_TURN_WHEELS);
 
     // Turning circles: Consome path starting from the latest
     size_t i = m_maneuvers;
@@ -429,38 +394,34 @@ void ParallelTrajectory::generateReferences(Car const& car, Parking const& parki
         // Lastest turn to make the ego car parallel to the road
         if (i == m_maneuvers - 1u)
         {
-            std::cout << "T111: " << t << std::endl;
             m_speeds.add(-VMAX, t);
-            m_steerings.add(-car.blueprint.max_steering_angle, t);
+            m_steerings.add(-steering, t);
         }
 
         // Lastest turn to leave the parking spot
         else if (i == m_maneuvers - 2u)
         {
-            std::cout << "T222: " << t << std::endl;
             m_speeds.add(-VMAX, t);
-            m_steerings.add(car.blueprint.max_steering_angle, t);
+            m_steerings.add(steering, t);
         }
 
         // Driving forward while turning to the left
         else if ((i & 1) == 0)
         {
-            std::cout << "T333: " << t << std::endl;
             m_speeds.add(-VMAX, t);
-            m_steerings.add(car.blueprint.max_steering_angle, t);
+            m_steerings.add(steering, t);
         }
 
         // Driving backward while turning to the right
         else
         {
-            std::cout << "T444: " << t << std::endl;
             m_speeds.add(VMAX, t);
-            m_steerings.add(-car.blueprint.max_steering_angle, t);
+            m_steerings.add(-steering, t);
         }
 
         // Stop the car to make turn wheels
         m_speeds.add(0.0_mps, DURATION_TO_TURN_WHEELS);
-        m_steerings.add(car.blueprint.max_steering_angle, DURATION_TO_TURN_WHEELS);
+        m_steerings.add(steering, DURATION_TO_TURN_WHEELS);
     }
 
     // Centering the car inside its parking spot
@@ -473,6 +434,65 @@ void ParallelTrajectory::generateReferences(Car const& car, Parking const& parki
     m_steerings.add(0.0_deg, 0.0_s);
 }
 
+//------------------------------------------------------------------------------
+void ParallelManeuvers::translate(sf::Vector2<Meter> const& offset)
+{
+    for (auto& it: Em)
+    {
+        it += offset;
+    }
+    for (auto& it: C)
+    {
+        it += offset;
+    }
+    Xs += offset.x; Ys += offset.y;
+    Xi += offset.x; Yi += offset.y;
+    Xf += offset.x; Yf += offset.y;
+    Xt += offset.x; Yt += offset.y;
+}
+
+//------------------------------------------------------------------------------
+sf::Vector2<Meter> ParallelTrajectory::frame(TrajectoryRequest const& request)
+{
+    return math::heading(request.parking.origin(), -request.car.heading);
+}
+
+//------------------------------------------------------------------------------
+bool ParallelTrajectory::save(TrajectoryRequest const& request,
+                              std::vector<uint8_t>& buffer) const
+{
+    ParallelManeuvers maneuvers(*this);
+    maneuvers.translate(-frame(request));
+
+    buffer.resize(sizeof(ParallelManeuvers));
+    std::memcpy(buffer.data(), &maneuvers, sizeof(ParallelManeuvers));
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool ParallelTrajectory::load(TrajectoryRequest const& request,
+                              std::vector<uint8_t> const& buffer)
+{
+    if (buffer.size() != sizeof(ParallelManeuvers))
+        return false;
+
+    ParallelManeuvers& maneuvers = *this;
+    std::memcpy(&maneuvers, buffer.data(), sizeof(ParallelManeuvers));
+    maneuvers.translate(frame(request));
+
+    // The cache key is quantized: the restored turns, Yi and Ys come from the
+    // same cached start pose and are kept together. Only the longitudinal
+    // start position is restored from the exact car position: the car drives
+    // straight to the first turn, so only the duration of the first segment
+    // of the references changes. The lateral offset (within the quantum) is
+    // left to the tracking controller.
+    Xi = math::heading(request.car.position, -request.car.heading).x;
+
+    logMessage(m_maneuvers, "-trial maneuvers restored from the cache");
+    generateReferences(request.car, request.parking, VMAX, ADES);
+    return true;
+}
+
 //------------------------------------------------------------------------------
 void ParallelTrajectory::draw(sf::RenderTarget& target, sf::RenderStates states) const
 {
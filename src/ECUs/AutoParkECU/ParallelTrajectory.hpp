@@ -24,18 +24,90 @@
 #  define PARALLEL_TRAJECTORY_HPP
 
 #  include "ECUs/AutoParkECU/Trajectory.hpp"
+#  include <array>
+
+// *****************************************************************************
+//! \brief Geometry of the maneuvers of the parallel parking. Arrays are
+//! preallocated and the structure is trivially copyable: it is stored as it
+//! in the ManeuverCache.
+// *****************************************************************************
+struct ParallelManeuvers
+{
+    //! \brief Reserve enough memory to store all maneuver states while not
+    //! information are needed to be saved we keep them for the debug.
+    static constexpr size_t MAX_MANEUVERS = 64u;
+
+    //--------------------------------------------------------------------------
+    //! \brief Translate all positions.
+    //--------------------------------------------------------------------------
+    void translate(sf::Vector2<Meter> const& offset);
+
+    //! \brief Minimal turning radius for the internal point of the car.
+    Meter Rimin;
+    //! \brief Minimal turning radius for the external point of the car.
+    Meter Remin;
+    //! \brief Minimal turning radius for the external point of the car.
+    Meter Rwmin;
+    //! \brief Minimal turning radius for the external point of the car.
+    Meter Lmin;
+    //! \brief Steering angle of the front wheels used for turning.
+    Radian steering;
+    //! \brief Number needed of maneuvers for parking the car (change of gear)
+    size_t m_maneuvers = 0u;
+    //! \brief X-Y world coordinates of the middle rear axle of the ego car.
+    std::array<sf::Vector2<Meter>, MAX_MANEUVERS> Em;
+    //! \brief X-Y world coordinates of the immedite center of rotations.
+    std::array<sf::Vector2<Meter>, MAX_MANEUVERS> C;
+    Meter Xs, Ys, Xi, Yi, Xf, Yf, Xt, Yt;
+    //! \brief
+    std::array<Radian, MAX_MANEUVERS> theta_E, theta_t, theta_s, theta_p, theta_g, theta_sum;
+    std::array<Meter, MAX_MANEUVERS> Rrg;
+};
 
 // *****************************************************************************
 //! \brief Compute the trajectory allowing the car to park. For parallel parking
 //! only!
 // *****************************************************************************
-class ParallelTrajectory: public CarTrajectory
+class ParallelTrajectory: public CarTrajectory, private ParallelManeuvers
 {
 public:
 
-    ParallelTrajectory(ECU& ecu) : m_ecu(ecu) {}
-    virtual bool init(Car& car, Parking const& parking, bool const entering) override;
+    // *************************************************************************
+    //! \brief Variant of the maneuvers. Several candidates are computed and the
+    //! TrajectoryPlanner keeps the cheapest one.
+    // *************************************************************************
+    struct Options
+    {
+        //! \brief Ratio of the maximum steering angle used for turning. Lower
+        //! ratios give larger turns, smoother but needing more space.
+        double steering = 1.0;
+        //! \brief Distance kept to the cars parked in front and back of the
+        //! parking spot [meter].
+        Meter margin = 0.0_m;
+        //! \brief Use N-trial maneuvers even if a single trial is possible.
+        bool trials = false;
+    };
+
+public:
+
+    ParallelTrajectory()
+        : m_options()
+    {}
+
+    ParallelTrajectory(Options const& options)
+        : m_options(options)
+    {}
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the variants of maneuvers to evaluate. The first one is
+    //! the nominal maneuver (maximum steering, no margin).
+    //--------------------------------------------------------------------------
+    static std::vector<Options> const& candidates();
+
+    virtual bool init(TrajectoryRequest const& request) override;
     virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+    virtual bool save(TrajectoryRequest const& request, std::vector<uint8_t>& buffer) const override;
+    virtual bool load(TrajectoryRequest const& request, std::vector<uint8_t> const& buffer) override;
 
 private:
 
@@ -46,7 +118,7 @@ private:
     //! - Step: ../../../doc/pics/ParallelFinalStep.png
     //! Equations: ../../../doc/pics/ParallelManeuversEq.png
     //--------------------------------------------------------------------------
-    size_t computePath1Trial(Car const& car, Parking const& parking);
+    size_t computePath1Trial(TrajectoryRequest::Ego const& car, Parking const& parking);
 
     //--------------------------------------------------------------------------
     //! \brief Compute the trajectory path when the car needs N maneuvers
@@ -57,37 +129,26 @@ private:
     //! - Final Step: ../../../doc/pics/ParallelFinalStep.png
     //! Equations: ../../../doc/pics/ParallelManeuversEq.png
     //--------------------------------------------------------------------------
-    size_t computePathNTrials(Car const& car, Parking const& parking);
+    size_t computePathNTrials(TrajectoryRequest::Ego const& car, Parking const& parking);
 
     //--------------------------------------------------------------------------
     //! \brief Generate ramp of speed, acceleration and angle of the wheel.
     //! \param[in] VMAX: max speed [m/s]
     //! \param[in] ADES: desired acceleration [m/s/s]
     //--------------------------------------------------------------------------
-    void generateReferences(Car const& car, Parking const& parking,
+    void generateReferences(TrajectoryRequest::Ego const& car, Parking const& parking,
                             MeterPerSecond const VMAX, MeterPerSecondSquared const ADES);
+
+    //--------------------------------------------------------------------------
+    //! \brief Origin of the frame used for computing maneuvers: the parking
+    //! origin in the frame of the car.
+    //--------------------------------------------------------------------------
+    static sf::Vector2<Meter> frame(TrajectoryRequest const& request);
+
 private:
 
-    //! \brief Needed for sending messages to the GUI.
-    ECU& m_ecu;
-    //! \brief Minimal turning radius for the internal point of the car.
-    Meter Rimin;
-    //! \brief Minimal turning radius for the external point of the car.
-    Meter Remin;
-    //! \brief Minimal turning radius for the external point of the car.
-    Meter Rwmin;
-    //! \brief Minimal turning radius for the external point of the car.
-    Meter Lmin;
-    //! \brief Number needed of maneuvers for parking the car (change of gear)
-    size_t m_maneuvers = 0u;
-    //! \brief X-Y world coordinates of the middle rear axle of the ego car.
-    std::vector<sf::Vector2<Meter>> Em;
-    //! \brief X-Y world coordinates of the immedite center of rotations.
-    std::vector<sf::Vector2<Meter>> C;
-    Meter Xs, Ys, Xi, Yi, Xf, Yf, Xt, Yt;
-    //! \brief
-    std::vector<Radian> theta_E, theta_t, theta_s, theta_p, theta_g, theta_sum;
-    std::vector<Meter> Rrg;
+    //! \brief Variant of the maneuvers.
+    Options m_options;
 };
 
 #endif
@@ -0,0 +1,228 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "ECUs/AutoParkECU/ParkingSpotMap.hpp"
+#include <algorithm>
+#include <iterator>
+
+//! \brief Maximal angle between the car and the kerb axis for reusing the map.
+static const Radian ALIGNMENT_ANGLE = 5.0_deg;
+//! \brief Maximal distance between the car and the kerb axis for reusing the
+//! map.
+static const Meter ALIGNMENT_DISTANCE = 1.0_m;
+
+//------------------------------------------------------------------------------
+void ParkingSpotMap::reset(sf::Vector2<Meter> const& origin, Radian const heading,
+                           bool const right)
+{
+    m_origin = origin;
+    m_heading = heading;
+    m_right = right;
+    m_intervals.clear();
+}
+
+//------------------------------------------------------------------------------
+bool ParkingSpotMap::aligned(sf::Vector2<Meter> const& position,
+                             Radian const heading, bool const right) const
+{
+    if (right != m_right)
+        return false;
+
+    if (units::math::cos(heading - m_heading) < units::math::cos(ALIGNMENT_ANGLE))
+        return false;
+
+    // Distance to the kerb axis.
+    Meter const lateral = (position.y - m_origin.y) * units::math::cos(m_heading)
+                        - (position.x - m_origin.x) * units::math::sin(m_heading);
+    return units::math::abs(lateral) <= ALIGNMENT_DISTANCE;
+}
+
+//------------------------------------------------------------------------------
+Meter ParkingSpotMap::abscissa(sf::Vector2<Meter> const& position) const
+{
+    return (position.x - m_origin.x) * units::math::cos(m_heading)
+         + (position.y - m_origin.y) * units::math::sin(m_heading);
+}
+
+//------------------------------------------------------------------------------
+sf::Vector2<Meter> ParkingSpotMap::position(Meter const s, Meter const offset) const
+{
+    // Normal to the kerb axis, pointing to the kerb.
+    double const side = m_right ? -1.0 : 1.0;
+    double const c = units::math::cos(m_heading);
+    double const n = units::math::sin(m_heading);
+
+    return sf::Vector2<Meter>(m_origin.x + s * c - side * offset * n,
+                              m_origin.y + s * n + side * offset * c);
+}
+
+//------------------------------------------------------------------------------
+Parking ParkingSpotMap::parking(Spot const& spot, Meter const width) const
+{
+    // TODO Missing detection of the type of parking type.
+    // https://github.com/Lecrapouille/Highway/issues/32
+    ParkingBluePrint const dim(spot.length(), width, 0.0_deg);
+
+    // Like City::addParking(), parkings are oriented by the opposite of the
+    // road heading.
+    return Parking(dim, position(spot.start, 0.5 * width), -m_heading);
+}
+
+//------------------------------------------------------------------------------
+void ParkingSpotMap::split(Meter const s)
+{
+    auto it = m_intervals.upper_bound(s);
+    if (it == m_intervals.begin())
+        return ;
+
+    --it;
+    if ((it->first < s) && (s < it->second.end))
+    {
+        m_intervals.emplace_hint(std::next(it), s, it->second);
+        it->second.end = s;
+    }
+}
+
+//------------------------------------------------------------------------------
+ParkingSpotMap::Intervals::iterator ParkingSpotMap::merge(Intervals::iterator it)
+{
+    if ((it == m_intervals.begin()) || (it == m_intervals.end()))
+        return it;
+
+    auto prev = std::prev(it);
+    if ((prev->second.end == it->first) &&
+        (prev->second.free == it->second.free) &&
+        (prev->second.confidence == it->second.confidence))
+    {
+        prev->second.end = it->second.end;
+        m_intervals.erase(it);
+        return prev;
+    }
+
+    return it;
+}
+
+//------------------------------------------------------------------------------
+void ParkingSpotMap::observe(Meter from, Meter to, bool const free)
+{
+    // The car may drive backward.
+    if (to < from)
+    {
+        std::swap(from, to);
+    }
+    if (!(from < to))
+        return ;
+
+    // Intervals overlapping [from, to] are now starting or ending exactly at
+    // from and to.
+    split(from);
+    split(to);
+
+    Meter s = from;
+    auto it = m_intervals.lower_bound(from);
+    while (s < to)
+    {
+        if ((it == m_intervals.end()) || (s < it->first))
+        {
+            // Unknown place: add a new interval up to the next known one.
+            Meter const end = ((it == m_intervals.end()) || (to < it->first))
+                            ? to : it->first;
+            it = m_intervals.emplace_hint(it, s, Interval{ end, free, 1u });
+        }
+        else if (it->second.free == free)
+        {
+            // Known place confirmed.
+            it->second.confidence += 1u;
+        }
+        else if (--it->second.confidence == 0u)
+        {
+            // Known place contradicted too many times (i.e. a parked vehicle
+            // has left).
+            it->second.free = free;
+            it->second.confidence = 1u;
+        }
+
+        s = it->second.end;
+        it = std::next(merge(it));
+    }
+
+    // Merge the interval following the observation.
+    merge(it);
+}
+
+//------------------------------------------------------------------------------
+ParkingSpotMap::Interval const* ParkingSpotMap::at(Meter const s) const
+{
+    auto it = m_intervals.upper_bound(s);
+    if (it == m_intervals.begin())
+        return nullptr;
+
+    --it;
+    return (s < it->second.end) ? &it->second : nullptr;
+}
+
+//------------------------------------------------------------------------------
+bool ParkingSpotMap::find(Meter const from, Meter const to, Meter const length,
+                          Meter const open_length, Spot& spot) const
+{
+    // Iterate on intervals from the car to the back.
+    auto it = m_intervals.upper_bound(to);
+    while (it != m_intervals.begin())
+    {
+        --it;
+        if (!(from < it->second.end))
+            return false;
+
+        if (!it->second.free || (it->first < from))
+            continue ;
+
+        // Adjacent free intervals differing by their confidence are not
+        // merged: extend the spot backward over the whole free run.
+        auto const last = it;
+        uint32_t confidence = it->second.confidence;
+        while (it != m_intervals.begin())
+        {
+            auto const prev = std::prev(it);
+            if (!prev->second.free || (prev->second.end != it->first) || (prev->first < from))
+                break;
+            it = prev;
+            confidence = std::min(confidence, it->second.confidence);
+        }
+
+        // The spot is closed when a parked vehicle has been detected after it.
+        Interval const& interval = last->second;
+        auto next = std::next(last);
+        bool const closed = !(to < interval.end) && (next != m_intervals.end()) &&
+                            !next->second.free && (next->first == interval.end);
+        Meter const end = units::math::min(interval.end, to);
+        Meter const spot_length = end - it->first;
+        if ((spot_length >= open_length) || (closed && (spot_length > length)))
+        {
+            spot.start = it->first;
+            spot.end = units::math::min(end, it->first + open_length);
+            spot.confidence = confidence;
+            spot.closed = closed;
+            return true;
+        }
+    }
+
+    return false;
+}
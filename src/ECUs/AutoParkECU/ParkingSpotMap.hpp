@@ -0,0 +1,192 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef PARKING_SPOT_MAP_HPP
+#  define PARKING_SPOT_MAP_HPP
+
+#  include "City/Parking.hpp"
+#  include <SFML/System/Vector2.hpp>
+#  include <map>
+#  include <cstdint>
+
+// *****************************************************************************
+//! \brief Persistent map of free and occupied intervals along the kerb, updated
+//! incrementally by the antenna sensor while the ego car drives along parked
+//! cars. Positions are curvilinear abscissas along the kerb axis (a straight
+//! line defined by the car pose when the map was reset). Each interval counts
+//! how many times it has been confirmed (confidence); a contradicting
+//! observation decreases the confidence and, once null, flips the interval.
+//! Intervals are sorted by their start abscissa, so queries by position are
+//! O(log n). Unobserved places are not stored (unknown).
+// *****************************************************************************
+class ParkingSpotMap
+{
+public:
+
+    // *************************************************************************
+    //! \brief Observed part of the kerb.
+    // *************************************************************************
+    struct Interval
+    {
+        //! \brief Curvilinear abscissa of the end of the interval.
+        Meter end;
+        //! \brief Free space (true) or parked vehicle (false).
+        bool free;
+        //! \brief Number of consistent observations.
+        uint32_t confidence;
+    };
+
+    // *************************************************************************
+    //! \brief Candidate parking spot.
+    // *************************************************************************
+    struct Spot
+    {
+        //! \brief Curvilinear abscissa of the beginning of the spot.
+        Meter start;
+        //! \brief Curvilinear abscissa of the end of the spot.
+        Meter end;
+        //! \brief Lowest confidence of the free intervals holding the spot.
+        uint32_t confidence;
+        //! \brief Is the spot followed by a parked vehicle ?
+        bool closed;
+
+        inline Meter length() const { return end - start; }
+    };
+
+    //! \brief Map of intervals indexed by their start abscissa.
+    using Intervals = std::map<Meter, Interval>;
+
+public:
+
+    //--------------------------------------------------------------------------
+    //! \brief Remove all observations and define a new kerb axis.
+    //! \param[in] origin: position of the car in world coordinates.
+    //! \param[in] heading: direction of the kerb (car heading).
+    //! \param[in] right: true if the kerb is on the right side of the car.
+    //--------------------------------------------------------------------------
+    void reset(sf::Vector2<Meter> const& origin, Radian const heading, bool const right);
+
+    //--------------------------------------------------------------------------
+    //! \brief Remove all observations but keep the kerb axis.
+    //--------------------------------------------------------------------------
+    inline void clear()
+    {
+        m_intervals.clear();
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Is the car driving along the kerb axis of this map ? If not the
+    //! map shall be reset.
+    //--------------------------------------------------------------------------
+    bool aligned(sf::Vector2<Meter> const& position, Radian const heading,
+                 bool const right) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Curvilinear abscissa of the projection of the given world
+    //! position on the kerb axis.
+    //--------------------------------------------------------------------------
+    Meter abscissa(sf::Vector2<Meter> const& position) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief World position of the given curvilinear abscissa, shifted by the
+    //! given distance toward the kerb.
+    //--------------------------------------------------------------------------
+    sf::Vector2<Meter> position(Meter const s, Meter const offset) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Direction of the kerb axis.
+    //--------------------------------------------------------------------------
+    inline Radian heading() const
+    {
+        return m_heading;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Add the observation of the sensor while the car was driving
+    //! between the two given abscissas. O(log n) plus the number of intervals
+    //! overlapped.
+    //! \param[in] free: true if no vehicle has been detected.
+    //--------------------------------------------------------------------------
+    void observe(Meter from, Meter to, bool const free);
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the interval holding the given abscissa or nullptr if the
+    //! place is unknown. O(log n).
+    //--------------------------------------------------------------------------
+    Interval const* at(Meter const s) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Search the nearest spot before the given abscissa (the car has
+    //! to be after the spot for parking). A run of adjacent free intervals
+    //! (whatever their confidence) is a spot if it is longer than \c length
+    //! and followed by a parked vehicle, or if it is longer than \c
+    //! open_length. Spots are truncated to \c open_length.
+    //! O(log n) plus the number of intervals inside [from, to].
+    //! \param[in] from: spots shall not start before this abscissa.
+    //! \param[in] to: spots shall not end after this abscissa (i.e. the car
+    //! position).
+    //! \param[out] spot: the found spot.
+    //! \return true if a spot has been found.
+    //--------------------------------------------------------------------------
+    bool find(Meter const from, Meter const to, Meter const length,
+              Meter const open_length, Spot& spot) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Make the parallel parking slot covering the given spot, placed
+    //! along the kerb axis.
+    //! \param[in] width: width of the parking slot.
+    //--------------------------------------------------------------------------
+    Parking parking(Spot const& spot, Meter const width) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return all observed intervals.
+    //--------------------------------------------------------------------------
+    inline Intervals const& intervals() const
+    {
+        return m_intervals;
+    }
+
+private:
+
+    //--------------------------------------------------------------------------
+    //! \brief Make an interval start at the given abscissa (if known).
+    //--------------------------------------------------------------------------
+    void split(Meter const s);
+
+    //--------------------------------------------------------------------------
+    //! \brief Merge the interval with the previous one if they are adjacent
+    //! and identical.
+    //--------------------------------------------------------------------------
+    Intervals::iterator merge(Intervals::iterator it);
+
+private:
+
+    //! \brief Observed intervals sorted by start abscissa.
+    Intervals m_intervals;
+    //! \brief Origin of the kerb axis in world coordinates.
+    sf::Vector2<Meter> m_origin = sf::Vector2<Meter>(0.0_m, 0.0_m);
+    //! \brief Direction of the kerb axis.
+    Radian m_heading = 0.0_rad;
+    //! \brief Is the kerb on the right side of the car ?
+    bool m_right = true;
+};
+
+#endif
@@ -21,15 +21,32 @@
 
 #include "ECUs/AutoParkECU/Trajectory.hpp"
 #include "ECUs/AutoParkECU/ParallelTrajectory.hpp"
-//#include "SelfParking/DiagonalTrajectory.hpp"
-//#include "SelfParking/PerpendicularTrajectory.hpp"
+#include "ECUs/AutoParkECU/HybridAStarTrajectory.hpp"
 #include "Vehicle/Car.hpp"
 
+//------------------------------------------------------------------------------
+TrajectoryRequest::TrajectoryRequest(Car const& car_, Parking const& parking_,
+                                     bool const entering_)
+    : car({car_.blueprint, car_.position(), car_.heading()}),
+      parking(parking_), entering(entering_)
+{}
+
 //------------------------------------------------------------------------------
 bool CarTrajectory::update(Car& car, Second const dt)
 {
     m_time += dt;
 
+    // Closed-loop tracking of the geometric path.
+    if (!m_tracking_path.empty())
+    {
+        if (!m_tracking)
+        {
+            car.track(m_tracking_path);
+            m_tracking = true;
+        }
+        return car.tracking();
+    }
+
     if (USE_KINEMATIC) // FIXME
     {
         // doc/Parallel/SpeedReferences.png
@@ -51,30 +68,87 @@ bool CarTrajectory::update(Car& car, Second const dt)
 }
 
 //------------------------------------------------------------------------------
-CarTrajectory::Ptr CarTrajectory::create(ECU& ecu, Parking::Type const type)
+void CarTrajectory::computeTrackingPath(TrajectoryRequest::Ego const& car)
+{
+    // Integration step [s] and distance between two points of the path [m].
+    const Second dt = 0.01_s;
+    const double spacing = 0.05;
+
+    // Copy references to not alter their playback cursors.
+    References<MeterPerSecond> speeds(m_speeds);
+    References<Radian> steerings(m_steerings);
+
+    m_tracking_path.clear();
+    m_tracking = false;
+
+    // Same equations than TricycleKinematic.
+    const double wheelbase = car.blueprint.wheelbase.value();
+    double x = car.position.x.value();
+    double y = car.position.y.value();
+    double heading = car.heading.value();
+    double travelled = 0.0; // since the last point of the path
+    int direction = 0;
+    MeterPerSecond previous = 0.0_mps;
+
+    m_tracking_path.push_back({ car.position, car.heading, 0.0_mps });
+    for (Second t = 0.0_s; !speeds.end(t); t += dt)
+    {
+        const MeterPerSecond v = speeds.get(t);
+        const int d = (v > 0.0_mps) ? 1 : ((v < 0.0_mps) ? -1 : 0);
+        if (d == 0)
+            continue;
+
+        if (direction == 0)
+        {
+            // Direction of the first motion.
+            m_tracking_path[0].speed = v;
+        }
+        else if ((d != direction) && (travelled > 0.0))
+        {
+            // Change of direction: the current pose ends the previous segment.
+            m_tracking_path.push_back({ { Meter(x), Meter(y) }, Radian(heading), previous });
+            travelled = 0.0;
+        }
+
+        const double vdt = v.value() * dt.value();
+        heading += vdt * std::tan(steerings.get(t).value()) / wheelbase;
+        x += vdt * std::cos(heading);
+        y += vdt * std::sin(heading);
+        travelled += std::abs(vdt);
+        direction = d;
+        previous = v;
+
+        if (travelled >= spacing)
+        {
+            m_tracking_path.push_back({ { Meter(x), Meter(y) }, Radian(heading), v });
+            travelled = 0.0;
+        }
+    }
+
+    // End of the path.
+    if (travelled > 0.0)
+    {
+        m_tracking_path.push_back({ { Meter(x), Meter(y) }, Radian(heading), previous });
+    }
+
+    if (m_tracking_path.size() < 2u)
+    {
+        m_tracking_path.clear();
+    }
+}
+
+//------------------------------------------------------------------------------
+CarTrajectory::Ptr CarTrajectory::create(Parking::Type const type)
 {
-    std::cout << "CarTrajectory::create\n";
     switch (type)
     {
     case Parking::Type::Parallel:
-        std::cout << "CarTrajectory::create Parallel\n";
-        return std::make_unique<ParallelTrajectory>(ecu);
+        return std::make_unique<ParallelTrajectory>();
     case Parking::Type::Perpendicular:
-        // FIXME https://github.com/Lecrapouille/Highway/issues/33
-        // return std::make_unique<PerpTrajectory>();
-        assert(false && "Not yet implemented");
-        break;
     case Parking::Type::Diagonal45:
     case Parking::Type::Diagonal60:
     case Parking::Type::Diagonal75:
-        // FIXME https://github.com/Lecrapouille/Highway/issues/33
-        // return std::make_unique<DiagonalTrajectory>();
-        assert(false && "Not yet implemented");
-        break;
     default:
-        assert(false && "Not yet implemented");
-        break;
+        return std::make_unique<HybridAStarTrajectory>();
     }
-
-    return nullptr;
 }
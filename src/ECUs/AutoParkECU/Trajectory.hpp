@@ -23,19 +23,55 @@
 #  define CAR_TRAJECTORIES_HPP
 
 #  include "City/Parking.hpp"
+#  include "Vehicle/VehicleBluePrint.hpp"
+#  include "Vehicle/TrackingControllers.hpp"
 #  include <SFML/Graphics.hpp> // FIXME deplacer CarTrajectory::draw
 #  include <vector>
 #  include <memory>
+#  include <atomic>
+#  include <chrono>
+#  include <sstream>
+#  include <string>
+#  include <algorithm>
+#  include <cassert>
+#  include <cmath>
+#  include <cstdint>
 
 class Car;
 class VehicleControl;
-class ECU;
+class TrajectoryPlanner;
 
 static const bool USE_KINEMATIC = true;
 
+// *****************************************************************************
+//! \brief Timed references (speeds, steering angles ...) to be played back by
+//! the vehicle controller. Values are appended with the duration they shall be
+//! maintained. The playback uses a cursor remembering the last played segment:
+//! since the simulation time is monotonic, looking for the segment to play is
+//! amortized O(1) per tick, whatever the number of references. Backward or
+//! large forward time jumps (seeks) fall back on a binary search.
+// *****************************************************************************
 template<class T>
 class References
 {
+public:
+
+    // *************************************************************************
+    //! \brief How values are computed between two references.
+    // *************************************************************************
+    enum class Interpolation
+    {
+        //! \brief Hold the value during its whole duration (step references).
+        ZeroOrder,
+        //! \brief Linear ramp from the start of a segment to the start of the
+        //! next one.
+        Linear,
+        //! \brief Monotone cubic Hermite spline (Fritsch-Carlson) passing
+        //! through the start of each segment. Smooth (C1) and never overshoots
+        //! neighbor values (important for steering saturations).
+        Cubic
+    };
+
 private:
 
     // *************************************************************************
@@ -52,17 +88,61 @@ private:
         {}
 
         T value;
+        //! \brief Ending time of the segment (cumulated durations).
         Second time;
     };
 
+    //! \brief Above this number of segments to skip, prefer the binary search
+    //! over moving the cursor forward.
+    static constexpr size_t MAX_CURSOR_STEPS = 8u;
+
 public:
 
+    //--------------------------------------------------------------------------
+    //! \brief Default constructor with the desired interpolation method.
+    //--------------------------------------------------------------------------
+    References(Interpolation const interpolation = Interpolation::ZeroOrder)
+        : m_interpolation(interpolation)
+    {}
+
+    //--------------------------------------------------------------------------
+    //! \brief Change the interpolation method.
+    //--------------------------------------------------------------------------
+    void interpolation(Interpolation const interpolation)
+    {
+        m_interpolation = interpolation;
+        m_slopes_dirty = true;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the interpolation method.
+    //--------------------------------------------------------------------------
+    inline Interpolation interpolation() const
+    {
+        return m_interpolation;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Remove all references and rewind the playback cursor.
     //--------------------------------------------------------------------------
     void clear()
     {
         m_references.clear();
+        m_slopes.clear();
+        m_cursor = 0u;
+        m_slopes_dirty = true;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Reserve memory for the given number of references.
+    //--------------------------------------------------------------------------
+    void reserve(size_t const size)
+    {
+        m_references.reserve(size);
     }
 
+    //--------------------------------------------------------------------------
+    //! \brief Append a value to maintain during the given duration.
     //--------------------------------------------------------------------------
     void add(T const value, Second const duration)
     {
@@ -70,60 +150,392 @@ public:
 
         Second time = m_references.empty() ? 0.0_s : m_references.back().time;
         m_references.push_back(TimedValue(value, time + duration));
+        m_slopes_dirty = true;
     }
 
+    //--------------------------------------------------------------------------
+    //! \brief Return the interpolated reference at the given time and move the
+    //! playback cursor to it.
+    //! \return The reference value or 0 if there is no reference for this time
+    //! (empty container or time after the end of references).
     //--------------------------------------------------------------------------
     T get(Second const time)
     {
-        if (m_references.size() == 0u)
+        if (end(time))
         {
             return T(0.0);
         }
 
-        const size_t N = m_references.size() - 1u;
-        if (time <= m_references[N].time)
+        seek(time);
+        return interpolate(m_cursor, time);
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Move the playback cursor on the segment holding the given time.
+    //! Small forward moves are made step by step (the normal playback case),
+    //! other moves use a binary search.
+    //--------------------------------------------------------------------------
+    void seek(Second const time)
+    {
+        const size_t N = m_references.size();
+        if (N == 0u)
+        {
+            m_cursor = 0u;
+            return ;
+        }
+
+        if ((m_cursor < N) && (time >= start(m_cursor)))
         {
-            for (size_t i = 0u; i <= N; ++i)
+            size_t steps = 0u;
+            while ((m_cursor < N) && (time >= m_references[m_cursor].time) &&
+                   (steps++ < MAX_CURSOR_STEPS))
             {
-                if (time < m_references[i].time)
-                {
-                    return m_references[i].value;
-                }
+                ++m_cursor;
+            }
+
+            if ((m_cursor == N) || (time < m_references[m_cursor].time))
+            {
+                return ;
             }
         }
 
-        return T(0.0);
+        // Seek: first segment ending after the given time.
+        auto it = std::upper_bound(m_references.begin(), m_references.end(), time,
+                                   [](Second const t, TimedValue const& r)
+                                   {
+                                       return t < r.time;
+                                   });
+        m_cursor = size_t(it - m_references.begin());
     }
 
-    bool end(Second const time)
+    //--------------------------------------------------------------------------
+    //! \brief Return true if there is no reference for the given time.
+    //--------------------------------------------------------------------------
+    bool end(Second const time) const
     {
         return m_references.empty() || (time >= m_references.back().time);
     }
 
+    //--------------------------------------------------------------------------
+    //! \brief Return the total duration of references.
+    //--------------------------------------------------------------------------
+    inline Second duration() const
+    {
+        return m_references.empty() ? 0.0_s : m_references.back().time;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the number of references.
+    //--------------------------------------------------------------------------
+    inline size_t size() const
+    {
+        return m_references.size();
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the value of the nth reference.
+    //--------------------------------------------------------------------------
+    inline T value(size_t const nth) const
+    {
+        return m_references[nth].value;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the duration of the nth reference.
+    //--------------------------------------------------------------------------
+    inline Second duration(size_t const nth) const
+    {
+        return m_references[nth].time - start(nth);
+    }
+
+private:
+
+    //--------------------------------------------------------------------------
+    //! \brief Starting time of the nth segment.
+    //--------------------------------------------------------------------------
+    inline Second start(size_t const nth) const
+    {
+        return (nth == 0u) ? 0.0_s : m_references[nth - 1u].time;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Compute the value inside the nth segment. Knots are placed at the
+    //! start of segments: the last segment is therefore always held.
+    //--------------------------------------------------------------------------
+    T interpolate(size_t const nth, Second const time)
+    {
+        if ((m_interpolation == Interpolation::ZeroOrder) ||
+            (nth + 1u >= m_references.size()))
+        {
+            return m_references[nth].value;
+        }
+
+        const double t0 = start(nth).value();
+        const double h = m_references[nth].time.value() - t0;
+        if (h <= 0.0)
+        {
+            return m_references[nth].value;
+        }
+
+        const double u = (time.value() - t0) / h;
+        const double y0 = m_references[nth].value.value();
+        const double y1 = m_references[nth + 1u].value.value();
+
+        if (m_interpolation == Interpolation::Linear)
+        {
+            return T(y0 + u * (y1 - y0));
+        }
+
+        // Cubic Hermite basis functions.
+        if (m_slopes_dirty)
+        {
+            computeSlopes();
+        }
+
+        const double u2 = u * u;
+        const double u3 = u2 * u;
+        const double h00 = 2.0 * u3 - 3.0 * u2 + 1.0;
+        const double h10 = u3 - 2.0 * u2 + u;
+        const double h01 = -2.0 * u3 + 3.0 * u2;
+        const double h11 = u3 - u2;
+
+        return T(h00 * y0 + h10 * h * m_slopes[nth] +
+                 h01 * y1 + h11 * h * m_slopes[nth + 1u]);
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Compute the tangents of the monotone cubic spline (Fritsch-Carlson
+    //! method). Done once after references have been modified.
+    //--------------------------------------------------------------------------
+    void computeSlopes()
+    {
+        const size_t N = m_references.size();
+        m_slopes.assign(N, 0.0);
+        m_slopes_dirty = false;
+        if (N < 2u)
+        {
+            return ;
+        }
+
+        // Secants between knots (knots are the starting time of segments)
+        std::vector<double> delta(N - 1u);
+        for (size_t i = 0u; i + 1u < N; ++i)
+        {
+            const double h = m_references[i].time.value() - start(i).value();
+            delta[i] = (h > 0.0)
+                       ? (m_references[i + 1u].value.value() - m_references[i].value.value()) / h
+                       : 0.0;
+        }
+
+        m_slopes[0] = delta[0];
+        m_slopes[N - 1u] = delta[N - 2u];
+        for (size_t i = 1u; i + 1u < N; ++i)
+        {
+            // Local extremum: flat tangent to avoid overshooting.
+            m_slopes[i] = (delta[i - 1u] * delta[i] <= 0.0)
+                          ? 0.0 : (delta[i - 1u] + delta[i]) / 2.0;
+        }
+
+        for (size_t i = 0u; i + 1u < N; ++i)
+        {
+            if (delta[i] == 0.0)
+            {
+                m_slopes[i] = m_slopes[i + 1u] = 0.0;
+                continue;
+            }
+
+            const double a = m_slopes[i] / delta[i];
+            const double b = m_slopes[i + 1u] / delta[i];
+            const double r = a * a + b * b;
+            if (r > 9.0)
+            {
+                const double tau = 3.0 / std::sqrt(r);
+                m_slopes[i] = tau * a * delta[i];
+                m_slopes[i + 1u] = tau * b * delta[i];
+            }
+        }
+    }
+
 protected:
 
+    //! \brief Timed references sorted by time.
     std::vector<TimedValue> m_references;
+    //! \brief Tangents for the cubic interpolation (lazily computed).
+    std::vector<double> m_slopes;
+    //! \brief Index of the segment currently played.
+    size_t m_cursor = 0u;
+    //! \brief Interpolation method.
+    Interpolation m_interpolation;
+    //! \brief Tangents shall be computed again.
+    bool m_slopes_dirty = true;
+};
+
+// *************************************************************************
+//! \brief Everything a trajectory planner needs to know to compute the path to
+//! a parking spot. This is a copy of the states of the ego car taken when the
+//! request is made: planners never access to the simulated car and therefore
+//! can run outside the simulation thread.
+// *************************************************************************
+struct TrajectoryRequest
+{
+    // *********************************************************************
+    //! \brief Snapshot of the ego car.
+    // *********************************************************************
+    struct Ego
+    {
+        //! \brief Dimension of the ego car.
+        CarBluePrint blueprint;
+        //! \brief World position of the middle of the rear axle.
+        sf::Vector2<Meter> position;
+        //! \brief Heading of the car.
+        Radian heading;
+    };
+
+    //----------------------------------------------------------------------
+    //! \brief Take a snapshot of the ego car and the parking spot.
+    //! \param[in] car: the ego car to be parked.
+    //! \param[in] parking: the parking spot to enter in or to leave.
+    //! \param[in] entering: true if entering in the spot, false if leaving.
+    //----------------------------------------------------------------------
+    TrajectoryRequest(Car const& car, Parking const& parking, bool const entering);
+
+    //! \brief Snapshot of the ego car.
+    Ego car;
+    //! \brief Copy of the parking spot.
+    Parking parking;
+    //! \brief Entering or leaving the parking spot.
+    bool entering;
+    //! \brief Oriented bounding boxes of obstacles (i.e. parked cars) near the
+    //! parking spot that the trajectory shall avoid.
+    std::vector<sf::RectangleShape> obstacles;
+    //! \brief Set to true for aborting the planning. Long planners shall poll
+    //! it through cancelled().
+    std::shared_ptr<std::atomic<bool>> cancellation =
+        std::make_shared<std::atomic<bool>>(false);
+    //! \brief Maximum duration for evaluating alternative candidates of
+    //! maneuvers. Candidates not evaluated in time are ignored.
+    std::chrono::milliseconds budget = std::chrono::milliseconds(20);
+    //! \brief When not zero, exactly this number of candidates of maneuvers
+    //! is evaluated whatever the duration, instead of the ones evaluated
+    //! within the budget. Results then do not depend on the machine load.
+    size_t candidates = 0u;
+    //! \brief Reuse and memorize maneuvers in the ManeuverCache. Batches
+    //! disable it: their results shall not depend on the previous runs.
+    bool cached = true;
+
+    //----------------------------------------------------------------------
+    //! \brief Has the requester aborted the planning ?
+    //----------------------------------------------------------------------
+    inline bool cancelled() const
+    {
+        return cancellation->load(std::memory_order_relaxed);
+    }
 };
 
 // *************************************************************************
-//! \brief
+//! \brief Base class for computing the trajectory to a parking spot and for
+//! replaying it as timed references for the car controller.
 // *************************************************************************
 class CarTrajectory
 {
+    //! \brief The planner reports on the selection of maneuvers.
+    friend class TrajectoryPlanner;
+
 public:
 
     using Ptr = std::unique_ptr<CarTrajectory>;
-    static CarTrajectory::Ptr create(ECU& ecu, Parking::Type const type);
+    static CarTrajectory::Ptr create(Parking::Type const type);
 
-    virtual ~CarTrajectory() { std::cout << "Destroy Trajectory\n"; };
-    virtual bool init(Car& car, Parking const& parking, bool const entering) = 0;
-    //! \brief
-    //! \return false if no need to update (end of references)
+    virtual ~CarTrajectory() = default;
+
+    //----------------------------------------------------------------------
+    //! \brief Compute the path and references. This method only uses the given
+    //! request and may therefore be called from any thread.
+    //! \return true if a path has been found.
+    //----------------------------------------------------------------------
+    virtual bool init(TrajectoryRequest const& request) = 0;
+
+    //----------------------------------------------------------------------
+    //! \brief Drive the car along the trajectory. When a geometric path is
+    //! known, the car tracks it with its closed-loop controllers else
+    //! references are played in open loop.
+    //! \return false if no need to update (end of the trajectory).
+    //----------------------------------------------------------------------
     virtual bool update(Car& car, Second const dt);
+
+    //----------------------------------------------------------------------
+    //! \brief Compute the geometric path to be tracked by the car once init()
+    //! or load() succeeded. By default, references are integrated with the
+    //! kinematic model of the car starting from its initial pose.
+    //----------------------------------------------------------------------
+    virtual void computeTrackingPath(TrajectoryRequest::Ego const& car);
+
+    //----------------------------------------------------------------------
+    //! \brief Return the geometric path to be tracked by the car.
+    //----------------------------------------------------------------------
+    inline TrackingPath const& trackingPath() const
+    {
+        return m_tracking_path;
+    }
+
+    //----------------------------------------------------------------------
+    //! \brief Return the duration of the timed references.
+    //----------------------------------------------------------------------
+    inline Second duration() const
+    {
+        return m_speeds.duration();
+    }
+
     virtual void draw(sf::RenderTarget& /*target*/, sf::RenderStates /*states*/) const {};
 
+    //----------------------------------------------------------------------
+    //! \brief Export the maneuvers computed by init() into the given buffer,
+    //! expressed relatively to the parking spot, to be memorized by the
+    //! ManeuverCache.
+    //! \return false if the trajectory cannot be cached (i.e. when it does
+    //! not only depend on the car, the parking spot and the relative start
+    //! pose but also on obstacles).
+    //----------------------------------------------------------------------
+    virtual bool save(TrajectoryRequest const& /*request*/,
+                      std::vector<uint8_t>& /*buffer*/) const
+    {
+        return false;
+    }
+
+    //----------------------------------------------------------------------
+    //! \brief Restore maneuvers exported by save() and transform them to
+    //! the world coordinates of the request. Replace the call of init().
+    //! \return false if the buffer cannot be restored.
+    //----------------------------------------------------------------------
+    virtual bool load(TrajectoryRequest const& /*request*/,
+                      std::vector<uint8_t> const& /*buffer*/)
+    {
+        return false;
+    }
+
+    //----------------------------------------------------------------------
+    //! \brief Return messages produced while computing the trajectory. Since
+    //! init() may run from a worker thread, messages are not directly sent to
+    //! the GUI but kept for the ECU which shall forward them.
+    //----------------------------------------------------------------------
+    inline std::vector<std::string> const& messages() const
+    {
+        return m_messages;
+    }
+
 protected:
 
+    //----------------------------------------------------------------------
+    //! \brief Memorize a message for the ECU (see messages()).
+    //----------------------------------------------------------------------
+    template<typename... Args>
+    void logMessage(Args const&... args)
+    {
+        std::stringstream ss;
+        ((ss << args), ...);
+        m_messages.push_back(ss.str());
+    }
+
     //! \brief Integration time
     Second m_time = 0.0_s;
     //! \brief Timed reference for the car accelerations.
@@ -132,6 +544,12 @@ protected:
     References<MeterPerSecond> m_speeds;
     //! \brief Timed reference for front wheel angles.
     References<Radian> m_steerings;
+    //! \brief Geometric path tracked by the car.
+    TrackingPath m_tracking_path;
+    //! \brief Has the car started tracking m_tracking_path ?
+    bool m_tracking = false;
+    //! \brief Messages produced while computing the trajectory.
+    std::vector<std::string> m_messages;
 };
 
 #endif
@@ -0,0 +1,355 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "ECUs/AutoParkECU/TrajectoryPlanner.hpp"
+#include "ECUs/AutoParkECU/ParallelTrajectory.hpp"
+#include "ECUs/AutoParkECU/HybridAStarTrajectory.hpp"
+#include "ECUs/AutoParkECU/ManeuverCache.hpp"
+#include "Math/Collide.hpp"
+#include <array>
+
+// Weights of the cost of trajectories.
+static const double LENGTH_WEIGHT = 1.0; // per meter
+static const double GEAR_WEIGHT = 2.0; // per change of gear
+static const double DURATION_WEIGHT = 0.5; // per second
+static const double CLEARANCE_WEIGHT = 10.0; // per meter below SAFETY_DISTANCE
+static const Meter SAFETY_DISTANCE = 0.3_m;
+//! \brief Obstacles further from the path do not matter: also the clearance
+//! of paths without obstacles around.
+static const Meter MAX_CLEARANCE = 10.0_m;
+
+// *****************************************************************************
+//! \brief Candidate of maneuvers and its cost.
+// *****************************************************************************
+struct Candidate
+{
+    CarTrajectory::Ptr trajectory;
+    TrajectoryPlanner::Cost cost;
+};
+
+//------------------------------------------------------------------------------
+//! \brief Compute the given variant of parallel maneuvers and its cost. The
+//! cost is infinite if no path has been found.
+//------------------------------------------------------------------------------
+static Candidate evaluate(TrajectoryRequest const& request,
+                          ParallelTrajectory::Options const& options)
+{
+    Candidate candidate;
+    candidate.trajectory = std::make_unique<ParallelTrajectory>(options);
+    if (candidate.trajectory->init(request) && !request.cancelled())
+    {
+        candidate.trajectory->computeTrackingPath(request.car);
+        candidate.cost = TrajectoryPlanner::cost(*candidate.trajectory, request);
+    }
+    return candidate;
+}
+
+//------------------------------------------------------------------------------
+//! \brief Return the corners of the oriented bounding box.
+//------------------------------------------------------------------------------
+static std::array<sf::Vector2f, 4u> corners(sf::RectangleShape const& obb)
+{
+    sf::Transform const& T = obb.getTransform();
+    return { T.transformPoint(obb.getPoint(0u)), T.transformPoint(obb.getPoint(1u)),
+             T.transformPoint(obb.getPoint(2u)), T.transformPoint(obb.getPoint(3u)) };
+}
+
+//------------------------------------------------------------------------------
+//! \brief Distance between the point P and the segment [A B].
+//------------------------------------------------------------------------------
+static float distance(sf::Vector2f const& P, sf::Vector2f const& A, sf::Vector2f const& B)
+{
+    const sf::Vector2f AB = B - A;
+    const sf::Vector2f AP = P - A;
+    const float l = AB.x * AB.x + AB.y * AB.y;
+    const float t = (l > 0.0f) ? std::max(0.0f, std::min(1.0f, (AP.x * AB.x + AP.y * AB.y) / l)) : 0.0f;
+    const sf::Vector2f D = AP - t * AB;
+    return std::sqrt(D.x * D.x + D.y * D.y);
+}
+
+//------------------------------------------------------------------------------
+//! \brief Distance between two non colliding oriented bounding boxes: the
+//! shortest distance from a corner of a box to a side of the other box.
+//------------------------------------------------------------------------------
+static float distance(std::array<sf::Vector2f, 4u> const& A, std::array<sf::Vector2f, 4u> const& B)
+{
+    float d = std::numeric_limits<float>::max();
+    for (size_t i = 0u; i < 4u; ++i)
+    {
+        for (size_t j = 0u; j < 4u; ++j)
+        {
+            d = std::min(d, distance(A[i], B[j], B[(j + 1u) % 4u]));
+            d = std::min(d, distance(B[i], A[j], A[(j + 1u) % 4u]));
+        }
+    }
+    return d;
+}
+
+//------------------------------------------------------------------------------
+TrajectoryPlanner::Ticket TrajectoryPlanner::submit(TrajectoryRequest const& request)
+{
+    auto cancellation = request.cancellation;
+    return Ticket(m_pool.submit([request]() { return TrajectoryPlanner::plan(request); }),
+                  cancellation);
+}
+
+//------------------------------------------------------------------------------
+TrajectoryPlanner::Result TrajectoryPlanner::plan(TrajectoryRequest const& request)
+{
+    Result result;
+
+    if (request.cancelled())
+        return result;
+
+    // Parallel, perpendicular, diagonal trajectories.
+    result.trajectory = CarTrajectory::create(request.parking.type);
+    if (result.trajectory != nullptr)
+    {
+        // Identical cars parking in identical spots: reuse maneuvers.
+        ManeuverCache& cache = ManeuverCache::instance();
+        ManeuverCache::Key const key = ManeuverCache::key(request);
+        ManeuverCache::Buffer buffer;
+        bool hit = request.cached && cache.find(key, buffer) &&
+                   result.trajectory->load(request, buffer);
+        if (hit)
+        {
+            result.trajectory->computeTrackingPath(request.car);
+
+            // Parallel maneuvers have been selected against obstacles which
+            // are not part of the key: check the replayed maneuver against
+            // the current ones and plan again if it collides.
+            if ((request.parking.type == Parking::Type::Parallel) &&
+                std::isinf(TrajectoryPlanner::cost(*result.trajectory, request).total))
+            {
+                hit = false;
+                result.trajectory = CarTrajectory::create(request.parking.type);
+            }
+            result.succeeded = hit;
+        }
+
+        if (!hit)
+        {
+            if (request.parking.type == Parking::Type::Parallel)
+            {
+                result.succeeded = planParallel(request, result);
+            }
+            else
+            {
+                result.succeeded = result.trajectory->init(request) && !request.cancelled();
+                if (result.succeeded)
+                {
+                    result.trajectory->computeTrackingPath(request.car);
+                }
+            }
+
+            buffer.clear();
+            if (request.cached && result.succeeded && result.trajectory->save(request, buffer))
+            {
+                cache.store(key, buffer);
+            }
+        }
+    }
+
+    // The geometric parallel trajectory has no knowledge of obstacles and
+    // needs enough space: fall back on the search-based planner.
+    if (!result.succeeded && !request.cancelled() &&
+        (request.parking.type == Parking::Type::Parallel))
+    {
+        auto trajectory = std::make_unique<HybridAStarTrajectory>();
+        if (trajectory->init(request) && !request.cancelled())
+        {
+            // Geometric path for the closed-loop tracking.
+            trajectory->computeTrackingPath(request.car);
+            result.trajectory = std::move(trajectory);
+            result.succeeded = true;
+        }
+    }
+
+    return result;
+}
+
+//------------------------------------------------------------------------------
+bool TrajectoryPlanner::planParallel(TrajectoryRequest const& request, Result& result)
+{
+    auto const& candidates = ParallelTrajectory::candidates();
+    Candidate best;
+    size_t evaluated = 0u;
+
+    if (request.candidates != 0u)
+    {
+        // Deterministic mode: evaluate the requested number of candidates in
+        // the caller thread whatever the time it takes.
+        size_t const count = std::min(request.candidates, candidates.size());
+        best = evaluate(request, candidates[0]);
+        for (evaluated = 1u; evaluated < count; ++evaluated)
+        {
+            Candidate candidate = evaluate(request, candidates[evaluated]);
+            if (candidate.cost.total < best.cost.total)
+            {
+                best = std::move(candidate);
+            }
+        }
+    }
+    else
+    {
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point const deadline = Clock::now() + request.budget;
+
+        // Alternatives are evaluated by worker threads on a shared copy of
+        // the request. Candidates not yet started when the budget is elapsed
+        // are skipped.
+        auto const shared = std::make_shared<TrajectoryRequest const>(request);
+        auto const expired = std::make_shared<std::atomic<bool>>(false);
+        ThreadPool& evaluators = TrajectoryPlanner::instance().m_evaluators;
+        std::vector<std::future<Candidate>> futures;
+        futures.reserve(candidates.size());
+        for (size_t i = 1u; i < candidates.size(); ++i)
+        {
+            ParallelTrajectory::Options const options = candidates[i];
+            futures.push_back(evaluators.submit([shared, expired, options]()
+            {
+                if (expired->load() || shared->cancelled())
+                    return Candidate();
+                return evaluate(*shared, options);
+            }));
+        }
+
+        // The nominal candidate is always evaluated.
+        best = evaluate(request, candidates[0]);
+        evaluated = 1u;
+        for (auto& future: futures)
+        {
+            if (future.wait_until(deadline) != std::future_status::ready)
+                continue;
+
+            Candidate candidate = future.get();
+            if (candidate.trajectory == nullptr)
+                continue;
+
+            ++evaluated;
+            if (candidate.cost.total < best.cost.total)
+            {
+                best = std::move(candidate);
+            }
+        }
+        expired->store(true);
+    }
+
+    result.trajectory = std::move(best.trajectory);
+    if (std::isinf(best.cost.total) || request.cancelled())
+    {
+        result.trajectory->logMessage("No collision-free maneuvers among ",
+                                      evaluated, " candidates");
+        return false;
+    }
+
+    result.trajectory->logMessage("Best of ", evaluated, " candidates: length ",
+                                  best.cost.length, ", ", best.cost.maneuvers,
+                                  " maneuvers, clearance ", best.cost.clearance);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+TrajectoryPlanner::Cost TrajectoryPlanner::cost(CarTrajectory const& trajectory,
+                                                TrajectoryRequest const& request)
+{
+    TrackingPath const& path = trajectory.trackingPath();
+    CarBluePrint const& car = request.car.blueprint;
+    Cost cost;
+
+    if (path.empty())
+        return cost;
+
+    // Shape of the ego car placed along the path.
+    sf::RectangleShape shape(sf::Vector2f(float(car.length.value()), float(car.width.value())));
+    shape.setOrigin(sf::Vector2f(float(car.back_overhang.value()), float(car.width.value()) / 2.0f));
+    const float center = float(car.length.value()) / 2.0f - float(car.back_overhang.value());
+    const float radius = std::hypot(float(car.length.value()), float(car.width.value())) / 2.0f;
+
+    // Obstacles bounded by circles for rejecting far obstacles quickly.
+    std::vector<std::array<sf::Vector2f, 4u>> obstacles;
+    struct Circle { float x, y, radius; };
+    std::vector<Circle> circles;
+    obstacles.reserve(request.obstacles.size());
+    circles.reserve(request.obstacles.size());
+    for (auto const& obstacle: request.obstacles)
+    {
+        const sf::Vector2f size = obstacle.getSize();
+        const sf::Vector2f c = obstacle.getTransform().transformPoint(size / 2.0f);
+        obstacles.push_back(corners(obstacle));
+        circles.push_back({ c.x, c.y, std::hypot(size.x, size.y) / 2.0f });
+    }
+
+    float clearance = float(MAX_CLEARANCE.value());
+    for (size_t i = 0u; i < path.size(); ++i)
+    {
+        PathPoint const& p = path[i];
+        if (!std::isfinite(p.position.x.value()) || !std::isfinite(p.position.y.value()) ||
+            !std::isfinite(p.heading.value()))
+        {
+            return cost;
+        }
+
+        if (i > 0u)
+        {
+            cost.length += math::distance(path[i - 1u].position, p.position);
+            if ((p.speed.value() * path[i - 1u].speed.value()) < 0.0)
+            {
+                cost.maneuvers += 1u;
+            }
+        }
+
+        const float x = float(p.position.x.value());
+        const float y = float(p.position.y.value());
+        const float h = float(p.heading.value());
+        const float cx = x + center * std::cos(h);
+        const float cy = y + center * std::sin(h);
+        bool placed = false;
+        for (size_t j = 0u; j < obstacles.size(); ++j)
+        {
+            // Lower bound of the distance to the obstacle.
+            const float d = std::hypot(cx - circles[j].x, cy - circles[j].y) - radius - circles[j].radius;
+            if (d >= clearance)
+                continue;
+
+            if (!placed)
+            {
+                shape.setPosition(x, y);
+                shape.setRotation(float(Degree(p.heading).value()));
+                placed = true;
+            }
+
+            sf::Vector2f mtv;
+            if (math::collide(shape, request.obstacles[j], mtv))
+                return cost;
+
+            clearance = std::min(clearance, distance(corners(shape), obstacles[j]));
+        }
+    }
+
+    cost.duration = trajectory.duration();
+    cost.clearance = Meter(double(clearance));
+    cost.total = LENGTH_WEIGHT * cost.length.value()
+               + GEAR_WEIGHT * double(cost.maneuvers)
+               + DURATION_WEIGHT * cost.duration.value()
+               + CLEARANCE_WEIGHT * std::max(0.0, (SAFETY_DISTANCE - cost.clearance).value());
+    return cost;
+}
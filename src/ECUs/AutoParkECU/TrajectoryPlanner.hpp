@@ -0,0 +1,179 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef TRAJECTORY_PLANNER_HPP
+#  define TRAJECTORY_PLANNER_HPP
+
+#  include "ECUs/AutoParkECU/Trajectory.hpp"
+#  include "Common/ThreadPool.hpp"
+#  include "Common/Singleton.hpp"
+#  include <limits>
+
+// *****************************************************************************
+//! \brief Service computing trajectories to parking spots in worker threads.
+//! ECUs submit a TrajectoryRequest and get a ticket they poll at each tick of
+//! the simulation: expensive planners never stall the simulation frame and
+//! several ego cars can plan concurrently.
+// *****************************************************************************
+class TrajectoryPlanner : public Singleton<TrajectoryPlanner>
+{
+    friend class Singleton<TrajectoryPlanner>;
+
+public:
+
+    // *************************************************************************
+    //! \brief Result of the planning.
+    // *************************************************************************
+    struct Result
+    {
+        //! \brief The computed trajectory (also holding log messages). nullptr
+        //! if the planning has been cancelled before being started.
+        CarTrajectory::Ptr trajectory;
+        //! \brief Has a path been found ?
+        bool succeeded = false;
+    };
+
+    // *************************************************************************
+    //! \brief Cost of a trajectory, used for selecting the best candidate
+    //! among several maneuvers.
+    // *************************************************************************
+    struct Cost
+    {
+        //! \brief Length of the path [meter].
+        Meter length = 0.0_m;
+        //! \brief Number of changes of gear.
+        size_t maneuvers = 0u;
+        //! \brief Duration of the maneuvers [second].
+        Second duration = 0.0_s;
+        //! \brief Minimal distance between the car and obstacles along the path,
+        //! saturated to a few meters (i.e. when there are no obstacles) [meter].
+        Meter clearance = 0.0_m;
+        //! \brief Weighted sum of the above criteria. Infinite if the path
+        //! collides an obstacle.
+        double total = std::numeric_limits<double>::infinity();
+    };
+
+    // *************************************************************************
+    //! \brief Handle on a submitted request.
+    // *************************************************************************
+    class Ticket
+    {
+    public:
+
+        Ticket() = default;
+        Ticket(std::future<Result>&& future,
+               std::shared_ptr<std::atomic<bool>> const& cancellation)
+            : m_future(std::move(future)), m_cancellation(cancellation)
+        {}
+
+        //----------------------------------------------------------------------
+        //! \brief Is there a pending request ?
+        //----------------------------------------------------------------------
+        inline bool valid() const
+        {
+            return m_future.valid();
+        }
+
+        //----------------------------------------------------------------------
+        //! \brief Non blocking check of the end of the planning.
+        //----------------------------------------------------------------------
+        bool ready() const
+        {
+            return m_future.valid() &&
+                (m_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+        }
+
+        //----------------------------------------------------------------------
+        //! \brief Get the result of the planning. Blocking if not ready(). The
+        //! ticket is no longer valid after this call.
+        //----------------------------------------------------------------------
+        Result get()
+        {
+            try
+            {
+                return m_future.get();
+            }
+            catch (std::exception const&)
+            {
+                // Broken promise: the planner has been stopped.
+                return Result();
+            }
+        }
+
+        //----------------------------------------------------------------------
+        //! \brief Abort the planning. Do not wait for the end of the job: the
+        //! ticket is simply released.
+        //----------------------------------------------------------------------
+        void cancel()
+        {
+            if (m_cancellation != nullptr)
+            {
+                m_cancellation->store(true);
+            }
+            m_future = std::future<Result>();
+        }
+
+    private:
+
+        std::future<Result> m_future;
+        std::shared_ptr<std::atomic<bool>> m_cancellation;
+    };
+
+public:
+
+    //--------------------------------------------------------------------------
+    //! \brief Push a planning request to the worker threads.
+    //! \param[in] request: the snapshot of the ego car and the parking spot.
+    //! \return the ticket to poll for getting the result.
+    //--------------------------------------------------------------------------
+    Ticket submit(TrajectoryRequest const& request);
+
+    //--------------------------------------------------------------------------
+    //! \brief Compute the trajectory in the caller thread.
+    //--------------------------------------------------------------------------
+    static Result plan(TrajectoryRequest const& request);
+
+    //--------------------------------------------------------------------------
+    //! \brief Compute the cost of the tracking path of the given trajectory.
+    //--------------------------------------------------------------------------
+    static Cost cost(CarTrajectory const& trajectory, TrajectoryRequest const& request);
+
+private:
+
+    TrajectoryPlanner() = default;
+
+    //--------------------------------------------------------------------------
+    //! \brief Compute candidates of parallel maneuvers and keep the cheapest.
+    //! The nominal candidate is computed in the caller thread, alternatives are
+    //! computed concurrently within the latency budget of the request.
+    //--------------------------------------------------------------------------
+    static bool planParallel(TrajectoryRequest const& request, Result& result);
+
+private:
+
+    //! \brief Worker threads.
+    ThreadPool m_pool;
+    //! \brief Worker threads evaluating candidates of maneuvers. Distinct from
+    //! m_pool since planning jobs wait for them.
+    ThreadPool m_evaluators;
+};
+
+#endif
@@ -0,0 +1,154 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "Math/Curves.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace math {
+
+//------------------------------------------------------------------------------
+//! \brief Second derivatives of the natural cubic spline interpolating the
+//! values v at the parameters t (tridiagonal system solved by the Thomas
+//! algorithm).
+static std::vector<double> secondDerivatives(std::vector<double> const& t,
+                                             std::vector<double> const& v)
+{
+    size_t const n = t.size();
+    std::vector<double> M(n, 0.0);
+    if (n < 3u)
+        return M;
+
+    std::vector<double> c(n, 0.0), r(n, 0.0);
+    for (size_t i = 1u; i + 1u < n; ++i)
+    {
+        double const h0 = t[i] - t[i - 1u];
+        double const h1 = t[i + 1u] - t[i];
+        double const a = h0 / 6.0;
+        double const b = (h0 + h1) / 3.0 - a * c[i - 1u];
+        c[i] = (h1 / 6.0) / b;
+        r[i] = ((v[i + 1u] - v[i]) / h1 - (v[i] - v[i - 1u]) / h0 - a * r[i - 1u]) / b;
+    }
+    for (size_t i = n - 2u; i >= 1u; --i)
+    {
+        M[i] = r[i] - c[i] * M[i + 1u];
+    }
+    return M;
+}
+
+//------------------------------------------------------------------------------
+std::vector<Frenet::Position> spline(std::vector<Frenet::Position> const& points,
+                                     double const step)
+{
+    size_t const n = points.size();
+    if (n < 3u)
+        return points;
+
+    std::vector<double> t(n, 0.0), x(n), y(n);
+    for (size_t i = 0u; i < n; ++i)
+    {
+        x[i] = points[i].x;
+        y[i] = points[i].y;
+        if (i > 0u)
+        {
+            // Duplicated points would make the system singular.
+            t[i] = t[i - 1u] + std::max(1e-6, std::hypot(x[i] - x[i - 1u], y[i] - y[i - 1u]));
+        }
+    }
+    std::vector<double> const Mx = secondDerivatives(t, x);
+    std::vector<double> const My = secondDerivatives(t, y);
+
+    std::vector<Frenet::Position> samples;
+    samples.push_back(points[0]);
+    for (size_t i = 0u; i + 1u < n; ++i)
+    {
+        double const h = t[i + 1u] - t[i];
+        auto eval = [&](double const b) -> Frenet::Position
+        {
+            double const a = 1.0 - b;
+            double const f = (a * a * a - a) * h * h / 6.0;
+            double const g = (b * b * b - b) * h * h / 6.0;
+            return { a * x[i] + b * x[i + 1u] + f * Mx[i] + g * Mx[i + 1u],
+                     a * y[i] + b * y[i + 1u] + f * My[i] + g * My[i + 1u] };
+        };
+
+        // The chord length underestimates the arc length: estimate it with a
+        // few points.
+        constexpr size_t ESTIMATION = 16u;
+        double length = 0.0;
+        Frenet::Position p = points[i];
+        for (size_t k = 1u; k <= ESTIMATION; ++k)
+        {
+            Frenet::Position const q = eval(double(k) / double(ESTIMATION));
+            length += std::hypot(q.x - p.x, q.y - p.y);
+            p = q;
+        }
+
+        size_t const count = std::max(size_t(1), size_t(std::ceil(length / step)));
+        for (size_t k = 1u; k <= count; ++k)
+        {
+            samples.push_back(eval(double(k) / double(count)));
+        }
+    }
+    return samples;
+}
+
+//------------------------------------------------------------------------------
+std::vector<Frenet::Position> clothoids(Frenet::Position const& start,
+                                        double const heading,
+                                        std::vector<Clothoid> const& segments,
+                                        double const step)
+{
+    std::vector<Frenet::Position> samples;
+    samples.push_back(start);
+
+    double x = start.x, y = start.y, theta = heading;
+    for (Clothoid const& c: segments)
+    {
+        if (c.length <= 0.0)
+            continue;
+
+        // Heading along the segment: theta(s) = theta + k0 s + (k1 - k0) s^2 / 2L
+        double const dk = (c.curvature1 - c.curvature0) / c.length;
+        auto angle = [&](double const s)
+        {
+            return theta + s * (c.curvature0 + 0.5 * dk * s);
+        };
+
+        bool const straight = (c.curvature0 == 0.0) && (c.curvature1 == 0.0);
+        size_t const count = straight ? 1u :
+            std::max(size_t(1), size_t(std::ceil(c.length / step)));
+        double const h = c.length / double(count);
+        for (size_t k = 0u; k < count; ++k)
+        {
+            // Simpson integration of (cos, sin) of the heading.
+            double const s0 = h * double(k);
+            double const a = angle(s0), m = angle(s0 + 0.5 * h), b = angle(s0 + h);
+            x += h / 6.0 * (std::cos(a) + 4.0 * std::cos(m) + std::cos(b));
+            y += h / 6.0 * (std::sin(a) + 4.0 * std::sin(m) + std::sin(b));
+            samples.push_back({ x, y });
+        }
+        theta = angle(c.length);
+    }
+    return samples;
+}
+
+} // namespace math
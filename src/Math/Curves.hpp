@@ -0,0 +1,73 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef MATH_CURVES_HPP
+#  define MATH_CURVES_HPP
+
+#  include "Math/Frenet.hpp"
+
+namespace math {
+
+// *****************************************************************************
+//! \brief Clothoid (Euler spiral) segment: its curvature varies linearly with
+//! the curvilinear abscissa from curvature0 to curvature1. Straight lines
+//! (null curvatures) and circular arcs (constant curvature) are particular
+//! cases. Consecutive segments are joined with the same position and heading,
+//! like the geometry of roads in OpenDRIVE files.
+// *****************************************************************************
+struct Clothoid
+{
+    //! \brief Length of the segment [meter].
+    double length = 0.0;
+    //! \brief Initial curvature [1/meter] (positive when turning left).
+    double curvature0 = 0.0;
+    //! \brief Final curvature [1/meter].
+    double curvature1 = 0.0;
+};
+
+//------------------------------------------------------------------------------
+//! \brief Sample the natural cubic spline passing through the given points,
+//! parameterized by the chord length.
+//! \param[in] points: at least two points.
+//! \param[in] step: mean distance between two samples [meter] (samples are
+//! uniform in the spline parameter, not in the arc length).
+//! \return sampled points (including the given points).
+//------------------------------------------------------------------------------
+std::vector<Frenet::Position> spline(std::vector<Frenet::Position> const& points,
+                                     double const step);
+
+//------------------------------------------------------------------------------
+//! \brief Sample consecutive clothoid segments.
+//! \param[in] start: initial position [meter].
+//! \param[in] heading: initial heading [radian].
+//! \param[in] segments: clothoid segments.
+//! \param[in] step: max distance between two samples [meter]. Straight lines
+//! are not sampled.
+//! \return sampled points (including the initial and final points).
+//------------------------------------------------------------------------------
+std::vector<Frenet::Position> clothoids(Frenet::Position const& start,
+                                        double const heading,
+                                        std::vector<Clothoid> const& segments,
+                                        double const step);
+
+} // namespace math
+
+#endif
@@ -0,0 +1,288 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "Math/Frenet.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace math {
+
+//------------------------------------------------------------------------------
+bool Frenet::build(std::vector<Position> const& polyline, double const step)
+{
+    m_x.clear(); m_y.clear(); m_s.clear();
+    m_tx.clear(); m_ty.clear(); m_lookup.clear();
+    m_step = std::max(step, 0.01);
+
+    // Vertices and their curvilinear abscissa.
+    for (Position const& p: polyline)
+    {
+        if (!m_x.empty())
+        {
+            double const dx = p.x - m_x.back();
+            double const dy = p.y - m_y.back();
+            double const l = std::sqrt(dx * dx + dy * dy);
+            if (l < 1e-9)
+                continue;
+
+            m_tx.push_back(dx / l);
+            m_ty.push_back(dy / l);
+            m_s.push_back(m_s.back() + l);
+        }
+        else
+        {
+            m_s.push_back(0.0);
+        }
+        m_x.push_back(p.x);
+        m_y.push_back(p.y);
+    }
+
+    if (m_tx.empty())
+    {
+        m_x.clear(); m_y.clear(); m_s.clear();
+        return false;
+    }
+    assert(m_tx.size() < std::numeric_limits<uint32_t>::max());
+
+    // Segment holding the abscissa k * step.
+    size_t const n = m_tx.size();
+    size_t const count = size_t(length() / m_step) + 1u;
+    m_lookup.resize(count);
+    size_t i = 0u;
+    for (size_t k = 0u; k < count; ++k)
+    {
+        double const s = double(k) * m_step;
+        while ((i + 1u < n) && (m_s[i + 1u] <= s))
+            ++i;
+        m_lookup[k] = uint32_t(i);
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+std::vector<Frenet::Position> Frenet::vertices() const
+{
+    std::vector<Position> vertices(m_x.size());
+    for (size_t i = 0u; i < m_x.size(); ++i)
+    {
+        vertices[i].x = m_x[i];
+        vertices[i].y = m_y[i];
+    }
+    return vertices;
+}
+
+//------------------------------------------------------------------------------
+std::vector<Frenet::Position> Frenet::offset(double const d) const
+{
+    size_t const n = m_tx.size();
+    std::vector<Position> vertices(m_x.size());
+    for (size_t j = 0u; j < vertices.size(); ++j)
+    {
+        // Left normals of the segments before and after the vertex.
+        size_t const a = (j == 0u) ? 0u : j - 1u;
+        size_t const b = (j == n) ? n - 1u : j;
+        double const ax = -m_ty[a], ay = m_tx[a];
+        double const bx = -m_ty[b], by = m_tx[b];
+
+        // Bisector scaled by 1 / cos(half angle). Limited for sharp turns.
+        double mx = ax + bx, my = ay + by;
+        double const l = std::sqrt(mx * mx + my * my);
+        if (l < 1e-9)
+        {
+            mx = ax; my = ay;
+        }
+        else
+        {
+            mx /= l; my /= l;
+        }
+        double const scale = d / std::max(mx * ax + my * ay, 0.1);
+        vertices[j].x = m_x[j] + scale * mx;
+        vertices[j].y = m_y[j] + scale * my;
+    }
+    return vertices;
+}
+
+//------------------------------------------------------------------------------
+size_t Frenet::segment(double const s) const
+{
+    assert(!empty());
+
+    if (s <= 0.0)
+        return 0u;
+
+    size_t const n = m_tx.size();
+    size_t const k = size_t(s / m_step);
+    if (k >= m_lookup.size())
+        return n - 1u;
+
+    // The lookup table gives the segment holding k * step, the wanted one is
+    // at most a few segments ahead (when segments are shorter than the step).
+    size_t i = m_lookup[k];
+    while ((i + 1u < n) && (m_s[i + 1u] <= s))
+        ++i;
+    return i;
+}
+
+//------------------------------------------------------------------------------
+double Frenet::heading(double const s) const
+{
+    size_t const i = segment(s);
+    return std::atan2(m_ty[i], m_tx[i]);
+}
+
+//------------------------------------------------------------------------------
+Frenet::Position Frenet::toCartesian(Coordinates const& c) const
+{
+    size_t const i = segment(c.s);
+    double const u = c.s - m_s[i];
+
+    Position p;
+    p.x = m_x[i] + u * m_tx[i] - c.d * m_ty[i];
+    p.y = m_y[i] + u * m_ty[i] + c.d * m_tx[i];
+    return p;
+}
+
+//------------------------------------------------------------------------------
+double Frenet::project(Position const& p, size_t const i, Coordinates& c) const
+{
+    double const dx = p.x - m_x[i];
+    double const dy = p.y - m_y[i];
+    double const u = dx * m_tx[i] + dy * m_ty[i];
+    double const d = dy * m_tx[i] - dx * m_ty[i];
+
+    // Extrapolate before the first vertex and after the last vertex.
+    double const lo = (i == 0u) ? -std::numeric_limits<double>::infinity() : 0.0;
+    double const hi = (i + 1u == m_tx.size())
+                      ? std::numeric_limits<double>::infinity()
+                      : m_s[i + 1u] - m_s[i];
+    double const v = std::min(std::max(u, lo), hi);
+    double const e = u - v;
+    double const distance = e * e + d * d;
+
+    c.s = m_s[i] + v;
+    c.d = (e == 0.0) ? d : std::copysign(std::sqrt(distance), d);
+    return distance;
+}
+
+//------------------------------------------------------------------------------
+Frenet::Coordinates Frenet::toFrenet(Position const& p, size_t& hint) const
+{
+    Coordinates best;
+    if (empty())
+    {
+        hint = NONE;
+        return best;
+    }
+
+    Coordinates c;
+    size_t const n = m_tx.size();
+
+    // No previous segment: scan all segments.
+    if (hint >= n)
+    {
+        double min = std::numeric_limits<double>::infinity();
+        for (size_t i = 0u; i < n; ++i)
+        {
+            double const distance = project(p, i, c);
+            if (distance < min)
+            {
+                min = distance;
+                best = c;
+                hint = i;
+            }
+        }
+        return best;
+    }
+
+    // Warm start: walk from the previous segment to the neighbor segments while
+    // the distance decreases.
+    size_t i = hint;
+    double min = project(p, i, best);
+    while ((i + 1u < n) && (project(p, i + 1u, c) < min))
+    {
+        min = project(p, ++i, best);
+    }
+    if (i == hint)
+    {
+        while ((i > 0u) && (project(p, i - 1u, c) < min))
+        {
+            min = project(p, --i, best);
+        }
+    }
+
+    hint = i;
+    return best;
+}
+
+//------------------------------------------------------------------------------
+void Frenet::toCartesian(std::vector<Coordinates> const& coordinates,
+                         std::vector<Position>& positions) const
+{
+    assert(!empty());
+
+    size_t const count = coordinates.size();
+    positions.resize(count);
+
+    // Scalar pass: find segments.
+    thread_local std::vector<uint32_t> segments;
+    segments.resize(count);
+    for (size_t k = 0u; k < count; ++k)
+    {
+        segments[k] = uint32_t(segment(coordinates[k].s));
+    }
+
+    // Arithmetic pass: no branch.
+    double const* X = m_x.data();
+    double const* Y = m_y.data();
+    double const* S = m_s.data();
+    double const* TX = m_tx.data();
+    double const* TY = m_ty.data();
+    for (size_t k = 0u; k < count; ++k)
+    {
+        uint32_t const i = segments[k];
+        double const u = coordinates[k].s - S[i];
+        double const d = coordinates[k].d;
+        positions[k].x = X[i] + u * TX[i] - d * TY[i];
+        positions[k].y = Y[i] + u * TY[i] + d * TX[i];
+    }
+}
+
+//------------------------------------------------------------------------------
+void Frenet::toFrenet(std::vector<Position> const& positions,
+                      std::vector<size_t>& hints,
+                      std::vector<Coordinates>& coordinates) const
+{
+    size_t const count = positions.size();
+    if (hints.size() != count)
+    {
+        hints.assign(count, NONE);
+    }
+    coordinates.resize(count);
+
+    for (size_t k = 0u; k < count; ++k)
+    {
+        coordinates[k] = toFrenet(positions[k], hints[k]);
+    }
+}
+
+} // namespace math
@@ -1,6 +1,228 @@
-// TODO https://github.com/Lecrapouille/Highway/issues/12
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
 
-https://kangcshin.github.io/project/path-planning
-https://fjp.at/posts/optimal-frenet/
-https://github.com/fjp/frenet
-https://github.com/MajidMoghadam2006/frenet-trajectory-planning-framework
+#ifndef MATH_FRENET_HPP
+#  define MATH_FRENET_HPP
+
+#  include <cstddef>
+#  include <cstdint>
+#  include <limits>
+#  include <vector>
+
+namespace math {
+
+// *****************************************************************************
+//! \brief Frenet frame along a reference line (the center line of a road or
+//! of a lane) given as a polyline: a world position (x, y) is converted into
+//! its curvilinear abscissa s along the line and its signed lateral offset d
+//! (positive on the left side of the line) and vice versa. Curved lines are
+//! sampled as dense polylines.
+//!
+//! Since lane-relative planners and traffic models convert coordinates of
+//! each agent at each tick:
+//!   - the arc-length parameterization is precomputed: cumulative abscissas of
+//!     vertices, unit tangents of segments, and a table giving the segment
+//!     holding the abscissa k * step, making Frenet to Cartesian conversions
+//!     O(1).
+//!   - the nearest point search of Cartesian to Frenet conversions is warm
+//!     started from the segment found at the previous tick (a hint): the search
+//!     walks to the neighbor segments while the distance decreases, which is
+//!     O(1) for agents moving smoothly. Without hint, all segments are scanned.
+//!   - data are stored as structure of arrays. Batched Frenet to Cartesian
+//!     conversions are split into a scalar pass finding segments and a
+//!     branchless arithmetic pass the compiler can vectorize.
+//! Computations are made with plain doubles, like for ReedsShepp.
+//!
+//! Since the frame is piecewise linear, Frenet to Cartesian and back is exact
+//! except near vertices on the inner side of bends where the abscissa error is
+//! bounded by |d| times the angle between the two segments.
+//!
+//! Positions before the origin or after the end of the line are extrapolated
+//! along the first or last segment.
+// *****************************************************************************
+class Frenet
+{
+public:
+
+    //! \brief Hint meaning "no previous segment known".
+    static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+    // *************************************************************************
+    //! \brief World position [meter].
+    // *************************************************************************
+    struct Position
+    {
+        double x = 0.0;
+        double y = 0.0;
+    };
+
+    // *************************************************************************
+    //! \brief Frenet coordinates [meter]: curvilinear abscissa and signed
+    //! lateral offset (positive on the left of the reference line).
+    // *************************************************************************
+    struct Coordinates
+    {
+        double s = 0.0;
+        double d = 0.0;
+    };
+
+public:
+
+    //--------------------------------------------------------------------------
+    //! \brief Empty reference line.
+    //--------------------------------------------------------------------------
+    Frenet() = default;
+
+    //--------------------------------------------------------------------------
+    //! \brief Build the reference line. See build().
+    //--------------------------------------------------------------------------
+    explicit Frenet(std::vector<Position> const& polyline, double const step = 1.0)
+    {
+        build(polyline, step);
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Precompute the arc-length tables of the given polyline.
+    //! Consecutive duplicated vertices are ignored.
+    //! \param[in] polyline: at least two distinct vertices.
+    //! \param[in] step: resolution of the abscissa lookup table [meter].
+    //! \return false if the polyline has less than two distinct vertices (the
+    //! reference line is then empty).
+    //--------------------------------------------------------------------------
+    bool build(std::vector<Position> const& polyline, double const step = 1.0);
+
+    //--------------------------------------------------------------------------
+    //! \brief Is the reference line empty ?
+    //--------------------------------------------------------------------------
+    inline bool empty() const
+    {
+        return m_tx.empty();
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the number of segments.
+    //--------------------------------------------------------------------------
+    inline size_t segments() const
+    {
+        return m_tx.size();
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the length of the reference line [meter].
+    //--------------------------------------------------------------------------
+    inline double length() const
+    {
+        return m_s.empty() ? 0.0 : m_s.back();
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the vertices of the reference line.
+    //--------------------------------------------------------------------------
+    std::vector<Position> vertices() const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the vertices of the line parallel to the reference line
+    //! at the lateral offset d (same number of vertices). Vertices are moved
+    //! along the bisector of their two segments so that segments of the
+    //! parallel line stay at the distance |d|.
+    //--------------------------------------------------------------------------
+    std::vector<Position> offset(double const d) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the index of the segment holding the abscissa s. O(1).
+    //--------------------------------------------------------------------------
+    size_t segment(double const s) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the heading [radian] of the reference line at the
+    //! abscissa s.
+    //--------------------------------------------------------------------------
+    double heading(double const s) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Frenet to Cartesian conversion. O(1).
+    //--------------------------------------------------------------------------
+    Position toCartesian(Coordinates const& c) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Cartesian to Frenet conversion.
+    //! \param[in] p: world position.
+    //! \param[inout] hint: the segment found by the previous conversion of the
+    //! same agent (or NONE for scanning all segments). Updated with the segment
+    //! holding the nearest point.
+    //--------------------------------------------------------------------------
+    Coordinates toFrenet(Position const& p, size_t& hint) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Cartesian to Frenet conversion without hint. O(n).
+    //--------------------------------------------------------------------------
+    inline Coordinates toFrenet(Position const& p) const
+    {
+        size_t hint = NONE;
+        return toFrenet(p, hint);
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Batched Frenet to Cartesian conversions.
+    //! \param[in] coordinates: Frenet coordinates of agents.
+    //! \param[out] positions: world positions (resized).
+    //--------------------------------------------------------------------------
+    void toCartesian(std::vector<Coordinates> const& coordinates,
+                     std::vector<Position>& positions) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Batched Cartesian to Frenet conversions.
+    //! \param[in] positions: world positions of agents.
+    //! \param[inout] hints: segments found at the previous call, one per agent
+    //! (resized with NONE values when sizes differ).
+    //! \param[out] coordinates: Frenet coordinates (resized).
+    //--------------------------------------------------------------------------
+    void toFrenet(std::vector<Position> const& positions,
+                  std::vector<size_t>& hints,
+                  std::vector<Coordinates>& coordinates) const;
+
+private:
+
+    //--------------------------------------------------------------------------
+    //! \brief Project the position on the i-th segment.
+    //! \return the square of the distance to the segment.
+    //--------------------------------------------------------------------------
+    double project(Position const& p, size_t const i, Coordinates& c) const;
+
+private:
+
+    //! \brief Vertices of the polyline.
+    std::vector<double> m_x;
+    std::vector<double> m_y;
+    //! \brief Curvilinear abscissa of each vertex [meter].
+    std::vector<double> m_s;
+    //! \brief Unit tangent of each segment.
+    std::vector<double> m_tx;
+    std::vector<double> m_ty;
+    //! \brief Index of the segment holding the abscissa k * m_step.
+    std::vector<uint32_t> m_lookup;
+    //! \brief Resolution of the lookup table [meter].
+    double m_step = 1.0;
+};
+
+} // namespace math
+
+#endif
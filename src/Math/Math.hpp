@@ -30,6 +30,9 @@
 
 namespace math {
 
+//! \brief Half turn [rad].
+constexpr double PI = 3.14159265358979323846;
+
 //------------------------------------------------------------------------------
 // Taken from the Godot Engine
 inline bool is_equal_approx(double const a, double const b)
@@ -314,7 +317,8 @@ inline bool intersect(Segment<Meter> const& lineAB, Segment<Meter> const& lineCD
 }
 
 //------------------------------------------------------------------------------
-//! \brief
+//! \brief Return true if the projection of P on the line (AB) is inside the
+//! segment [AB].
 //------------------------------------------------------------------------------
 inline bool aligned(sf::Vector2<Meter> const& P, Segment<Meter> const& lineAB)
 {
@@ -324,7 +328,7 @@ inline bool aligned(sf::Vector2<Meter> const& P, Segment<Meter> const& lineAB)
    sf::Vector2<Meter> const AB = B - A;
    sf::Vector2<Meter> const AP = P - A;
    SquareMeter const d = math::dot(AP, AB);
-   return (d >= 0.0_m * 0.0_m) && (d <= math::dot(AP, AP));
+   return (d >= 0.0_m * 0.0_m) && (d <= math::dot(AB, AB));
 }
 
 } // namespace math
@@ -24,9 +24,56 @@
 
 #  define DB_PERLIN_IMPL
 #  include "perlin-noise/db_perlin.hpp"
+#  include "Common/ThreadPool.hpp"
 #  include <SFML/Graphics.hpp>
+#  include <algorithm>
 #  include <functional>
+#  include <vector>
 
 void perlin(sf::Image& image, sf::Vector2u const& dimension, std::function<sf::Color(const double, const double)> lambda);
 
+//------------------------------------------------------------------------------
+//! \brief Fill a row major grid of floats with a noise function. Bands of rows
+//! are computed by worker threads and the noise function is inlined in the
+//! loop over the columns (no call through std::function per sample).
+//! \param[out] grid: dimension.x columns and dimension.y rows (resized).
+//! \param[in] noise: functor (x, y) -> float called on each sample. Shall be
+//! thread safe.
+//! \param[in] threads: number of worker threads (0: number of CPU cores).
+//------------------------------------------------------------------------------
+template<class NOISE>
+void perlin(std::vector<float>& grid, sf::Vector2u const& dimension, NOISE const& noise,
+            size_t const threads = 0u)
+{
+    size_t const width = dimension.x;
+    size_t const height = dimension.y;
+    grid.resize(width * height);
+    if (grid.empty())
+        return ;
+
+    ThreadPool pool(threads);
+    size_t const bands = std::min(height, 4u * pool.size());
+    std::vector<std::future<void>> futures;
+    futures.reserve(bands);
+    for (size_t b = 0u; b < bands; ++b)
+    {
+        futures.push_back(pool.submit([&grid, &noise, width, height, bands, b]()
+        {
+            for (size_t y = b * height / bands; y < (b + 1u) * height / bands; ++y)
+            {
+                float* row = grid.data() + y * width;
+                double const fy = double(y);
+                for (size_t x = 0u; x < width; ++x)
+                {
+                    row[x] = noise(double(x), fy);
+                }
+            }
+        }));
+    }
+    for (auto& future: futures)
+    {
+        future.get();
+    }
+}
+
 #endif // MATH_PERLIN_HPP
@@ -0,0 +1,449 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "Math/ReedsShepp.hpp"
+#include "Math/Math.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace math {
+
+static constexpr double TWO_PI = 2.0 * PI;
+static constexpr double HALF_PI = 0.5 * PI;
+static constexpr double ZERO = 10.0 * std::numeric_limits<double>::epsilon();
+
+using S = ReedsShepp::Segment;
+
+//------------------------------------------------------------------------------
+//! \brief The 18 families of Reeds-Shepp words (others are obtained by
+//! timeflip and reflection).
+//------------------------------------------------------------------------------
+static const S WORDS[18][5] =
+{
+    { S::LEFT, S::RIGHT, S::LEFT, S::NOP, S::NOP },             // 0
+    { S::RIGHT, S::LEFT, S::RIGHT, S::NOP, S::NOP },            // 1
+    { S::LEFT, S::RIGHT, S::LEFT, S::RIGHT, S::NOP },           // 2
+    { S::RIGHT, S::LEFT, S::RIGHT, S::LEFT, S::NOP },           // 3
+    { S::LEFT, S::RIGHT, S::STRAIGHT, S::LEFT, S::NOP },        // 4
+    { S::RIGHT, S::LEFT, S::STRAIGHT, S::RIGHT, S::NOP },       // 5
+    { S::LEFT, S::STRAIGHT, S::RIGHT, S::LEFT, S::NOP },        // 6
+    { S::RIGHT, S::STRAIGHT, S::LEFT, S::RIGHT, S::NOP },       // 7
+    { S::LEFT, S::RIGHT, S::STRAIGHT, S::RIGHT, S::NOP },       // 8
+    { S::RIGHT, S::LEFT, S::STRAIGHT, S::LEFT, S::NOP },        // 9
+    { S::RIGHT, S::STRAIGHT, S::RIGHT, S::LEFT, S::NOP },       // 10
+    { S::LEFT, S::STRAIGHT, S::LEFT, S::RIGHT, S::NOP },        // 11
+    { S::LEFT, S::STRAIGHT, S::RIGHT, S::NOP, S::NOP },         // 12
+    { S::RIGHT, S::STRAIGHT, S::LEFT, S::NOP, S::NOP },         // 13
+    { S::LEFT, S::STRAIGHT, S::LEFT, S::NOP, S::NOP },          // 14
+    { S::RIGHT, S::STRAIGHT, S::RIGHT, S::NOP, S::NOP },        // 15
+    { S::LEFT, S::RIGHT, S::STRAIGHT, S::LEFT, S::RIGHT },      // 16
+    { S::RIGHT, S::LEFT, S::STRAIGHT, S::RIGHT, S::LEFT }       // 17
+};
+
+//------------------------------------------------------------------------------
+//! \brief Wrap the angle to [-pi, pi].
+static inline double mod2pi(double const x)
+{
+    double v = std::fmod(x, TWO_PI);
+    if (v < -PI)
+        v += TWO_PI;
+    else if (v > PI)
+        v -= TWO_PI;
+    return v;
+}
+
+//------------------------------------------------------------------------------
+static inline void polar(double const x, double const y, double& r, double& theta)
+{
+    r = std::sqrt(x * x + y * y);
+    theta = std::atan2(y, x);
+}
+
+//------------------------------------------------------------------------------
+static inline void tauOmega(double const u, double const v, double const xi,
+                            double const eta, double const phi,
+                            double& tau, double& omega)
+{
+    const double delta = mod2pi(u - v);
+    const double A = std::sin(u) - std::sin(delta);
+    const double B = std::cos(u) - std::cos(delta) - 1.0;
+    const double t1 = std::atan2(eta * A - xi * B, xi * A + eta * B);
+    const double t2 = 2.0 * (std::cos(delta) - std::cos(v) - std::cos(u)) + 3.0;
+    tau = (t2 < 0.0) ? mod2pi(t1 + PI) : mod2pi(t1);
+    omega = mod2pi(tau - u + v - phi);
+}
+
+//------------------------------------------------------------------------------
+// Formula 8.1
+static inline bool LpSpLp(double x, double y, double phi, double& t, double& u, double& v)
+{
+    polar(x - std::sin(phi), y - 1.0 + std::cos(phi), u, t);
+    if (t >= -ZERO)
+    {
+        v = mod2pi(phi - t);
+        if (v >= -ZERO)
+            return true;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// Formula 8.2
+static inline bool LpSpRp(double x, double y, double phi, double& t, double& u, double& v)
+{
+    double t1, u1;
+    polar(x + std::sin(phi), y - 1.0 - std::cos(phi), u1, t1);
+    u1 = u1 * u1;
+    if (u1 >= 4.0)
+    {
+        u = std::sqrt(u1 - 4.0);
+        const double theta = std::atan2(2.0, u);
+        t = mod2pi(t1 + theta);
+        v = mod2pi(t - phi);
+        return (t >= -ZERO) && (v >= -ZERO);
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// Formula 8.3 / 8.4 (typo in the paper)
+static inline bool LpRmL(double x, double y, double phi, double& t, double& u, double& v)
+{
+    double u1, theta;
+    polar(x - std::sin(phi), y - 1.0 + std::cos(phi), u1, theta);
+    if (u1 <= 4.0)
+    {
+        u = -2.0 * std::asin(0.25 * u1);
+        t = mod2pi(theta + 0.5 * u + PI);
+        v = mod2pi(phi - t + u);
+        return (t >= -ZERO) && (u <= ZERO);
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// Formula 8.7
+static inline bool LpRupLumRm(double x, double y, double phi, double& t, double& u, double& v)
+{
+    const double xi = x + std::sin(phi);
+    const double eta = y - 1.0 - std::cos(phi);
+    const double rho = 0.25 * (2.0 + std::sqrt(xi * xi + eta * eta));
+    if (rho <= 1.0)
+    {
+        u = std::acos(rho);
+        tauOmega(u, -u, xi, eta, phi, t, v);
+        return (t >= -ZERO) && (v <= ZERO);
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// Formula 8.8
+static inline bool LpRumLumRp(double x, double y, double phi, double& t, double& u, double& v)
+{
+    const double xi = x + std::sin(phi);
+    const double eta = y - 1.0 - std::cos(phi);
+    const double rho = (20.0 - xi * xi - eta * eta) / 16.0;
+    if ((rho >= 0.0) && (rho <= 1.0))
+    {
+        u = -std::acos(rho);
+        if (u >= -HALF_PI)
+        {
+            tauOmega(u, u, xi, eta, phi, t, v);
+            return (t >= -ZERO) && (v >= -ZERO);
+        }
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// Formula 8.9
+static inline bool LpRmSmLm(double x, double y, double phi, double& t, double& u, double& v)
+{
+    double rho, theta;
+    polar(x - std::sin(phi), y - 1.0 + std::cos(phi), rho, theta);
+    if (rho >= 2.0)
+    {
+        const double r = std::sqrt(rho * rho - 4.0);
+        u = 2.0 - r;
+        t = mod2pi(theta + std::atan2(r, -2.0));
+        v = mod2pi(phi - HALF_PI - t);
+        return (t >= -ZERO) && (u <= ZERO) && (v <= ZERO);
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// Formula 8.10
+static inline bool LpRmSmRm(double x, double y, double phi, double& t, double& u, double& v)
+{
+    double rho, theta;
+    polar(-(y - 1.0 - std::cos(phi)), x + std::sin(phi), rho, theta);
+    if (rho >= 2.0)
+    {
+        t = theta;
+        u = 2.0 - rho;
+        v = mod2pi(t + HALF_PI - phi);
+        return (t >= -ZERO) && (u <= ZERO) && (v <= ZERO);
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// Formula 8.11 (typo in the paper)
+static inline bool LpRmSLmRp(double x, double y, double phi, double& t, double& u, double& v)
+{
+    const double xi = x + std::sin(phi);
+    const double eta = y - 1.0 - std::cos(phi);
+    double rho, theta;
+    polar(xi, eta, rho, theta);
+    if (rho >= 2.0)
+    {
+        u = 4.0 - std::sqrt(rho * rho - 4.0);
+        if (u <= ZERO)
+        {
+            t = mod2pi(std::atan2((4.0 - u) * xi - 2.0 * eta, -2.0 * xi + (u - 4.0) * eta));
+            v = mod2pi(t - phi);
+            return (t >= -ZERO) && (v >= -ZERO);
+        }
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+static inline double len(double const t, double const u, double const v)
+{
+    return std::abs(t) + std::abs(u) + std::abs(v);
+}
+
+//------------------------------------------------------------------------------
+//! \brief Keep the given candidate if shorter than the current best path.
+static inline void keep(ReedsShepp::Path& best, double const length,
+                        ReedsShepp::Path const& candidate)
+{
+    if (length < best.total)
+    {
+        best = candidate;
+    }
+}
+
+//------------------------------------------------------------------------------
+static void CSC(double x, double y, double phi, ReedsShepp::Path& path)
+{
+    double t, u, v;
+    if (LpSpLp(x, y, phi, t, u, v))   keep(path, len(t, u, v), { WORDS[14], t, u, v });
+    if (LpSpLp(-x, y, -phi, t, u, v)) keep(path, len(t, u, v), { WORDS[14], -t, -u, -v }); // timeflip
+    if (LpSpLp(x, -y, -phi, t, u, v)) keep(path, len(t, u, v), { WORDS[15], t, u, v });    // reflect
+    if (LpSpLp(-x, -y, phi, t, u, v)) keep(path, len(t, u, v), { WORDS[15], -t, -u, -v }); // timeflip + reflect
+    if (LpSpRp(x, y, phi, t, u, v))   keep(path, len(t, u, v), { WORDS[12], t, u, v });
+    if (LpSpRp(-x, y, -phi, t, u, v)) keep(path, len(t, u, v), { WORDS[12], -t, -u, -v });
+    if (LpSpRp(x, -y, -phi, t, u, v)) keep(path, len(t, u, v), { WORDS[13], t, u, v });
+    if (LpSpRp(-x, -y, phi, t, u, v)) keep(path, len(t, u, v), { WORDS[13], -t, -u, -v });
+}
+
+//------------------------------------------------------------------------------
+static void CCC(double x, double y, double phi, ReedsShepp::Path& path)
+{
+    double t, u, v;
+    if (LpRmL(x, y, phi, t, u, v))   keep(path, len(t, u, v), { WORDS[0], t, u, v });
+    if (LpRmL(-x, y, -phi, t, u, v)) keep(path, len(t, u, v), { WORDS[0], -t, -u, -v });
+    if (LpRmL(x, -y, -phi, t, u, v)) keep(path, len(t, u, v), { WORDS[1], t, u, v });
+    if (LpRmL(-x, -y, phi, t, u, v)) keep(path, len(t, u, v), { WORDS[1], -t, -u, -v });
+
+    // Backwards
+    const double xb = x * std::cos(phi) + y * std::sin(phi);
+    const double yb = x * std::sin(phi) - y * std::cos(phi);
+    if (LpRmL(xb, yb, phi, t, u, v))   keep(path, len(t, u, v), { WORDS[0], v, u, t });
+    if (LpRmL(-xb, yb, -phi, t, u, v)) keep(path, len(t, u, v), { WORDS[0], -v, -u, -t });
+    if (LpRmL(xb, -yb, -phi, t, u, v)) keep(path, len(t, u, v), { WORDS[1], v, u, t });
+    if (LpRmL(-xb, -yb, phi, t, u, v)) keep(path, len(t, u, v), { WORDS[1], -v, -u, -t });
+}
+
+//------------------------------------------------------------------------------
+static void CCCC(double x, double y, double phi, ReedsShepp::Path& path)
+{
+    double t, u, v;
+    if (LpRupLumRm(x, y, phi, t, u, v))   keep(path, len(t, u, v) + std::abs(u), { WORDS[2], t, u, -u, v });
+    if (LpRupLumRm(-x, y, -phi, t, u, v)) keep(path, len(t, u, v) + std::abs(u), { WORDS[2], -t, -u, u, -v });
+    if (LpRupLumRm(x, -y, -phi, t, u, v)) keep(path, len(t, u, v) + std::abs(u), { WORDS[3], t, u, -u, v });
+    if (LpRupLumRm(-x, -y, phi, t, u, v)) keep(path, len(t, u, v) + std::abs(u), { WORDS[3], -t, -u, u, -v });
+
+    if (LpRumLumRp(x, y, phi, t, u, v))   keep(path, len(t, u, v) + std::abs(u), { WORDS[2], t, u, u, v });
+    if (LpRumLumRp(-x, y, -phi, t, u, v)) keep(path, len(t, u, v) + std::abs(u), { WORDS[2], -t, -u, -u, -v });
+    if (LpRumLumRp(x, -y, -phi, t, u, v)) keep(path, len(t, u, v) + std::abs(u), { WORDS[3], t, u, u, v });
+    if (LpRumLumRp(-x, -y, phi, t, u, v)) keep(path, len(t, u, v) + std::abs(u), { WORDS[3], -t, -u, -u, -v });
+}
+
+//------------------------------------------------------------------------------
+static void CCSC(double x, double y, double phi, ReedsShepp::Path& path)
+{
+    double t, u, v;
+    if (LpRmSmLm(x, y, phi, t, u, v))   keep(path, len(t, u, v) + HALF_PI, { WORDS[4], t, -HALF_PI, u, v });
+    if (LpRmSmLm(-x, y, -phi, t, u, v)) keep(path, len(t, u, v) + HALF_PI, { WORDS[4], -t, HALF_PI, -u, -v });
+    if (LpRmSmLm(x, -y, -phi, t, u, v)) keep(path, len(t, u, v) + HALF_PI, { WORDS[5], t, -HALF_PI, u, v });
+    if (LpRmSmLm(-x, -y, phi, t, u, v)) keep(path, len(t, u, v) + HALF_PI, { WORDS[5], -t, HALF_PI, -u, -v });
+
+    if (LpRmSmRm(x, y, phi, t, u, v))   keep(path, len(t, u, v) + HALF_PI, { WORDS[8], t, -HALF_PI, u, v });
+    if (LpRmSmRm(-x, y, -phi, t, u, v)) keep(path, len(t, u, v) + HALF_PI, { WORDS[8], -t, HALF_PI, -u, -v });
+    if (LpRmSmRm(x, -y, -phi, t, u, v)) keep(path, len(t, u, v) + HALF_PI, { WORDS[9], t, -HALF_PI, u, v });
+    if (LpRmSmRm(-x, -y, phi, t, u, v)) keep(path, len(t, u, v) + HALF_PI, { WORDS[9], -t, HALF_PI, -u, -v });
+
+    // Backwards
+    const double xb = x * std::cos(phi) + y * std::sin(phi);
+    const double yb = x * std::sin(phi) - y * std::cos(phi);
+    if (LpRmSmLm(xb, yb, phi, t, u, v))   keep(path, len(t, u, v) + HALF_PI, { WORDS[6], v, u, -HALF_PI, t });
+    if (LpRmSmLm(-xb, yb, -phi, t, u, v)) keep(path, len(t, u, v) + HALF_PI, { WORDS[6], -v, -u, HALF_PI, -t });
+    if (LpRmSmLm(xb, -yb, -phi, t, u, v)) keep(path, len(t, u, v) + HALF_PI, { WORDS[7], v, u, -HALF_PI, t });
+    if (LpRmSmLm(-xb, -yb, phi, t, u, v)) keep(path, len(t, u, v) + HALF_PI, { WORDS[7], -v, -u, HALF_PI, -t });
+
+    if (LpRmSmRm(xb, yb, phi, t, u, v))   keep(path, len(t, u, v) + HALF_PI, { WORDS[10], v, u, -HALF_PI, t });
+    if (LpRmSmRm(-xb, yb, -phi, t, u, v)) keep(path, len(t, u, v) + HALF_PI, { WORDS[10], -v, -u, HALF_PI, -t });
+    if (LpRmSmRm(xb, -yb, -phi, t, u, v)) keep(path, len(t, u, v) + HALF_PI, { WORDS[11], v, u, -HALF_PI, t });
+    if (LpRmSmRm(-xb, -yb, phi, t, u, v)) keep(path, len(t, u, v) + HALF_PI, { WORDS[11], -v, -u, HALF_PI, -t });
+}
+
+//------------------------------------------------------------------------------
+static void CCSCC(double x, double y, double phi, ReedsShepp::Path& path)
+{
+    double t, u, v;
+    if (LpRmSLmRp(x, y, phi, t, u, v))   keep(path, len(t, u, v) + PI, { WORDS[16], t, -HALF_PI, u, -HALF_PI, v });
+    if (LpRmSLmRp(-x, y, -phi, t, u, v)) keep(path, len(t, u, v) + PI, { WORDS[16], -t, HALF_PI, -u, HALF_PI, -v });
+    if (LpRmSLmRp(x, -y, -phi, t, u, v)) keep(path, len(t, u, v) + PI, { WORDS[17], t, -HALF_PI, u, -HALF_PI, v });
+    if (LpRmSLmRp(-x, -y, phi, t, u, v)) keep(path, len(t, u, v) + PI, { WORDS[17], -t, HALF_PI, -u, HALF_PI, -v });
+}
+
+//------------------------------------------------------------------------------
+//! \brief Shortest path to (x, y, phi) from the origin, for a unit radius.
+static ReedsShepp::Path shortest(double const x, double const y, double const phi)
+{
+    ReedsShepp::Path path;
+    CSC(x, y, phi, path);
+    CCC(x, y, phi, path);
+    CCCC(x, y, phi, path);
+    CCSC(x, y, phi, path);
+    CCSCC(x, y, phi, path);
+    return path;
+}
+
+//------------------------------------------------------------------------------
+ReedsShepp::Path::Path()
+    : total(std::numeric_limits<double>::infinity())
+{
+    types.fill(S::NOP);
+    lengths.fill(0.0);
+}
+
+//------------------------------------------------------------------------------
+ReedsShepp::Path::Path(Segment const* t, double l0, double l1, double l2,
+                       double l3, double l4)
+    : lengths({ l0, l1, l2, l3, l4 })
+{
+    std::copy(t, t + 5, types.begin());
+    total = std::abs(l0) + std::abs(l1) + std::abs(l2) + std::abs(l3) + std::abs(l4);
+}
+
+//------------------------------------------------------------------------------
+ReedsShepp::Path ReedsShepp::path(Pose const& from, Pose const& to) const
+{
+    const double dx = to.x - from.x;
+    const double dy = to.y - from.y;
+    const double c = std::cos(from.theta);
+    const double s = std::sin(from.theta);
+    const double x = c * dx + s * dy;
+    const double y = -s * dx + c * dy;
+    return shortest(x / m_radius, y / m_radius, to.theta - from.theta);
+}
+
+//------------------------------------------------------------------------------
+double ReedsShepp::distance(double const x, double const y, double const theta) const
+{
+    return m_radius * shortest(x / m_radius, y / m_radius, theta).length();
+}
+
+//------------------------------------------------------------------------------
+ReedsShepp::Pose ReedsShepp::interpolate(Pose const& from, Path const& path,
+                                         double const s, size_t& segment) const
+{
+    // Work in the normalized frame (unit radius) centered on the initial pose.
+    double seg = std::min(std::max(s / m_radius, 0.0), path.length());
+    double x = 0.0, y = 0.0, phi = from.theta;
+
+    segment = 0u;
+    for (size_t i = 0u; (i < 5u) && (seg > 0.0); ++i)
+    {
+        double v;
+        if (path.lengths[i] < 0.0)
+        {
+            v = std::max(-seg, path.lengths[i]);
+            seg += v;
+        }
+        else
+        {
+            v = std::min(seg, path.lengths[i]);
+            seg -= v;
+        }
+
+        segment = i;
+        switch (path.types[i])
+        {
+        case S::LEFT:
+            x += std::sin(phi + v) - std::sin(phi);
+            y += -std::cos(phi + v) + std::cos(phi);
+            phi += v;
+            break;
+        case S::RIGHT:
+            x += -std::sin(phi - v) + std::sin(phi);
+            y += std::cos(phi - v) - std::cos(phi);
+            phi -= v;
+            break;
+        case S::STRAIGHT:
+            x += v * std::cos(phi);
+            y += v * std::sin(phi);
+            break;
+        case S::NOP:
+            break;
+        }
+    }
+
+    return { from.x + x * m_radius, from.y + y * m_radius, phi };
+}
+
+//------------------------------------------------------------------------------
+std::vector<ReedsShepp::Pose>
+ReedsShepp::sample(Pose const& from, Path const& path, double const step) const
+{
+    std::vector<Pose> poses;
+    const double length = m_radius * path.length();
+    if (!std::isfinite(length))
+        return poses;
+
+    size_t segment;
+    poses.reserve(size_t(length / step) + 2u);
+    for (double s = 0.0; s < length; s += step)
+    {
+        poses.push_back(interpolate(from, path, s, segment));
+    }
+    poses.push_back(interpolate(from, path, length, segment));
+    return poses;
+}
+
+} // namespace math
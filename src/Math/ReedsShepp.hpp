@@ -0,0 +1,139 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef MATH_REEDS_SHEPP_HPP
+#  define MATH_REEDS_SHEPP_HPP
+
+#  include <array>
+#  include <cstddef>
+#  include <vector>
+
+namespace math {
+
+// *****************************************************************************
+//! \brief Shortest path between two poses for a car-like vehicle driving
+//! forward and backward with a minimal turning radius (Reeds & Shepp, "Optimal
+//! paths for a car that goes both forwards and backwards", 1990). The path is
+//! made of at most five segments among left turn, right turn and straight
+//! line, with forward (positive length) or backward (negative length) motion.
+//! The implementation follows the formulas of the paper (with the typos fixed
+//! as done in the OMPL library). Computations are made with plain doubles
+//! since this is called intensively by search-based planners.
+// *****************************************************************************
+class ReedsShepp
+{
+public:
+
+    // *************************************************************************
+    //! \brief Kind of segment.
+    // *************************************************************************
+    enum Segment { NOP, LEFT, STRAIGHT, RIGHT };
+
+    // *************************************************************************
+    //! \brief Pose of the middle of the rear axle [meter, meter, radian].
+    // *************************************************************************
+    struct Pose
+    {
+        double x = 0.0;
+        double y = 0.0;
+        double theta = 0.0;
+    };
+
+    // *************************************************************************
+    //! \brief Reeds-Shepp path. Lengths are normalized by the turning radius
+    //! and signed by the direction of motion (negative: backward).
+    // *************************************************************************
+    struct Path
+    {
+        Path();
+        Path(Segment const* types, double t, double u, double v = 0.0,
+             double w = 0.0, double x = 0.0);
+
+        //! \brief Total normalized length (infinity when no path).
+        inline double length() const { return total; }
+
+        std::array<Segment, 5u> types;
+        std::array<double, 5u> lengths;
+        double total;
+    };
+
+public:
+
+    //--------------------------------------------------------------------------
+    //! \brief Set the minimal turning radius of the vehicle [meter].
+    //--------------------------------------------------------------------------
+    explicit ReedsShepp(double const radius)
+        : m_radius(radius)
+    {}
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the minimal turning radius [meter].
+    //--------------------------------------------------------------------------
+    inline double radius() const
+    {
+        return m_radius;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Compute the shortest path from the pose \c from to the pose \c to.
+    //--------------------------------------------------------------------------
+    Path path(Pose const& from, Pose const& to) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Length in meter of the shortest path between two poses.
+    //--------------------------------------------------------------------------
+    inline double distance(Pose const& from, Pose const& to) const
+    {
+        return m_radius * path(from, to).length();
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Length in meter of the shortest path reaching the pose (x, y,
+    //! theta) expressed in the frame of the initial pose.
+    //--------------------------------------------------------------------------
+    double distance(double const x, double const y, double const theta) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the pose reached after travelling the given distance
+    //! along the path.
+    //! \param[in] from: the initial pose of the path.
+    //! \param[in] path: the path to follow.
+    //! \param[in] s: the travelled distance [meter] in [0 .. radius * length].
+    //! \param[out] segment: the index of the segment holding the pose.
+    //--------------------------------------------------------------------------
+    Pose interpolate(Pose const& from, Path const& path, double const s,
+                     size_t& segment) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Sample poses along the path every \c step meters (the final pose
+    //! is always added).
+    //--------------------------------------------------------------------------
+    std::vector<Pose> sample(Pose const& from, Path const& path, double const step) const;
+
+private:
+
+    //! \brief Minimal turning radius [meter].
+    double m_radius;
+};
+
+} // namespace math
+
+#endif
@@ -34,8 +34,8 @@
 //------------------------------------------------------------------------------
 void Renderer::draw(Lane const& lane, sf::RenderTarget& target, sf::RenderStates const& states)
 {
-    sf::RectangleShape const& shape = lane.shape();
-    target.draw(shape, states);
+    target.draw(lane.vertices(), states);
+    target.draw(lane.outline(), states);
     // Draw the origin of the lane
     target.draw(Circle(lane.origin(), 0.01_m, sf::Color::Black, 8u), states);
 }
@@ -80,6 +80,12 @@ void Renderer::draw(Parking const& parking, sf::RenderTarget& target, sf::Render
     target.draw(Circle(parking.origin(), 0.01_m, sf::Color::Red, 8u), states);
 }
 
+//------------------------------------------------------------------------------
+void Renderer::draw(Pedestrian const& pedestrian, sf::RenderTarget& target, sf::RenderStates const& states)
+{
+    target.draw(Circle(pedestrian.position(), pedestrian.radius(), sf::Color::Magenta, 12u), states);
+}
+
 //------------------------------------------------------------------------------
 void Renderer::draw(Car const& car, sf::RenderTarget& target, sf::RenderStates const& states)
 {
@@ -28,6 +28,7 @@ class Parking;
 class Lane;
 class Road;
 class Car;
+class Pedestrian;
 //class SpatialHashGrid;
 
 // *****************************************************************************
@@ -41,6 +42,7 @@ public:
     static void draw(Lane const& lane, sf::RenderTarget& target, sf::RenderStates const& states = sf::RenderStates::Default);
     static void draw(Road const& road, sf::RenderTarget& target, sf::RenderStates const& states = sf::RenderStates::Default);
     static void draw(Car const& Car, sf::RenderTarget& target, sf::RenderStates const& states = sf::RenderStates::Default);
+    static void draw(Pedestrian const& pedestrian, sf::RenderTarget& target, sf::RenderStates const& states = sf::RenderStates::Default);
     //static void draw(SpatialHashGrid const& grid, sf::RenderTarget& target, sf::RenderStates const& states = sf::RenderStates::Default);
 };
 
@@ -34,9 +34,9 @@ Antenna::Antenna(AntennaBluePrint const& blueprint_, const char* name_,
 void Antenna::update(Second const dt)
 {
     m_detection.valid = false;
-    for (auto const& car: m_city.cars()) // TODO m_city.collidables()
+    for (Car const& car: m_city.cars(City::CarGroup::Traffic | City::CarGroup::Agent))
     {
-        if (detects(car->obb(), m_detection.position))
+        if (detects(car.obb(), m_detection.position))
         {
             m_detection.valid = true;
             m_detection.distance = math::distance(m_detection.position, shape.position());
@@ -44,6 +44,30 @@ void Antenna::update(Second const dt)
             return ;
         }
     }
+
+    // Sleeping cars are looked for in the static grid of the city.
+    m_city.statics(shape.obb().getGlobalBounds(), m_statics);
+    for (Car const* car: m_statics)
+    {
+        if (detects(car->obb(), m_detection.position))
+        {
+            m_detection.valid = true;
+            m_detection.distance = math::distance(m_detection.position, shape.position());
+            return ;
+        }
+    }
+
+    // Pedestrians are looked for in the spatial hash grid of the crowd.
+    m_city.crowd().find(shape.obb().getGlobalBounds(), m_pedestrians);
+    for (Pedestrian const* pedestrian: m_pedestrians)
+    {
+        if (detects(pedestrian->obb(), m_detection.position))
+        {
+            m_detection.valid = true;
+            m_detection.distance = math::distance(m_detection.position, shape.position());
+            return ;
+        }
+    }
 }
 
 //------------------------------------------------------------------------------
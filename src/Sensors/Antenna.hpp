@@ -25,6 +25,8 @@
 #  include "Sensors/Sensor.hpp"
 
 class City;
+class Pedestrian;
+class Car;
 
 // ****************************************************************************
 //! \brief A sensor shape is just a blue print used inside of the vehicle shape
@@ -112,6 +114,10 @@ public:
 private:
 
     Detection m_detection;
+    //! \brief Pedestrians near the sensor (avoid allocations).
+    std::vector<Pedestrian const*> m_pedestrians;
+    //! \brief Sleeping cars near the sensor (avoid allocations).
+    std::vector<Car const*> m_statics;
 };
 
 #endif
@@ -36,13 +36,33 @@ void Radar::update(Second const dt)
     sf::Vector2f p;
 
     m_detections.clear();
-    for (auto const& car: m_city.cars()) // TODO m_city.collidables()
+    for (Car const& car: m_city.cars(City::CarGroup::Traffic | City::CarGroup::Agent))
+    {
+        if (detects(car.obb(), p))
+        {
+            m_detections.push_back(sf::Vector2<Meter>(Meter(p.x), Meter(p.y)));
+        }
+    }
+
+    // Sleeping cars are looked for in the static grid of the city.
+    m_city.statics(shape.obb().getGlobalBounds(), m_statics);
+    for (Car const* car: m_statics)
     {
         if (detects(car->obb(), p))
         {
             m_detections.push_back(sf::Vector2<Meter>(Meter(p.x), Meter(p.y)));
         }
     }
+
+    // Pedestrians are looked for in the spatial hash grid of the crowd.
+    m_city.crowd().find(shape.obb().getGlobalBounds(), m_pedestrians);
+    for (Pedestrian const* pedestrian: m_pedestrians)
+    {
+        if (detects(pedestrian->obb(), p))
+        {
+            m_detections.push_back(sf::Vector2<Meter>(Meter(p.x), Meter(p.y)));
+        }
+    }
 }
 
 //------------------------------------------------------------------------------
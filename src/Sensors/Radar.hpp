@@ -26,6 +26,8 @@
 #  include "Sensors/Sensor.hpp"
 
 class City;
+class Pedestrian;
+class Car;
 
 // ****************************************************************************
 //! \brief
@@ -109,6 +111,10 @@ private:
     Arc m_coverage_area;
     //! \brief Points detected by the sensor
     std::vector<sf::Vector2<Meter>> m_detections;
+    //! \brief Pedestrians near the sensor (avoid allocations).
+    std::vector<Pedestrian const*> m_pedestrians;
+    //! \brief Sleeping cars near the sensor (avoid allocations).
+    std::vector<Car const*> m_statics;
 };
 
 #endif
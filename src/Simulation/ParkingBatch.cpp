@@ -0,0 +1,232 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "Simulation/ParkingBatch.hpp"
+#include "Simulation/BluePrints.hpp"
+#include "ECUs/AutoParkECU/TrajectoryPlanner.hpp"
+#include "ECUs/AutoParkECU/ParallelTrajectory.hpp"
+#include "City/Parking.hpp"
+#include "Vehicle/Car.hpp"
+#include "Math/Collide.hpp"
+#include "Math/Math.hpp"
+#include "MyLogger/Logger.hpp"
+#include <random>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+//------------------------------------------------------------------------------
+ParkingBatch::Case ParkingBatch::generate(size_t const id) const
+{
+    // One generator per case: results do not depend on the scheduling of
+    // worker threads.
+    std::seed_seq seq{ m_config.seed, uint32_t(id) };
+    std::mt19937 gen(seq);
+    auto uniform = [&gen](double const a, double const b)
+    {
+        return std::uniform_real_distribution<double>(a, b)(gen);
+    };
+    auto pick = [&gen](std::vector<std::string> const& names)
+    {
+        assert(!names.empty());
+        return names[std::uniform_int_distribution<size_t>(0u, names.size() - 1u)(gen)];
+    };
+
+    Case c;
+    c.id = id;
+    c.car = pick(m_config.cars);
+    c.parking = pick(m_config.parkings);
+    ParkingBluePrint const& bp = BluePrints::get<ParkingBluePrint>(c.parking.c_str());
+    CarBluePrint const& car = BluePrints::get<CarBluePrint>(c.car.c_str());
+    c.length = car.length + Meter(uniform(m_config.min_length, m_config.max_length));
+    c.width = bp.width + Meter(uniform(m_config.min_width, m_config.max_width));
+    c.back_gap = Meter(uniform(m_config.min_gap, m_config.max_gap));
+    c.front_gap = Meter(uniform(m_config.min_gap, m_config.max_gap));
+    c.x = Meter(uniform(m_config.min_x, m_config.max_x));
+    c.y = Meter(uniform(m_config.min_y, m_config.max_y));
+    c.heading = Degree(uniform(m_config.min_heading, m_config.max_heading));
+    return c;
+}
+
+//------------------------------------------------------------------------------
+ParkingBatch::Result ParkingBatch::run(Case const& c) const
+{
+    Result result;
+
+    // The kerb is along the X-axis, the slot starts at the origin.
+    ParkingBluePrint const& bp = BluePrints::get<ParkingBluePrint>(c.parking.c_str());
+    ParkingBluePrint const dim(c.length, c.width, bp.angle);
+    Parking const spot(dim, sf::Vector2<Meter>(0.0_m, 0.0_m), 0.0_rad);
+
+    // Distance between two consecutive slots along the kerb.
+    Meter const pitch = (bp.angle.value() < 1.0)
+                      ? c.length : c.width / units::math::sin(bp.angle);
+
+    // Parked neighbours in the previous and the next slots.
+    Car back(c.car.c_str(), sf::Color::Blue);
+    Car front(c.car.c_str(), sf::Color::Blue);
+    Car* neighbours[2] = { &back, &front };
+    Meter const offsets[2] = { -pitch - c.back_gap, pitch + c.front_gap };
+    for (size_t i = 0u; i < 2u; ++i)
+    {
+        Parking const slot(dim, sf::Vector2<Meter>(offsets[i], 0.0_m), 0.0_rad);
+        sf::Vector2<Meter> position;
+        Radian heading;
+        slot.goal(neighbours[i]->blueprint, position, heading);
+        neighbours[i]->init(0.0_mps_sq, 0.0_mps, position, heading);
+        neighbours[i]->update(0.0_s);
+    }
+
+    // Ego car driving along the slots.
+    Car ego(c.car.c_str(), sf::Color::Green);
+    ego.init(0.0_mps_sq, 0.0_mps, sf::Vector2<Meter>(pitch + c.x, c.y), c.heading);
+    ego.update(0.0_s);
+
+    // Plan in the caller thread: the batch is already running in workers.
+    TrajectoryRequest request(ego, spot, true);
+    request.obstacles.push_back(back.obb());
+    request.obstacles.push_back(front.obb());
+    // Results shall neither depend on previous runs nor on the machine load.
+    request.cached = false;
+    request.candidates = ParallelTrajectory::candidates().size();
+    auto const start = std::chrono::steady_clock::now();
+    TrajectoryPlanner::Result planning = TrajectoryPlanner::plan(request);
+    result.planning_time = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    result.planned = planning.succeeded;
+    if (!result.planned)
+        return result;
+
+    // Drive along the trajectory.
+    Second const dt(m_config.dt);
+    Second const max_duration(m_config.max_duration);
+    bool hit[2] = { false, false };
+    int direction = 0;
+    while (result.duration < max_duration)
+    {
+        if (!planning.trajectory->update(ego, dt))
+        {
+            result.arrived = true;
+            break;
+        }
+        ego.update(dt);
+        result.duration += dt;
+
+        // Count changes of gear.
+        int const d = (ego.speed() > 0.01_mps) ? 1 : ((ego.speed() < -0.01_mps) ? -1 : 0);
+        if (d != 0)
+        {
+            if ((direction != 0) && (d != direction))
+            {
+                result.maneuvers += 1u;
+            }
+            direction = d;
+        }
+
+        // Count hit neighbours.
+        for (size_t i = 0u; i < 2u; ++i)
+        {
+            sf::Vector2f mtv;
+            if (!hit[i] && math::collide(ego.obb(), neighbours[i]->obb(), mtv))
+            {
+                hit[i] = true;
+                result.collisions += 1u;
+            }
+        }
+    }
+
+    // Final pose error.
+    sf::Vector2<Meter> position;
+    Radian heading;
+    spot.goal(ego.blueprint, position, heading);
+    Radian const error = ego.heading() - heading;
+    result.position_error = math::distance(ego.position(), position);
+    result.heading_error = units::math::abs(units::math::atan2(
+        units::math::sin(error), units::math::cos(error)));
+
+    result.succeeded = result.arrived && (result.collisions == 0u) &&
+        (result.position_error <= Meter(m_config.position_tolerance)) &&
+        (result.heading_error <= Degree(m_config.heading_tolerance));
+    return result;
+}
+
+//------------------------------------------------------------------------------
+bool ParkingBatch::run(std::string const& csv_file) const
+{
+    std::ofstream file(csv_file);
+    if (!file)
+    {
+        LOGE("Failed creating the batch result file '%s'", csv_file.c_str());
+        return false;
+    }
+
+    LOGI("Running %zu parking situations", m_config.cases);
+    std::vector<Case> cases;
+    cases.reserve(m_config.cases);
+    for (size_t i = 0u; i < m_config.cases; ++i)
+    {
+        cases.push_back(generate(i));
+    }
+
+    // Situations are independent: run them on all cores.
+    std::vector<std::future<Result>> futures;
+    futures.reserve(cases.size());
+    {
+        ThreadPool pool(m_config.threads);
+        for (auto const& c: cases)
+        {
+            futures.push_back(pool.submit([this, &c]() { return run(c); }));
+        }
+
+        file << "id;car;parking;length;width;back_gap;front_gap;x;y;heading;"
+             << "planned;arrived;succeeded;maneuvers;collisions;position_error;"
+             << "heading_error;planning_time_ms;duration" << std::endl;
+        file << std::fixed << std::setprecision(3);
+
+        size_t succeeded = 0u;
+        double planning_time = 0.0;
+        for (size_t i = 0u; i < cases.size(); ++i)
+        {
+            Case const& c = cases[i];
+            Result const r = futures[i].get();
+            succeeded += r.succeeded ? 1u : 0u;
+            planning_time += r.planning_time;
+            file << c.id << ';' << c.car << ';' << c.parking << ';'
+                 << c.length.value() << ';' << c.width.value() << ';'
+                 << c.back_gap.value() << ';' << c.front_gap.value() << ';'
+                 << c.x.value() << ';' << c.y.value() << ';'
+                 << c.heading.value() << ';'
+                 << r.planned << ';' << r.arrived << ';' << r.succeeded << ';'
+                 << r.maneuvers << ';' << r.collisions << ';'
+                 << r.position_error.value() << ';' << r.heading_error.value() << ';'
+                 << r.planning_time << ';' << r.duration.value() << std::endl;
+        }
+
+        std::cout << "Batch: " << succeeded << " / " << cases.size()
+                  << " parking succeeded. Mean planning time: "
+                  << (cases.empty() ? 0.0 : planning_time / double(cases.size()))
+                  << " ms. Results saved in " << csv_file << std::endl;
+    }
+
+    return true;
+}
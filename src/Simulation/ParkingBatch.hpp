@@ -0,0 +1,158 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef PARKING_BATCH_HPP
+#  define PARKING_BATCH_HPP
+
+#  include "Math/Units.hpp"
+#  include <string>
+#  include <vector>
+#  include <cstdint>
+
+// *****************************************************************************
+//! \brief Headless evaluation of auto-parking trajectory planners. Thousands of
+//! randomly generated situations (car blueprint, parking dimensions, position
+//! of the parked neighbours, start pose of the ego car) are planned and then
+//! driven by the closed-loop controller, in parallel on all cores and without
+//! window. Results are written in a CSV file, one line per situation.
+// *****************************************************************************
+class ParkingBatch
+{
+public:
+
+    // *************************************************************************
+    //! \brief Ranges of the generated situations.
+    // *************************************************************************
+    struct Config
+    {
+        //! \brief Number of situations.
+        size_t cases = 1000u;
+        //! \brief Seed of the random generator. A given seed and index always
+        //! generate the same situation.
+        uint32_t seed = 42u;
+        //! \brief Car blueprints (names in the BluePrints database).
+        std::vector<std::string> cars = { "Renault.Twingo", "Citroen.DS3",
+            "Citroen.C3", "Nissan.NV200", "Audi.A6", "Mini.Cooper" };
+        //! \brief Parking blueprints (names in the BluePrints database).
+        std::vector<std::string> parkings = { "epi.0" };
+        //! \brief Slot length relatively to the car length [meter].
+        double min_length = 0.3, max_length = 2.5;
+        //! \brief Slot width relatively to the blueprint [meter].
+        double min_width = -0.2, max_width = 0.3;
+        //! \brief Gap between the slot and the parked neighbours [meter].
+        //! Negative values make neighbours overlap the slot.
+        double min_gap = -0.2, max_gap = 0.8;
+        //! \brief Longitudinal start position of the ego car (middle of the
+        //! rear axle) relatively to the end of the slot [meter].
+        double min_x = -3.0, max_x = 1.0;
+        //! \brief Lateral start position of the ego car (middle of the rear
+        //! axle) from the kerb [meter].
+        double min_y = 1.8, max_y = 3.0;
+        //! \brief Start heading of the ego car [degree].
+        double min_heading = -5.0, max_heading = 5.0;
+        //! \brief Integration time step of the simulation [second].
+        double dt = 0.05;
+        //! \brief Abort driving the trajectory after this duration [second].
+        double max_duration = 60.0;
+        //! \brief Accepted final position error [meter].
+        double position_tolerance = 0.2;
+        //! \brief Accepted final heading error [degree].
+        double heading_tolerance = 5.0;
+        //! \brief Number of worker threads (0 for all cores).
+        size_t threads = 0u;
+    };
+
+    // *************************************************************************
+    //! \brief Generated situation.
+    // *************************************************************************
+    struct Case
+    {
+        size_t id;
+        std::string car;
+        std::string parking;
+        Meter length;
+        Meter width;
+        Meter back_gap;
+        Meter front_gap;
+        Meter x;
+        Meter y;
+        Degree heading;
+    };
+
+    // *************************************************************************
+    //! \brief Result of a situation.
+    // *************************************************************************
+    struct Result
+    {
+        //! \brief Has the planner found a trajectory ?
+        bool planned = false;
+        //! \brief Has the car reached the end of the trajectory ?
+        bool arrived = false;
+        //! \brief Number of changes of gear while driving.
+        size_t maneuvers = 0u;
+        //! \brief Number of parked neighbours hit by the ego car.
+        size_t collisions = 0u;
+        //! \brief Distance between the final and the desired positions.
+        Meter position_error = 0.0_m;
+        //! \brief Difference between the final and the desired headings.
+        Degree heading_error = 0.0_deg;
+        //! \brief Duration of the planning (wall clock) [millisecond].
+        double planning_time = 0.0;
+        //! \brief Duration of the maneuver (simulated time).
+        Second duration = 0.0_s;
+        //! \brief Planned, arrived, no collision and final pose in tolerances.
+        bool succeeded = false;
+    };
+
+public:
+
+    ParkingBatch()
+        : m_config()
+    {}
+
+    ParkingBatch(Config const& config)
+        : m_config(config)
+    {}
+
+    //--------------------------------------------------------------------------
+    //! \brief Generate the situation of the given index.
+    //--------------------------------------------------------------------------
+    Case generate(size_t const id) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Plan and drive a single situation in the caller thread.
+    //--------------------------------------------------------------------------
+    Result run(Case const& c) const;
+
+    //--------------------------------------------------------------------------
+    //! \brief Run all situations in worker threads and write results in the
+    //! given CSV file. Blueprints shall have been initialized.
+    //! \return false if the file cannot be written.
+    //--------------------------------------------------------------------------
+    bool run(std::string const& csv_file) const;
+
+private:
+
+    //! \brief Ranges of the generated situations.
+    Config m_config;
+};
+
+#endif
@@ -24,6 +24,9 @@
 #include "Renderer/FontManager.hpp"
 #include "MyLogger/Logger.hpp"
 
+// Radius of the world around the ego and the camera which is fully simulated.
+static const Meter ACTIVE_RADIUS = 300.0_m;
+
 //------------------------------------------------------------------------------
 Simulator::Simulator(sf::RenderWindow& renderer, MessageBar& message_bar)
     : m_renderer(renderer), m_message_bar(message_bar)
@@ -114,10 +117,12 @@ bool Simulator::init()
 
     // Create a new city from "scratch".
     m_city.reset();
-    m_ego = &m_scenario.create(*this, m_city);
+    m_traffic.clear();
+    Car& ego = m_scenario.create(*this, m_city);
+    m_ego = m_city.handle(ego);
 
     // Make by default, the camera follows the ego car.
-    follow(*m_ego);
+    follow(ego);
 
     // Clear simulation time
     m_pause = false;
@@ -168,6 +173,7 @@ void Simulator::deactivate()
 void Simulator::release()
 {
     m_city.reset();
+    m_traffic.clear();
     m_loader.close();
     m_scenario.clear();
     monitor.close();
@@ -195,14 +201,39 @@ void Simulator::collisions(Car& ego)
     bool collided = false;
 
     ego.clear_collided();
-    for (auto& it: m_city.cars())
+    for (Car& car: m_city.cars(City::CarGroup::Traffic | City::CarGroup::Agent))
     {
         // Do not collide to itself
-        if (it.get() == &ego)
+        if (&car == &ego)
             continue ;
 
-        it->clear_collided();
-        if (ego.collides(*it))
+        car.clear_collided();
+        if (ego.collides(car))
+        {
+            collided = true;
+        }
+    }
+
+    // Sleeping cars around the ego are woken up when hit
+    std::vector<Car const*> statics;
+    m_city.statics(ego.obb().getGlobalBounds(), statics);
+    for (Car const* parked: statics)
+    {
+        City::CarHandle const handle = m_city.handle(*parked);
+        Car& car = *m_city.get(handle);
+        if (ego.collides(car))
+        {
+            collided = true;
+            m_city.wake(handle);
+        }
+    }
+
+    // Pedestrians around the ego
+    std::vector<Pedestrian const*> pedestrians;
+    m_city.crowd().find(ego.obb().getGlobalBounds(), pedestrians);
+    for (Pedestrian const* pedestrian: pedestrians)
+    {
+        if (ego.collides(pedestrian->obb()))
         {
             collided = true;
         }
@@ -227,26 +258,63 @@ void Simulator::update(const Second dt)
         return ;
     }
 
+    // Only tiles of the world around the ego and the camera are simulated
+    sf::Vector2<Meter> const camera(Meter(m_camera.x), Meter(m_camera.y));
+    m_city.activate({ ego().position(), camera }, ACTIVE_RADIUS);
+
+    // Level of detail of NPC vehicles from their distance to the ego
+    sf::Vector2<Meter> const origin = ego().position();
+    for (Car& car: m_city.cars(City::CarGroup::Traffic | City::CarGroup::Agent))
+    {
+        car.lod(m_lod.select(car.lod(), math::distance(car.position(), origin)));
+    }
+
+    // Slope of the ground under cars
+    m_city.updateSlopes();
+
     // Update physics, ECU, sensors of all NPC vehicles ...
-    for (auto& it: m_city.cars())
+    for (Car& car: m_city.cars(City::CarGroup::Traffic))
     {
-        it->update(dt);
+        if (m_city.active(car.position()))
+        {
+            car.update(dt);
+        }
     }
 
+    // Drive the background traffic
+    m_traffic.update(m_city, dt);
+
+    // Move pedestrians
+    m_city.updatePedestrians(dt);
+
     // Update physics, ECU, sensors of the Ego vehicle
-    m_ego->update(dt);
-    collisions(*m_ego);
+    Car& car = ego();
+    car.update(dt);
+    collisions(car);
+
+    // Update which cars are inside which lanes
+    m_city.updateLanes();
 
-    // Update parkings
-    for (auto& it: m_city.parkings())
+    // Update parkings of active tiles
+    for (Tiles::Key const key: m_city.tiles().actives())
     {
-        it->update(dt);
+        if (Tiles::Tile const* tile = m_city.tiles().tile(key))
+        {
+            for (Parking* parking: tile->parkings)
+            {
+                // A sleeping car cannot have left its slot
+                if (!parking->empty() && !m_city.sleeping(parking->car()))
+                {
+                    parking->update(dt);
+                }
+            }
+        }
     }
 
     // Make the camera follows the car
-    if (m_follow != nullptr)
+    if (Car const* car = m_city.get(m_follow))
     {
-        const sf::Vector2<Meter> p = m_follow->position();
+        const sf::Vector2<Meter> p = car->position();
         m_camera = sf::Vector2f(float(p.x.value()), float(p.y.value()));
     }
 
@@ -279,16 +347,22 @@ void Simulator::drawSimulation(sf::View const& view)
         Renderer::draw(*it, m_renderer);
     }
 
+    // Draw pedestrians
+    for (Pedestrian const& pedestrian: m_city.crowd().pedestrians())
+    {
+        Renderer::draw(pedestrian, m_renderer);
+    }
+
     // Draw vehicle and ego
-    for (auto const& it: m_city.cars())
+    for (Car const& car: m_city.cars())
     {
-        Renderer::draw(*it, m_renderer);
+        Renderer::draw(car, m_renderer);
     }
 
     // Draw ghost cars
-    for (auto const& it: m_city.ghosts())
+    for (Car const& car: m_city.ghosts())
     {
-        Renderer::draw(*it, m_renderer);
+        Renderer::draw(car, m_renderer);
     }
 
     // Ego vehicle
@@ -23,6 +23,7 @@
 #  define SIMULATOR_HPP
 
 #  include "City/City.hpp"
+#  include "City/Traffic.hpp"
 #  include "Scenario.hpp"
 #  include "Vehicle/ECU.hpp"
 #  include "Renderer/MessageBar.hpp"
@@ -168,12 +169,30 @@ public:
         return m_city;
     }
 
+    //-------------------------------------------------------------------------
+    //! \brief Return the distances of the levels of detail of NPC vehicles.
+    //-------------------------------------------------------------------------
+    inline LODPolicy& lod()
+    {
+        return m_lod;
+    }
+
+    //-------------------------------------------------------------------------
+    //! \brief Return the background traffic (to spawn agents).
+    //-------------------------------------------------------------------------
+    inline Traffic& traffic()
+    {
+        return m_traffic;
+    }
+
     //-------------------------------------------------------------------------
     //! \brief Return the ego car.
     //-------------------------------------------------------------------------
     inline Car& ego()
     {
-        return *m_ego;
+        Car* ego = m_city.get(m_ego);
+        assert(ego != nullptr);
+        return *ego;
     }
 
     //-------------------------------------------------------------------------
@@ -181,15 +200,17 @@ public:
     //-------------------------------------------------------------------------
     inline Car const& ego() const
     {
-        return *m_ego;
+        Car const* ego = m_city.get(m_ego);
+        assert(ego != nullptr);
+        return *ego;
     }
 
     //-------------------------------------------------------------------------
     //! \brief Make the camera follows the given car.
     //-------------------------------------------------------------------------
-    inline void follow(Car& car)
+    inline void follow(Car const& car)
     {
-        m_follow = &car;
+        m_follow = m_city.handle(car);
     }
 
     //-------------------------------------------------------------------------
@@ -268,12 +289,16 @@ private:
     //! \brief The simulated city (with its roads, parkings, cars,
     //! pedestrians ...)
     City m_city;
+    //! \brief Drive the agent cars of the city.
+    Traffic m_traffic;
+    //! \brief Level of detail of NPC vehicles.
+    LODPolicy m_lod;
     //! \brief The ego car we want to simulate.
-    Car* m_ego = nullptr; // FIXME remove the pointer!
+    City::CarHandle m_ego;
     //! \brief Memorize the camera position.
     sf::Vector2f m_camera;
     //! \brief Camera follow the given car.
-    Car* m_follow = nullptr;
+    City::CarHandle m_follow;
     //! \brief Current elapsed time of the simulation.
     sf::Clock m_clock;
     //! \brief Total elapsed time of the simulation.
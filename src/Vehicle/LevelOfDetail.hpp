@@ -0,0 +1,76 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef LEVEL_OF_DETAIL_HPP
+#  define LEVEL_OF_DETAIL_HPP
+
+#  include "Math/Units.hpp"
+#  include <cstdint>
+
+// *****************************************************************************
+//! \brief Level of detail of the simulation of a vehicle. Switching of level
+//! keeps the state of the vehicle (position, heading, speed, acceleration).
+// *****************************************************************************
+enum class LOD : uint8_t
+{
+    //! \brief Sensors, ECUs, control, physics, wheels and shape.
+    Full,
+    //! \brief Control, physics, wheels and shape: no sensors nor ECUs.
+    Kinematic,
+    //! \brief Constant speed along the lane (else along the heading): only
+    //! the shape is moved.
+    Coarse
+};
+
+// *****************************************************************************
+//! \brief Select the level of detail of vehicles from their distance to the
+//! ego. Vehicles get back a finer level as soon as they are nearer than the
+//! threshold but they get a coarser one only when they are further than the
+//! threshold plus the hysteresis, so vehicles around thresholds do not toggle
+//! at each tick.
+// *****************************************************************************
+struct LODPolicy
+{
+    //--------------------------------------------------------------------------
+    //! \brief Return the level of detail of a vehicle.
+    //! \param[in] current: the current level of the vehicle.
+    //! \param[in] distance: distance of the vehicle to the nearest ego.
+    //--------------------------------------------------------------------------
+    LOD select(LOD const current, Meter const distance) const
+    {
+        Meter const k = (current == LOD::Full) ? kinematic + hysteresis : kinematic;
+        Meter const c = (current == LOD::Coarse) ? coarse : coarse + hysteresis;
+        if (distance < k)
+            return LOD::Full;
+        if (distance < c)
+            return LOD::Kinematic;
+        return LOD::Coarse;
+    }
+
+    //! \brief Distance beyond which vehicles have no sensors nor ECUs.
+    Meter kinematic = Meter(50.0);
+    //! \brief Distance beyond which vehicles drive at constant speed.
+    Meter coarse = Meter(150.0);
+    //! \brief Extra distance for getting a coarser level.
+    Meter hysteresis = Meter(10.0);
+};
+
+#endif
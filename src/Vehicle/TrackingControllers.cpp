@@ -0,0 +1,291 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "Vehicle/TrackingControllers.hpp"
+#include "Math/Math.hpp"
+#include <algorithm>
+#include <cmath>
+
+//! \brief Number of points searched forward for projecting the vehicle on the
+//! path.
+static constexpr size_t SEARCH_WINDOW = 32u;
+
+//! \brief Minimal speed for approaching the end of a segment [m/s].
+static const MeterPerSecond CREEPING_SPEED = 0.2_mps;
+
+//! \brief Half length of the path used for estimating its curvature [m].
+static const Meter CURVATURE_STEP = 0.25_m;
+
+//------------------------------------------------------------------------------
+//! \brief Wrap the angle to [-pi .. pi].
+static inline double wrap(double const angle)
+{
+    return std::remainder(angle, 2.0 * math::PI);
+}
+
+//------------------------------------------------------------------------------
+double PIDController::update(double const error, Second const dt)
+{
+    const double T = dt.value();
+
+    m_integral = math::constrain(m_integral + error * T, -m_windup, m_windup);
+    const double derivative = (m_first || (T <= 0.0)) ? 0.0 : (error - m_previous) / T;
+    m_previous = error;
+    m_first = false;
+
+    return m_kp * error + m_ki * m_integral + m_kd * derivative;
+}
+
+//------------------------------------------------------------------------------
+Radian PurePursuit::steering(sf::Vector2<Meter> const& position, Radian const heading,
+                             sf::Vector2<Meter> const& target, Meter const wheelbase,
+                             int const direction) const
+{
+    // Target in the frame of the motion (the car is reversed when driving
+    // backward).
+    const double h = heading.value() + ((direction < 0) ? math::PI : 0.0);
+    const double dx = (target.x - position.x).value();
+    const double dy = (target.y - position.y).value();
+    const double x = std::cos(h) * dx + std::sin(h) * dy;
+    const double y = -std::sin(h) * dx + std::cos(h) * dy;
+    const double ld = std::hypot(x, y);
+    if (ld < 1e-6)
+        return 0.0_rad;
+
+    // Curvature of the arc of circle tangent to the motion and passing by the
+    // target: 2 sin(alpha) / ld. When driving backward, the steering is
+    // mirrored for getting the same yaw rate.
+    const double alpha = std::atan2(y, x);
+    const double delta = std::atan(2.0 * wheelbase.value() * std::sin(alpha) / ld);
+    return Radian(double(direction) * delta);
+}
+
+//------------------------------------------------------------------------------
+Radian Stanley::steering(Radian const heading_error, Meter const cross_track,
+                         double const curvature, MeterPerSecond const speed,
+                         Meter const wheelbase, int const direction) const
+{
+    const double v = units::math::abs(speed).value() + softening.value();
+    const double delta = std::atan(wheelbase.value() * curvature) +
+        wrap(heading_error.value()) + std::atan(gain * cross_track.value() / v);
+
+    // When driving backward, the steering is mirrored for getting the same
+    // yaw rate.
+    return Radian(double(direction) * delta);
+}
+
+//------------------------------------------------------------------------------
+PathTracker::PathTracker()
+    : m_speed_pid(2.0, 0.5, 0.0, 1.0)
+{}
+
+//------------------------------------------------------------------------------
+void PathTracker::start(TrackingPath const& path, Meter const wheelbase,
+                        Radian const max_steering)
+{
+    m_path = path;
+    m_wheelbase = wheelbase;
+    m_max_steering = units::math::abs(max_steering);
+    m_segments.clear();
+    m_abscissas.assign(m_path.size(), 0.0);
+    m_segment = 0u;
+    m_speed = 0.0_mps;
+    m_speed_pid.reset();
+
+    // Curvilinear abscissa and split into segments of constant direction. The
+    // point where the direction changes ends a segment and starts the next.
+    int direction = 0;
+    size_t first = 0u;
+    for (size_t i = 0u; i < m_path.size(); ++i)
+    {
+        if (i > 0u)
+        {
+            m_abscissas[i] = m_abscissas[i - 1u] +
+                math::distance(m_path[i - 1u].position, m_path[i].position).value();
+        }
+
+        const int d = (m_path[i].speed > 0.0_mps) ? 1 : ((m_path[i].speed < 0.0_mps) ? -1 : 0);
+        if ((d == 0) || (d == direction))
+            continue;
+
+        if ((direction != 0) && (i - 1u > first))
+        {
+            m_segments.push_back({ first, i - 1u, direction });
+        }
+        first = (i > 0u) ? i - 1u : 0u;
+        direction = d;
+    }
+    if ((direction != 0) && (m_path.size() > first + 1u))
+    {
+        m_segments.push_back({ first, m_path.size() - 1u, direction });
+    }
+
+    m_cursor = m_segments.empty() ? 0u : m_segments[0].first;
+}
+
+//------------------------------------------------------------------------------
+double PathTracker::project(sf::Vector2<Meter> const& position)
+{
+    Segment const& segment = m_segments[m_segment];
+    const size_t end = std::min(segment.last, m_cursor + SEARCH_WINDOW);
+
+    double best_distance = std::numeric_limits<double>::max();
+    double best_abscissa = m_abscissas[m_cursor];
+    size_t best = m_cursor;
+    for (size_t i = m_cursor; i < end; ++i)
+    {
+        const sf::Vector2<Meter>& A = m_path[i].position;
+        const sf::Vector2<Meter>& B = m_path[i + 1u].position;
+        const double abx = (B.x - A.x).value();
+        const double aby = (B.y - A.y).value();
+        const double amx = (position.x - A.x).value();
+        const double amy = (position.y - A.y).value();
+        const double l2 = abx * abx + aby * aby;
+        const double t = (l2 > 0.0) ? math::constrain((amx * abx + amy * aby) / l2, 0.0, 1.0) : 0.0;
+        const double dx = amx - t * abx;
+        const double dy = amy - t * aby;
+        const double d = dx * dx + dy * dy;
+        if (d < best_distance)
+        {
+            best_distance = d;
+            best = i;
+            best_abscissa = m_abscissas[i] + t * std::sqrt(l2);
+        }
+    }
+
+    m_cursor = best;
+    return best_abscissa;
+}
+
+//------------------------------------------------------------------------------
+PathPoint PathTracker::interpolate(double const s) const
+{
+    Segment const& segment = m_segments[m_segment];
+    PathPoint const& last = m_path[segment.last];
+
+    // Extend the end of the segment along its heading.
+    if (s >= m_abscissas[segment.last])
+    {
+        const double e = double(segment.direction) * (s - m_abscissas[segment.last]);
+        PathPoint p = last;
+        p.position.x += Meter(e * std::cos(last.heading.value()));
+        p.position.y += Meter(e * std::sin(last.heading.value()));
+        return p;
+    }
+
+    auto const begin = m_abscissas.begin() + long(segment.first);
+    auto const end = m_abscissas.begin() + long(segment.last) + 1;
+    auto const it = std::upper_bound(begin, end, s);
+    if (it == begin)
+        return m_path[segment.first];
+
+    const size_t i = size_t(it - m_abscissas.begin()) - 1u;
+    const double l = m_abscissas[i + 1u] - m_abscissas[i];
+    const double t = (l > 0.0) ? (s - m_abscissas[i]) / l : 0.0;
+    PathPoint const& A = m_path[i];
+    PathPoint const& B = m_path[i + 1u];
+
+    PathPoint p;
+    p.position.x = A.position.x + (B.position.x - A.position.x) * t;
+    p.position.y = A.position.y + (B.position.y - A.position.y) * t;
+    p.heading = A.heading + Radian(t * wrap((B.heading - A.heading).value()));
+    // The first point of the segment may hold the speed of the previous
+    // segment (change of direction).
+    const MeterPerSecond va = units::math::abs(A.speed);
+    const MeterPerSecond vb = units::math::abs(B.speed);
+    p.speed = double(segment.direction) * (va + (vb - va) * t);
+    return p;
+}
+
+//------------------------------------------------------------------------------
+PathTracker::Commands PathTracker::update(Second const dt, sf::Vector2<Meter> const& position,
+                                          Radian const heading, MeterPerSecond const speed)
+{
+    Commands commands;
+    commands.steering = m_steering;
+    if (arrived())
+        return commands;
+
+    // Where is the vehicle along the current segment ? Go to the next segment
+    // once its end is reached.
+    double s = project(position);
+    double remaining = m_abscissas[m_segments[m_segment].last] - s;
+    while (remaining < tolerance.value())
+    {
+        m_speed = 0.0_mps;
+        m_speed_pid.reset();
+        if (++m_segment >= m_segments.size())
+            return commands;
+
+        m_cursor = m_segments[m_segment].first;
+        s = project(position);
+        remaining = m_abscissas[m_segments[m_segment].last] - s;
+    }
+
+    Segment const& segment = m_segments[m_segment];
+    const double direction = double(segment.direction);
+
+    // Longitudinal control: follow the speed of the path but brake for
+    // stopping at the end of the segment. The PID gives the acceleration.
+    const MeterPerSecond v_path = units::math::abs(interpolate(s).speed);
+    const MeterPerSecond v_stop(std::sqrt(2.0 * max_acceleration.value() * remaining));
+    const MeterPerSecond v_ref = units::math::min(v_path, units::math::max(v_stop, CREEPING_SPEED));
+    const MeterPerSecond v = direction * speed;
+    const MeterPerSecondSquared acceleration = math::constrain(
+        MeterPerSecondSquared(m_speed_pid.update((v_ref - v).value(), dt)),
+        -max_acceleration, max_acceleration);
+    m_speed = math::constrain(units::math::abs(m_speed) + acceleration * dt, 0.0_mps, v_ref);
+    if (dt > 0.0_s)
+    {
+        // Do not overshoot the end of the segment during this time step.
+        m_speed = units::math::min(m_speed, Meter(remaining) / dt);
+    }
+
+    // Lateral control.
+    Radian steering;
+    if (m_lateral == Lateral::PurePursuit)
+    {
+        const Meter ld = pure_pursuit.lookahead(m_speed);
+        const PathPoint target = interpolate(s + ld.value());
+        steering = pure_pursuit.steering(position, heading, target.position,
+                                         m_wheelbase, segment.direction);
+    }
+    else
+    {
+        const PathPoint reference = interpolate(s);
+        const double s0 = std::max(m_abscissas[segment.first], s - CURVATURE_STEP.value());
+        const double s1 = s + CURVATURE_STEP.value();
+        const double curvature = wrap((interpolate(s1).heading -
+                                       interpolate(s0).heading).value()) / (s1 - s0);
+        const double tx = direction * std::cos(reference.heading.value());
+        const double ty = direction * std::sin(reference.heading.value());
+        const double cross_track = tx * (reference.position.y - position.y).value() -
+                                   ty * (reference.position.x - position.x).value();
+        steering = stanley.steering(reference.heading - heading, Meter(cross_track),
+                                    curvature, m_speed, m_wheelbase,
+                                    segment.direction);
+    }
+
+    m_steering = math::constrain(steering, -m_max_steering, m_max_steering);
+    commands.speed = direction * m_speed;
+    commands.steering = m_steering;
+    return commands;
+}
@@ -0,0 +1,264 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#ifndef TRACKING_CONTROLLERS_HPP
+#  define TRACKING_CONTROLLERS_HPP
+
+#  include "Math/Math.hpp"
+#  include <vector>
+#  include <limits>
+
+// *****************************************************************************
+//! \brief Point of a geometric path to be tracked by a vehicle.
+// *****************************************************************************
+struct PathPoint
+{
+    //! \brief Desired position of the middle of the rear axle [meter].
+    sf::Vector2<Meter> position;
+    //! \brief Desired heading of the vehicle [rad].
+    Radian heading;
+    //! \brief Desired longitudinal speed [m/s]. Its sign gives the direction
+    //! of the motion (negative when driving backward).
+    MeterPerSecond speed;
+};
+
+//! \brief Geometric path: consecutive points where the vehicle stops and
+//! changes its direction when the sign of the desired speed changes.
+using TrackingPath = std::vector<PathPoint>;
+
+// *****************************************************************************
+//! \brief Proportional Integral Derivative controller.
+// *****************************************************************************
+class PIDController
+{
+public:
+
+    //--------------------------------------------------------------------------
+    //! \brief Set the gains.
+    //! \param[in] kp: proportional gain.
+    //! \param[in] ki: integral gain.
+    //! \param[in] kd: derivative gain.
+    //! \param[in] windup: absolute max value of the integral term.
+    //--------------------------------------------------------------------------
+    PIDController(double const kp, double const ki, double const kd, double const windup)
+        : m_kp(kp), m_ki(ki), m_kd(kd), m_windup(windup)
+    {}
+
+    //--------------------------------------------------------------------------
+    //! \brief Clear the memory of the controller.
+    //--------------------------------------------------------------------------
+    void reset()
+    {
+        m_integral = m_previous = 0.0;
+        m_first = true;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Compute the command from the error (reference - measure).
+    //--------------------------------------------------------------------------
+    double update(double const error, Second const dt);
+
+private:
+
+    double m_kp, m_ki, m_kd, m_windup;
+    double m_integral = 0.0;
+    double m_previous = 0.0;
+    bool m_first = true;
+};
+
+// *****************************************************************************
+//! \brief Pure pursuit lateral controller: compute the steering angle of the
+//! arc of circle joining the middle of the rear axle to a point of the path
+//! placed at a lookahead distance growing with the speed.
+// *****************************************************************************
+class PurePursuit
+{
+public:
+
+    //! \brief Lookahead distance = gain * |speed| clamped to [min .. max].
+    Second lookahead_gain = 0.8_s;
+    Meter min_lookahead = 1.0_m;
+    Meter max_lookahead = 6.0_m;
+
+    //--------------------------------------------------------------------------
+    //! \brief Return the lookahead distance for the given speed.
+    //--------------------------------------------------------------------------
+    inline Meter lookahead(MeterPerSecond const speed) const
+    {
+        return math::constrain(lookahead_gain * units::math::abs(speed),
+                               min_lookahead, max_lookahead);
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Steering angle for reaching the target.
+    //! \param[in] position: middle of the rear axle of the vehicle.
+    //! \param[in] heading: vehicle heading.
+    //! \param[in] target: point of the path at the lookahead distance.
+    //! \param[in] wheelbase: vehicle wheelbase.
+    //! \param[in] direction: +1 forward, -1 backward.
+    //--------------------------------------------------------------------------
+    Radian steering(sf::Vector2<Meter> const& position, Radian const heading,
+                    sf::Vector2<Meter> const& target, Meter const wheelbase,
+                    int const direction) const;
+};
+
+// *****************************************************************************
+//! \brief Stanley lateral controller (Stanford DARPA challenge) adapted to
+//! paths of the middle of the rear axle: correct the heading error and the
+//! cross-track error of the rear axle, plus the feed-forward steering angle
+//! of the curvature of the path.
+// *****************************************************************************
+class Stanley
+{
+public:
+
+    //! \brief Cross-track error gain [1/s].
+    double gain = 1.5;
+    //! \brief Softening speed avoiding aggressive steering at low speed.
+    MeterPerSecond softening = 0.5_mps;
+
+    //--------------------------------------------------------------------------
+    //! \brief Steering angle correcting errors.
+    //! \param[in] heading_error: path heading - vehicle heading.
+    //! \param[in] cross_track: signed lateral distance of the rear axle to
+    //! the path (positive when the path is on the left of the motion).
+    //! \param[in] curvature: curvature of the path along the motion [1/m].
+    //! \param[in] speed: vehicle speed.
+    //! \param[in] wheelbase: vehicle wheelbase.
+    //! \param[in] direction: +1 forward, -1 backward.
+    //--------------------------------------------------------------------------
+    Radian steering(Radian const heading_error, Meter const cross_track,
+                    double const curvature, MeterPerSecond const speed,
+                    Meter const wheelbase, int const direction) const;
+};
+
+// *****************************************************************************
+//! \brief Closed-loop tracking of a TrackingPath. The path is split into
+//! segments of constant direction. For each segment, the lateral controller
+//! (pure pursuit or Stanley) computes the steering angle, and a PID loop
+//! controls the speed, slowing down to stop at the end of the segment (the
+//! speed is also limited to not overshoot the end of the segment within the
+//! time step). Tracking errors do not accumulate as with open-loop references
+//! and the simulation can use coarser time steps.
+// *****************************************************************************
+class PathTracker
+{
+public:
+
+    //--------------------------------------------------------------------------
+    //! \brief Lateral controller.
+    //--------------------------------------------------------------------------
+    enum class Lateral { PurePursuit, Stanley };
+
+    //--------------------------------------------------------------------------
+    //! \brief Commands for the vehicle.
+    //--------------------------------------------------------------------------
+    struct Commands
+    {
+        MeterPerSecond speed = 0.0_mps;
+        Radian steering = 0.0_rad;
+    };
+
+    PathTracker();
+
+    //--------------------------------------------------------------------------
+    //! \brief Start tracking a new path.
+    //! \param[in] path: the path to follow.
+    //! \param[in] wheelbase: vehicle wheelbase.
+    //! \param[in] max_steering: vehicle max steering angle.
+    //--------------------------------------------------------------------------
+    void start(TrackingPath const& path, Meter const wheelbase,
+               Radian const max_steering);
+
+    //--------------------------------------------------------------------------
+    //! \brief Compute commands from the current vehicle states.
+    //--------------------------------------------------------------------------
+    Commands update(Second const dt, sf::Vector2<Meter> const& position,
+                    Radian const heading, MeterPerSecond const speed);
+
+    //--------------------------------------------------------------------------
+    //! \brief Has the vehicle reached the end of the path ?
+    //--------------------------------------------------------------------------
+    inline bool arrived() const
+    {
+        return m_segment >= m_segments.size();
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Change the lateral controller.
+    //--------------------------------------------------------------------------
+    inline void lateral(Lateral const controller)
+    {
+        m_lateral = controller;
+    }
+
+    //! \brief Gains of lateral controllers.
+    PurePursuit pure_pursuit;
+    Stanley stanley;
+    //! \brief Max absolute longitudinal acceleration [m/s/s].
+    MeterPerSecondSquared max_acceleration = 1.5_mps_sq;
+    //! \brief Distance under which the end of a segment is reached.
+    Meter tolerance = 0.03_m;
+
+private:
+
+    //--------------------------------------------------------------------------
+    //! \brief Project the position on the current segment.
+    //! \return the curvilinear abscissa of the projection.
+    //--------------------------------------------------------------------------
+    double project(sf::Vector2<Meter> const& position);
+
+    //--------------------------------------------------------------------------
+    //! \brief Interpolate the pose at the given curvilinear abscissa. Beyond
+    //! the end of the segment the last point is extended along its heading.
+    //--------------------------------------------------------------------------
+    PathPoint interpolate(double const s) const;
+
+private:
+
+    struct Segment
+    {
+        //! \brief Range of points [first .. last].
+        size_t first, last;
+        //! \brief +1 forward, -1 backward.
+        int direction;
+    };
+
+    TrackingPath m_path;
+    //! \brief Curvilinear abscissa of the points, measured from the first
+    //! point of the path (not restarting at each segment) [meter].
+    std::vector<double> m_abscissas;
+    std::vector<Segment> m_segments;
+    //! \brief Current segment.
+    size_t m_segment = 0u;
+    //! \brief Index of the point the closest to the vehicle in the current
+    //! segment. Only moves forward: no search from the beginning.
+    size_t m_cursor = 0u;
+    PIDController m_speed_pid;
+    Lateral m_lateral = Lateral::PurePursuit;
+    Meter m_wheelbase = 0.0_m;
+    Radian m_max_steering = 0.0_rad;
+    //! \brief Last commands (absolute speed).
+    MeterPerSecond m_speed = 0.0_mps;
+    Radian m_steering = 0.0_rad;
+};
+
+#endif
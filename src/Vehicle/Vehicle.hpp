@@ -25,6 +25,8 @@
 #  include "Vehicle/Wheel.hpp"
 #  include "Vehicle/VehicleBluePrint.hpp"
 #  include "Vehicle/VehiclePhysics.hpp"
+#  include "Vehicle/LevelOfDetail.hpp"
+#  include "Math/Frenet.hpp"
 #  include "ECUs/TurningIndicatorECU/TurningIndicator.hpp"
 #  include <functional>
 
@@ -78,6 +80,7 @@ public:
         m_physics->init(acceleration, speed, position, heading);
         // TODO m_control->init(0.0f, speed, position, heading);
         this->update_wheels(speed, steering);
+        m_shape->update(m_physics->position(), m_physics->heading());
     }
 
     //-------------------------------------------------------------------------
@@ -126,35 +129,90 @@ public:
     template<class T> T& getECU() { return getComponent<T>(); }
     template<class T> T const& getECU() const { return getComponent<T>(); }
 
+    //-------------------------------------------------------------------------
+    //! \brief Set the level of detail of the simulation of the vehicle. The
+    //! state of the vehicle is kept.
+    //-------------------------------------------------------------------------
+    inline void lod(LOD const level)
+    {
+        m_lod = level;
+    }
+
+    //-------------------------------------------------------------------------
+    //! \brief Return the level of detail of the simulation of the vehicle.
+    //-------------------------------------------------------------------------
+    inline LOD lod() const
+    {
+        return m_lod;
+    }
+
+    //-------------------------------------------------------------------------
+    //! \brief Set the reference line followed by the vehicle when simulated
+    //! with the coarse level of detail (i.e. the center line of its lane).
+    //! nullptr: the vehicle keeps its heading. The line shall outlive the
+    //! vehicle or be replaced.
+    //-------------------------------------------------------------------------
+    inline void follow(math::Frenet const* line)
+    {
+        if (line != m_line)
+        {
+            m_line = line;
+            m_line_hint = math::Frenet::NONE;
+        }
+    }
+
     //-------------------------------------------------------------------------
     // External or internal: collides with city and sensor detecs city ???
     //-------------------------------------------------------------------------
     virtual void update(Second const dt)
     {
-        // Update sensors. Observer pattern: feed ECUs with sensor data.
-        // Note that a sensor can be used by several ECUs.
-        for (auto& sensor: m_sensors)
+        if (m_lod == LOD::Full)
         {
-            assert(sensor != nullptr && "nullptr sensor");
-            sensor->update(dt);
-            sensor->notifyObservers();
+            // Update sensors. Observer pattern: feed ECUs with sensor data.
+            // Note that a sensor can be used by several ECUs.
+            for (auto& sensor: m_sensors)
+            {
+                assert(sensor != nullptr && "nullptr sensor");
+                sensor->update(dt);
+                sensor->notifyObservers();
+            }
+
+            // Update Electronic Control Units. They will apply control to the car.
+            // TBD: ecu->update(m_control, dt); m_control is not necessary since ECU
+            // knows the car and therefore m_control
+            for (auto& ecu: m_ecus)
+            {
+                assert(ecu != nullptr && "nullptr ECU");
+                ecu->update(dt);
+            }
         }
 
-        // Update Electronic Control Units. They will apply control to the car.
-        // TBD: ecu->update(m_control, dt); m_control is not necessary since ECU
-        // knows the car and therefore m_control
-        for (auto& ecu: m_ecus)
+        if (m_lod != LOD::Coarse)
         {
-            assert(ecu != nullptr && "nullptr ECU");
-            ecu->update(dt);
+            // Vehicle control and references
+            m_control->update(dt, m_physics->position(), m_physics->heading(),
+                              m_physics->speed());
+            // vehicle momentum
+            m_physics->update(dt);
+            // Wheel momentum
+            update_wheels(m_physics->speed(), m_control->get_steering());
+        }
+        else
+        {
+            // Dead reckoning: keep the speed and the lateral offset along the
+            // followed line, else keep the heading.
+            Meter const d = m_physics->speed() * dt;
+            sf::Vector2<Meter> position;
+            Radian heading;
+            if (!along(d, position, heading))
+            {
+                heading = m_physics->heading();
+                position.x = m_physics->position().x + d * units::math::cos(heading);
+                position.y = m_physics->position().y + d * units::math::sin(heading);
+            }
+            m_physics->init(m_physics->acceleration(), m_physics->speed(), position, heading);
         }
 
-        // Vehicle control and references
-        m_control->update(dt);
-        // vehicle momentum
-        m_physics->update(dt);
-        // Wheel momentum
-        update_wheels(m_physics->speed(), m_control->get_steering());
         // Update orientation of the vehicle shape
         m_shape->update(m_physics->position(), m_physics->heading());
         // Update the tracked trailer if attached
@@ -250,6 +308,19 @@ public:
         return res;
     }
 
+    //-------------------------------------------------------------------------
+    //! \brief Check if the vehicle collides with the given bounding box (i.e.
+    //! of a pedestrian).
+    //-------------------------------------------------------------------------
+    bool collides(sf::RectangleShape const& obb)
+    {
+        sf::Vector2f p;
+
+        bool res = m_shape->collides(obb, p);
+        m_collided |= res;
+        return res;
+    }
+
     //-------------------------------------------------------------------------
     //! \brief
     //-------------------------------------------------------------------------
@@ -307,6 +378,24 @@ public:
         return m_control->get_ref_steering();
     }
 
+    //-------------------------------------------------------------------------
+    //! \brief Drive along the given path with closed-loop controllers. Setting
+    //! a reference speed or steering angle stops the tracking.
+    //-------------------------------------------------------------------------
+    void track(TrackingPath const& path)
+    {
+        m_control->track(path, blueprint.wheelbase, blueprint.max_steering_angle);
+    }
+
+    //-------------------------------------------------------------------------
+    //! \brief Is the vehicle tracking a path ? Return false once the end of
+    //! the path has been reached.
+    //-------------------------------------------------------------------------
+    bool tracking() const
+    {
+        return m_control->tracking();
+    }
+
     //--------------------------------------------------------------------------
     //! \brief Const getter: return the longitudinal speed [meter/second].
     //--------------------------------------------------------------------------
@@ -332,6 +421,23 @@ public:
         return m_physics->heading();
     }
 
+    //--------------------------------------------------------------------------
+    //! \brief Set the slope of the ground along the vehicle (pitch, positive
+    //! when climbing) used by the physics.
+    //--------------------------------------------------------------------------
+    inline void slope(Radian const pitch)
+    {
+        m_physics->slope(pitch);
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Const getter: return the slope of the ground along the vehicle.
+    //--------------------------------------------------------------------------
+    inline Radian slope() const
+    {
+        return m_physics->slope();
+    }
+
     //--------------------------------------------------------------------------
     //! \brief Const getter: return the steering angle [rad].
     //--------------------------------------------------------------------------
@@ -395,6 +501,35 @@ public:
                   << "}";
     }
 
+private:
+
+    //-------------------------------------------------------------------------
+    //! \brief Move the vehicle by the given distance along the followed line,
+    //! keeping its lateral offset. The heading becomes the one of the line.
+    //! \return false if no line is followed or if the line ends before.
+    //-------------------------------------------------------------------------
+    bool along(Meter const distance, sf::Vector2<Meter>& position, Radian& heading)
+    {
+        if (m_line == nullptr)
+            return false;
+
+        math::Frenet::Coordinates c = m_line->toFrenet(
+            { m_physics->position().x.value(), m_physics->position().y.value() },
+            m_line_hint);
+
+        // Driving in the direction of the line or against it.
+        bool const forward = units::math::cos(m_physics->heading() -
+                                              Radian(m_line->heading(c.s))) >= 0.0;
+        c.s += forward ? distance.value() : -distance.value();
+        if ((c.s < 0.0) || (c.s > m_line->length()))
+            return false;
+
+        math::Frenet::Position const p = m_line->toCartesian(c);
+        position = sf::Vector2<Meter>(Meter(p.x), Meter(p.y));
+        heading = Radian(m_line->heading(c.s)) + (forward ? 0.0_deg : 180.0_deg);
+        return true;
+    }
+
 protected:
 
     //! \brief Simulate Electronic Control Units.
@@ -431,6 +566,12 @@ protected:
     std::map<size_t, Callback> m_callbacks;
     //! \brief Has car collided again an other object?
     bool m_collided = false;
+    //! \brief Level of detail of the simulation.
+    LOD m_lod = LOD::Full;
+    //! \brief Line followed with the coarse level of detail (not owned).
+    math::Frenet const* m_line = nullptr;
+    //! \brief Segment of m_line holding the vehicle (warm start).
+    size_t m_line_hint = math::Frenet::NONE;
 };
 
 #endif
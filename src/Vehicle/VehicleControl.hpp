@@ -22,7 +22,7 @@
 #ifndef VEHICLE_CONTROL_HPP
 #  define VEHICLE_CONTROL_HPP
 
-#  include "Math/Units.hpp"
+#  include "Vehicle/TrackingControllers.hpp"
 
 class VehicleControl
 {
@@ -60,6 +60,7 @@ public:
     //----------------------------------------------------------------------
     void set_ref_speed(MeterPerSecond const speed)
     {
+        m_tracking = false;
         ref.speed = speed;
     }
 
@@ -76,6 +77,7 @@ public:
     //----------------------------------------------------------------------
     void set_ref_steering(Radian const steering)
     {
+        m_tracking = false;
         ref.steering = steering;
     }
 
@@ -120,16 +122,53 @@ public:
     }
 
     //----------------------------------------------------------------------
-    //! \brief
+    //! \brief Follow the given path with closed-loop controllers instead of
+    //! applying references. Setting a reference speed or steering angle stops
+    //! the tracking.
+    //! \param[in] path: the path to follow.
+    //! \param[in] wheelbase: vehicle wheelbase.
+    //! \param[in] max_steering: vehicle max steering angle.
+    //----------------------------------------------------------------------
+    void track(TrackingPath const& path, Meter const wheelbase, Radian const max_steering)
+    {
+        m_tracker.start(path, wheelbase, max_steering);
+        m_tracking = true;
+    }
+
+    //----------------------------------------------------------------------
+    //! \brief Is the vehicle tracking a path ?
+    //----------------------------------------------------------------------
+    inline bool tracking() const
+    {
+        return m_tracking && !m_tracker.arrived();
+    }
+
     //----------------------------------------------------------------------
-// TODO init
+    //! \brief Access to tracking controllers for tuning them.
+    //----------------------------------------------------------------------
+    inline PathTracker& tracker()
+    {
+        return m_tracker;
+    }
 
     //----------------------------------------------------------------------
-    //! \brief TODO
+    //! \brief Compute outputs.
+    //! \param[in] dt: time step.
+    //! \param[in] position: measured position of the middle of the rear axle.
+    //! \param[in] heading: measured heading.
+    //! \param[in] speed: measured longitudinal speed.
     //----------------------------------------------------------------------
-    void update(Second const /*dt*/ /*, sensors*/)
+    void update(Second const dt, sf::Vector2<Meter> const& position,
+                Radian const heading, MeterPerSecond const speed)
     {
-        //
+        if (m_tracking)
+        {
+            PathTracker::Commands const commands =
+                m_tracker.update(dt, position, heading, speed);
+            ref.speed = commands.speed;
+            ref.steering = commands.steering;
+        }
+
         outputs.speed = ref.speed;
         outputs.steering = ref.steering;
     }
@@ -137,6 +176,13 @@ public:
     References ref;
     Inputs inputs;
     Outputs outputs;
+
+private:
+
+    //! \brief Closed-loop tracking of a path.
+    PathTracker m_tracker;
+    //! \brief Is the tracker driving the vehicle ?
+    bool m_tracking = false;
 };
 
 #endif
@@ -70,7 +70,7 @@ void TricycleDynamic::update(CarControl const& control, float const dt)
     const float m = 2000.0f;
 
     // Gravitational force due to road inclination [Newton: N == kg.m/s^2]
-    const float road_angle = 0.0f; // TODO
+    const float road_angle = float(m_slope.value());
     const float Fg = m * G * sinf(road_angle);
     std::cout << "Fg: " << Fg << std::endl;
 
@@ -27,6 +27,8 @@ void TricycleKinematic::update(Second const dt)
     const Meter wb = m_shape.blueprint().wheelbase;
     m_speed = m_control.outputs.speed;
     m_heading += dt * m_speed * u * units::math::tan(m_control.outputs.steering) / wb;
-    m_position.x += dt * m_speed * units::math::cos(m_heading);
-    m_position.y += dt * m_speed * units::math::sin(m_heading);
+    // The speed is along the ground: project it on the horizontal plane.
+    const MeterPerSecond v = m_speed * units::math::cos(m_slope);
+    m_position.x += dt * v * units::math::cos(m_heading);
+    m_position.y += dt * v * units::math::sin(m_heading);
 }
@@ -48,12 +48,31 @@ public:
     //--------------------------------------------------------------------------
     virtual ~VehiclePhysics() = default;
 
+    //--------------------------------------------------------------------------
+    //! \brief Set the slope of the ground along the vehicle (pitch, positive
+    //! when climbing). See City::updateSlopes().
+    //--------------------------------------------------------------------------
+    inline void slope(Radian const pitch)
+    {
+        m_slope = pitch;
+    }
+
+    //--------------------------------------------------------------------------
+    //! \brief Const getter: return the slope of the ground along the vehicle.
+    //--------------------------------------------------------------------------
+    inline Radian slope() const
+    {
+        return m_slope;
+    }
+
 protected:
 
     //! \brief
     VehicleShape<BLUEPRINT> const& m_shape;
     //! \brief
     VehicleControl const& m_control;
+    //! \brief Slope of the ground along the vehicle [radian].
+    Radian m_slope = 0.0_rad;
 };
 
 #endif
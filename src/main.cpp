@@ -23,6 +23,7 @@
 #include "Application/GUILoadSimulMenu.hpp"
 #include "Renderer/FontManager.hpp"
 #include "Common/Prolog.hpp"
+#include "Simulation/ParkingBatch.hpp"
 #include "project_info.hpp" // Generated by the Makefile
 #include "MyLogger/Logger.hpp"
 
@@ -74,6 +75,34 @@ static void init_config()
     LOGI("Search path: '%s'", project::info::data_path.c_str());
 }
 
+// -----------------------------------------------------------------------------
+//! \brief Headless evaluation of auto-parking planners:
+//! highway --batch [number of cases] [seed] [result file]
+// -----------------------------------------------------------------------------
+static int start_batch(int argc, char* const argv[])
+{
+    ParkingBatch::Config config;
+    std::string output = "parking_batch.csv";
+
+    if (argc > 2)
+    {
+        config.cases = size_t(std::stoul(argv[2]));
+    }
+    if (argc > 3)
+    {
+        config.seed = uint32_t(std::stoul(argv[3]));
+    }
+    if (argc > 4)
+    {
+        output = argv[4];
+    }
+
+    LOGI("Started '%s' in batch mode: %zu cases, seed %u", argv[0],
+         config.cases, config.seed);
+    ParkingBatch batch(config);
+    return batch.run(output) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 // -----------------------------------------------------------------------------
 static int start_highway(int argc, char* const argv[])
 {
@@ -81,6 +110,12 @@ static int start_highway(int argc, char* const argv[])
     // Initialize the database of blueprints.
     BluePrints::init();
 
+    // No window: evaluate auto-parking in batch.
+    if ((argc > 1) && (std::string(argv[1]) == "--batch"))
+    {
+        return start_batch(argc, argv);
+    }
+
     // Load fonts
     if (!FontManager::instance().load("main font", "font.ttf"))
     {
@@ -107,7 +142,9 @@ static int start_highway(int argc, char* const argv[])
         if (std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help")
         {
             // Display usage
-            std::cout << argv[0] << "[scenario file]" << std::endl;
+            std::cout << argv[0] << " [scenario file]" << std::endl
+                      << argv[0] << " --batch [cases] [seed] [result.csv]"
+                      << std::endl;
             return EXIT_SUCCESS;
         }
         else if (fs::exists(argv[1]))
@@ -0,0 +1,176 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "City/CityFile.hpp"
+#include "City/City.hpp"
+#include "Simulation/BluePrints.hpp"
+#include <fstream>
+
+//--------------------------------------------------------------------------
+//! \brief Grid of N x N blocks of 100 meters with two ways roads, a curved
+//! road and some parkings.
+static void create(City& city, size_t const N)
+{
+    for (size_t i = 0u; i <= N; ++i)
+    {
+        Meter const a = Meter(100.0 * double(i));
+        for (size_t j = 0u; j < N; ++j)
+        {
+            Meter const b0 = Meter(100.0 * double(j)), b1 = Meter(100.0 * double(j + 1u));
+            city.addRoad({ { a, b0 }, { a, b1 } }, 3.0_m, { 1u, 1u });
+            city.addRoad({ { b0, a }, { b1, a } }, 3.0_m, { 1u, 2u });
+        }
+    }
+    city.addRoad({ { 0.0_m, -50.0_m }, { 100.0_m, -80.0_m }, { 300.0_m, -60.0_m } },
+                 3.0_m, { 1u, 1u }, Road::Curve::Spline);
+    city.addRoad(sf::Vector2<Meter>(300.0_m, -60.0_m), 0.0_rad,
+                 { { 50.0, 0.0, 0.02 }, { 30.0, 0.02, 0.02 } }, 3.0_m, { 1u, 1u });
+    Parking& parking = city.addParking("epi.0", { 10.0_m, 5.0_m }, 0.0_deg);
+    city.addParking(parking);
+    city.addParking("epi.90", { 260.0_m, 105.0_m }, 90.0_deg);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestCityFile, RoundTrip)
+{
+    BluePrints::init();
+    std::string const path = ::testing::TempDir() + "city.bin";
+    City original;
+    create(original, 4u);
+    RoadGraph const& graph = original.graph();
+    ASSERT_TRUE(CityFile::save(original, path));
+
+    CityFile file;
+    ASSERT_TRUE(file.open(path));
+    ASSERT_EQ(file.count(CityFile::Roads), original.roads().size());
+    City loaded;
+    ASSERT_TRUE(file.load(loaded));
+    ASSERT_FALSE(file.load(loaded)); // The city already has roads
+    file.close();
+
+    // Roads and lanes
+    ASSERT_EQ(loaded.roads().size(), original.roads().size());
+    for (size_t i = 0u; i < original.roads().size(); ++i)
+    {
+        Road const& a = *original.roads()[i];
+        Road const& b = *loaded.roads()[i];
+        ASSERT_EQ(a.centers().size(), b.centers().size());
+        EXPECT_NEAR(a.frenet().length(), b.frenet().length(), 1e-3);
+        EXPECT_DOUBLE_EQ(a.width().value(), b.width().value());
+        for (size_t side = 0u; side < TrafficSide::Max; ++side)
+        {
+            ASSERT_EQ(a.m_lanes[side].size(), b.m_lanes[side].size());
+        }
+    }
+
+    // Parkings
+    ASSERT_EQ(loaded.parkings().size(), 3u);
+    for (size_t i = 0u; i < 3u; ++i)
+    {
+        Parking const& a = *original.parkings()[i];
+        Parking const& b = *loaded.parkings()[i];
+        EXPECT_NEAR(a.position().x.value(), b.position().x.value(), 1e-3);
+        EXPECT_NEAR(a.position().y.value(), b.position().y.value(), 1e-3);
+        EXPECT_NEAR(a.heading().value(), b.heading().value(), 1e-6);
+        EXPECT_EQ(a.type, b.type);
+        EXPECT_NEAR(a.blueprint.length.value(), b.blueprint.length.value(), 1e-6);
+    }
+
+    // Tiles
+    EXPECT_EQ(loaded.tiles().count(), original.tiles().count());
+    Tiles::Tile const* tile = loaded.tiles().tile({ 260.0_m, 105.0_m });
+    ASSERT_NE(tile, nullptr);
+    EXPECT_EQ(tile->parkings.size(), 1u);
+
+    // The contracted road graph is not computed again and gives the same
+    // routes.
+    RoadGraph const& restored = loaded.graph();
+    ASSERT_TRUE(restored.contracted());
+    ASSERT_EQ(restored.size(), graph.size());
+    ASSERT_EQ(restored.shortcuts(), graph.shortcuts());
+    for (RoadGraph::Id v = 0u; v < graph.size(); ++v)
+    {
+        ASSERT_EQ(restored.vertex(*restored.lane(v)), v);
+    }
+    for (RoadGraph::Id from = 0u; from < graph.size(); from += 7u)
+    {
+        for (RoadGraph::Id to = 3u; to < graph.size(); to += 11u)
+        {
+            RoadGraph::Route a, b;
+            ASSERT_EQ(graph.route(from, to, a), restored.route(from, to, b));
+            EXPECT_EQ(a.vertices, b.vertices);
+            EXPECT_NEAR(a.length.value(), b.length.value(), 1e-3);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------
+TEST(TestCityFile, Corrupted)
+{
+    BluePrints::init();
+    std::string const path = ::testing::TempDir() + "corrupted.bin";
+    City city;
+    create(city, 2u);
+    ASSERT_TRUE(CityFile::save(city, path));
+
+    std::vector<char> content;
+    {
+        std::ifstream file(path, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    auto write = [&path](std::vector<char> const& data)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), std::streamsize(data.size()));
+    };
+
+    CityFile file;
+    EXPECT_FALSE(file.open(path + ".missing"));
+
+    // Truncated
+    write(std::vector<char>(content.begin(), content.begin() + content.size() / 2u));
+    EXPECT_FALSE(file.open(path));
+    EXPECT_FALSE(file.opened());
+
+    // Other version
+    std::vector<char> other(content);
+    other[4] = char(CityFile::VERSION + 1u);
+    write(other);
+    EXPECT_FALSE(file.open(path));
+
+    // Edge to a missing vertex
+    other = content;
+    CityFile::Header header;
+    std::memcpy(&header, content.data(), sizeof(header));
+    ASSERT_GT(header.sections[CityFile::Edges].count, 0u);
+    uint32_t const missing = 0xFFFFFFu;
+    std::memcpy(&other[header.sections[CityFile::Edges].offset], &missing, sizeof(missing));
+    write(other);
+    EXPECT_FALSE(file.open(path));
+
+    write(content);
+    ASSERT_TRUE(file.open(path));
+    City loaded;
+    EXPECT_FALSE(file.load(city));
+    EXPECT_TRUE(file.load(loaded));
+}
@@ -0,0 +1,250 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#define protected public
+#define private public
+#  include "City/CityGenerator.hpp"
+#undef protected
+#undef private
+
+#include "Math/Random.hpp"
+#include <random>
+
+//--------------------------------------------------------------------------
+//! \brief Reference of CityGenerator::localConstraints() checking rules
+//! against all the accepted roads instead of the roads of the grid.
+static bool fullScanConstraints(CityGenerator& generator, CityGenerator::Road& road)
+{
+    size_t priority = 0u;
+    size_t action = 0u;
+
+    for (CityGenerator::Road* other: generator.m_roads)
+    {
+        size_t i = generator.m_rules.size();
+        while (i--)
+        {
+            if (priority <= generator.m_rules[i]->priority)
+            {
+                if (generator.m_rules[i]->accept(road, *other))
+                {
+                    priority = generator.m_rules[i]->priority;
+                    action = priority;
+                }
+            }
+        }
+    }
+
+    return generator.m_rules[action]->apply(road);
+}
+
+//--------------------------------------------------------------------------
+//! \brief Reference of CityGenerator::generate() without the grid.
+static void fullScanGenerate(CityGenerator& generator, sf::Vector2<Meter> const& dimension)
+{
+    generator.m_pendings.clear();
+    generator.m_roads.clear();
+    generator.m_grid.clear();
+    generator.m_branches.clear();
+    generator.m_dimension = dimension;
+    generator.m_population.generate(dimension, sf::Vector2u(512u, 512u));
+    generator.generateInitialRoads(sf::Vector2<Meter>(0.0_m, 0.0_m), true);
+
+    while ((generator.m_pendings.size() >= 1u) &&
+           (generator.m_roads.size() < generator.config.max_roads))
+    {
+        CityGenerator::Road& road = *generator.m_pendings.pop();
+        if (fullScanConstraints(generator, road))
+        {
+            road.setup_branch_links();
+            generator.m_roads.push_back(&road);
+            generator.globalGoals(road);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------
+TEST(TestCityGenerator, SameRoadsThanFullScan)
+{
+    sf::Vector2<Meter> const dimension(10000.0_m, 10000.0_m);
+
+    CityGenerator grid;
+    grid.config.max_roads = 1000u;
+    Random::seed(42u);
+    std::vector<CityGenerator::Road*> const& roads = grid.generate(dimension);
+
+    CityGenerator scan;
+    scan.config.max_roads = 1000u;
+    Random::seed(42u);
+    fullScanGenerate(scan, dimension);
+
+    ASSERT_GT(roads.size(), 100u);
+    ASSERT_EQ(roads.size(), scan.m_roads.size());
+    for (size_t i = 0u; i < roads.size(); ++i)
+    {
+        ASSERT_EQ(roads[i]->from.x.value(), scan.m_roads[i]->from.x.value());
+        ASSERT_EQ(roads[i]->from.y.value(), scan.m_roads[i]->from.y.value());
+        ASSERT_EQ(roads[i]->to.x.value(), scan.m_roads[i]->to.x.value());
+        ASSERT_EQ(roads[i]->to.y.value(), scan.m_roads[i]->to.y.value());
+        ASSERT_EQ(roads[i]->highway, scan.m_roads[i]->highway);
+    }
+}
+
+//--------------------------------------------------------------------------
+TEST(TestCityGenerator, NeighboursContainFullScan)
+{
+    CityGenerator generator;
+    generator.config.max_roads = 1000u;
+    Random::seed(42u);
+    std::vector<CityGenerator::Road*> const& roads = generator.generate({ 10000.0_m, 10000.0_m });
+    ASSERT_GT(roads.size(), 100u);
+
+    // Random roads near the generated ones, crossing one or several cells.
+    std::mt19937 engine(42u);
+    std::uniform_int_distribution<size_t> pick(0u, roads.size() - 1u);
+    std::uniform_real_distribution<double> shift(-600.0, 600.0);
+    Meter const margin = generator.config.max_snap_distance;
+    for (size_t probe = 0u; probe < 500u; ++probe)
+    {
+        CityGenerator::Road const& near = *roads[pick(engine)];
+        sf::Vector2<Meter> const from(near.from.x + Meter(shift(engine)),
+                                      near.from.y + Meter(shift(engine)));
+        sf::Vector2<Meter> const to(from.x + Meter(shift(engine)),
+                                    from.y + Meter(shift(engine)));
+        CityGenerator::Road const road(from, to, 0u, false);
+
+        // Full scan: accepted roads whose bounding box is closer than the
+        // snapping distance to the bounding box of the road.
+        std::vector<size_t> expected;
+        for (size_t i = 0u; i < roads.size(); ++i)
+        {
+            CityGenerator::Road const& other = *roads[i];
+            if ((units::math::max(other.from.x, other.to.x) >= units::math::min(from.x, to.x) - margin) &&
+                (units::math::min(other.from.x, other.to.x) <= units::math::max(from.x, to.x) + margin) &&
+                (units::math::max(other.from.y, other.to.y) >= units::math::min(from.y, to.y) - margin) &&
+                (units::math::min(other.from.y, other.to.y) <= units::math::max(from.y, to.y) + margin))
+            {
+                expected.push_back(i);
+            }
+        }
+
+        // The grid may return farther roads sharing a cell but shall not miss
+        // any, and shall keep the order of acceptance.
+        generator.neighbours(road);
+        ASSERT_TRUE(std::is_sorted(generator.m_neighbours.begin(), generator.m_neighbours.end()));
+        ASSERT_EQ(std::adjacent_find(generator.m_neighbours.begin(), generator.m_neighbours.end()),
+                  generator.m_neighbours.end());
+        ASSERT_TRUE(std::includes(generator.m_neighbours.begin(), generator.m_neighbours.end(),
+                                  expected.begin(), expected.end()));
+    }
+}
+
+//--------------------------------------------------------------------------
+TEST(TestCityGenerator, HeatMapThreads)
+{
+    // Each sample is written once, at its place, whatever the number of
+    // bands of rows.
+    sf::Vector2u const dimension(97u, 61u);
+    for (size_t threads: { 1u, 2u, 7u, 64u })
+    {
+        std::vector<float> grid;
+        perlin(grid, dimension, [](double const x, double const y) -> float
+        {
+            return float(1000.0 * y + x);
+        }, threads);
+
+        ASSERT_EQ(grid.size(), size_t(dimension.x) * size_t(dimension.y));
+        for (size_t y = 0u; y < dimension.y; ++y)
+        {
+            for (size_t x = 0u; x < dimension.x; ++x)
+            {
+                ASSERT_EQ(grid[y * dimension.x + x], float(1000.0 * double(y) + double(x)));
+            }
+        }
+    }
+
+    // Same population map with one or several threads.
+    sf::Vector2<Meter> const world(5000.0_m, 3000.0_m);
+    CityGenerator::HeatMap single;
+    single.generate(world, dimension, 1u);
+    for (size_t threads: { 2u, 5u, 0u })
+    {
+        CityGenerator::HeatMap multiple;
+        multiple.generate(world, dimension, threads);
+        ASSERT_EQ(single.m_density, multiple.m_density);
+    }
+}
+
+//--------------------------------------------------------------------------
+TEST(TestCityGenerator, HeatMapGet)
+{
+    // 4 x 3 samples covering 400 x 300 meters centered on the origin: samples
+    // are the centers of 100 x 100 meters pixels. The density 10 i + 100 j is
+    // linear so the bilinear interpolation is exact.
+    CityGenerator::HeatMap map;
+    ASSERT_EQ(map.get({ 0.0_m, 0.0_m }), 0.0);
+
+    map.generate({ 400.0_m, 300.0_m }, { 4u, 3u }, 1u);
+    for (size_t j = 0u; j < 3u; ++j)
+    {
+        for (size_t i = 0u; i < 4u; ++i)
+        {
+            map.m_density[j * 4u + i] = float(10 * i + 100 * j);
+        }
+    }
+    auto center = [](double const i, double const j)
+    {
+        return sf::Vector2<Meter>(Meter(100.0 * i - 150.0), Meter(100.0 * j - 100.0));
+    };
+
+    // Sample centers.
+    for (size_t j = 0u; j < 3u; ++j)
+    {
+        for (size_t i = 0u; i < 4u; ++i)
+        {
+            ASSERT_NEAR(map.get(center(double(i), double(j))), double(10 * i + 100 * j), 1e-9);
+        }
+    }
+
+    // Between samples (including the last column and row).
+    ASSERT_NEAR(map.get(center(1.5, 0.5)), 65.0, 1e-9);
+    ASSERT_NEAR(map.get(center(0.25, 1.75)), 177.5, 1e-9);
+    ASSERT_NEAR(map.get(center(2.5, 1.5)), 175.0, 1e-9);
+    ASSERT_NEAR(map.get(center(3.0, 1.5)), 180.0, 1e-9);
+    ASSERT_NEAR(map.get(center(2.5, 2.0)), 225.0, 1e-9);
+
+    // Past the borders: clamped to the border samples.
+    ASSERT_NEAR(map.get(center(-0.25, 1.0)), 100.0, 1e-9);
+    ASSERT_NEAR(map.get(center(-10.0, 1.0)), 100.0, 1e-9);
+    ASSERT_NEAR(map.get(center(1.0, -10.0)), 10.0, 1e-9);
+    ASSERT_NEAR(map.get(center(10.0, 0.5)), 80.0, 1e-9);
+    ASSERT_NEAR(map.get(center(1.5, 10.0)), 215.0, 1e-9);
+    ASSERT_NEAR(map.get(center(-10.0, -10.0)), 0.0, 1e-9);
+    ASSERT_NEAR(map.get(center(10.0, 10.0)), 230.0, 1e-9);
+
+    // Map of a single sample.
+    map.generate({ 400.0_m, 300.0_m }, { 1u, 1u }, 1u);
+    map.m_density[0] = 42.0f;
+    ASSERT_NEAR(map.get(center(0.0, 0.0)), 42.0, 1e-9);
+    ASSERT_NEAR(map.get(center(-10.0, 10.0)), 42.0, 1e-9);
+}
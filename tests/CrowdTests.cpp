@@ -0,0 +1,165 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "City/Pedestrian.hpp"
+#include "Math/Math.hpp"
+#include <cmath>
+
+//--------------------------------------------------------------------------
+TEST(TestSpatialHashGrid, Queries)
+{
+    SpatialHashGrid grid(sf::FloatRect(0.0f, 0.0f, 10.0f, 10.0f), { 10u, 10u });
+
+    // Item overlapping 4 cells.
+    SpatialHashGrid::Item a;
+    a.position = sf::Vector2f(5.0f, 5.0f);
+    a.dimension = sf::Vector2f(1.0f, 1.0f);
+    a.id = 0u;
+    grid.add(a);
+    ASSERT_EQ(a.spatial_indices[0], sf::Vector2u(4u, 4u));
+    ASSERT_EQ(a.spatial_indices[1], sf::Vector2u(5u, 5u));
+
+    // Item outside the grid is hold by border cells.
+    SpatialHashGrid::Item b;
+    b.position = sf::Vector2f(12.0f, 0.5f);
+    b.dimension = sf::Vector2f(0.5f, 0.5f);
+    b.id = 1u;
+    grid.add(b);
+    ASSERT_EQ(b.spatial_indices[0], sf::Vector2u(9u, 0u));
+
+    // Items are returned once.
+    std::vector<SpatialHashGrid::Item*> res;
+    grid.findNear(sf::FloatRect(3.0f, 3.0f, 4.0f, 4.0f), res);
+    ASSERT_EQ(res.size(), 1u);
+    ASSERT_EQ(res[0], &a);
+    grid.findNear(sf::FloatRect(0.0f, 0.0f, 10.0f, 10.0f), res);
+    ASSERT_EQ(res.size(), 2u);
+    grid.findNear(a, res);
+    ASSERT_EQ(res.size(), 0u);
+    grid.findNear(sf::FloatRect(0.0f, 8.0f, 2.0f, 2.0f), res);
+    ASSERT_EQ(res.size(), 0u);
+
+    // Moved and removed items.
+    a.position = sf::Vector2f(1.0f, 9.0f);
+    grid.update(a);
+    grid.findNear(sf::FloatRect(0.0f, 8.0f, 2.0f, 2.0f), res);
+    ASSERT_EQ(res.size(), 1u);
+    grid.findNear(sf::FloatRect(3.0f, 3.0f, 4.0f, 4.0f), res);
+    ASSERT_EQ(res.size(), 0u);
+    grid.remove(a);
+    grid.remove(b);
+    grid.findNear(sf::FloatRect(0.0f, 0.0f, 10.0f, 10.0f), res);
+    ASSERT_EQ(res.size(), 0u);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestCrowd, WalkAlongPath)
+{
+    Crowd crowd;
+    crowd.add("p0", { { 0.0_m, 0.0_m }, { 10.0_m, 0.0_m }, { 10.0_m, 10.0_m } }, 1.4_mps);
+
+    for (size_t i = 0u; i < 2000u && !crowd.pedestrians()[0].arrived(); ++i)
+    {
+        crowd.update(0.01_s, {});
+    }
+
+    Pedestrian const& p = crowd.pedestrians()[0];
+    ASSERT_TRUE(p.arrived());
+    EXPECT_NEAR(p.position().x.value(), 10.0, 0.5);
+    EXPECT_NEAR(p.position().y.value(), 10.0, 0.5);
+    EXPECT_LE(p.speed().value(), 1.4 * crowd.config().max_speed_factor);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestCrowd, Avoidance)
+{
+    // Two pedestrians walking face to face, then a car on the way.
+    Crowd crowd;
+    crowd.add("p0", { { 0.0_m, 0.0_m }, { 10.0_m, 0.05_m } }, 1.4_mps);
+    crowd.add("p1", { { 10.0_m, 0.0_m }, { 0.0_m, -0.05_m } }, 1.4_mps);
+    crowd.add("p2", { { 0.0_m, 5.0_m }, { 10.0_m, 5.0_m } }, 1.4_mps);
+
+    sf::RectangleShape car(sf::Vector2f(4.0f, 1.8f));
+    car.setOrigin(0.0f, 0.9f);
+    car.setPosition(3.0f, 5.3f);
+    std::vector<sf::RectangleShape const*> obstacles = { &car };
+
+    double closest = 1e9;
+    bool hit = false;
+    for (size_t i = 0u; i < 1500u; ++i)
+    {
+        crowd.update(0.01_s, obstacles);
+        std::vector<Pedestrian> const& p = crowd.pedestrians();
+        closest = std::min(closest, math::distance(p[0].position(), p[1].position()).value());
+        sf::Vector2f const local = car.getInverseTransform().transformPoint(
+            float(p[2].position().x.value()), float(p[2].position().y.value()));
+        hit |= (local.x > 0.0f) && (local.x < 4.0f) && (local.y > 0.0f) && (local.y < 1.8f);
+    }
+
+    EXPECT_GT(closest, 0.4);
+    EXPECT_FALSE(hit);
+    EXPECT_TRUE(crowd.pedestrians()[0].arrived());
+    EXPECT_TRUE(crowd.pedestrians()[1].arrived());
+    EXPECT_TRUE(crowd.pedestrians()[2].arrived());
+
+    // Queries of sensors.
+    std::vector<Pedestrian const*> found;
+    crowd.find(sf::FloatRect(9.0f, 4.0f, 2.0f, 2.0f), found);
+    ASSERT_EQ(found.size(), 1u);
+    EXPECT_EQ(found[0]->name, "p2");
+}
+
+//--------------------------------------------------------------------------
+TEST(TestCrowd, ObstaclesGrid)
+{
+    // Indices of pedestrians stay valid when others are added.
+    Crowd crowd;
+    ASSERT_EQ(crowd.add("p0", { { 0.0_m, 0.0_m }, { 20.0_m, 0.0_m } }, 1.4_mps), 0u);
+    ASSERT_EQ(crowd.add("p1", { { 0.0_m, 30.0_m }, { 20.0_m, 30.0_m } }, 1.4_mps), 1u);
+
+    // A parking lot far from the pedestrians and a car on the way of p0.
+    std::vector<sf::RectangleShape> cars(201u, sf::RectangleShape(sf::Vector2f(4.0f, 1.8f)));
+    std::vector<sf::RectangleShape const*> obstacles;
+    for (size_t i = 0u; i < cars.size(); ++i)
+    {
+        cars[i].setOrigin(0.0f, 0.9f);
+        cars[i].setPosition(-100.0f + 5.0f * float(i % 20u), 100.0f + 3.0f * float(i / 20u));
+        obstacles.push_back(&cars[i]);
+    }
+    cars.back().setPosition(8.0f, 0.3f);
+
+    bool hit = false;
+    for (size_t i = 0u; i < 2500u; ++i)
+    {
+        crowd.update(0.01_s, obstacles);
+        Pedestrian const& p = crowd.pedestrians()[0];
+        sf::Vector2f const local = cars.back().getInverseTransform().transformPoint(
+            float(p.position().x.value()), float(p.position().y.value()));
+        hit |= (local.x > 0.0f) && (local.x < 4.0f) && (local.y > 0.0f) && (local.y < 1.8f);
+    }
+
+    EXPECT_FALSE(hit);
+    EXPECT_TRUE(crowd.pedestrians()[0].arrived());
+    EXPECT_TRUE(crowd.pedestrians()[1].arrived());
+    EXPECT_NEAR(crowd.pedestrians()[1].position().y.value(), 30.0, 0.5);
+}
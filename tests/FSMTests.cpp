@@ -19,104 +19,193 @@
 // along with Highway.  If not, see <http://www.gnu.org/licenses/>.
 //=====================================================================
 
-#include "qq.hpp"
-#include <iostream>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "FSMTests.hpp"
+#include "ECUs/AutoParkECU/AutoParkECU.hpp"
+#include "Simulation/BluePrints.hpp"
+#include "City/City.hpp"
 
 // -----------------------------------------------------------------------------
-static void enteringStateIdle(MotorControl& mc)
+MotorControl::MotorControl()
+    : StateMachine(MotorStateID::IDLE)
+{}
+
+// -----------------------------------------------------------------------------
+void MotorControl::onEnteringIdle()
 {
-    std::cout << "Entering in state Idle: " << mc.refspeed() << std::endl;
+    actions.push_back("entering IDLE");
+    m_speed = 0.0f;
 }
 
 // -----------------------------------------------------------------------------
-static void enteringStateStop(MotorControl& mc)
+void MotorControl::onEnteringStopping()
 {
-    std::cout << "Entering in state Stop: " << mc.refspeed() << std::endl;
-    mc.transit(MotorStateID::IDLE);
+    actions.push_back("entering STOPPING");
+
+    // Internal event: the motor stops immediately.
+    transition(MotorStateID::IDLE);
 }
 
 // -----------------------------------------------------------------------------
-static void enteringStateStart(MotorControl& mc)
+void MotorControl::onLeavingStarting()
 {
-    std::cout << "Entering in state Start: " << mc.refspeed() << std::endl;
+    actions.push_back("leaving STARTING");
 }
 
 // -----------------------------------------------------------------------------
-static void enteringStateSpinning(MotorControl& mc)
+bool MotorControl::onGuardSpinning()
 {
-    std::cout << "Entering in state Spinning: " << mc.refspeed() << std::endl;
+    actions.push_back("guard SPINNING");
+    return allow_spinning;
 }
 
 // -----------------------------------------------------------------------------
-MotorControl::MotorControl()
-    : StateMachine(MotorStateID::IDLE)
+MotorEventID MotorControl::duringSpinning(float const dt)
 {
-    m_states[MotorStateID::IDLE].entering = enteringStateIdle;
-    m_states[MotorStateID::STOPPING].entering = enteringStateStop;
-    m_states[MotorStateID::STARTING].entering = enteringStateStart;
-    m_states[MotorStateID::SPINNING].entering = enteringStateSpinning;
+    m_speed += dt * (m_refspeed - m_speed);
+    return (m_refspeed > 0.0f) ? MotorEventID::NO_EVENT : MotorEventID::HALT;
 }
 
 // -----------------------------------------------------------------------------
-void MotorControl::halt()
+bool MotorControl::halt()
 {
     m_refspeed = 0.0f;
-    std::cout << "Halt event" << std::endl;
-
-    static Transitions s_transitions = {
-        { MotorStateID::STARTING, MotorStateID::STOPPING },
-        { MotorStateID::SPINNING, MotorStateID::STOPPING },
-    };
-
-    react(s_transitions);
+    return react(MotorEventID::HALT);
 }
 
 // -----------------------------------------------------------------------------
-void MotorControl::refspeed(int const value)
+bool MotorControl::refspeed(float const value)
 {
     m_refspeed = value;
-    std::cout << "New reference speed event: " << value << std::endl;
+    return react(MotorEventID::SET_SPEED);
+}
 
-    static Transitions s_transitions = {
-        { MotorStateID::IDLE, MotorStateID::STARTING },
-        { MotorStateID::STARTING, MotorStateID::SPINNING },
-        { MotorStateID::SPINNING, MotorStateID::SPINNING },
-        { MotorStateID::STOPPING, MotorStateID::CANNOT_HAPPEN },
-    };
+//--------------------------------------------------------------------------
+TEST(TestStateMachine, Transitions)
+{
+    MotorControl mc;
+    ASSERT_EQ(mc.state(), MotorStateID::IDLE);
+    ASSERT_STREQ(mc.c_str(), "IDLE");
+
+    // Ignored event: no action.
+    ASSERT_TRUE(mc.halt());
+    ASSERT_EQ(mc.state(), MotorStateID::IDLE);
+    ASSERT_TRUE(mc.actions.empty());
+
+    ASSERT_TRUE(mc.refspeed(100.0f));
+    ASSERT_EQ(mc.state(), MotorStateID::STARTING);
+    ASSERT_STREQ(mc.c_str(), "STARTING");
+
+    ASSERT_TRUE(mc.refspeed(200.0f));
+    ASSERT_EQ(mc.state(), MotorStateID::SPINNING);
+
+    // Self transition: no entering or leaving actions.
+    mc.actions.clear();
+    ASSERT_TRUE(mc.refspeed(300.0f));
+    ASSERT_EQ(mc.state(), MotorStateID::SPINNING);
+    ASSERT_THAT(mc.actions, testing::ElementsAre("guard SPINNING"));
+
+    // Internal event from the "entering" action of STOPPING.
+    mc.actions.clear();
+    ASSERT_TRUE(mc.halt());
+    ASSERT_EQ(mc.state(), MotorStateID::IDLE);
+    ASSERT_THAT(mc.actions, testing::ElementsAre("entering STOPPING", "entering IDLE"));
+}
 
-    react(s_transitions);
+//--------------------------------------------------------------------------
+TEST(TestStateMachine, Guard)
+{
+    MotorControl mc;
+    mc.allow_spinning = false;
+
+    ASSERT_TRUE(mc.refspeed(100.0f));
+    mc.actions.clear();
+    ASSERT_FALSE(mc.refspeed(200.0f));
+    ASSERT_EQ(mc.state(), MotorStateID::STARTING);
+    ASSERT_THAT(mc.actions, testing::ElementsAre("guard SPINNING"));
+
+    mc.allow_spinning = true;
+    ASSERT_TRUE(mc.refspeed(200.0f));
+    ASSERT_EQ(mc.state(), MotorStateID::SPINNING);
+    ASSERT_THAT(mc.actions, testing::ElementsAre("guard SPINNING", "guard SPINNING",
+                                                 "leaving STARTING"));
 }
 
-// -----------------------------------------------------------------------------
-const char* MotorControl::stringify(MotorStateID const state) const
+//--------------------------------------------------------------------------
+TEST(TestStateMachine, During)
 {
-    static const char* s_states[] = {
-        [MotorStateID::IDLE] = "IDLE",
-        [MotorStateID::STARTING] = "STARTING",
-        [MotorStateID::SPINNING] = "SPINNING",
-        [MotorStateID::STOPPING] = "STOPPING",
-    };
-
-    return s_states[state];
+    MotorControl mc;
+
+    // No "during" action in IDLE.
+    ASSERT_TRUE(mc.update(0.5f));
+    ASSERT_EQ(mc.state(), MotorStateID::IDLE);
+
+    mc.refspeed(10.0f);
+    mc.refspeed(10.0f);
+    ASSERT_EQ(mc.state(), MotorStateID::SPINNING);
+    ASSERT_TRUE(mc.update(0.5f));
+    ASSERT_FLOAT_EQ(mc.speed(), 5.0f);
+    ASSERT_EQ(mc.state(), MotorStateID::SPINNING);
+
+    // The "during" action returns the HALT event.
+    mc.refspeed(0.0f);
+    ASSERT_EQ(mc.state(), MotorStateID::SPINNING);
+    ASSERT_TRUE(mc.update(0.5f));
+    ASSERT_EQ(mc.state(), MotorStateID::IDLE);
+    ASSERT_FLOAT_EQ(mc.speed(), 0.0f);
 }
 
-// -----------------------------------------------------------------------------
-int main()
+//--------------------------------------------------------------------------
+TEST(TestStateMachine, ForbiddenEvent)
 {
     MotorControl mc;
-    std::cout << mc.state() << std::endl;
 
-    mc.refspeed(100);
-    std::cout << mc.state() << std::endl;
+    // Reach STOPPING without its internal transition: use the table directly.
+    ASSERT_TRUE(mc.refspeed(100.0f));
+    ASSERT_TRUE(mc.transition(MotorStateID::STOPPING));
+    ASSERT_EQ(mc.state(), MotorStateID::IDLE);
 
-    mc.refspeed(200);
-    std::cout << mc.state() << std::endl;
+    // Forbidden transitions do not abort the program.
+    ASSERT_FALSE(mc.transition(MotorStateID::CANNOT_HAPPEN));
+    ASSERT_EQ(mc.state(), MotorStateID::IDLE);
 
-    mc.refspeed(300);
-    std::cout << mc.state() << std::endl;
+    mc.reset();
+    ASSERT_EQ(mc.state(), MotorStateID::IDLE);
+    ASSERT_STREQ(MotorControl::name(MotorStateID::SPINNING), "SPINNING");
+}
 
-    mc.halt();
-    std::cout << mc.state() << std::endl;
+//--------------------------------------------------------------------------
+TEST(TestAutoParkStateMachine, LeavingRequested)
+{
+    BluePrints::init();
+    City city;
+    Parking& parking = city.addParking("epi.0", sf::Vector2<Meter>(0.0_m, 0.0_m), 0.0_deg);
+    Car& ego = city.addEgo("Renault.Twingo", sf::Vector2<Meter>(0.0_m, 0.0_m));
+    ASSERT_TRUE(parking.bind(ego));
+
+    // Waiting for the driver.
+    AutoParkECU ecu(ego, city);
+    ecu.update(0.01_s);
+    ASSERT_STREQ(ecu.state(), "IDLE");
+
+    // The car is parked: the turning indicator requests leaving the spot.
+    ego.turningIndicator.state(TurningIndicator::Right);
+    ecu.update(0.01_s);
+    ASSERT_STREQ(ecu.state(), "COMPUTE_LEAVING_TRAJECTORY");
+}
 
-    return 0;
+//--------------------------------------------------------------------------
+TEST(TestAutoParkStateMachine, EnteringRequested)
+{
+    BluePrints::init();
+    City city;
+    city.addParking("epi.0", sf::Vector2<Meter>(0.0_m, 0.0_m), 0.0_deg);
+    Car& ego = city.addEgo("Renault.Twingo", sf::Vector2<Meter>(-20.0_m, -3.0_m));
+
+    // The car is driving: the turning indicator requests scanning spots.
+    AutoParkECU ecu(ego, city);
+    ego.turningIndicator.state(TurningIndicator::Right);
+    ecu.update(0.01_s);
+    ASSERT_STREQ(ecu.state(), "SCAN_PARKING_SPOTS");
 }
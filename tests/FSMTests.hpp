@@ -19,35 +19,78 @@
 // along with Highway.  If not, see <http://www.gnu.org/licenses/>.
 //=====================================================================
 
-#ifndef QQ_HPP
-#define QQ_HPP
+#ifndef FSM_TESTS_HPP
+#  define FSM_TESTS_HPP
 
-#include "StateMachine.hpp"
+#  include "Common/StateMachine.hpp"
+#  include <vector>
+#  include <string>
 
-enum MotorStateID { IDLE, STARTING, SPINNING, STOPPING, IGNORING_EVENT, CANNOT_HAPPEN, MAX_STATES };
+enum MotorStateID { IDLE, STARTING, SPINNING, STOPPING, MAX_STATES, IGNORING_EVENT, CANNOT_HAPPEN };
+enum MotorEventID { SET_SPEED, HALT, MAX_EVENTS, NO_EVENT };
 
 // *****************************************************************************
-//! \brief
+//! \brief Example of state machine: a motor controller.
 // *****************************************************************************
-class MotorControl : public StateMachine<MotorControl, MotorStateID>
+class MotorControl : public StateMachine<MotorControl, MotorStateID, MotorEventID, float>
 {
+    friend class StateMachine<MotorControl, MotorStateID, MotorEventID, float>;
+    using FSM = StateMachine<MotorControl, MotorStateID, MotorEventID, float>;
+
 public:
 
     MotorControl();
-    void halt();
-    void refspeed(int const value);
-    inline float refspeed() const
-    {
-        return m_refspeed;
-    }
+    bool halt();
+    bool refspeed(float const value);
+    inline float refspeed() const { return m_refspeed; }
+    inline float speed() const { return m_speed; }
+
+public:
+
+    //! \brief Trace of called actions.
+    std::vector<std::string> actions;
+    //! \brief Value returned by the guard of the SPINNING state.
+    bool allow_spinning = true;
+
+private:
+
+    void onEnteringIdle();
+    void onEnteringStopping();
+    void onLeavingStarting();
+    bool onGuardSpinning();
+    MotorEventID duringSpinning(float const dt);
+
+private:
+
+    static constexpr FSM::Transitions transitions =
+    {{
+        // SET_SPEED                     HALT
+        {{ MotorStateID::STARTING,       MotorStateID::IGNORING_EVENT }}, // IDLE
+        {{ MotorStateID::SPINNING,       MotorStateID::STOPPING }},       // STARTING
+        {{ MotorStateID::SPINNING,       MotorStateID::STOPPING }},       // SPINNING
+        {{ MotorStateID::CANNOT_HAPPEN,  MotorStateID::IGNORING_EVENT }}, // STOPPING
+    }};
+
+    static constexpr FSM::States states =
+    {{
+        { nullptr, &MotorControl::onEnteringIdle, nullptr, nullptr },     // IDLE
+        { nullptr, nullptr, &MotorControl::onLeavingStarting, nullptr },  // STARTING
+        { &MotorControl::onGuardSpinning, nullptr, nullptr,
+          &MotorControl::duringSpinning },                                // SPINNING
+        { nullptr, &MotorControl::onEnteringStopping, nullptr, nullptr }, // STOPPING
+    }};
 
-protected:
+    static constexpr FSM::Names names =
+    {{
+        "IDLE", "STARTING", "SPINNING", "STOPPING"
+    }};
 
-    virtual const char* stringify(MotorStateID const state) const override;
+    static_assert(FSM::check(transitions), "Bad table of transitions");
 
 private:
 
     float m_refspeed = 0.0f;
+    float m_speed = 0.0f;
 };
 
 #endif
@@ -0,0 +1,191 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "Math/Curves.hpp"
+#include "Math/Math.hpp"
+#include <cmath>
+#include <random>
+
+using math::Frenet;
+
+//--------------------------------------------------------------------------
+//! \brief Quarter of circle of radius R centered on the origin, starting on
+//! the X-axis, sampled by n segments.
+static std::vector<Frenet::Position> arc(double const R, size_t const n)
+{
+    std::vector<Frenet::Position> points;
+    for (size_t i = 0u; i <= n; ++i)
+    {
+        double const a = (math::PI / 2.0) * double(i) / double(n);
+        points.push_back({ R * std::cos(a), R * std::sin(a) });
+    }
+    return points;
+}
+
+//--------------------------------------------------------------------------
+TEST(TestFrenet, Straight)
+{
+    Frenet frenet;
+    ASSERT_EQ(frenet.build({ { 0.0, 0.0 } }), false);
+    ASSERT_EQ(frenet.empty(), true);
+    ASSERT_EQ(frenet.build({ { 1.0, 1.0 }, { 1.0, 1.0 }, { 1.0, 11.0 } }), true);
+    ASSERT_EQ(frenet.segments(), 1u);
+    ASSERT_DOUBLE_EQ(frenet.length(), 10.0);
+    ASSERT_DOUBLE_EQ(frenet.heading(5.0), math::PI / 2.0);
+
+    // Positive lateral offsets on the left side.
+    Frenet::Coordinates c = frenet.toFrenet({ 0.0, 4.0 });
+    ASSERT_NEAR(c.s, 3.0, 1e-9);
+    ASSERT_NEAR(c.d, 1.0, 1e-9);
+
+    // Extrapolation before and after the line.
+    c = frenet.toFrenet({ 2.0, -1.0 });
+    ASSERT_NEAR(c.s, -2.0, 1e-9);
+    ASSERT_NEAR(c.d, -1.0, 1e-9);
+    Frenet::Position p = frenet.toCartesian({ 12.0, 0.5 });
+    ASSERT_NEAR(p.x, 0.5, 1e-9);
+    ASSERT_NEAR(p.y, 13.0, 1e-9);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestFrenet, RoundTrip)
+{
+    double const R = 50.0;
+    Frenet frenet(arc(R, 200u), 0.5);
+    ASSERT_EQ(frenet.segments(), 200u);
+    ASSERT_NEAR(frenet.length(), math::PI * R / 2.0, 0.01);
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> S(0.0, frenet.length());
+    std::uniform_real_distribution<double> D(-3.0, 3.0);
+    for (size_t k = 0u; k < 1000u; ++k)
+    {
+        Frenet::Coordinates const c = { S(rng), D(rng) };
+        Frenet::Position const p = frenet.toCartesian(c);
+
+        // The circle is sampled finely: the point is close to the true one.
+        double const a = c.s / R;
+        ASSERT_NEAR(p.x, (R - c.d) * std::cos(a), 0.05);
+        ASSERT_NEAR(p.y, (R - c.d) * std::sin(a), 0.05);
+
+        // Near vertices, on the inner side of the bend, the round trip error
+        // on the abscissa is bounded by |d| * (angle between segments).
+        Frenet::Coordinates const f = frenet.toFrenet(p);
+        ASSERT_NEAR(f.s, c.s, 3.0 * (math::PI / 2.0) / 200.0);
+        ASSERT_NEAR(f.d, c.d, 1e-3);
+    }
+}
+
+//--------------------------------------------------------------------------
+TEST(TestFrenet, WarmStart)
+{
+    Frenet frenet(arc(50.0, 200u), 0.5);
+
+    // An agent driving along the line: the warm started search shall give the
+    // same result than the full scan.
+    size_t hint = Frenet::NONE;
+    for (double s = -5.0; s < frenet.length() + 5.0; s += 0.7)
+    {
+        Frenet::Position const p = frenet.toCartesian({ s, 1.5 });
+        Frenet::Coordinates const warm = frenet.toFrenet(p, hint);
+        Frenet::Coordinates const cold = frenet.toFrenet(p);
+        ASSERT_LT(hint, frenet.segments());
+        ASSERT_NEAR(warm.s, cold.s, 1e-9);
+        ASSERT_NEAR(warm.d, cold.d, 1e-9);
+        ASSERT_NEAR(warm.s, s, 1.5 * (math::PI / 2.0) / 200.0);
+    }
+}
+
+//--------------------------------------------------------------------------
+TEST(TestFrenet, Batched)
+{
+    Frenet frenet(arc(50.0, 100u), 2.0);
+
+    std::vector<Frenet::Coordinates> coordinates;
+    for (double s = 0.0; s < frenet.length(); s += 1.3)
+    {
+        coordinates.push_back({ s, std::sin(s) });
+    }
+
+    std::vector<Frenet::Position> positions;
+    frenet.toCartesian(coordinates, positions);
+    ASSERT_EQ(positions.size(), coordinates.size());
+
+    std::vector<size_t> hints;
+    std::vector<Frenet::Coordinates> results;
+    frenet.toFrenet(positions, hints, results);
+    ASSERT_EQ(hints.size(), coordinates.size());
+    for (size_t k = 0u; k < coordinates.size(); ++k)
+    {
+        Frenet::Position const p = frenet.toCartesian(coordinates[k]);
+        ASSERT_DOUBLE_EQ(positions[k].x, p.x);
+        ASSERT_DOUBLE_EQ(positions[k].y, p.y);
+        ASSERT_NEAR(results[k].s, coordinates[k].s, (math::PI / 2.0) / 100.0);
+        ASSERT_NEAR(results[k].d, coordinates[k].d, 1e-3);
+    }
+
+    // Second call is warm started.
+    frenet.toFrenet(positions, hints, results);
+    for (size_t k = 0u; k < coordinates.size(); ++k)
+    {
+        ASSERT_NEAR(results[k].s, coordinates[k].s, (math::PI / 2.0) / 100.0);
+    }
+}
+
+//--------------------------------------------------------------------------
+TEST(TestFrenet, Curves)
+{
+    // The spline passes through the given points.
+    std::vector<Frenet::Position> const points = {
+        { 0.0, 0.0 }, { 10.0, 5.0 }, { 20.0, 0.0 }, { 30.0, 5.0 }
+    };
+    std::vector<Frenet::Position> const spline = math::spline(points, 0.5);
+    Frenet frenet(spline);
+    for (auto const& p: points)
+    {
+        ASSERT_NEAR(frenet.toFrenet(p).d, 0.0, 1e-9);
+    }
+    for (size_t i = 1u; i < spline.size(); ++i)
+    {
+        ASSERT_LE(std::hypot(spline[i].x - spline[i - 1u].x,
+                             spline[i].y - spline[i - 1u].y), 0.6);
+    }
+
+    // Lines are not sampled. A full circle is closed.
+    std::vector<Frenet::Position> const line =
+            math::clothoids({ 1.0, 2.0 }, math::PI / 2.0, { { 10.0, 0.0, 0.0 } }, 0.5);
+    ASSERT_EQ(line.size(), 2u);
+    ASSERT_NEAR(line[1].x, 1.0, 1e-9);
+    ASSERT_NEAR(line[1].y, 12.0, 1e-9);
+    std::vector<Frenet::Position> const circle =
+            math::clothoids({ 0.0, 0.0 }, 0.0, { { 2.0 * math::PI * 10.0, 0.1, 0.1 } }, 0.5);
+    ASSERT_NEAR(circle.back().x, 0.0, 1e-6);
+    ASSERT_NEAR(circle.back().y, 0.0, 1e-6);
+
+    // Clothoid: the curvature grows linearly so the heading is quadratic.
+    std::vector<Frenet::Position> const spiral =
+            math::clothoids({ 0.0, 0.0 }, 0.0, { { 20.0, 0.0, 0.1 } }, 0.1);
+    Frenet const s(spiral);
+    ASSERT_NEAR(s.length(), 20.0, 1e-3);
+    ASSERT_NEAR(s.heading(19.99), 0.1 * 20.0 / 2.0, 0.01);
+}
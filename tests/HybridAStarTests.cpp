@@ -0,0 +1,167 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ECUs/AutoParkECU/HybridAStarTrajectory.hpp"
+#include "Simulation/BluePrints.hpp"
+#include "Vehicle/Car.hpp"
+#include "Math/Collide.hpp"
+#include "Math/Math.hpp"
+#include <cmath>
+
+//--------------------------------------------------------------------------
+//! \brief Perpendicular spot at the origin between two parked cars. The ego
+//! car is driving along the aisle.
+class TestHybridAStar : public ::testing::Test
+{
+protected:
+
+    void SetUp() override
+    {
+        BluePrints::init();
+        ParkingBluePrint const& bp = BluePrints::get<ParkingBluePrint>("epi.90");
+        spot = std::make_unique<Parking>(bp, sf::Vector2<Meter>(0.0_m, 0.0_m), 0.0_rad);
+        for (Meter const x: { -2.6_m, 2.6_m })
+        {
+            Parking const slot(bp, sf::Vector2<Meter>(x, 0.0_m), 0.0_rad);
+            sf::Vector2<Meter> position;
+            Radian heading;
+            parked.push_back(std::make_unique<Car>("Renault.Twingo", sf::Color::Blue));
+            slot.goal(parked.back()->blueprint, position, heading);
+            parked.back()->init(0.0_mps_sq, 0.0_mps, position, heading);
+            parked.back()->update(0.0_s);
+        }
+        ego = std::make_unique<Car>("Renault.Twingo", sf::Color::Green);
+        ego->init(0.0_mps_sq, 0.0_mps, sf::Vector2<Meter>(4.0_m, 3.5_m), 0.0_rad);
+        ego->update(0.0_s);
+    }
+
+    TrajectoryRequest request() const
+    {
+        TrajectoryRequest r(*ego, *spot, true);
+        for (auto const& car: parked)
+        {
+            r.obstacles.push_back(car->obb());
+        }
+        return r;
+    }
+
+    std::unique_ptr<Parking> spot;
+    std::vector<std::unique_ptr<Car>> parked;
+    std::unique_ptr<Car> ego;
+};
+
+//--------------------------------------------------------------------------
+TEST_F(TestHybridAStar, PerpendicularSpot)
+{
+    TrajectoryRequest const r = request();
+    HybridAStarTrajectory trajectory;
+    ASSERT_TRUE(trajectory.init(r));
+    auto const& path = trajectory.path();
+    ASSERT_GE(path.size(), 2u);
+
+    // The path reaches the goal pose.
+    sf::Vector2<Meter> position;
+    Radian heading;
+    spot->goal(ego->blueprint, position, heading);
+    math::ReedsShepp::Pose const& end = path.back().pose;
+    EXPECT_NEAR(end.x, position.x.value(), 0.1);
+    EXPECT_NEAR(end.y, position.y.value(), 0.1);
+    EXPECT_NEAR(std::remainder(end.theta - heading.value(), 2.0 * math::PI), 0.0, 0.05);
+
+    // The car never hits the parked cars.
+    Car car("Renault.Twingo", sf::Color::Green);
+    for (auto const& waypoint: path)
+    {
+        sf::Vector2<Meter> const p(Meter(waypoint.pose.x), Meter(waypoint.pose.y));
+        car.init(0.0_mps_sq, 0.0_mps, p, Radian(waypoint.pose.theta));
+        car.update(0.0_s);
+        for (auto const& obstacle: r.obstacles)
+        {
+            sf::Vector2f mtv;
+            ASSERT_FALSE(math::collide(car.obb(), obstacle, mtv));
+        }
+    }
+}
+
+//--------------------------------------------------------------------------
+TEST_F(TestHybridAStar, BlockedSpot)
+{
+    // A car parked in the spot.
+    Car intruder("Renault.Twingo", sf::Color::Red);
+    sf::Vector2<Meter> position;
+    Radian heading;
+    spot->goal(intruder.blueprint, position, heading);
+    intruder.init(0.0_mps_sq, 0.0_mps, position, heading);
+    intruder.update(0.0_s);
+
+    TrajectoryRequest r = request();
+    r.obstacles.push_back(intruder.obb());
+    HybridAStarTrajectory trajectory;
+    EXPECT_FALSE(trajectory.init(r));
+    EXPECT_TRUE(trajectory.path().empty());
+
+    // The spot is free but the search budget is too short.
+    HybridAStarTrajectory::Config config;
+    config.max_iterations = 1u;
+    config.analytic_period = 1000u;
+    HybridAStarTrajectory limited(config);
+    EXPECT_FALSE(limited.init(request()));
+    EXPECT_TRUE(limited.path().empty());
+}
+
+//--------------------------------------------------------------------------
+TEST(TestParking, AngledSpotOnRotatedRoad)
+{
+    // 45 degrees spot along a road heading to 30 degrees.
+    BluePrints::init();
+    ParkingBluePrint const& bp = BluePrints::get<ParkingBluePrint>("epi.45");
+    Radian const road = 30.0_deg;
+    Parking const spot(bp, sf::Vector2<Meter>(10.0_m, 20.0_m), -road);
+    Car car("Renault.Twingo", sf::Color::Green);
+
+    // The parked car is aligned on the slot shape.
+    sf::Vector2<Meter> position;
+    Radian heading;
+    spot.goal(car.blueprint, position, heading);
+    EXPECT_NEAR(Degree(heading).value(), -15.0, 1e-6);
+    EXPECT_NEAR(double(spot.obb().getRotation()), 360.0 - 15.0, 1e-3);
+
+    // origin() and delta() follow the same orientation than the shape: the
+    // middle of its left side and its bottom-right corner.
+    sf::Transform const& transform = spot.obb().getTransform();
+    float const length = float(bp.length.value());
+    float const width = float(bp.width.value());
+    sf::Vector2f const origin = transform.transformPoint(0.0f, width / 2.0f);
+    EXPECT_NEAR(spot.origin().x.value(), double(origin.x), 1e-3);
+    EXPECT_NEAR(spot.origin().y.value(), double(origin.y), 1e-3);
+    sf::Vector2f const delta = transform.transformPoint(length, width);
+    EXPECT_NEAR(spot.delta().x.value(), double(delta.x), 1e-3);
+    EXPECT_NEAR(spot.delta().y.value(), double(delta.y), 1e-3);
+
+    // The goal of the planners is centered in the slot, in front of origin().
+    Meter const x = car.blueprint.back_overhang + (bp.length - car.blueprint.length) / 2.0;
+    sf::Vector2<Meter> const expected = spot.origin() + math::heading(
+        sf::Vector2<Meter>(x, 0.0_m), heading);
+    EXPECT_NEAR(position.x.value(), expected.x.value(), 1e-6);
+    EXPECT_NEAR(position.y.value(), expected.y.value(), 1e-6);
+}
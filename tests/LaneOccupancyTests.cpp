@@ -0,0 +1,186 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "City/City.hpp"
+#include "Simulation/BluePrints.hpp"
+#include "Math/Math.hpp"
+
+//--------------------------------------------------------------------------
+//! \brief Two consecutive roads along the X-axis with a single lane in each
+//! direction.
+class TestLaneOccupancy : public ::testing::Test
+{
+protected:
+
+    void SetUp() override
+    {
+        BluePrints::init();
+        first = &city.addRoad({ { 0.0_m, 0.0_m }, { 100.0_m, 0.0_m } }, 2.0_m, { 1u, 1u });
+        second = &city.addRoad({ { 100.0_m, 0.0_m }, { 200.0_m, 0.0_m } }, 2.0_m, { 1u, 1u });
+    }
+
+    void move(Car& car, Meter const x)
+    {
+        car.init(0.0_mps_sq, 0.0_mps, sf::Vector2<Meter>(x, car.position().y), car.heading());
+    }
+
+    City city;
+    Road* first;
+    Road* second;
+};
+
+//--------------------------------------------------------------------------
+TEST_F(TestLaneOccupancy, Queries)
+{
+    Car& a = city.addCar("Renault.Twingo", *first, TrafficSide::RightHand, 0u, 0.2, 0.5);
+    Car& c = city.addCar("Renault.Twingo", *first, TrafficSide::RightHand, 0u, 0.8, 0.5);
+    Car& b = city.addCar("Renault.Twingo", *first, TrafficSide::RightHand, 0u, 0.5, 0.5);
+
+    Lane& lane = *first->m_lanes[TrafficSide::RightHand][0];
+    ASSERT_EQ(city.lane(a), &lane);
+    ASSERT_EQ(city.lane(b), &lane);
+    ASSERT_EQ(city.lane(c), &lane);
+
+    // Sorted by curvilinear abscissa.
+    Lane::Occupants const& occupants = lane.occupants();
+    ASSERT_EQ(occupants.size(), 3u);
+    ASSERT_EQ(occupants[0].car, &a);
+    ASSERT_EQ(occupants[1].car, &b);
+    ASSERT_EQ(occupants[2].car, &c);
+    ASSERT_NEAR(occupants[0].s.value(), 20.0, 1e-3);
+    ASSERT_LT(occupants[0].rear, occupants[0].s);
+    ASSERT_GT(occupants[0].front, occupants[0].s);
+
+    // Leader, follower and gaps.
+    Meter const s = occupants[1].s;
+    ASSERT_EQ(lane.leader(s)->car, &c);
+    ASSERT_EQ(lane.follower(s)->car, &a);
+    ASSERT_EQ(lane.leader(occupants[2].s), nullptr);
+    ASSERT_EQ(lane.follower(occupants[0].s), nullptr);
+    Meter const length = occupants[0].front - occupants[0].rear;
+    ASSERT_NEAR(lane.gap(s).value(), (30.0_m - length).value(), 1e-3);
+    ASSERT_NEAR(lane.gap(0.0_m).value(), occupants[0].rear.value(), 1e-3);
+    ASSERT_NEAR(lane.gap(99.0_m).value(), (100.0_m - occupants[2].front).value(), 1e-3);
+
+    // Overtaking.
+    move(a, 60.0_m);
+    city.updateLanes();
+    ASSERT_EQ(occupants.size(), 3u);
+    ASSERT_EQ(occupants[0].car, &b);
+    ASSERT_EQ(occupants[1].car, &a);
+    ASSERT_EQ(occupants[2].car, &c);
+    ASSERT_NEAR(occupants[1].s.value(), 60.0, 1e-3);
+}
+
+//--------------------------------------------------------------------------
+TEST_F(TestLaneOccupancy, ChangeOfLane)
+{
+    Car& a = city.addCar("Renault.Twingo", *first, TrafficSide::RightHand, 0u, 0.9, 0.5);
+    Lane& lane1 = *first->m_lanes[TrafficSide::RightHand][0];
+    Lane& lane2 = *second->m_lanes[TrafficSide::RightHand][0];
+    ASSERT_EQ(city.lane(a), &lane1);
+
+    // Drive to the next road.
+    move(a, 110.0_m);
+    city.updateLanes();
+    ASSERT_EQ(city.lane(a), &lane2);
+    ASSERT_TRUE(lane1.occupants().empty());
+    ASSERT_EQ(lane2.occupants().size(), 1u);
+    ASSERT_NEAR(lane2.occupants()[0].s.value(), 10.0, 1e-3);
+
+    // Looking for the next lane does not compute the contraction hierarchy.
+    ASSERT_FALSE(city.graph(false).contracted());
+    ASSERT_TRUE(city.graph().contracted());
+
+    // Outside roads.
+    Car& b = city.addCar("Renault.Twingo", sf::Vector2<Meter>(50.0_m, 20.0_m), 0.0_rad, 0.0_mps);
+    ASSERT_EQ(city.lane(b), nullptr);
+
+    // Removed when the city is reset.
+    city.reset();
+    ASSERT_TRUE(lane2.occupants().empty());
+}
+
+//--------------------------------------------------------------------------
+TEST_F(TestLaneOccupancy, CurvedRoad)
+{
+    // Quarter of circle of radius 50 meters turning left, followed by a line.
+    double const R = 50.0;
+    Road& road = city.addRoad(sf::Vector2<Meter>(0.0_m, 100.0_m), 0.0_rad,
+                              { { math::PI * R / 2.0, 1.0 / R, 1.0 / R }, { 20.0, 0.0, 0.0 } },
+                              2.0_m, { 1u, 1u });
+    ASSERT_NEAR(road.frenet().length(), math::PI * R / 2.0 + 20.0, 0.01);
+    ASSERT_NEAR(road.destination().x.value(), R, 0.01);
+    ASSERT_NEAR(road.destination().y.value(), 100.0 + R + 20.0, 0.01);
+
+    // The right-hand lane is on the outer side of the curve: its center line is
+    // at 1 meter of the road center line.
+    Lane& right = *road.m_lanes[TrafficSide::RightHand][0];
+    Lane& left = *road.m_lanes[TrafficSide::LeftHand][0];
+    ASSERT_NEAR(right.blueprint.length.value(), math::PI * (R + 1.0) / 2.0 + 20.0, 0.01);
+    ASSERT_NEAR(left.blueprint.length.value(), math::PI * (R - 1.0) / 2.0 + 20.0, 0.01);
+
+    // Cars are placed along the curve with the heading of the lane.
+    Car& a = city.addCar("Renault.Twingo", road, TrafficSide::RightHand, 0u, 0.25, 0.5);
+    ASSERT_EQ(city.lane(a), &right);
+    ASSERT_NEAR(a.heading().value(), right.heading(0.25 * right.blueprint.length).value(), 1e-6);
+    ASSERT_NEAR(right.occupants()[0].s.value(), 0.25 * right.blueprint.length.value(), 1e-3);
+
+    // Driving along the lane.
+    sf::Vector2<Meter> const p = road.offset(TrafficSide::RightHand, 0u, 0.5, 0.5);
+    a.init(0.0_mps_sq, 0.0_mps, p, road.heading(TrafficSide::RightHand, 0u, 0.5));
+    city.updateLanes();
+    ASSERT_EQ(city.lane(a), &right);
+    ASSERT_NEAR(right.occupants()[0].s.value(), 0.5 * right.blueprint.length.value(), 1e-3);
+}
+
+//--------------------------------------------------------------------------
+TEST_F(TestLaneOccupancy, RemoveCar)
+{
+    Car& a = city.addCar("Renault.Twingo", *first, TrafficSide::RightHand, 0u, 0.2, 0.5);
+    Car& b = city.addCar("Renault.Twingo", *first, TrafficSide::RightHand, 0u, 0.5, 0.5);
+    City::CarHandle const ha = city.handle(a);
+    City::CarHandle const hb = city.handle(b);
+    ASSERT_EQ(city.get(ha), &a);
+    ASSERT_EQ(city.get(b.name.c_str()), &b);
+
+    Lane& lane = *first->m_lanes[TrafficSide::RightHand][0];
+    ASSERT_EQ(lane.occupants().size(), 2u);
+    ASSERT_TRUE(city.removeCar(ha));
+    ASSERT_FALSE(city.removeCar(ha));
+    ASSERT_EQ(city.get(ha), nullptr);
+    ASSERT_EQ(lane.occupants().size(), 1u);
+    ASSERT_EQ(lane.occupants()[0].car, &b);
+
+    // Only traffic cars are iterated.
+    city.addEgo("Renault.Twingo", *second, TrafficSide::RightHand, 0u, 0.5, 0.5);
+    size_t count = 0u;
+    for (Car const& car: city.cars())
+    {
+        ASSERT_EQ(&car, &b);
+        ++count;
+    }
+    ASSERT_EQ(count, 1u);
+    ASSERT_NE(city.ego(), nullptr);
+    ASSERT_EQ(city.get(hb), &b);
+}
@@ -0,0 +1,108 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "City/City.hpp"
+#include "Simulation/BluePrints.hpp"
+#include "Math/Math.hpp"
+
+//--------------------------------------------------------------------------
+TEST(TestLevelOfDetail, Hysteresis)
+{
+    LODPolicy policy;
+
+    EXPECT_EQ(policy.select(LOD::Full, 10.0_m), LOD::Full);
+    EXPECT_EQ(policy.select(LOD::Full, 55.0_m), LOD::Full);
+    EXPECT_EQ(policy.select(LOD::Full, 65.0_m), LOD::Kinematic);
+    EXPECT_EQ(policy.select(LOD::Kinematic, 55.0_m), LOD::Kinematic);
+    EXPECT_EQ(policy.select(LOD::Kinematic, 45.0_m), LOD::Full);
+    EXPECT_EQ(policy.select(LOD::Kinematic, 155.0_m), LOD::Kinematic);
+    EXPECT_EQ(policy.select(LOD::Kinematic, 165.0_m), LOD::Coarse);
+    EXPECT_EQ(policy.select(LOD::Coarse, 155.0_m), LOD::Coarse);
+    EXPECT_EQ(policy.select(LOD::Coarse, 145.0_m), LOD::Kinematic);
+    EXPECT_EQ(policy.select(LOD::Coarse, 10.0_m), LOD::Full);
+    EXPECT_EQ(policy.select(LOD::Full, 1000.0_m), LOD::Coarse);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestLevelOfDetail, Switching)
+{
+    BluePrints::init();
+    City city;
+    Car& car = city.addCar("Renault.Twingo", { 0.0_m, 0.0_m }, 90.0_deg, 10.0_mps, 0.0_deg);
+    ASSERT_EQ(car.lod(), LOD::Full);
+
+    // Far away: dead reckoning along the heading.
+    car.lod(LOD::Coarse);
+    for (size_t i = 0u; i < 100u; ++i)
+    {
+        car.update(0.01_s);
+    }
+    EXPECT_NEAR(car.position().x.value(), 0.0, 1e-6);
+    EXPECT_NEAR(car.position().y.value(), 10.0, 1e-6);
+    EXPECT_NEAR(car.speed().value(), 10.0, 1e-6);
+    EXPECT_NEAR(car.obb().getPosition().y, 10.0f, 1e-4f);
+
+    // Back to full fidelity from the same state.
+    car.lod(LOD::Full);
+    car.update(0.01_s);
+    EXPECT_NEAR(car.position().x.value(), 0.0, 1e-3);
+    EXPECT_GE(car.position().y.value(), 10.0 - 1e-6);
+    EXPECT_LT(car.position().y.value(), 10.2);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestLevelOfDetail, CoarseAlongLane)
+{
+    // Quarter of circle of radius 50 meters turning left.
+    BluePrints::init();
+    City city;
+    double const R = 50.0;
+    Road& road = city.addRoad(sf::Vector2<Meter>(0.0_m, 100.0_m), 0.0_rad,
+                              { { math::PI * R / 2.0, 1.0 / R, 1.0 / R }, { 20.0, 0.0, 0.0 } },
+                              2.0_m, { 1u, 1u });
+    Lane const& lane = *road.m_lanes[TrafficSide::RightHand][0];
+    Car& car = city.addCar("Renault.Twingo", road, TrafficSide::RightHand, 0u, 0.1, 0.5, 10.0_mps);
+    ASSERT_EQ(city.lane(car), &lane);
+    double const s0 = lane.frenet().toFrenet({ car.position().x.value(), car.position().y.value() }).s;
+
+    // Far away: dead reckoning along the lane, not along the heading.
+    car.lod(LOD::Coarse);
+    for (size_t i = 0u; i < 300u; ++i)
+    {
+        car.update(0.01_s);
+        city.updateLanes();
+    }
+    math::Frenet::Coordinates const c =
+        lane.frenet().toFrenet({ car.position().x.value(), car.position().y.value() });
+    EXPECT_NEAR(c.s, s0 + 30.0, 1e-2);
+    EXPECT_NEAR(c.d, 0.0, 1e-2);
+    EXPECT_NEAR(car.heading().value(), lane.frenet().heading(c.s), 1e-3);
+    EXPECT_NEAR(car.speed().value(), 10.0, 1e-6);
+    EXPECT_EQ(city.lane(car), &lane);
+
+    // Back to full fidelity: the car continues from its lane.
+    sf::Vector2<Meter> const before = car.position();
+    car.lod(LOD::Full);
+    car.update(0.01_s);
+    EXPECT_LT(math::distance(car.position(), before).value(), 0.2);
+}
@@ -0,0 +1,210 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ECUs/AutoParkECU/ManeuverCache.hpp"
+#include "ECUs/AutoParkECU/TrajectoryPlanner.hpp"
+#include "Simulation/BluePrints.hpp"
+#include "Vehicle/Car.hpp"
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+
+//--------------------------------------------------------------------------
+//! \brief Key of a car entering a parallel spot at the origin.
+static ManeuverCache::Key key(const char* model, sf::Vector2<Meter> const& position,
+                              Radian const heading, bool const entering = true)
+{
+    BluePrints::init();
+    Car car(model, sf::Color::Green);
+    car.init(0.0_mps_sq, 0.0_mps, position, heading);
+    car.update(0.0_s);
+    ParkingBluePrint const& bp = BluePrints::get<ParkingBluePrint>("epi.0");
+    Parking const spot(bp, sf::Vector2<Meter>(0.0_m, 0.0_m), 0.0_rad);
+    return ManeuverCache::key(TrajectoryRequest(car, spot, entering));
+}
+
+//--------------------------------------------------------------------------
+static std::vector<char> read(std::string const& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file),
+                             std::istreambuf_iterator<char>());
+}
+
+//--------------------------------------------------------------------------
+static void write(std::string const& path, std::vector<char> const& bytes)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(bytes.data(), std::streamsize(bytes.size()));
+}
+
+//--------------------------------------------------------------------------
+TEST(TestManeuverCache, KeyQuantization)
+{
+    ManeuverCache::Key const k = key("Renault.Twingo", { 10.0_m, 2.5_m }, 0.0_rad);
+
+    // Start poses within the quanta share the same key.
+    EXPECT_EQ(key("Renault.Twingo", { 10.01_m, 2.49_m }, 0.001_rad), k);
+
+    // Neighbouring poses, other cars and directions do not.
+    EXPECT_NE(key("Renault.Twingo", { 10.1_m, 2.5_m }, 0.0_rad), k);
+    EXPECT_NE(key("Renault.Twingo", { 10.0_m, 2.6_m }, 0.0_rad), k);
+    EXPECT_NE(key("Renault.Twingo", { 10.0_m, 2.5_m }, 0.01_rad), k);
+    EXPECT_NE(key("Audi.A6", { 10.0_m, 2.5_m }, 0.0_rad), k);
+    EXPECT_NE(key("Renault.Twingo", { 10.0_m, 2.5_m }, 0.0_rad, false), k);
+}
+
+//--------------------------------------------------------------------------
+//! \brief Request of a car entering a parallel spot along a road heading to
+//! the given angle. The scene is the one at the origin rotated around the
+//! given position.
+static TrajectoryRequest request(Car& car, sf::Vector2<Meter> const& position,
+                                 Radian const heading)
+{
+    ParkingBluePrint const& bp = BluePrints::get<ParkingBluePrint>("epi.0");
+    ParkingBluePrint const dim(car.blueprint.length + 1.5_m, bp.width, bp.angle);
+    Parking const spot(dim, position, -heading);
+    car.init(0.0_mps_sq, 0.0_mps, position + math::heading(
+                 sf::Vector2<Meter>(dim.length, 2.5_m), heading), heading);
+    car.update(0.0_s);
+    TrajectoryRequest r(car, spot, true);
+    r.candidates = 1u;
+    return r;
+}
+
+//--------------------------------------------------------------------------
+TEST(TestManeuverCache, RotatedScenes)
+{
+    BluePrints::init();
+    Car car("Renault.Twingo", sf::Color::Green);
+
+    // Same scene at several rotations: same key.
+    ManeuverCache::Key const k = ManeuverCache::key(
+        request(car, { 0.0_m, 0.0_m }, 0.0_deg));
+    for (Degree const angle: { 30.0_deg, 90.0_deg, 145.0_deg, -60.0_deg })
+    {
+        EXPECT_EQ(ManeuverCache::key(request(car, { 100.0_m, 50.0_m }, angle)), k);
+    }
+
+    // Planning the rotated scene replays the maneuvers of the first one.
+    ManeuverCache& cache = ManeuverCache::instance();
+    cache.clear();
+    TrajectoryPlanner::Result const first =
+        TrajectoryPlanner::plan(request(car, { 0.0_m, 0.0_m }, 0.0_deg));
+    ASSERT_TRUE(first.succeeded);
+    ASSERT_EQ(cache.size(), 1u);
+
+    TrajectoryPlanner::Result const second =
+        TrajectoryPlanner::plan(request(car, { 100.0_m, 50.0_m }, 30.0_deg));
+    ASSERT_TRUE(second.succeeded);
+    EXPECT_EQ(cache.size(), 1u);
+    auto const& messages = second.trajectory->messages();
+    EXPECT_NE(std::find_if(messages.begin(), messages.end(), [](std::string const& m)
+    {
+        return m.find("restored from the cache") != std::string::npos;
+    }), messages.end());
+    cache.clear();
+}
+
+//--------------------------------------------------------------------------
+TEST(TestManeuverCache, StoreAndReload)
+{
+    ManeuverCache& cache = ManeuverCache::instance();
+    cache.clear();
+    ASSERT_EQ(cache.size(), 0u);
+
+    ManeuverCache::Key const k1 = key("Renault.Twingo", { 10.0_m, 2.5_m }, 0.0_rad);
+    ManeuverCache::Key const k2 = key("Renault.Twingo", { 12.0_m, 2.5_m }, 0.0_rad);
+    ManeuverCache::Buffer const b1 = { 1u, 2u, 3u };
+    ManeuverCache::Buffer const b2 = { 4u, 5u };
+    cache.store(k1, b1);
+    cache.store(k2, b2);
+    ASSERT_EQ(cache.size(), 2u);
+
+    ManeuverCache::Buffer buffer;
+    ASSERT_TRUE(cache.find(k1, buffer));
+    EXPECT_EQ(buffer, b1);
+
+    // Entries are found back from the file after a restart.
+    std::string const path = ::testing::TempDir() + "copy.cache";
+    std::vector<char> const bytes = read(cache.path());
+    write(path, bytes);
+    cache.clear();
+    ASSERT_EQ(cache.size(), 0u);
+    ASSERT_FALSE(cache.find(k1, buffer));
+    ASSERT_TRUE(cache.load(path));
+    ASSERT_EQ(cache.size(), 2u);
+    ASSERT_TRUE(cache.find(k1, buffer));
+    EXPECT_EQ(buffer, b1);
+    ASSERT_TRUE(cache.find(k2, buffer));
+    EXPECT_EQ(buffer, b2);
+    cache.clear();
+}
+
+//--------------------------------------------------------------------------
+TEST(TestManeuverCache, RejectedFiles)
+{
+    ManeuverCache& cache = ManeuverCache::instance();
+    cache.clear();
+
+    ManeuverCache::Key const k1 = key("Renault.Twingo", { 10.0_m, 2.5_m }, 0.0_rad);
+    ManeuverCache::Key const k2 = key("Renault.Twingo", { 12.0_m, 2.5_m }, 0.0_rad);
+    cache.store(k1, { 1u, 2u, 3u });
+    cache.store(k2, { 4u, 5u });
+    std::vector<char> const bytes = read(cache.path());
+    cache.clear();
+    ASSERT_GT(bytes.size(), 8u);
+
+    std::string const path = ::testing::TempDir() + "copy.cache";
+    ManeuverCache::Buffer buffer;
+
+    // Missing file.
+    std::remove(path.c_str());
+    EXPECT_FALSE(cache.load(path));
+
+    // Truncated entry (i.e. the simulator has been killed): previous entries
+    // are kept.
+    write(path, std::vector<char>(bytes.begin(), bytes.end() - 1));
+    EXPECT_TRUE(cache.load(path));
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_TRUE(cache.find(k1, buffer));
+    EXPECT_FALSE(cache.find(k2, buffer));
+    cache.clear();
+
+    // Truncated header.
+    write(path, std::vector<char>(bytes.begin(), bytes.begin() + 6));
+    EXPECT_FALSE(cache.load(path));
+
+    // Wrong magic number.
+    std::vector<char> corrupted = bytes;
+    corrupted[0] = 'X';
+    write(path, corrupted);
+    EXPECT_FALSE(cache.load(path));
+
+    // Wrong version.
+    corrupted = bytes;
+    corrupted[4] = char(corrupted[4] + 1);
+    write(path, corrupted);
+    EXPECT_FALSE(cache.load(path));
+    EXPECT_EQ(cache.size(), 0u);
+}
@@ -0,0 +1,283 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "City/MapImporter.hpp"
+#include "City/City.hpp"
+#include "City/Network.hpp"
+#include "Common/FileSystem.hpp"
+#include "Common/XmlReader.hpp"
+#include "Simulation/BluePrints.hpp"
+#include <fstream>
+#include <sstream>
+
+//--------------------------------------------------------------------------
+//! \brief Memorize the visited elements.
+class Trace : public XmlReader::Listener
+{
+public:
+
+    void onStart(std::string const& name, XmlReader::Attributes const& attributes) override
+    {
+        text += "<" + name;
+        if (const char* v = attributes.get("v"))
+            text += " " + std::string(v);
+        text += ">";
+    }
+
+    void onEnd(std::string const& name) override
+    {
+        text += "</" + name + ">";
+    }
+
+    std::string text;
+};
+
+//--------------------------------------------------------------------------
+static void write(std::string const& path, const char* content)
+{
+    std::ofstream file(path);
+    file << content;
+}
+
+//--------------------------------------------------------------------------
+TEST(TestMapImporter, XmlReader)
+{
+    XmlReader reader;
+    Trace trace;
+    std::istringstream good(
+        "<?xml version='1.0'?>\n<!DOCTYPE osm>\n<!-- <ignored/> -->"
+        "<a v=\"x &amp; &lt;y&gt;\"><b v='1'/><![CDATA[<c/>]]><d></d></a>");
+    ASSERT_TRUE(reader.parse(good, trace));
+    EXPECT_EQ(trace.text, "<a x & <y>><b 1></b><d></d></a>");
+
+    Trace bad;
+    std::istringstream mismatch("<a><b></a>");
+    EXPECT_FALSE(reader.parse(mismatch, bad));
+    EXPECT_FALSE(reader.error().empty());
+
+    std::istringstream truncated("<a><b/>");
+    EXPECT_FALSE(reader.parse(truncated, bad));
+}
+
+//--------------------------------------------------------------------------
+//! \brief Terminators of sections preceded by their own first characters.
+TEST(TestMapImporter, XmlReaderTerminators)
+{
+    XmlReader reader;
+
+    Trace cdata;
+    std::istringstream brackets("<a><![CDATA[x]]]><b/></a>");
+    ASSERT_TRUE(reader.parse(brackets, cdata)) << reader.error();
+    EXPECT_EQ(cdata.text, "<a><b></b></a>");
+
+    Trace instruction;
+    std::istringstream marks("<?xml version='1.0'??><a><?pi x??><b/></a>");
+    ASSERT_TRUE(reader.parse(marks, instruction)) << reader.error();
+    EXPECT_EQ(instruction.text, "<a><b></b></a>");
+
+    Trace comment;
+    std::istringstream dashes("<a><!-- x ---><b/></a>");
+    ASSERT_TRUE(reader.parse(dashes, comment)) << reader.error();
+    EXPECT_EQ(comment.text, "<a><b></b></a>");
+}
+
+//--------------------------------------------------------------------------
+//! \brief Documents truncated inside markup declarations.
+TEST(TestMapImporter, XmlReaderTruncatedDeclarations)
+{
+    XmlReader reader;
+    for (const char* document: { "<!", "<!DOCTY", "<!DOCTYPE osm", "<a><!DOCTYPE",
+                                 "<!DOCTYPE osm [<!ENTITY x 'y'>", "<!DOCTYPE osm [ ]" })
+    {
+        Trace trace;
+        std::istringstream truncated(document);
+        EXPECT_FALSE(reader.parse(truncated, trace)) << document;
+        EXPECT_FALSE(reader.error().empty()) << document;
+    }
+
+    // Short declarations and internal subsets do not swallow the next tags.
+    Trace trace;
+    std::istringstream dtd("<!X><a><!DOCTYPE a [<!ENTITY x '>'>]><b/></a>");
+    ASSERT_TRUE(reader.parse(dtd, trace)) << reader.error();
+    EXPECT_EQ(trace.text, "<a><b></b></a>");
+}
+
+//--------------------------------------------------------------------------
+//! \brief Two roads crossing at a junction (node 3), a oneway road and a
+//! parking area of 20 x 10 meters.
+TEST(TestMapImporter, OpenStreetMap)
+{
+    BluePrints::init();
+    std::string const path = ::testing::TempDir() + "map.osm";
+    write(path, R"(<?xml version="1.0" encoding="UTF-8"?>
+<osm version="0.6">
+ <node id="1" lat="48.8500" lon="2.3500"/>
+ <node id="2" lat="48.8500" lon="2.3510"/>
+ <node id="3" lat="48.8500" lon="2.3520"/>
+ <node id="4" lat="48.8500" lon="2.3530"/>
+ <node id="5" lat="48.8510" lon="2.3520"/>
+ <node id="6" lat="48.8490" lon="2.3520"/>
+ <node id="7" lat="48.8495" lon="2.3500"/>
+ <node id="10" lat="48.8520" lon="2.3500"/>
+ <node id="11" lat="48.8520" lon="2.35027"/>
+ <node id="12" lat="48.85209" lon="2.35027"/>
+ <node id="13" lat="48.85209" lon="2.3500"/>
+ <way id="100">
+  <nd ref="1"/><nd ref="2"/><nd ref="3"/><nd ref="4"/>
+  <tag k="highway" v="residential"/>
+  <tag k="lanes" v="3"/>
+ </way>
+ <way id="101">
+  <nd ref="5"/><nd ref="3"/><nd ref="6"/>
+  <tag k="highway" v="primary"/>
+  <tag k="oneway" v="yes"/>
+  <tag k="lanes" v="2"/>
+  <tag k="width" v="7"/>
+ </way>
+ <way id="102">
+  <nd ref="7"/><nd ref="1"/>
+  <tag k="highway" v="footway"/>
+ </way>
+ <way id="103">
+  <nd ref="10"/><nd ref="11"/><nd ref="12"/><nd ref="13"/><nd ref="10"/>
+  <tag k="amenity" v="parking"/>
+ </way>
+</osm>)");
+
+    City city;
+    Path network;
+    MapImporter importer;
+    ASSERT_TRUE(importer.importOSM(path, city, &network));
+
+    // The two ways are split at their junction. The footway is ignored.
+    ASSERT_EQ(city.roads().size(), 4u);
+    Road const& west = *city.roads()[0];
+    EXPECT_EQ(west.centers().size(), 3u);
+    EXPECT_EQ(west.m_lanes[TrafficSide::RightHand].size(), 2u);
+    EXPECT_EQ(west.m_lanes[TrafficSide::LeftHand].size(), 1u);
+    EXPECT_DOUBLE_EQ(west.width().value(), 3.0);
+    EXPECT_NEAR(west.frenet().length(), 146.4, 0.5);
+    EXPECT_NEAR(west.destination().x.value(), city.roads()[1]->origin().x.value(), 1e-6);
+
+    Road const& north = *city.roads()[2];
+    EXPECT_EQ(north.m_lanes[TrafficSide::RightHand].size(), 2u);
+    EXPECT_EQ(north.m_lanes[TrafficSide::LeftHand].size(), 0u);
+    EXPECT_DOUBLE_EQ(north.width().value(), 3.5);
+    EXPECT_NEAR(north.frenet().length(), 111.2, 0.5);
+    EXPECT_LT(north.destination().y, north.origin().y);
+
+    // Junctions are shared by roads of the network.
+    EXPECT_EQ(network.nodes().size(), 5u);
+    EXPECT_EQ(network.ways().size(), 4u);
+
+    // A row of perpendicular slots along the 20 meters side.
+    ASSERT_EQ(city.parkings().size(), 8u);
+    for (auto const& parking: city.parkings())
+    {
+        EXPECT_EQ(parking->type, Parking::Type::Perpendicular);
+        EXPECT_GT(parking->position().y, west.origin().y);
+    }
+}
+
+//--------------------------------------------------------------------------
+//! \brief A road made of a line and an arc, one driving lane on each side
+//! and a parking space.
+TEST(TestMapImporter, OpenDRIVE)
+{
+    BluePrints::init();
+    std::string const path = ::testing::TempDir() + "map.xodr";
+    write(path, R"(<?xml version="1.0" standalone="yes"?>
+<OpenDRIVE>
+ <header revMajor="1" revMinor="6"/>
+ <road name="r" length="131.4159" id="1" junction="-1">
+  <planView>
+   <geometry s="0" x="10" y="20" hdg="0" length="100"><line/></geometry>
+   <geometry s="100" x="110" y="20" hdg="0" length="31.4159"><arc curvature="0.05"/></geometry>
+  </planView>
+  <lanes>
+   <laneSection s="0">
+    <left><lane id="2" type="sidewalk"><width sOffset="0" a="2" b="0" c="0" d="0"/></lane>
+          <lane id="1" type="driving"><width sOffset="0" a="3.25" b="0" c="0" d="0"/></lane></left>
+    <center><lane id="0" type="none"/></center>
+    <right><lane id="-1" type="driving"><width sOffset="0" a="3.25" b="0" c="0" d="0"/></lane></right>
+   </laneSection>
+  </lanes>
+  <objects>
+   <object id="1" type="parkingSpace" s="50" t="-5" hdg="0"/>
+  </objects>
+ </road>
+ <road name="empty" length="10" id="2" junction="-1">
+  <planView><geometry s="0" x="0" y="0" hdg="0" length="10"><line/></geometry></planView>
+  <lanes><laneSection s="0"><right><lane id="-1" type="sidewalk"/></right></laneSection></lanes>
+ </road>
+</OpenDRIVE>)");
+
+    City city;
+    MapImporter importer;
+    ASSERT_TRUE(importer.importOpenDRIVE(path, city));
+
+    ASSERT_EQ(city.roads().size(), 1u);
+    Road const& road = *city.roads()[0];
+    EXPECT_EQ(road.m_lanes[TrafficSide::RightHand].size(), 1u);
+    EXPECT_EQ(road.m_lanes[TrafficSide::LeftHand].size(), 1u);
+    EXPECT_DOUBLE_EQ(road.width().value(), 3.25);
+    EXPECT_NEAR(road.frenet().length(), 131.4159, 0.1);
+    EXPECT_NEAR(road.origin().x.value(), 10.0, 1e-6);
+    EXPECT_NEAR(road.origin().y.value(), 20.0, 1e-6);
+    // Quarter of circle of 20 meters of radius.
+    EXPECT_NEAR(road.destination().x.value(), 130.0, 0.1);
+    EXPECT_NEAR(road.destination().y.value(), 40.0, 0.1);
+
+    ASSERT_EQ(city.parkings().size(), 1u);
+    EXPECT_NEAR(city.parkings()[0]->position().x.value(), 60.0, 1e-3);
+    EXPECT_NEAR(city.parkings()[0]->position().y.value(), 15.0, 1e-3);
+
+    EXPECT_FALSE(importer.importOpenDRIVE(::testing::TempDir() + "none.xodr", city));
+    EXPECT_FALSE(importer.error().empty());
+}
+
+//--------------------------------------------------------------------------
+TEST(TestMapImporter, Cache)
+{
+    BluePrints::init();
+    std::string const path = ::testing::TempDir() + "map.xodr";
+    std::string const cache = ::testing::TempDir() + "map.bin";
+    std::remove(cache.c_str());
+
+    City imported;
+    MapImporter importer;
+    ASSERT_TRUE(importer.load(path, imported, cache));
+    std::ifstream file(cache);
+    ASSERT_TRUE(file.good());
+
+    // Loaded from the cache: the map is no longer read.
+    std::remove(path.c_str());
+    write(path, "");
+    fs::last_write_time(cache, fs::last_write_time(path) + std::chrono::seconds(1));
+    City cached;
+    ASSERT_TRUE(importer.load(path, cached, cache));
+    ASSERT_EQ(cached.roads().size(), imported.roads().size());
+    ASSERT_EQ(cached.parkings().size(), imported.parkings().size());
+    EXPECT_NEAR(cached.roads()[0]->frenet().length(),
+                imported.roads()[0]->frenet().length(), 1e-3);
+}
@@ -0,0 +1,173 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ECUs/AutoParkECU/ParkingSpotMap.hpp"
+#include "Simulation/BluePrints.hpp"
+#include <cmath>
+
+//--------------------------------------------------------------------------
+//! \brief Drive along the kerb from 0 to 20 meters by steps of 5 cm: parked
+//! cars are in [0, 4.5] and [10, 14.5].
+static void scan(ParkingSpotMap& map)
+{
+    for (int i = 0; i < 400; ++i)
+    {
+        bool const free = (i >= 90 && i < 200) || (i >= 290);
+        map.observe(Meter(0.05 * i), Meter(0.05 * (i + 1)), free);
+    }
+}
+
+//--------------------------------------------------------------------------
+TEST(TestParkingSpotMap, Intervals)
+{
+    ParkingSpotMap map;
+    map.reset(sf::Vector2<Meter>(10.0_m, 5.0_m), 0.0_rad, true);
+    scan(map);
+
+    // Adjacent observations are merged.
+    ASSERT_EQ(map.intervals().size(), 4u);
+    ASSERT_EQ(map.at(-1.0_m), nullptr);
+    ASSERT_EQ(map.at(21.0_m), nullptr);
+    ASSERT_FALSE(map.at(2.0_m)->free);
+    ASSERT_TRUE(map.at(7.0_m)->free);
+    ASSERT_NEAR(map.at(7.0_m)->end.value(), 10.0, 1e-6);
+    ASSERT_EQ(map.at(7.0_m)->confidence, 1u);
+
+    // Second pass: confidence increases.
+    scan(map);
+    ASSERT_EQ(map.intervals().size(), 4u);
+    ASSERT_EQ(map.at(7.0_m)->confidence, 2u);
+
+    // The parked car has left.
+    map.observe(10.0_m, 14.5_m, true);
+    ASSERT_FALSE(map.at(12.0_m)->free);
+    map.observe(14.5_m, 10.0_m, true);
+    ASSERT_TRUE(map.at(12.0_m)->free);
+    ASSERT_EQ(map.at(12.0_m)->confidence, 1u);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestParkingSpotMap, Spots)
+{
+    ParkingSpotMap map;
+    map.reset(sf::Vector2<Meter>(10.0_m, 5.0_m), 0.0_rad, true);
+    scan(map);
+
+    ParkingSpotMap::Spot spot;
+
+    // Closed spot [4.5, 10] long enough for a 4 meters car.
+    ASSERT_TRUE(map.find(0.0_m, 12.0_m, 4.0_m, 8.0_m, spot));
+    ASSERT_TRUE(spot.closed);
+    ASSERT_NEAR(spot.start.value(), 4.5, 1e-6);
+    ASSERT_NEAR(spot.end.value(), 10.0, 1e-6);
+
+    // Too short for a 6 meters car but the open spot after the second parked
+    // car is long enough.
+    ASSERT_TRUE(map.find(0.0_m, 20.0_m, 6.0_m, 5.0_m, spot));
+    ASSERT_FALSE(spot.closed);
+    ASSERT_NEAR(spot.start.value(), 14.5, 1e-6);
+    ASSERT_NEAR(spot.end.value(), 19.5, 1e-6);
+
+    // Not yet observed far enough.
+    ASSERT_FALSE(map.find(0.0_m, 8.0_m, 4.0_m, 8.0_m, spot));
+    // Spots before the search window are ignored.
+    ASSERT_FALSE(map.find(5.0_m, 12.0_m, 4.0_m, 8.0_m, spot));
+
+    // World coordinates: the kerb is on the right.
+    ASSERT_NEAR(map.abscissa(sf::Vector2<Meter>(14.5_m, 3.0_m)).value(), 4.5, 1e-6);
+    sf::Vector2<Meter> p = map.position(4.5_m, 1.0_m);
+    ASSERT_NEAR(p.x.value(), 14.5, 1e-6);
+    ASSERT_NEAR(p.y.value(), 4.0, 1e-6);
+    ASSERT_TRUE(map.aligned(sf::Vector2<Meter>(30.0_m, 5.5_m), 2.0_deg, true));
+    ASSERT_FALSE(map.aligned(sf::Vector2<Meter>(30.0_m, 5.5_m), 2.0_deg, false));
+    ASSERT_FALSE(map.aligned(sf::Vector2<Meter>(30.0_m, 8.0_m), 0.0_deg, true));
+}
+
+//--------------------------------------------------------------------------
+TEST(TestParkingSpotMap, SpotOverIntervalsOfDifferentConfidences)
+{
+    ParkingSpotMap map;
+    map.reset(sf::Vector2<Meter>(0.0_m, 0.0_m), 0.0_rad, true);
+    map.observe(0.0_m, 6.0_m, true);
+    map.observe(0.0_m, 6.0_m, true);
+    map.observe(6.0_m, 8.0_m, true);
+
+    // Free intervals are not merged since their confidences differ.
+    ASSERT_EQ(map.intervals().size(), 2u);
+    ASSERT_EQ(map.at(3.0_m)->confidence, 2u);
+    ASSERT_EQ(map.at(7.0_m)->confidence, 1u);
+
+    // The spot holds on both intervals.
+    ParkingSpotMap::Spot spot;
+    ASSERT_TRUE(map.find(0.0_m, 10.0_m, 4.0_m, 7.0_m, spot));
+    ASSERT_FALSE(spot.closed);
+    ASSERT_NEAR(spot.start.value(), 0.0, 1e-6);
+    ASSERT_NEAR(spot.end.value(), 7.0, 1e-6);
+    ASSERT_EQ(spot.confidence, 1u);
+
+    // Closed by a parked vehicle.
+    map.observe(8.0_m, 12.0_m, false);
+    ASSERT_TRUE(map.find(0.0_m, 12.0_m, 7.5_m, 20.0_m, spot));
+    ASSERT_TRUE(spot.closed);
+    ASSERT_NEAR(spot.start.value(), 0.0, 1e-6);
+    ASSERT_NEAR(spot.end.value(), 8.0, 1e-6);
+    ASSERT_EQ(spot.confidence, 1u);
+
+    // The run does not start before the search window.
+    ASSERT_FALSE(map.find(1.0_m, 12.0_m, 7.5_m, 20.0_m, spot));
+    ASSERT_TRUE(map.find(1.0_m, 12.0_m, 1.5_m, 20.0_m, spot));
+    ASSERT_NEAR(spot.start.value(), 6.0, 1e-6);
+    ASSERT_NEAR(spot.end.value(), 8.0, 1e-6);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestParkingSpotMap, ParkingOnRotatedKerb)
+{
+    BluePrints::init();
+    CarBluePrint const& car = BluePrints::get<CarBluePrint>("Renault.Twingo");
+
+    // Kerb on the right of a road heading to 30 degrees.
+    Radian const heading = 30.0_deg;
+    ParkingSpotMap map;
+    map.reset(sf::Vector2<Meter>(10.0_m, 5.0_m), heading, true);
+    scan(map);
+
+    ParkingSpotMap::Spot spot;
+    ASSERT_TRUE(map.find(0.0_m, 12.0_m, 4.0_m, 8.0_m, spot));
+    Parking const parking = map.parking(spot, 2.0_m);
+
+    // Like parkings made by City::addParking(): oriented by the opposite of
+    // the road heading.
+    ASSERT_NEAR(parking.heading().value(), -heading.value(), 1e-6);
+
+    // The parked car is aligned on the kerb, centered in the spot and in the
+    // middle of the slot width.
+    sf::Vector2<Meter> position;
+    Radian goal;
+    parking.goal(car, position, goal);
+    ASSERT_NEAR(std::remainder((goal - heading).value(), Radian(360.0_deg).value()), 0.0, 1e-6);
+    Meter const x = car.back_overhang + (spot.length() - car.length) / 2.0;
+    sf::Vector2<Meter> const expected = map.position(spot.start + x, 2.0_m);
+    ASSERT_NEAR(position.x.value(), expected.x.value(), 1e-6);
+    ASSERT_NEAR(position.y.value(), expected.y.value(), 1e-6);
+}
@@ -0,0 +1,64 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "Math/ReedsShepp.hpp"
+#include "Math/Math.hpp"
+#include <cmath>
+#include <random>
+
+//--------------------------------------------------------------------------
+TEST(TestReedsShepp, StraightLine)
+{
+    math::ReedsShepp rs(5.0);
+
+    ASSERT_NEAR(rs.distance({ 0.0, 0.0, 0.0 }, { 10.0, 0.0, 0.0 }), 10.0, 1e-9);
+    ASSERT_NEAR(rs.distance({ 0.0, 0.0, 0.0 }, { -3.0, 0.0, 0.0 }), 3.0, 1e-9);
+    ASSERT_NEAR(rs.distance({ 1.0, 2.0, 0.5 }, { 1.0, 2.0, 0.5 }), 0.0, 1e-9);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestReedsShepp, ReachGoal)
+{
+    math::ReedsShepp rs(4.0);
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> xy(-20.0, 20.0);
+    std::uniform_real_distribution<double> angle(-math::PI, math::PI);
+
+    for (size_t i = 0u; i < 1000u; ++i)
+    {
+        const math::ReedsShepp::Pose from = { xy(gen), xy(gen), angle(gen) };
+        const math::ReedsShepp::Pose to = { xy(gen), xy(gen), angle(gen) };
+        const auto path = rs.path(from, to);
+
+        // Not shorter than the Euclidean distance.
+        ASSERT_GE(rs.radius() * path.length() + 1e-9,
+                  std::hypot(to.x - from.x, to.y - from.y));
+
+        size_t segment;
+        const auto end = rs.interpolate(from, path, rs.radius() * path.length(), segment);
+        ASSERT_NEAR(end.x, to.x, 1e-6);
+        ASSERT_NEAR(end.y, to.y, 1e-6);
+        ASSERT_NEAR(std::cos(end.theta), std::cos(to.theta), 1e-6);
+        ASSERT_NEAR(std::sin(end.theta), std::sin(to.theta), 1e-6);
+    }
+}
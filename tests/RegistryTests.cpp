@@ -0,0 +1,165 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "Common/Registry.hpp"
+#include "City/City.hpp"
+#include "Simulation/BluePrints.hpp"
+
+//--------------------------------------------------------------------------
+//! \brief Entity counting its instances.
+struct Entity
+{
+    Entity(int v) : value(v) { ++instances; }
+    ~Entity() { --instances; }
+
+    int value;
+    static int instances;
+};
+
+int Entity::instances = 0;
+
+using Entities = Registry<Entity, 4u>;
+
+//--------------------------------------------------------------------------
+TEST(TestRegistry, Handles)
+{
+    Entities registry;
+    Entities::Handle const a = registry.create("a", 1u, 1);
+    Entities::Handle const b = registry.create("b", 1u, 2);
+    ASSERT_EQ(registry.size(), 2u);
+    ASSERT_EQ(Entity::instances, 2);
+    ASSERT_EQ(registry.get(Entities::Handle()), nullptr);
+    ASSERT_EQ(registry.get(a)->value, 1);
+    ASSERT_EQ(registry.get(b)->value, 2);
+    ASSERT_EQ(registry.handle(*registry.get(b)), b);
+
+    // Names are unique.
+    ASSERT_EQ(registry.create("a", 1u, 3), Entities::Handle());
+    ASSERT_EQ(registry.find("a"), a);
+    ASSERT_EQ(registry.find("c"), Entities::Handle());
+
+    // Destroyed entities are no longer referred.
+    Entity* address = registry.get(a);
+    ASSERT_TRUE(registry.destroy(a));
+    ASSERT_FALSE(registry.destroy(a));
+    ASSERT_EQ(Entity::instances, 1);
+    ASSERT_EQ(registry.get(a), nullptr);
+    ASSERT_EQ(registry.find("a"), Entities::Handle());
+
+    // The slot is reused by a new entity but old handles stay invalid.
+    Entities::Handle const c = registry.create("a", 1u, 4);
+    ASSERT_EQ(c.index, a.index);
+    ASSERT_NE(c.generation, a.generation);
+    ASSERT_EQ(registry.get(c), address);
+    ASSERT_EQ(registry.get(a), nullptr);
+
+    registry.clear();
+    ASSERT_EQ(registry.size(), 0u);
+    ASSERT_EQ(Entity::instances, 0);
+    ASSERT_EQ(registry.get(b), nullptr);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestRegistry, Slabs)
+{
+    Entities registry;
+    std::vector<Entities::Handle> handles;
+    std::vector<Entity*> addresses;
+    for (int i = 0; i < 10; ++i)
+    {
+        handles.push_back(registry.create(std::to_string(i), uint8_t(1 << (i % 2)), i));
+        addresses.push_back(registry.get(handles.back()));
+    }
+    ASSERT_EQ(registry.capacity(), 12u);
+
+    // Entities are never moved.
+    for (size_t i = 0u; i < handles.size(); ++i)
+    {
+        ASSERT_EQ(registry.get(handles[i]), addresses[i]);
+    }
+
+    // Iterate on groups.
+    int sum = 0;
+    for (Entity const& e: registry.entities(2u))
+    {
+        ASSERT_EQ(e.value % 2, 1);
+        sum += e.value;
+    }
+    ASSERT_EQ(sum, 1 + 3 + 5 + 7 + 9);
+    size_t count = 0u;
+    for (Entity& e: registry.entities())
+    {
+        (void) e;
+        ++count;
+    }
+    ASSERT_EQ(count, 10u);
+
+    // Spawning and despawning do not allocate new slabs.
+    for (int k = 0; k < 1000; ++k)
+    {
+        ASSERT_TRUE(registry.destroy(handles[size_t(k % 10)]));
+        handles[size_t(k % 10)] = registry.create("x" + std::to_string(k), 1u, k);
+    }
+    ASSERT_EQ(registry.size(), 10u);
+    ASSERT_EQ(registry.capacity(), 12u);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestRegistry, Regroup)
+{
+    Entities registry;
+    Entities::Handle const a = registry.create("a", 1u, 1);
+    Entities::Handle const b = registry.create("b", 1u, 2);
+
+    registry.regroup(a, 2u);
+    ASSERT_EQ(registry.group(a), 2u);
+    ASSERT_EQ(registry.get(a)->value, 1);
+    size_t count = 0u;
+    for (Entity const& e: registry.entities(1u))
+    {
+        ASSERT_EQ(e.value, 2);
+        ++count;
+    }
+    ASSERT_EQ(count, 1u);
+    ASSERT_EQ(registry.group(b), 1u);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestRegistry, CityCarNames)
+{
+    // Generated names are not truncated: they do not collide after
+    // thousands of cars.
+    BluePrints::init();
+    City city;
+    for (size_t i = 0u; i <= 10000u; ++i)
+    {
+        city.addCar("Renault.Twingo", sf::Vector2<Meter>(Meter(double(i)), 0.0_m),
+                    0.0_rad, 0.0_mps);
+    }
+    Car* first = city.get("car1000");
+    Car* last = city.get("car10000");
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(last, nullptr);
+    ASSERT_NE(first, last);
+    ASSERT_EQ(last->name, "car10000");
+}
@@ -0,0 +1,206 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "City/RoadGraph.hpp"
+#include <random>
+#include <limits>
+
+//--------------------------------------------------------------------------
+//! \brief Grid of N x N junctions spaced by 100 meters where some ways are
+//! missing.
+static void grid(Path& path, size_t const N, uint32_t const seed)
+{
+    std::mt19937 rng(seed);
+    std::bernoulli_distribution missing(0.2);
+    std::vector<Node*> nodes;
+    for (size_t y = 0u; y < N; ++y)
+    {
+        for (size_t x = 0u; x < N; ++x)
+        {
+            nodes.push_back(&path.addNode(sf::Vector2<Meter>(Meter(100.0 * x), Meter(100.0 * y))));
+        }
+    }
+    for (size_t y = 0u; y < N; ++y)
+    {
+        for (size_t x = 0u; x < N; ++x)
+        {
+            if ((x + 1u < N) && !missing(rng))
+                path.addWay(*nodes[y * N + x], *nodes[y * N + x + 1u]);
+            if ((y + 1u < N) && !missing(rng))
+                path.addWay(*nodes[y * N + x], *nodes[(y + 1u) * N + x]);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------
+//! \brief Check the route is made of consecutive edges and return its length.
+static double length(RoadGraph const& graph, RoadGraph::Route const& route)
+{
+    double length = 0.0;
+    for (size_t i = 1u; i < route.vertices.size(); ++i)
+    {
+        double cost = -1.0;
+        for (auto const& e: graph.edges(route.vertices[i - 1u]))
+        {
+            if (e.to == route.vertices[i])
+                cost = double(e.cost);
+        }
+        EXPECT_GE(cost, 0.0);
+        length += cost;
+    }
+    return length;
+}
+
+//--------------------------------------------------------------------------
+TEST(TestRoadGraph, AStar)
+{
+    Path path;
+    grid(path, 3u, 0u);
+    RoadGraph graph;
+    graph.build(path);
+    ASSERT_EQ(graph.size(), 9u);
+    ASSERT_FALSE(graph.contracted());
+
+    RoadGraph::Route route;
+    ASSERT_TRUE(graph.route(0u, 0u, route));
+    ASSERT_EQ(route.vertices.size(), 1u);
+    ASSERT_EQ(route.length.value(), 0.0);
+    ASSERT_FALSE(graph.route(0u, 9u, route));
+    ASSERT_EQ(graph.nearest(sf::Vector2<Meter>(190.0_m, 110.0_m)), 5u);
+
+    // Isolated vertex.
+    RoadGraph::Id const v = graph.addVertex(sf::Vector2<Meter>(0.0_m, 1000.0_m));
+    ASSERT_FALSE(graph.route(0u, v, route));
+}
+
+//--------------------------------------------------------------------------
+TEST(TestRoadGraph, Nearest)
+{
+    RoadGraph graph;
+    ASSERT_EQ(graph.nearest(sf::Vector2<Meter>(0.0_m, 0.0_m)), RoadGraph::NONE);
+
+    // Scattered vertices, some of them sharing cells, some of them far away.
+    std::mt19937 rng(7u);
+    std::uniform_real_distribution<double> near(-300.0, 300.0);
+    std::uniform_real_distribution<double> far(-5000.0, 5000.0);
+    for (size_t i = 0u; i < 500u; ++i)
+    {
+        graph.addVertex(sf::Vector2<Meter>(Meter(near(rng)), Meter(near(rng))));
+    }
+    graph.addVertex(sf::Vector2<Meter>(4000.0_m, -3000.0_m));
+
+    // Same vertex than a full scan, including positions outside the grid.
+    for (size_t i = 0u; i < 2000u; ++i)
+    {
+        sf::Vector2<Meter> const p(Meter(far(rng)), Meter(i % 2u ? near(rng) : far(rng)));
+        RoadGraph::Id expected = RoadGraph::NONE;
+        double min = std::numeric_limits<double>::infinity();
+        for (RoadGraph::Id v = 0u; v < graph.size(); ++v)
+        {
+            double const d = math::distance(p, graph.position(v)).value();
+            if (d < min)
+            {
+                min = d;
+                expected = v;
+            }
+        }
+        ASSERT_EQ(graph.nearest(p), expected);
+    }
+
+    // Cleared with the graph.
+    graph.clear();
+    ASSERT_EQ(graph.nearest(sf::Vector2<Meter>(0.0_m, 0.0_m)), RoadGraph::NONE);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestRoadGraph, ContractionHierarchy)
+{
+    Path path;
+    grid(path, 30u, 42u);
+    RoadGraph graph;
+    graph.build(path);
+    graph.contract();
+    ASSERT_TRUE(graph.contracted());
+
+    std::mt19937 rng(1u);
+    std::uniform_int_distribution<RoadGraph::Id> vertex(0u, RoadGraph::Id(graph.size() - 1u));
+    RoadGraph::Route expected, route;
+    for (size_t i = 0u; i < 200u; ++i)
+    {
+        RoadGraph::Id const from = vertex(rng);
+        RoadGraph::Id const to = vertex(rng);
+        bool const found = graph.astar(from, to, expected);
+        ASSERT_EQ(graph.route(from, to, route), found);
+        if (!found)
+            continue;
+
+        ASSERT_NEAR(route.length.value(), expected.length.value(), 1e-2);
+        ASSERT_EQ(route.vertices.front(), from);
+        ASSERT_EQ(route.vertices.back(), to);
+        ASSERT_NEAR(length(graph, route), route.length.value(), 1e-2);
+    }
+
+    // Editing the graph discards the hierarchy.
+    graph.addEdge(0u, 1u, 100.0_m);
+    ASSERT_FALSE(graph.contracted());
+}
+
+//--------------------------------------------------------------------------
+TEST(TestRoadGraph, Lanes)
+{
+    // Two consecutive roads with two lanes in each direction.
+    std::vector<std::unique_ptr<Road>> roads;
+    roads.push_back(std::make_unique<Road>(std::vector<sf::Vector2<Meter>>{
+        { 0.0_m, 0.0_m }, { 100.0_m, 0.0_m } }, 2.0_m, std::array<size_t, 2>{ 2u, 2u }));
+    roads.push_back(std::make_unique<Road>(std::vector<sf::Vector2<Meter>>{
+        { 100.0_m, 0.0_m }, { 200.0_m, 0.0_m } }, 2.0_m, std::array<size_t, 2>{ 2u, 2u }));
+
+    RoadGraph graph;
+    graph.build(roads);
+    graph.contract();
+    ASSERT_EQ(graph.size(), 8u);
+
+    Lane const& first = *roads[0]->m_lanes[TrafficSide::RightHand][1];
+    Lane const& last = *roads[1]->m_lanes[TrafficSide::RightHand][1];
+    RoadGraph::Id const from = graph.vertex(first);
+    RoadGraph::Id const to = graph.vertex(last);
+    ASSERT_NE(from, RoadGraph::NONE);
+    ASSERT_NE(to, RoadGraph::NONE);
+    ASSERT_EQ(graph.lane(from), &first);
+
+    RoadGraph::Route route;
+    ASSERT_TRUE(graph.route(from, to, route));
+    ASSERT_EQ(route.vertices.size(), 2u);
+    ASSERT_EQ(graph.lane(route.vertices.back()), &last);
+    ASSERT_NEAR(route.length.value(), 100.0, 1e-3);
+
+    // Change of lane.
+    Lane const& next = *roads[0]->m_lanes[TrafficSide::RightHand][0];
+    ASSERT_TRUE(graph.route(from, graph.vertex(next), route));
+    ASSERT_EQ(route.vertices.size(), 2u);
+    ASSERT_NEAR(route.length.value(), 20.0, 1e-3);
+
+    // No U-turn: lanes of the other traffic side cannot be reached.
+    Lane const& back = *roads[0]->m_lanes[TrafficSide::LeftHand][0];
+    ASSERT_FALSE(graph.route(from, graph.vertex(back), route));
+}
@@ -0,0 +1,92 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "City/City.hpp"
+#include "Simulation/BluePrints.hpp"
+
+//--------------------------------------------------------------------------
+static size_t count(City::Cars::Entities cars)
+{
+    size_t n = 0u;
+    for (Car& car: cars)
+    {
+        (void) car;
+        ++n;
+    }
+    return n;
+}
+
+//--------------------------------------------------------------------------
+TEST(TestSleepingCars, ParkedCars)
+{
+    BluePrints::init();
+    City city;
+    Parking& parking0 = city.addParking("epi.0", { 0.0_m, 0.0_m }, 0.0_deg);
+    Parking& parking1 = city.addParking(parking0);
+    Parking& parking2 = city.addParking("epi.0", { 500.0_m, 0.0_m }, 0.0_deg);
+    Car& a = city.addCar("Renault.Twingo", parking0);
+    Car& b = city.addCar("Renault.Twingo", parking1);
+    Car& c = city.addCar("Renault.Twingo", parking2);
+    Car& d = city.addCar("Renault.Twingo", { 0.0_m, 50.0_m }, 0.0_deg, 0.0_mps, 0.0_deg);
+
+    // Parked cars are sleeping: they are no longer simulated but still
+    // collidable.
+    ASSERT_TRUE(city.sleeping(a));
+    ASSERT_TRUE(city.sleeping(c));
+    ASSERT_FALSE(city.sleeping(d));
+    EXPECT_EQ(count(city.cars(City::CarGroup::Traffic)), 1u);
+    EXPECT_EQ(count(city.cars()), 4u);
+
+    // Static broad phase.
+    std::vector<Car const*> found;
+    city.statics(a.obb().getGlobalBounds(), found);
+    EXPECT_THAT(found, ::testing::Contains(&a));
+    EXPECT_THAT(found, ::testing::Not(::testing::Contains(&c)));
+    city.statics(sf::FloatRect(490.0f, -10.0f, 20.0f, 20.0f), found);
+    ASSERT_EQ(found.size(), 1u);
+    EXPECT_EQ(found[0], &c);
+    city.statics(d.obb().getGlobalBounds(), found);
+    EXPECT_TRUE(found.empty());
+
+    // Only scripted cars can sleep.
+    EXPECT_FALSE(city.sleep(city.handle(a)));
+    EXPECT_FALSE(city.wake(city.handle(d)));
+
+    // Woken cars leave the static broad phase.
+    ASSERT_TRUE(city.wake(city.handle(a)));
+    ASSERT_FALSE(city.sleeping(a));
+    EXPECT_EQ(count(city.cars(City::CarGroup::Traffic)), 2u);
+    city.statics(sf::FloatRect(-20.0f, -20.0f, 40.0f, 40.0f), found);
+    EXPECT_THAT(found, ::testing::Not(::testing::Contains(&a)));
+    EXPECT_THAT(found, ::testing::Contains(&b));
+
+    // Idle cars can be put to sleep by the scenario.
+    ASSERT_TRUE(city.sleep(city.handle(d)));
+    city.statics(d.obb().getGlobalBounds(), found);
+    EXPECT_THAT(found, ::testing::ElementsAre(&d));
+
+    // Removed cars leave the static broad phase.
+    ASSERT_TRUE(city.removeCar(city.handle(c)));
+    city.statics(sf::FloatRect(490.0f, -10.0f, 20.0f, 20.0f), found);
+    EXPECT_TRUE(found.empty());
+}
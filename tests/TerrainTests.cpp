@@ -0,0 +1,125 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "City/City.hpp"
+#include "City/Terrain.hpp"
+#include "Simulation/BluePrints.hpp"
+
+//--------------------------------------------------------------------------
+//! \brief Heightmap of the plane z = 5 + 0.1 x - 0.2 y (sampled every 2
+//! meters from (-10, -20)) spanning several tiles.
+static void plane(Terrain& terrain, size_t const columns, size_t const rows)
+{
+    std::vector<float> heights(columns * rows);
+    for (size_t j = 0u; j < rows; ++j)
+    {
+        for (size_t i = 0u; i < columns; ++i)
+        {
+            double const x = -10.0 + 2.0 * double(i);
+            double const y = -20.0 + 2.0 * double(j);
+            heights[j * columns + i] = float(5.0 + 0.1 * x - 0.2 * y);
+        }
+    }
+    ASSERT_TRUE(terrain.load({ -10.0_m, -20.0_m }, 2.0_m, columns, rows, heights));
+}
+
+//--------------------------------------------------------------------------
+TEST(TestTerrain, Bilinear)
+{
+    Terrain terrain;
+    ASSERT_TRUE(terrain.flat());
+    EXPECT_EQ(terrain.altitude({ 12.0_m, 3.0_m }).value(), 0.0);
+    EXPECT_FALSE(terrain.load({ 0.0_m, 0.0_m }, 1.0_m, 1u, 4u, std::vector<float>(4u)));
+    EXPECT_FALSE(terrain.load({ 0.0_m, 0.0_m }, 1.0_m, 2u, 2u, std::vector<float>(3u)));
+
+    plane(terrain, 70u, 45u);
+    ASSERT_FALSE(terrain.flat());
+
+    // A plane is exactly interpolated, including across borders of tiles.
+    sf::Vector2<double> gradient;
+    for (double x = -10.0; x <= 128.0; x += 1.37)
+    {
+        for (double y = -20.0; y <= 68.0; y += 0.91)
+        {
+            Meter const z = terrain.altitude({ Meter(x), Meter(y) }, gradient);
+            ASSERT_NEAR(z.value(), 5.0 + 0.1 * x - 0.2 * y, 1e-4);
+            ASSERT_NEAR(terrain.altitude({ Meter(x), Meter(y) }).value(), z.value(), 1e-9);
+            ASSERT_NEAR(gradient.x, 0.1, 1e-4);
+            ASSERT_NEAR(gradient.y, -0.2, 1e-4);
+        }
+    }
+
+    // Outside the heightmap: altitude of the nearest border.
+    EXPECT_NEAR(terrain.altitude({ -100.0_m, 0.0_m }).value(), 5.0 - 1.0, 1e-4);
+    EXPECT_NEAR(terrain.altitude({ 1000.0_m, 1000.0_m }).value(), 5.0 + 12.8 - 13.6, 1e-4);
+
+    // Slopes
+    EXPECT_NEAR(terrain.slope({ 0.0_m, 0.0_m }, 0.0_deg).value(), std::atan(0.1), 1e-4);
+    EXPECT_NEAR(terrain.slope({ 0.0_m, 0.0_m }, 180.0_deg).value(), -std::atan(0.1), 1e-4);
+    EXPECT_NEAR(terrain.slope({ 0.0_m, 0.0_m }, -90.0_deg).value(), std::atan(0.2), 1e-4);
+
+    terrain.clear();
+    EXPECT_TRUE(terrain.flat());
+}
+
+//--------------------------------------------------------------------------
+TEST(TestTerrain, Batch)
+{
+    Terrain terrain;
+    std::vector<sf::Vector2<Meter>> positions;
+    for (size_t i = 0u; i < 1000u; ++i)
+    {
+        positions.push_back({ Meter(double(i % 97u) * 1.3 - 15.0), Meter(double(i % 31u) * 2.1 - 25.0) });
+    }
+    std::vector<Meter> altitudes;
+    terrain.altitudes(positions, altitudes);
+    ASSERT_EQ(altitudes.size(), positions.size());
+    EXPECT_EQ(altitudes[10].value(), 0.0);
+
+    plane(terrain, 70u, 45u);
+    terrain.altitudes(positions, altitudes);
+    for (size_t i = 0u; i < positions.size(); ++i)
+    {
+        ASSERT_EQ(altitudes[i].value(), terrain.altitude(positions[i]).value());
+    }
+}
+
+//--------------------------------------------------------------------------
+TEST(TestTerrain, CarSlopes)
+{
+    BluePrints::init();
+    City city;
+    Car& up = city.addCar("Renault.Twingo", { 20.0_m, 10.0_m }, 0.0_deg, 0.0_mps, 0.0_deg);
+    Car& down = city.addCar("Renault.Twingo", { 20.0_m, 20.0_m }, 90.0_deg, 0.0_mps, 0.0_deg);
+
+    // Flat terrain
+    city.updateSlopes();
+    EXPECT_EQ(up.slope().value(), 0.0);
+    EXPECT_EQ(city.altitude({ 20.0_m, 10.0_m }).value(), 0.0);
+
+    plane(city.terrain(), 70u, 45u);
+    EXPECT_NEAR(city.altitude({ 20.0_m, 10.0_m }).value(), 5.0, 1e-4);
+    city.updateSlopes();
+    EXPECT_NEAR(up.slope().value(), std::atan(0.1), 1e-4);
+    EXPECT_NEAR(down.slope().value(), -std::atan(0.2), 1e-4);
+}
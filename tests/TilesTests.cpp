@@ -0,0 +1,105 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "City/Traffic.hpp"
+#include "Simulation/BluePrints.hpp"
+
+//--------------------------------------------------------------------------
+TEST(TestTiles, Activation)
+{
+    Tiles tiles(100.0_m);
+    ASSERT_EQ(tiles.key({ 10.0_m, 10.0_m }), tiles.key({ 90.0_m, 0.0_m }));
+    ASSERT_NE(tiles.key({ 10.0_m, 10.0_m }), tiles.key({ -10.0_m, 10.0_m }));
+    ASSERT_TRUE(tiles.allActive());
+    ASSERT_TRUE(tiles.active({ 1e5_m, 1e5_m }));
+
+    // Disk of radius 60 m centered on (50, 50): the 3x3 tiles around
+    // (0, 0) except the corners.
+    tiles.activate({ { 50.0_m, 50.0_m } }, 60.0_m);
+    ASSERT_FALSE(tiles.allActive());
+    EXPECT_EQ(tiles.actives().size(), 5u);
+    EXPECT_TRUE(tiles.active({ 50.0_m, 50.0_m }));
+    EXPECT_TRUE(tiles.active({ 150.0_m, 50.0_m }));
+    EXPECT_TRUE(tiles.active({ 50.0_m, -50.0_m }));
+    EXPECT_FALSE(tiles.active({ 150.0_m, 150.0_m }));
+    EXPECT_FALSE(tiles.active({ 250.0_m, 50.0_m }));
+
+    tiles.activate();
+    ASSERT_TRUE(tiles.active({ 250.0_m, 50.0_m }));
+}
+
+//--------------------------------------------------------------------------
+TEST(TestTiles, CityRoads)
+{
+    BluePrints::init();
+    City city;
+    Road& road = city.addRoad({ { 0.0_m, 0.0_m }, { 600.0_m, 0.0_m } }, 3.0_m, { 1u, 1u });
+    Road& other = city.addRoad({ { 0.0_m, 1000.0_m }, { 100.0_m, 1000.0_m } }, 3.0_m, { 1u, 1u });
+    Tiles const& tiles = city.tiles();
+
+    // Roads are referred by all the tiles they overlap.
+    ASSERT_NE(tiles.tile({ 400.0_m, 1.0_m }), nullptr);
+    ASSERT_EQ(tiles.tile({ 400.0_m, 1.0_m })->roads.size(), 1u);
+    EXPECT_EQ(tiles.tile({ 400.0_m, 1.0_m })->roads[0], &road);
+    EXPECT_EQ(tiles.tile({ 50.0_m, 1000.0_m })->roads[0], &other);
+    EXPECT_EQ(tiles.tile({ 400.0_m, 500.0_m }), nullptr);
+
+    // Lanes are found through tiles.
+    Car& car = city.addCar("Renault.Twingo", road, TrafficSide::RightHand, 0u, 0.9, 0.5);
+    EXPECT_EQ(city.lane(car), road.m_lanes[TrafficSide::RightHand][0].get());
+    Parking& parking = city.addParking("epi.0", { 50.0_m, 1005.0_m }, 0.0_deg);
+    EXPECT_EQ(tiles.tile({ 50.0_m, 1000.0_m })->parkings[0], &parking);
+    city.reset();
+    EXPECT_TRUE(tiles.tile({ 50.0_m, 1000.0_m })->parkings.empty());
+}
+
+//--------------------------------------------------------------------------
+TEST(TestTiles, FrozenTraffic)
+{
+    BluePrints::init();
+    City city;
+    Traffic traffic;
+    Road& road = city.addRoad({ { 0.0_m, 0.0_m }, { 2000.0_m, 0.0_m } }, 3.0_m, { 0u, 1u });
+    Car& near = traffic.spawn(city, "Renault.Twingo", road, TrafficSide::RightHand,
+                              0u, 0.0, 0.0_mps, 10.0_mps);
+    Car& far = traffic.spawn(city, "Renault.Twingo", road, TrafficSide::RightHand,
+                             0u, 0.5, 5.0_mps, 10.0_mps);
+    sf::Vector2<Meter> const position = far.position();
+
+    // Only the world around the origin is simulated: the far agent keeps its
+    // speed and its car is not moved.
+    city.activate({ { 0.0_m, 0.0_m } }, 300.0_m);
+    for (size_t i = 0u; i < 1000u; ++i)
+    {
+        traffic.update(city, 0.01_s);
+        city.updateLanes();
+    }
+    EXPECT_GT(near.speed().value(), 5.0);
+    EXPECT_EQ(far.position().x, position.x);
+    EXPECT_EQ(far.speed().value(), 5.0);
+
+    // Its pose is refreshed once active: it has driven at constant speed.
+    city.activate({ { 1000.0_m, 0.0_m } }, 300.0_m);
+    traffic.update(city, 0.01_s);
+    EXPECT_NEAR((far.position().x - position.x).value(), 5.0 * 10.01, 0.1);
+}
@@ -0,0 +1,86 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "Vehicle/VehicleControl.hpp"
+#include <cmath>
+
+//--------------------------------------------------------------------------
+//! \brief Follow a straight line (forward then backward) starting with
+//! lateral and heading errors, using the tricycle kinematic equations with a
+//! coarse time step.
+static void trackLine(PathTracker::Lateral const lateral, Second const dt)
+{
+    const double wheelbase = 2.5;
+    TrackingPath path;
+    for (int i = 0; i <= 100; ++i)
+        path.push_back({ { Meter(0.1 * i), 0.0_m }, 0.0_rad, 1.0_mps });
+    for (int i = 99; i >= 50; --i)
+        path.push_back({ { Meter(0.1 * i), 0.0_m }, 0.0_rad, -1.0_mps });
+
+    VehicleControl control;
+    control.track(path, Meter(wheelbase), 0.6_rad);
+    control.tracker().lateral(lateral);
+    ASSERT_EQ(control.tracking(), true);
+
+    double x = 0.0, y = 0.5, heading = 0.2, v = 0.0;
+    size_t steps = 0u;
+    while (control.tracking() && (++steps < 10000u))
+    {
+        control.update(dt, { Meter(x), Meter(y) }, Radian(heading), MeterPerSecond(v));
+        v = control.outputs.speed.value();
+        heading += dt.value() * v * std::tan(control.outputs.steering.value()) / wheelbase;
+        x += dt.value() * v * std::cos(heading);
+        y += dt.value() * v * std::sin(heading);
+    }
+
+    ASSERT_EQ(control.tracking(), false);
+    ASSERT_NEAR(x, 5.0, 0.05);
+    ASSERT_NEAR(y, 0.0, 0.05);
+    ASSERT_NEAR(heading, 0.0, 0.05);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestTracking, PurePursuit)
+{
+    trackLine(PathTracker::Lateral::PurePursuit, 0.01_s);
+    trackLine(PathTracker::Lateral::PurePursuit, 0.2_s);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestTracking, Stanley)
+{
+    trackLine(PathTracker::Lateral::Stanley, 0.01_s);
+    trackLine(PathTracker::Lateral::Stanley, 0.2_s);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestTracking, ManualReferenceStopsTracking)
+{
+    TrackingPath path = { { { 0.0_m, 0.0_m }, 0.0_rad, 1.0_mps },
+                          { { 1.0_m, 0.0_m }, 0.0_rad, 1.0_mps } };
+    VehicleControl control;
+    control.track(path, 2.5_m, 0.6_rad);
+    ASSERT_EQ(control.tracking(), true);
+    control.set_ref_speed(0.0_mps);
+    ASSERT_EQ(control.tracking(), false);
+}
@@ -0,0 +1,161 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "City/Traffic.hpp"
+#include "Simulation/BluePrints.hpp"
+
+//--------------------------------------------------------------------------
+//! \brief Straight roads along the X-axis with two lanes in the right-hand
+//! direction.
+class TestTraffic : public ::testing::Test
+{
+protected:
+
+    void SetUp() override
+    {
+        BluePrints::init();
+        first = &city.addRoad({ { 0.0_m, 0.0_m }, { 1000.0_m, 0.0_m } }, 3.0_m, { 0u, 2u });
+    }
+
+    // Simulate the given duration as the Simulator does.
+    void run(City& c, Traffic& t, Second const duration)
+    {
+        static const Second dt = 0.01_s;
+        for (Second time = 0.0_s; time < duration; time += dt)
+        {
+            t.update(c, dt);
+            c.updateLanes();
+        }
+    }
+
+    City city;
+    Traffic traffic;
+    Road* first;
+};
+
+//--------------------------------------------------------------------------
+TEST_F(TestTraffic, FreeRoad)
+{
+    Car& car = traffic.spawn(city, "Renault.Twingo", *first, TrafficSide::RightHand,
+                             0u, 0.0, 0.0_mps, 15.0_mps);
+    ASSERT_EQ(traffic.size(), 1u);
+    ASSERT_EQ(city.cars(City::CarGroup::Agent).begin()->name, car.name);
+
+    run(city, traffic, 40.0_s);
+    EXPECT_GT(car.speed().value(), 14.0);
+    EXPECT_LE(car.speed().value(), 15.0);
+    EXPECT_NEAR(car.position().y.value(), first->offset(TrafficSide::RightHand, 0u, 0.0, 0.5).y.value(), 1e-6);
+    EXPECT_EQ(&traffic.lane(0u), first->m_lanes[TrafficSide::RightHand][0].get());
+}
+
+//--------------------------------------------------------------------------
+TEST_F(TestTraffic, StopBehindStoppedCar)
+{
+    city.addRoad({ { 0.0_m, 10.0_m }, { 300.0_m, 10.0_m } }, 3.0_m, { 0u, 1u });
+    Road& road = *city.roads().back();
+    Car& stopped = city.addCar("Renault.Twingo", road, TrafficSide::RightHand, 0u, 0.5, 0.5);
+    Car& car = traffic.spawn(city, "Renault.Twingo", road, TrafficSide::RightHand,
+                             0u, 0.0, 15.0_mps, 15.0_mps);
+
+    run(city, traffic, 60.0_s);
+    EXPECT_LT(car.speed().value(), 0.01);
+    EXPECT_FALSE(car.collides(stopped));
+
+    Lane const& lane = *road.m_lanes[TrafficSide::RightHand][0];
+    ASSERT_EQ(lane.occupants().size(), 2u);
+    ASSERT_EQ(lane.occupants()[0].car, &car);
+    Meter const gap = lane.occupants()[1].rear - lane.occupants()[0].front;
+    EXPECT_GT(gap.value(), 1.0);
+    EXPECT_LT(gap.value(), 3.0);
+}
+
+//--------------------------------------------------------------------------
+TEST_F(TestTraffic, LaneChange)
+{
+    Car& stopped = city.addCar("Renault.Twingo", *first, TrafficSide::RightHand, 0u, 0.2, 0.5);
+    Car& car = traffic.spawn(city, "Renault.Twingo", *first, TrafficSide::RightHand,
+                             0u, 0.0, 10.0_mps, 15.0_mps);
+
+    Lane const* other = first->m_lanes[TrafficSide::RightHand][1].get();
+    bool collided = false;
+    for (size_t i = 0u; i < 4000u; ++i)
+    {
+        traffic.update(city, 0.01_s);
+        city.updateLanes();
+        collided |= car.collides(stopped);
+    }
+
+    EXPECT_FALSE(collided);
+    EXPECT_EQ(&traffic.lane(0u), other);
+    EXPECT_GT(car.position().x, stopped.position().x);
+    EXPECT_GT(car.speed().value(), 10.0);
+}
+
+//--------------------------------------------------------------------------
+TEST_F(TestTraffic, LeaveTheCity)
+{
+    city.addRoad({ { 1000.0_m, 0.0_m }, { 1100.0_m, 0.0_m } }, 3.0_m, { 0u, 2u });
+    traffic.spawn(city, "Renault.Twingo", *first, TrafficSide::RightHand,
+                  1u, 0.95, 10.0_mps, 10.0_mps);
+
+    // Drives through the next road.
+    run(city, traffic, 10.0_s);
+    ASSERT_EQ(traffic.size(), 1u);
+    EXPECT_EQ(&traffic.lane(0u), city.roads().back()->m_lanes[TrafficSide::RightHand][1].get());
+
+    // Then leaves the road network.
+    run(city, traffic, 10.0_s);
+    EXPECT_EQ(traffic.size(), 0u);
+    EXPECT_EQ(city.cars(City::CarGroup::Agent).begin(), city.cars(City::CarGroup::Agent).end());
+}
+
+//--------------------------------------------------------------------------
+TEST_F(TestTraffic, Deterministic)
+{
+    City other;
+    Traffic traffic2;
+    Road& road2 = other.addRoad({ { 0.0_m, 0.0_m }, { 1000.0_m, 0.0_m } }, 3.0_m, { 0u, 2u });
+
+    for (size_t i = 0u; i < 20u; ++i)
+    {
+        size_t const lane = i % 2u;
+        double const x = 0.025 * double(i);
+        MeterPerSecond const v0 = MeterPerSecond(8.0 + double(i % 5u) * 2.0);
+        traffic.spawn(city, "Renault.Twingo", *first, TrafficSide::RightHand, lane, x, 5.0_mps, v0);
+        traffic2.spawn(other, "Renault.Twingo", road2, TrafficSide::RightHand, lane, x, 5.0_mps, v0);
+    }
+    city.updateLanes();
+    other.updateLanes();
+
+    run(city, traffic, 20.0_s);
+    run(other, traffic2, 20.0_s);
+    ASSERT_EQ(traffic.size(), traffic2.size());
+    for (size_t i = 0u; i < traffic.size(); ++i)
+    {
+        Car const* a = city.get(traffic.car(i));
+        Car const* b = other.get(traffic2.car(i));
+        ASSERT_EQ(a->name, b->name);
+        ASSERT_EQ(a->position().x, b->position().x);
+        ASSERT_EQ(a->position().y, b->position().y);
+    }
+}
@@ -0,0 +1,73 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "ECUs/AutoParkECU/TrajectoryPlanner.hpp"
+#include "ECUs/AutoParkECU/ManeuverCache.hpp"
+#include "Simulation/BluePrints.hpp"
+#include "Vehicle/Car.hpp"
+#include <cmath>
+
+//--------------------------------------------------------------------------
+TEST(TestTrajectoryPlanner, CacheHitIsScoredAgainstObstacles)
+{
+    BluePrints::init();
+    ManeuverCache::instance().clear();
+
+    // Parallel spot along the X-axis, the ego car is driving along it.
+    ParkingBluePrint const& bp = BluePrints::get<ParkingBluePrint>("epi.0");
+    Car ego("Renault.Twingo", sf::Color::Green);
+    ParkingBluePrint const dim(ego.blueprint.length + 1.5_m, bp.width, bp.angle);
+    Parking const spot(dim, sf::Vector2<Meter>(0.0_m, 0.0_m), 0.0_rad);
+    ego.init(0.0_mps_sq, 0.0_mps, sf::Vector2<Meter>(dim.length, 2.5_m), 0.0_rad);
+    ego.update(0.0_s);
+
+    // Free space: the maneuver is planned and memorized.
+    TrajectoryRequest request(ego, spot, true);
+    TrajectoryPlanner::Result first = TrajectoryPlanner::plan(request);
+    ASSERT_TRUE(first.succeeded);
+    ASSERT_EQ(ManeuverCache::instance().size(), 1u);
+    TrackingPath const& path = first.trajectory->trackingPath();
+    ASSERT_FALSE(path.empty());
+
+    // Without obstacles, the clearance is saturated.
+    TrajectoryPlanner::Cost const free = TrajectoryPlanner::cost(*first.trajectory, request);
+    ASSERT_FALSE(std::isinf(free.total));
+    ASSERT_TRUE(std::isfinite(free.clearance.value()));
+
+    // Same start pose but an obstacle now lies on the memorized path.
+    sf::RectangleShape obstacle(sf::Vector2f(1.0f, 1.0f));
+    obstacle.setOrigin(0.5f, 0.5f);
+    PathPoint const& middle = path[path.size() / 2u];
+    obstacle.setPosition(float(middle.position.x.value()), float(middle.position.y.value()));
+    request.obstacles.push_back(obstacle);
+    ASSERT_TRUE(std::isinf(TrajectoryPlanner::cost(*first.trajectory, request).total));
+
+    // The cached maneuver shall not be replayed.
+    TrajectoryPlanner::Result second = TrajectoryPlanner::plan(request);
+    if (second.succeeded)
+    {
+        ASSERT_FALSE(std::isinf(TrajectoryPlanner::cost(*second.trajectory, request).total));
+    }
+
+    ManeuverCache::instance().clear();
+}
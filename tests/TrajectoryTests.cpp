@@ -0,0 +1,128 @@
+//=====================================================================
+// https://github.com/Lecrapouille/Highway
+// Highway: Open-source simulator for autonomous driving research.
+// Copyright 2021 -- 2023 Quentin Quadrat <lecrapouille@gmail.com>
+//
+// This file is part of Highway.
+//
+// Highway is free software: you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Highway.  If not, see <http://www.gnu.org/licenses/>.
+//=====================================================================
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#define protected public
+#define private public
+#  pragma GCC diagnostic push
+#  pragma GCC diagnostic ignored "-Wfloat-equal"
+#    include "ECUs/AutoParkECU/Trajectory.hpp"
+#  pragma GCC diagnostic pop
+#undef protected
+#undef private
+
+//--------------------------------------------------------------------------
+TEST(TestReferences, Empty)
+{
+    References<MeterPerSecond> refs;
+
+    ASSERT_EQ(refs.end(0.0_s), true);
+    ASSERT_FLOAT_EQ(refs.get(0.0_s).value(), 0.0);
+    ASSERT_FLOAT_EQ(refs.duration().value(), 0.0);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestReferences, ZeroOrder)
+{
+    References<MeterPerSecond> refs;
+    refs.add(1.0_mps, 1.0_s);
+    refs.add(2.0_mps, 2.0_s);
+    refs.add(-1.0_mps, 1.0_s);
+
+    ASSERT_FLOAT_EQ(refs.duration().value(), 4.0);
+    ASSERT_FLOAT_EQ(refs.get(0.0_s).value(), 1.0);
+    ASSERT_FLOAT_EQ(refs.get(0.99_s).value(), 1.0);
+    ASSERT_FLOAT_EQ(refs.get(1.0_s).value(), 2.0);
+    ASSERT_FLOAT_EQ(refs.get(2.5_s).value(), 2.0);
+    ASSERT_FLOAT_EQ(refs.get(3.5_s).value(), -1.0);
+    ASSERT_EQ(refs.end(4.0_s), true);
+    ASSERT_FLOAT_EQ(refs.get(4.0_s).value(), 0.0);
+
+    // Seek backward
+    ASSERT_FLOAT_EQ(refs.get(0.5_s).value(), 1.0);
+    ASSERT_EQ(refs.m_cursor, 0u);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestReferences, CursorPlayback)
+{
+    References<Radian> refs;
+    for (size_t i = 0u; i < 10000u; ++i)
+    {
+        refs.add(Radian(double(i)), 0.01_s);
+    }
+
+    // Monotonic playback
+    for (size_t i = 0u; i < 10000u; ++i)
+    {
+        Second t(double(i) * 0.01 + 0.005);
+        ASSERT_FLOAT_EQ(refs.get(t).value(), double(i));
+        ASSERT_EQ(refs.m_cursor, i);
+    }
+
+    // Large jumps use the binary search
+    ASSERT_FLOAT_EQ(refs.get(12.345_s).value(), 1234.0);
+    ASSERT_FLOAT_EQ(refs.get(50.005_s).value(), 5000.0);
+    ASSERT_EQ(refs.m_cursor, 5000u);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestReferences, Linear)
+{
+    References<Radian> refs(References<Radian>::Interpolation::Linear);
+    refs.add(0.0_rad, 1.0_s);
+    refs.add(1.0_rad, 2.0_s);
+    refs.add(0.0_rad, 1.0_s);
+
+    ASSERT_FLOAT_EQ(refs.get(0.0_s).value(), 0.0);
+    ASSERT_FLOAT_EQ(refs.get(0.5_s).value(), 0.5);
+    ASSERT_FLOAT_EQ(refs.get(1.0_s).value(), 1.0);
+    ASSERT_FLOAT_EQ(refs.get(2.0_s).value(), 0.5);
+    // Last segment is held
+    ASSERT_FLOAT_EQ(refs.get(3.5_s).value(), 0.0);
+}
+
+//--------------------------------------------------------------------------
+TEST(TestReferences, CubicDoesNotOvershoot)
+{
+    References<Radian> refs(References<Radian>::Interpolation::Cubic);
+    refs.add(0.0_rad, 1.0_s);
+    refs.add(0.0_rad, 1.0_s);
+    refs.add(1.0_rad, 1.0_s);
+    refs.add(1.0_rad, 1.0_s);
+
+    // Pass through knots
+    ASSERT_FLOAT_EQ(refs.get(1.0_s).value(), 0.0);
+    ASSERT_FLOAT_EQ(refs.get(2.0_s).value(), 1.0);
+
+    // Smooth and bounded
+    double previous = 0.0;
+    for (double t = 0.0; t < 4.0; t += 0.01)
+    {
+        double v = refs.get(Second(t)).value();
+        ASSERT_GE(v, 0.0);
+        ASSERT_LE(v, 1.0);
+        ASSERT_GE(v, previous - 1e-9);
+        previous = v;
+    }
+}